@@ -27,4 +27,7 @@ namespace events {}
 /// The namespace used to hold RTK data transfer components.
 namespace transfer {}
 
+/// The namespace used to hold the RTK host machine simulator.
+namespace host {}
+
 } /* namespace rtk */
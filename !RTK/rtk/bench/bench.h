@@ -0,0 +1,169 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#ifndef _RTK_BENCH_BENCH
+#define _RTK_BENCH_BENCH
+
+#include <ctime>
+#include <cstdio>
+#include <string>
+
+namespace rtk {
+namespace bench {
+
+using std::string;
+
+/** A class for measuring elapsed time. */
+class stopwatch
+{
+private:
+	/** The time at which the stopwatch was last started. */
+	struct timespec _start;
+public:
+	/** Construct and start stopwatch. */
+	stopwatch()
+		{ restart(); }
+
+	/** Restart stopwatch. */
+	void restart()
+		{ clock_gettime(CLOCK_MONOTONIC,&_start); }
+
+	/** Get elapsed time.
+	 * @return the time since the stopwatch was last started, in seconds
+	 */
+	double seconds() const
+	{
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC,&now);
+		return (now.tv_sec-_start.tv_sec)+
+			(now.tv_nsec-_start.tv_nsec)*1e-9;
+	}
+};
+
+/** A class to represent one benchmark result.
+ * Results are written to standard output as JSON objects, one per line,
+ * so that they can be collected and compared by other programs.  Every
+ * result has the fields "suite", "subject", "nodes", "op", "iterations"
+ * and "seconds" (the mean time per iteration).  Further fields may be
+ * added for counters specific to the operation.
+ */
+class result
+{
+private:
+	/** The fields written so far. */
+	string _text;
+public:
+	/** Construct result.
+	 * @param suite the name of the benchmark suite
+	 * @param subject the name of the object being measured
+	 * @param nodes the number of nodes in the object being measured
+	 * @param op the name of the operation being measured
+	 * @param iterations the number of times the operation was performed
+	 * @param seconds the total time taken, in seconds
+	 */
+	result(const string& suite,const string& subject,unsigned long nodes,
+		const string& op,unsigned long iterations,double seconds)
+	{
+		field("suite",suite);
+		field("subject",subject);
+		field("nodes",nodes);
+		field("op",op);
+		field("iterations",iterations);
+		field("seconds",(iterations)?seconds/iterations:0.0);
+	}
+
+	/** Add string field.
+	 * @param name the name of the field
+	 * @param value the value of the field
+	 * @return a reference to this
+	 */
+	result& field(const char* name,const string& value)
+	{
+		separator(name);
+		_text+='"';
+		_text+=value;
+		_text+='"';
+		return *this;
+	}
+
+	/** Add integer field.
+	 * @param name the name of the field
+	 * @param value the value of the field
+	 * @return a reference to this
+	 */
+	result& field(const char* name,unsigned long value)
+	{
+		char buffer[32];
+		std::sprintf(buffer,"%lu",value);
+		separator(name);
+		_text+=buffer;
+		return *this;
+	}
+
+	/** Add floating point field.
+	 * @param name the name of the field
+	 * @param value the value of the field
+	 * @return a reference to this
+	 */
+	result& field(const char* name,double value)
+	{
+		char buffer[32];
+		std::sprintf(buffer,"%.9g",value);
+		separator(name);
+		_text+=buffer;
+		return *this;
+	}
+
+	/** Write result to standard output. */
+	void write() const
+	{
+		std::printf("{%s}\n",_text.c_str());
+		std::fflush(stdout);
+	}
+private:
+	/** Begin field.
+	 * @param name the name of the field
+	 */
+	void separator(const char* name)
+	{
+		if (_text.length()) _text+=',';
+		_text+='"';
+		_text+=name;
+		_text+="\":";
+	}
+};
+
+/** A class for generating pseudo-random numbers.
+ * A fixed sequence is used so that successive runs of a benchmark
+ * perform the same operations.
+ */
+class random_sequence
+{
+private:
+	/** The current state. */
+	unsigned int _state;
+public:
+	/** Construct random number generator.
+	 * @param seed the initial state
+	 */
+	explicit random_sequence(unsigned int seed=1):
+		_state(seed)
+		{}
+
+	/** Get next number.
+	 * @param limit the upper bound (exclusive), which must be non-zero
+	 * @return a number in the range 0 to limit-1
+	 */
+	unsigned int operator()(unsigned int limit)
+	{
+		_state=_state*1103515245+12345;
+		return (_state>>8)%limit;
+	}
+};
+
+} /* namespace bench */
+} /* namespace rtk */
+
+#endif
@@ -0,0 +1,253 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+// Measure the cost of posting events through a deep component hierarchy.
+//
+// A chain of nested layouts is built with an empty layout at the
+// bottom and a handler at the top, so that each event must pass through
+// every layout before it is handled.  The following cases are timed:
+// - cached: an event class which provides its own type index, so that
+//   layouts without a handler are skipped after the first post;
+// - uncached: an event class which does not provide a type index, so
+//   that every layout is tested by a dynamic cast;
+// - derived: a class derived from the cached event class, with its own
+//   handler but no type index of its own.  The handler for the derived
+//   class is placed next to the bottom of the chain, in a layout which
+//   has already been found not to handle the base class.  The result
+//   records whether it was called.
+
+#include <cstdlib>
+#include <vector>
+
+#include "rtk/desktop/component.h"
+#include "rtk/desktop/column_layout.h"
+#include "rtk/events/event.h"
+#include "rtk/bench/bench.h"
+
+namespace {
+
+using rtk::desktop::component;
+using rtk::desktop::column_layout;
+using rtk::events::event;
+using rtk::bench::stopwatch;
+using rtk::bench::result;
+
+/** The name of this benchmark suite. */
+const char* suite="dispatch";
+
+/** The total number of layouts to be passed through for each case. */
+const unsigned long visits=10000000;
+
+/** An event class which is cached. */
+class cached_event:
+	public event
+{
+public:
+	/** A mixin class for handling cached_event events. */
+	class handler
+	{
+	public:
+		/** Handle cached_event event.
+		 * @param ev the cached_event event to be handled
+		 */
+		virtual void handle_event(cached_event& ev)=0;
+	};
+
+	/** Construct cached_event event.
+	 * @param target the target of the event
+	 */
+	cached_event(component& target):
+		event(target)
+		{}
+protected:
+	virtual bool deliver(component& dest)
+	{
+		handler* h=dynamic_cast<handler*>(&dest);
+		if (h) h->handle_event(*this);
+		return h;
+	}
+
+	virtual unsigned int type_index() const
+	{
+		static unsigned int index=allocate_type_index(typeid(cached_event));
+		return index;
+	}
+};
+
+/** An event class which is not cached. */
+class uncached_event:
+	public event
+{
+public:
+	/** A mixin class for handling uncached_event events. */
+	class handler
+	{
+	public:
+		/** Handle uncached_event event.
+		 * @param ev the uncached_event event to be handled
+		 */
+		virtual void handle_event(uncached_event& ev)=0;
+	};
+
+	/** Construct uncached_event event.
+	 * @param target the target of the event
+	 */
+	uncached_event(component& target):
+		event(target)
+		{}
+protected:
+	virtual bool deliver(component& dest)
+	{
+		handler* h=dynamic_cast<handler*>(&dest);
+		if (h) h->handle_event(*this);
+		return h;
+	}
+};
+
+/** An event class derived from cached_event without a type index. */
+class derived_event:
+	public cached_event
+{
+public:
+	/** A mixin class for handling derived_event events. */
+	class handler
+	{
+	public:
+		/** Handle derived_event event.
+		 * @param ev the derived_event event to be handled
+		 */
+		virtual void handle_event(derived_event& ev)=0;
+	};
+
+	/** Construct derived_event event.
+	 * @param target the target of the event
+	 */
+	derived_event(component& target):
+		cached_event(target)
+		{}
+protected:
+	virtual bool deliver(component& dest)
+	{
+		handler* h=dynamic_cast<handler*>(&dest);
+		if (h) h->handle_event(*this);
+		return h;
+	}
+};
+
+/** A layout at the top of the chain, which handles the cached and
+ * uncached events. */
+class top_layout:
+	public column_layout,
+	public cached_event::handler,
+	public uncached_event::handler
+{
+public:
+	/** The number of events handled. */
+	unsigned long count;
+
+	/** Construct top layout. */
+	top_layout():
+		count(0)
+		{}
+
+	virtual void handle_event(cached_event& ev)
+		{ ++count; }
+
+	virtual void handle_event(uncached_event& ev)
+		{ ++count; }
+};
+
+/** A layout at the bottom of the chain, which handles the derived
+ * event. */
+class bottom_layout:
+	public column_layout,
+	public derived_event::handler
+{
+public:
+	/** The number of events handled. */
+	unsigned long count;
+
+	/** Construct bottom layout. */
+	bottom_layout():
+		count(0)
+		{}
+
+	virtual void handle_event(derived_event& ev)
+		{ ++count; }
+};
+
+/** Time the posting of an event.
+ * @param ev the event to be posted
+ * @param iterations the number of times to post it
+ * @return the time taken, in seconds
+ */
+double time_post(event& ev,unsigned long iterations)
+{
+	// Post once before starting the stopwatch, so that the cache
+	// (if any) is populated.
+	ev.post();
+	stopwatch sw;
+	for (unsigned long i=0;i!=iterations;++i) ev.post();
+	return sw.seconds();
+}
+
+/** Measure a chain of given depth.
+ * @param depth the number of layouts in the chain
+ * @return true if the derived event was delivered, otherwise false
+ */
+bool run_chain(unsigned int depth)
+{
+	// Build the chain from the top downwards.
+	top_layout* top=new top_layout;
+	std::vector<column_layout*> layouts;
+	layouts.push_back(top);
+	for (unsigned int i=2;i<depth;++i)
+	{
+		column_layout* layout=new column_layout;
+		layouts.back()->add(*layout);
+		layouts.push_back(layout);
+	}
+	bottom_layout* bottom=new bottom_layout;
+	layouts.back()->add(*bottom);
+	layouts.push_back(bottom);
+	column_layout* leaf=new column_layout;
+	bottom->add(*leaf);
+
+	unsigned long iterations=visits/depth;
+
+	cached_event cev(*leaf);
+	result(suite,"cached",depth,"post",iterations,
+		time_post(cev,iterations)).write();
+
+	uncached_event uev(*leaf);
+	result(suite,"uncached",depth,"post",iterations,
+		time_post(uev,iterations)).write();
+
+	derived_event dev(*leaf);
+	bottom->count=0;
+	double seconds=time_post(dev,iterations);
+	bool delivered=(bottom->count==iterations+1);
+	result(suite,"derived",depth,"post",iterations,seconds).
+		field("delivered",static_cast<unsigned long>(delivered)).write();
+
+	// Destroy the chain from the bottom upwards.
+	delete leaf;
+	while (!layouts.empty())
+	{
+		delete layouts.back();
+		layouts.pop_back();
+	}
+	return delivered;
+}
+
+} /* anonymous namespace */
+
+int main(int argc,char** argv)
+{
+	bool ok=true;
+	for (unsigned int depth=10;depth<=1000;depth*=10)
+		ok&=run_chain(depth);
+	return (ok)?EXIT_SUCCESS:EXIT_FAILURE;
+}
@@ -0,0 +1,226 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+// Measure the cost of mapping Wimp handles to components at a high
+// event rate.
+//
+// The first part compares util::handle_table with std::map (which it
+// replaced) for tables of between 16 and 65536 word-aligned handles:
+// - lookup: finding a random handle which is present;
+// - miss: finding a random handle which is not present;
+// - churn: erasing a random handle and inserting a new one, as happens
+//   when windows and menus are opened and closed.
+//
+// The second part runs an application with between 10 and 1000 open
+// windows on a simulated machine, and posts a long sequence of
+// Pointer_Entering_Window events to randomly chosen windows.  Each
+// event is dispatched through the window handle table.
+
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+#include "rtk/util/handle_table.h"
+#include "rtk/desktop/application.h"
+#include "rtk/desktop/window.h"
+#include "rtk/host/system.h"
+#include "rtk/host/runtime.h"
+#include "rtk/bench/bench.h"
+
+namespace {
+
+using rtk::graphics::point;
+using rtk::util::handle_table;
+using rtk::desktop::application;
+using rtk::desktop::window;
+using rtk::host::script;
+using rtk::bench::stopwatch;
+using rtk::bench::result;
+using rtk::bench::random_sequence;
+
+/** The name of this benchmark suite. */
+const char* suite="handle";
+
+/** The number of operations performed on each table. */
+const unsigned long operations=1000000;
+
+/** The number of events posted to each application. */
+const unsigned long events=100000;
+
+/** Make handle.
+ * Handles are word-aligned, as RISC OS window handles typically are.
+ * @param index the index of the handle
+ * @return the handle
+ */
+inline int make_handle(unsigned int index)
+{
+	return 0x8000+index*0x40;
+}
+
+/** An adapter which gives std::map the interface of handle_table. */
+class map_table
+{
+private:
+	/** The underlying map. */
+	std::map<int,int> _map;
+public:
+	const int* find(int key) const
+	{
+		std::map<int,int>::const_iterator f=_map.find(key);
+		return (f!=_map.end())?&(*f).second:0;
+	}
+
+	void insert(int key,int value)
+		{ _map[key]=value; }
+
+	bool erase(int key)
+		{ return _map.erase(key); }
+};
+
+/** Measure one type of table.
+ * @param subject the name of the table type
+ * @param size the number of entries
+ * @return true if the expected number of entries were found,
+ *  otherwise false
+ */
+template<class table_type>
+bool run_table(const char* subject,unsigned int size)
+{
+	// Present handles have an even index, absent ones an odd index.
+	table_type table;
+	std::vector<int> present;
+	for (unsigned int i=0;i!=size;++i)
+	{
+		int handle=make_handle(i*2);
+		table.insert(handle,i);
+		present.push_back(handle);
+	}
+
+	random_sequence lookup_random;
+	unsigned long found=0;
+	stopwatch sw;
+	for (unsigned long i=0;i!=operations;++i)
+	{
+		if (table.find(present[lookup_random(size)])) ++found;
+	}
+	result(suite,subject,size,"lookup",operations,sw.seconds()).write();
+
+	random_sequence miss_random;
+	unsigned long missed=0;
+	sw.restart();
+	for (unsigned long i=0;i!=operations;++i)
+	{
+		if (!table.find(make_handle(miss_random(size)*2+1))) ++missed;
+	}
+	result(suite,subject,size,"miss",operations,sw.seconds()).write();
+
+	// Each churn operation replaces a random handle with one which has
+	// not been used before, so that the table does not settle into a
+	// fixed arrangement.
+	random_sequence churn_random;
+	unsigned int next=size*2;
+	sw.restart();
+	for (unsigned long i=0;i!=operations;++i)
+	{
+		unsigned int index=churn_random(size);
+		table.erase(present[index]);
+		present[index]=make_handle(next);
+		table.insert(present[index],index);
+		next+=2;
+	}
+	result(suite,subject,size,"churn",operations,sw.seconds()).write();
+
+	return (found==operations)&&(missed==operations);
+}
+
+/** The windows to which events are posted. */
+std::vector<window*> loop_windows;
+
+/** The stopwatch used to time the event loop. */
+stopwatch loop_stopwatch;
+
+/** The time taken by the event loop, in seconds. */
+double loop_seconds=0;
+
+/** Stop timing the event loop.
+ * @param handle unused
+ */
+void stop_loop(void* handle)
+{
+	loop_seconds=loop_stopwatch.seconds();
+}
+
+/** Add events to script, then start timing the event loop.
+ * This is called from within the event loop, because the windows
+ * are not created (and their handles are not known) until it has
+ * started.
+ * @param handle unused
+ */
+void start_loop(void* handle)
+{
+	script& s=rtk::host::system::current().events();
+	rtk::os::wimp_block wimpblock;
+	random_sequence random;
+	for (unsigned long i=0;i!=events;++i)
+	{
+		wimpblock.word[0]=
+			loop_windows[random(loop_windows.size())]->handle();
+		s.post(5,wimpblock);
+	}
+	s.at_end(stop_loop);
+	loop_stopwatch.restart();
+}
+
+
+/** Measure an application with a given number of windows.
+ * @param count the number of windows
+ * @return true if the event loop ran to completion, otherwise false
+ */
+bool run_application(unsigned int count)
+{
+	rtk::host::system machine;
+	application app("handle_bench");
+	for (unsigned int i=0;i!=count;++i)
+	{
+		window* w=new window;
+		app.add(*w,point(i%64*16,1024+i%64*16));
+		loop_windows.push_back(w);
+	}
+
+	script& s=machine.events();
+	s.call(start_loop);
+	loop_seconds=0;
+	app.run();
+	result(suite,"application",count,"event",events,loop_seconds).
+		field("polls",static_cast<unsigned long>(s.polls())).write();
+
+	for (std::vector<window*>::iterator i=loop_windows.begin();
+		i!=loop_windows.end();++i)
+	{
+		delete *i;
+	}
+	loop_windows.clear();
+	return s.polls()>events;
+}
+
+int body(int argc,char** argv)
+{
+	bool ok=true;
+	for (unsigned int size=16;size<=65536;size*=16)
+	{
+		ok&=run_table<handle_table<int,int> >("handle_table",size);
+		ok&=run_table<map_table>("std::map",size);
+	}
+	for (unsigned int count=10;count<=1000;count*=10)
+		ok&=run_application(count);
+	return (ok)?EXIT_SUCCESS:EXIT_FAILURE;
+}
+
+} /* anonymous namespace */
+
+int main(int argc,char** argv)
+{
+	return rtk::host::run(body,argc,argv);
+}
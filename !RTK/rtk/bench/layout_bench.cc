@@ -0,0 +1,550 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+// Measure the cost of laying out and redrawing large component trees.
+//
+// For each type of layout, a synthetic tree is built with between 10^3
+// and 10^6 leaf components (up to the limit given on the command line).
+// The following operations are timed:
+// - resize: the first call to resize() after the tree is built;
+// - reformat: the first call to reformat() after the tree is resized;
+// - relayout: resize() and reformat() after one leaf is invalidated;
+// - find: locating the leaf at a random point, by repeated calls to
+//   find() (or for a text area, searching for a string);
+// - redraw: redrawing a screen-sized clip box at the centre of the tree,
+//   through a counting graphics context.
+//
+// The trees are not attached to an application, so no Wimp windows or
+// icons are created.  A simulated machine is installed so that text
+// areas can measure text.
+//
+// Each tree is built and measured in a child process, which exits
+// without destroying it.  Removing the children of a layout one at a
+// time takes time proportional to the square of their number, and
+// would otherwise dominate the run time for the larger trees.
+
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "rtk/graphics/counting_gcontext.h"
+#include "rtk/desktop/component.h"
+#include "rtk/desktop/grid_layout.h"
+#include "rtk/desktop/column_layout.h"
+#include "rtk/desktop/row_layout.h"
+#include "rtk/desktop/toolbar_layout.h"
+#include "rtk/desktop/card_layout.h"
+#include "rtk/desktop/window.h"
+#include "rtk/desktop/text_area.h"
+#include "rtk/host/system.h"
+#include "rtk/host/runtime.h"
+#include "rtk/bench/bench.h"
+
+namespace {
+
+using std::string;
+using rtk::graphics::point;
+using rtk::graphics::box;
+using rtk::graphics::gcontext;
+using rtk::graphics::counting_gcontext;
+using rtk::desktop::component;
+using rtk::bench::stopwatch;
+using rtk::bench::result;
+using rtk::bench::random_sequence;
+
+/** The name of this benchmark suite. */
+const char* suite="layout";
+
+/** The width to which text areas are formatted, in OS units. */
+const int wrap_width=1280;
+
+/** The size of the clip box used for redraw, in OS units. */
+const point screen_size(2560,2048);
+
+/** The number of times that each repeatable operation is performed. */
+const unsigned int repeats=20;
+
+/** The number of points located by the find operation. */
+const unsigned int finds=10000;
+
+/** A class to represent a leaf of a synthetic component tree.
+ * It has a fixed minimum size, and draws a filled rectangle.
+ */
+class cell:
+	public component
+{
+private:
+	/** The class from which this one is derived. */
+	typedef component inherited;
+
+	/** The minimum bounding box. */
+	box _min_bbox;
+
+	/** The actual bounding box. */
+	box _bbox;
+public:
+	/** Construct cell.
+	 * @param size the minimum size
+	 */
+	cell(const point& size=point(64,32)):
+		_min_bbox(0,-size.y(),size.x(),0)
+		{}
+
+	virtual box bbox() const
+		{ return _bbox; }
+
+	virtual box min_bbox() const
+		{ return _min_bbox; }
+
+	virtual void reformat(const point& origin,const box& pbbox)
+	{
+		_bbox=pbbox;
+		inherited::reformat(origin,pbbox);
+	}
+
+	virtual void redraw(gcontext& context,const box& clip)
+	{
+		context.plot(4,point(_bbox.xmin(),_bbox.ymin()));
+		context.plot(101,point(_bbox.xmax()-1,_bbox.ymax()-1));
+		inherited::redraw(context,clip);
+	}
+};
+
+/** A class to represent a synthetic component tree. */
+class tree
+{
+public:
+	/** Destroy tree. */
+	virtual ~tree()
+		{}
+
+	/** Get name of tree.
+	 * @return the name of the layout class being measured
+	 */
+	virtual const char* name() const=0;
+
+	/** Get root of tree.
+	 * @return the root component
+	 */
+	virtual component& root()=0;
+
+	/** Get leaf to be invalidated.
+	 * @return a leaf component near the middle of the tree,
+	 *  or 0 if none
+	 */
+	virtual component* middle()=0;
+
+	/** Get number of nodes.
+	 * @return the number of components in the tree
+	 */
+	virtual unsigned long nodes() const=0;
+
+	/** Get bounding box for reformat.
+	 * @return the bounding box to be passed to reformat()
+	 */
+	virtual box pbbox()
+		{ return root().min_bbox(); }
+};
+
+/** A tree consisting of a layout with a given number of leaves. */
+template<class layout_type>
+class leaf_tree:
+	public tree
+{
+protected:
+	/** The root of the tree. */
+	layout_type _layout;
+
+	/** The leaves of the tree. */
+	cell* _cells;
+
+	/** The number of leaves. */
+	unsigned long _count;
+public:
+	/** Construct tree.
+	 * @param count the number of leaves
+	 */
+	explicit leaf_tree(unsigned long count):
+		_cells(new cell[count]),
+		_count(count)
+		{}
+
+	/** Destroy tree. */
+	virtual ~leaf_tree()
+		{ delete[] _cells; }
+
+	virtual component& root()
+		{ return _layout; }
+
+	virtual component* middle()
+		{ return (_count)?&_cells[_count/2]:0; }
+
+	virtual unsigned long nodes() const
+		{ return _count+1; }
+};
+
+/** A square grid of cells. */
+class grid_tree:
+	public leaf_tree<rtk::desktop::grid_layout>
+{
+public:
+	explicit grid_tree(unsigned long count):
+		leaf_tree<rtk::desktop::grid_layout>(side(count)*side(count))
+	{
+		unsigned int n=side(count);
+		_layout.cells(n,n);
+		for (unsigned int y=0;y!=n;++y)
+			for (unsigned int x=0;x!=n;++x)
+				_layout.add(_cells[y*n+x],x,y);
+	}
+
+	virtual const char* name() const
+		{ return "grid_layout"; }
+private:
+	/** Get side of square grid.
+	 * @param count the required number of cells
+	 * @return the number of cells along each side
+	 */
+	static unsigned int side(unsigned long count)
+	{
+		unsigned int n=1;
+		while ((unsigned long)(n+1)*(n+1)<=count) ++n;
+		return n;
+	}
+};
+
+/** A single column of cells. */
+class column_tree:
+	public leaf_tree<rtk::desktop::column_layout>
+{
+public:
+	explicit column_tree(unsigned long count):
+		leaf_tree<rtk::desktop::column_layout>(count)
+	{
+		for (unsigned long i=0;i!=count;++i) _layout.add(_cells[i]);
+	}
+
+	virtual const char* name() const
+		{ return "column_layout"; }
+};
+
+/** A single row of cells. */
+class row_tree:
+	public leaf_tree<rtk::desktop::row_layout>
+{
+public:
+	explicit row_tree(unsigned long count):
+		leaf_tree<rtk::desktop::row_layout>(count)
+	{
+		for (unsigned long i=0;i!=count;++i) _layout.add(_cells[i]);
+	}
+
+	virtual const char* name() const
+		{ return "row_layout"; }
+};
+
+/** A toolbar layout within a window.
+ * The work area is a column of rows, each of ten cells.  There is one
+ * toolbar, which is a row of ten cells.  The toolbar layout is measured
+ * as the root of the tree, but must have a window as its parent.
+ */
+class toolbar_tree:
+	public tree
+{
+private:
+	/** The number of cells in each row. */
+	static const unsigned int row_length=10;
+
+	/** The root of the tree. */
+	rtk::desktop::window _window;
+
+	/** The toolbar layout. */
+	rtk::desktop::toolbar_layout _layout;
+
+	/** The work area. */
+	rtk::desktop::column_layout _column;
+
+	/** The rows of the work area. */
+	rtk::desktop::row_layout* _rows;
+
+	/** The number of rows. */
+	unsigned long _row_count;
+
+	/** The toolbar. */
+	rtk::desktop::window _toolbar;
+
+	/** The row of cells within the toolbar. */
+	rtk::desktop::row_layout _buttons;
+
+	/** The cells (in the work area, then in the toolbar). */
+	cell* _cells;
+
+	/** The number of cells. */
+	unsigned long _count;
+public:
+	explicit toolbar_tree(unsigned long count):
+		_rows(new rtk::desktop::row_layout[count/row_length]),
+		_row_count(count/row_length),
+		_cells(new cell[_row_count*row_length+row_length]),
+		_count(_row_count*row_length+row_length)
+	{
+		for (unsigned long y=0;y!=_row_count;++y)
+		{
+			for (unsigned int x=0;x!=row_length;++x)
+				_rows[y].add(_cells[y*row_length+x]);
+			_column.add(_rows[y]);
+		}
+		for (unsigned int x=0;x!=row_length;++x)
+			_buttons.add(_cells[_row_count*row_length+x]);
+		_toolbar.add(_buttons);
+		_layout.add(_column);
+		_layout.add_toolbar(_toolbar);
+		_window.add(_layout);
+	}
+
+	/** Destroy tree. */
+	virtual ~toolbar_tree()
+	{
+		delete[] _cells;
+		delete[] _rows;
+	}
+
+	virtual const char* name() const
+		{ return "toolbar_layout"; }
+
+	virtual component& root()
+		{ return _layout; }
+
+	virtual component* middle()
+		{ return &_cells[_count/2]; }
+
+	virtual unsigned long nodes() const
+		{ return _count+_row_count+5; }
+};
+
+/** A deck of cards, each of which is a cell.
+ * The middle card is selected.
+ */
+class card_tree:
+	public leaf_tree<rtk::desktop::card_layout>
+{
+public:
+	explicit card_tree(unsigned long count):
+		leaf_tree<rtk::desktop::card_layout>(count)
+	{
+		for (unsigned long i=0;i!=count;++i)
+			_layout.add(_cells[i],tag(i));
+		_layout.select(tag(count/2));
+	}
+
+	virtual const char* name() const
+		{ return "card_layout"; }
+private:
+	/** Make tag for card.
+	 * @param i the index of the card
+	 * @return the tag
+	 */
+	static string tag(unsigned long i)
+	{
+		// Large enough for a 64-bit unsigned long and terminator.
+		char buffer[24];
+		std::sprintf(buffer,"%lu",i);
+		return buffer;
+	}
+};
+
+/** A text area containing one paragraph per node.
+ * Each paragraph is long enough to wrap once at the formatting width.
+ */
+class text_tree:
+	public tree
+{
+private:
+	/** The text area. */
+	rtk::desktop::text_area _area;
+
+	/** The number of paragraphs. */
+	unsigned long _count;
+public:
+	explicit text_tree(unsigned long count):
+		_count(count)
+	{
+		static const char* words[]={"the","quick","brown","fox",
+			"jumps","over","lazy","dog","and","runs","away"};
+		random_sequence rand;
+		rtk::desktop::text_area::text_type text;
+		for (unsigned long i=0;i!=count;++i)
+		{
+			string para;
+			while (para.length()<120)
+			{
+				if (para.length()) para+=' ';
+				para+=words[rand(sizeof(words)/sizeof(words[0]))];
+			}
+			if (i==count-1) para+=" needle";
+			text.push_back(para);
+		}
+		_area.text(text);
+	}
+
+	virtual const char* name() const
+		{ return "text_area"; }
+
+	virtual component& root()
+		{ return _area; }
+
+	virtual component* middle()
+		{ return 0; }
+
+	virtual unsigned long nodes() const
+		{ return _count; }
+
+	virtual box pbbox()
+		{ return _area.min_wrap_bbox(box(0,0,wrap_width,0)); }
+
+	/** Search for the string placed in the last paragraph.
+	 * @return true if it was found, otherwise false
+	 */
+	bool search() const
+	{
+		rtk::desktop::text_area::mark found=_area.begin();
+		return _area.find("needle",_area.begin(),found);
+	}
+};
+
+/** Locate leaf at point.
+ * @param root the root of the tree
+ * @param p the point, with respect to the root
+ * @return the deepest component containing the point
+ */
+component* locate(component& root,point p)
+{
+	component* target=&root;
+	while (component* child=target->find(p))
+	{
+		target=child;
+		p-=child->origin();
+	}
+	return target;
+}
+
+/** Measure tree.
+ * @param t the tree
+ * @param build_time the time taken to build the tree, in seconds
+ */
+void measure(tree& t,double build_time)
+{
+	component& root=t.root();
+	const char* name=t.name();
+	unsigned long nodes=t.nodes();
+	result(suite,name,nodes,"build",1,build_time).write();
+
+	// Initial resize and reformat.
+	stopwatch sw;
+	root.resize();
+	result(suite,name,nodes,"resize",1,sw.seconds()).write();
+
+	box pbbox=t.pbbox();
+	sw.restart();
+	root.reformat(point(),pbbox);
+	result(suite,name,nodes,"reformat",1,sw.seconds()).write();
+
+	// Resize and reformat after invalidating one leaf.
+	if (component* leaf=t.middle())
+	{
+		sw.restart();
+		for (unsigned int i=0;i!=repeats;++i)
+		{
+			leaf->invalidate();
+			root.resize();
+			root.reformat(point(),t.pbbox());
+		}
+		result(suite,name,nodes,"relayout",repeats,sw.seconds()).write();
+	}
+
+	// Find.
+	box bbox=root.bbox();
+	if (text_tree* tt=dynamic_cast<text_tree*>(&t))
+	{
+		unsigned long found=0;
+		sw.restart();
+		for (unsigned int i=0;i!=repeats;++i) found+=tt->search();
+		result(suite,name,nodes,"find",repeats,sw.seconds()).
+			field("found",found).write();
+	}
+	else if ((bbox.xsize()>0)&&(bbox.ysize()>0))
+	{
+		random_sequence rand;
+		unsigned long leaves=0;
+		sw.restart();
+		for (unsigned int i=0;i!=finds;++i)
+		{
+			point p(bbox.xmin()+rand(bbox.xsize()),
+				bbox.ymin()+rand(bbox.ysize()));
+			if (locate(root,p)!=&root) ++leaves;
+		}
+		result(suite,name,nodes,"find",finds,sw.seconds()).
+			field("leaves",leaves).write();
+	}
+
+	// Redraw a screen-sized area at the centre of the tree.
+	point centre((bbox.xmin()+bbox.xmax())/2,(bbox.ymin()+bbox.ymax())/2);
+	box clip(centre.x()-screen_size.x()/2,centre.y()-screen_size.y()/2,
+		centre.x()+screen_size.x()/2,centre.y()+screen_size.y()/2);
+	counting_gcontext context;
+	sw.restart();
+	for (unsigned int i=0;i!=repeats;++i) root.redraw(context,clip);
+	double redraw_time=sw.seconds();
+	result(suite,name,nodes,"redraw",repeats,redraw_time).
+		field("plots",(unsigned long)context.plots()/repeats).
+		field("draws",(unsigned long)context.draws()/repeats).
+		field("chars",(unsigned long)context.chars()/repeats).write();
+}
+
+/** Build and measure tree in a child process.
+ * @param count the number of leaves
+ * @return true if successful, otherwise false
+ */
+template<class tree_type>
+bool run_tree(unsigned long count)
+{
+	pid_t pid=fork();
+	if (pid==0)
+	{
+		stopwatch sw;
+		tree_type* t=new tree_type(count);
+		measure(*t,sw.seconds());
+		_exit(EXIT_SUCCESS);
+	}
+	int status=0;
+	if ((pid<0)||(waitpid(pid,&status,0)!=pid)) return false;
+	return WIFEXITED(status)&&(WEXITSTATUS(status)==EXIT_SUCCESS);
+}
+
+int body(int argc,char** argv)
+{
+	unsigned long limit=(argc>1)?std::strtoul(argv[1],0,10):1000000;
+	rtk::host::system machine;
+	bool ok=true;
+	for (unsigned long count=1000;count<=limit;count*=10)
+	{
+		ok&=run_tree<grid_tree>(count);
+		ok&=run_tree<column_tree>(count);
+		ok&=run_tree<row_tree>(count);
+		ok&=run_tree<toolbar_tree>(count);
+		ok&=run_tree<card_tree>(count);
+		ok&=run_tree<text_tree>(count);
+	}
+	return (ok)?EXIT_SUCCESS:EXIT_FAILURE;
+}
+
+} /* anonymous namespace */
+
+int main(int argc,char** argv)
+{
+	return rtk::host::run(body,argc,argv);
+}
@@ -15,8 +15,10 @@
 #include "rtk/desktop/basic_window.h"
 #include "rtk/desktop/menu.h"
 #include "rtk/desktop/application.h"
+#include "rtk/desktop/screen_metrics.h"
 #include "rtk/events/wimp.h"
 #include "rtk/events/null_reason.h"
+#include "rtk/events/timer.h"
 #include "rtk/events/user_drag_box.h"
 #include "rtk/events/message.h"
 #include "rtk/events/claim_entity.h"
@@ -27,10 +29,18 @@
 namespace rtk {
 namespace desktop {
 
+namespace {
+
+/** The maximum number of queued messages to send per polling interval. */
+const unsigned int message_batch=16;
+
+} /* anonymous namespace */
+
 application::application(const string& name):
 	_name(name),
 	_dbox(0),
 	_dbox_level(0),
+	_timer_serial(0),
 	_current_drag(0),
 	_drag_sprite(0),
 	_current_selection(0),
@@ -39,8 +49,12 @@ application::application(const string& name):
 	_current_save(0),
 	_wimp_mask(0),
 	_quit(false),
-	_defer_caret(0)
+	_defer_caret(0),
+	_layout_budget(0),
+	_layout_deadline(0),
+	_layout_pending(0)
 {
+	reset_message_statistics();
 	static int messages[]={0};
 	os::Wimp_Initialise(380,_name.c_str(),messages,0,&_handle);
 }
@@ -59,6 +73,17 @@ application::~application()
 	// Similarly for load and save operations.
 	if (_current_load) _current_load->remove();
 	if (_current_save) _current_save->remove();
+	// Release any unsent messages, then the message block pool.
+	while (_message_queue.size())
+	{
+		delete _message_queue.front().wimpblock;
+		_message_queue.pop();
+	}
+	for (std::vector<os::wimp_block*>::iterator i=_message_pool.begin();
+		i!=_message_pool.end();++i)
+	{
+		delete *i;
+	}
 }
 
 application* application::as_application()
@@ -70,24 +95,24 @@ box application::min_bbox() const
 {
 	// The bounding box of the application object is defined to be the
 	// bounding box of the desktop.
-	int xeigfactor=0;
-	int yeigfactor=0;
-	int xwindlimit=0;
-	int ywindlimit=0;
-	os::OS_ReadModeVariable(swi::XEigFactor,&xeigfactor);
-	os::OS_ReadModeVariable(swi::YEigFactor,&yeigfactor);
-	os::OS_ReadModeVariable(swi::XWindLimit,&xwindlimit);
-	os::OS_ReadModeVariable(swi::YWindLimit,&ywindlimit);
+	int xeigfactor=screen_metrics::xeigfactor();
+	int yeigfactor=screen_metrics::yeigfactor();
+	int xwindlimit=screen_metrics::xwindlimit();
+	int ywindlimit=screen_metrics::ywindlimit();
 	return box(0,0,(xwindlimit+1)<<xeigfactor,(ywindlimit+1)<<yeigfactor);
 }
 
 void application::resize() const
 {
-	// Resize child windows.
-	for (std::vector<basic_window*>::const_iterator i=_windows.begin();
-		i!=_windows.end();++i)
+	// Resize child windows.  (If a layout budget has been set then
+	// this is left to reformat(), so that it can be deferred.)
+	if (!_layout_budget)
 	{
-		if (!(*i)->size_valid()) (*i)->resize();
+		for (std::vector<basic_window*>::const_iterator
+			i=_windows.begin();i!=_windows.end();++i)
+		{
+			if (!(*i)->size_valid()) (*i)->resize();
+		}
 	}
 	// Resize child icons.
 	for (std::vector<icon*>::const_iterator i=_icons.begin();
@@ -112,33 +137,33 @@ void application::resize() const
 void application::reformat(const point& origin,const box& pbbox)
 {
 	inherited::reformat(origin,pbbox);
-	// Reformat child windows.
+	// Reformat child windows which are open.  Within each window,
+	// the visible area is reformatted first.  If the layout budget
+	// is used then the remainder is left for a later pass, in which
+	// case the window remains invalid.
+	size_type pending=0;
 	for (std::vector<basic_window*>::iterator i=_windows.begin();
 		i!=_windows.end();++i)
 	{
-		// If a window has an adjust icon or a scroll bar, the application
-		// object does not exercise any influence over its position or
-		// size.  (The values passed to reformat() are those returned by
-		// origin() and bbox().)
-
-		// If a window does not have an adjust icon or a scroll bar (for
-		// a given direction), its size is forced to match the minimum
-		// bounding box.
-		if (!(*i)->layout_valid())
+		if ((*i)->handle()&&!(*i)->layout_valid())
 		{
-			box cbbox=(*i)->bbox();
-			box mcbbox=(*i)->min_wrap_bbox(cbbox);
-			if (!(*i)->x_scroll_bar()&&!(*i)->adjust_icon())
-			{
-				cbbox.xmin(mcbbox.xmin());
-				cbbox.xmax(mcbbox.xmax());
-			}
-			if (!(*i)->y_scroll_bar()&&!(*i)->adjust_icon())
+			reformat_window(**i);
+			if (!(*i)->layout_valid()) ++pending;
+		}
+	}
+	// Reformat child windows which are not yet open.  These may be
+	// deferred entirely if the layout budget has been used.
+	for (std::vector<basic_window*>::iterator i=_windows.begin();
+		i!=_windows.end();++i)
+	{
+		if (!(*i)->handle()&&!(*i)->layout_valid())
+		{
+			if (layout_expired()) ++pending;
+			else
 			{
-				cbbox.ymin(mcbbox.ymin());
-				cbbox.ymax(mcbbox.ymax());
+				reformat_window(**i);
+				if (!(*i)->layout_valid()) ++pending;
 			}
-			(*i)->reformat((*i)->origin(),cbbox);
 		}
 	}
 	// Reformat child icons.
@@ -189,6 +214,50 @@ void application::reformat(const point& origin,const box& pbbox)
 			_dbox->reformat(cpos,mcbbox,_dbox_level);
 		}
 	}
+	// Report progress of budgeted layout.  If any windows were
+	// deferred (wholly or in part) then invalidate this component,
+	// so that layout resumes during the next pass through the
+	// polling loop.
+	if (pending||_layout_pending)
+	{
+		_layout_pending=pending;
+		layout_progress(pending);
+	}
+	if (pending) invalidate();
+}
+
+void application::reformat_window(basic_window& w)
+{
+	// If a window has an adjust icon or a scroll bar, the application
+	// object does not exercise any influence over its position or
+	// size.  (The values passed to reformat() are those returned by
+	// origin() and bbox().)
+
+	// If a window does not have an adjust icon or a scroll bar (for
+	// a given direction), its size is forced to match the minimum
+	// bounding box.
+	if (!w.size_valid()) w.resize();
+	box cbbox=w.bbox();
+	box mcbbox=w.min_wrap_bbox(cbbox);
+	if (!w.x_scroll_bar()&&!w.adjust_icon())
+	{
+		cbbox.xmin(mcbbox.xmin());
+		cbbox.xmax(mcbbox.xmax());
+	}
+	if (!w.y_scroll_bar()&&!w.adjust_icon())
+	{
+		cbbox.ymin(mcbbox.ymin());
+		cbbox.ymax(mcbbox.ymax());
+	}
+	w.reformat(w.origin(),cbbox);
+}
+
+bool application::layout_expired() const
+{
+	if (!_layout_budget) return false;
+	unsigned int now=0;
+	os::OS_ReadMonotonicTime(&now);
+	return static_cast<int>(now-_layout_deadline)>=0;
 }
 
 void application::remove_notify(component& c)
@@ -343,7 +412,15 @@ void application::run()
 	{
 		try
 		{
-			// Ensure layout valid before polling Wimp.
+			// Ensure layout valid before polling Wimp.  If a layout
+			// budget has been set then some windows may be deferred,
+			// in which case null events are requested below so that
+			// layout can continue promptly.
+			if (_layout_budget)
+			{
+				os::OS_ReadMonotonicTime(&_layout_deadline);
+				_layout_deadline+=_layout_budget;
+			}
 			if (!size_valid()) resize();
 			if (!layout_valid()) reformat(point(0,0),box(0,0,0,0));
 			// Set the caret position if it has been defered from
@@ -353,22 +430,36 @@ void application::run()
 				_defer_caret->set_caret_position(_caret_pos,_caret_height,_caret_index);
 				_defer_caret=0;
 			}
-			// Poll Wimp.
+			// Pass any deferred redraws to the Wimp.
+			for (std::vector<basic_window*>::iterator i=_damaged.begin();
+				i!=_damaged.end();++i)
+			{
+				(*i)->flush_redraw();
+			}
+			_damaged.clear();
+			// Poll Wimp.  If null events are not otherwise required
+			// but a timer is pending then use Wimp_PollIdle, so that
+			// a null event is returned once the earliest deadline
+			// has been reached.
 			rtk::graphics::vdu_gcontext::current(0);
 			static os::wimp_block wimpblock;
 			int wimpcode;
-			os::Wimp_Poll(_wimp_mask,wimpblock,0,&wimpcode);
-			// Act on returned event block.
-			deliver_wimp_block(wimpcode,wimpblock);
-			// Send up to one message from queue.
-			if (_message_queue.size())
+			unsigned int deadline;
+			unsigned int mask=_wimp_mask;
+			if (_layout_pending) mask&=~1;
+			if ((mask&1)&&next_timer(&deadline))
 			{
-				message msg=_message_queue.front();
-				_message_queue.pop();
-				os::Wimp_SendMessage(msg.wimpcode,*msg.wimpblock,
-					msg.whandle,msg.ihandle,0);
-				delete msg.wimpblock;
+				os::Wimp_PollIdle(mask&~1,wimpblock,deadline,0,
+					&wimpcode);
 			}
+			else
+			{
+				os::Wimp_Poll(mask,wimpblock,0,&wimpcode);
+			}
+			// Act on returned event block.
+			deliver_wimp_block(wimpcode,wimpblock);
+			// Send a batch of messages from queue.
+			send_queued_messages();
 		}
 		// Catch exceptions, display using Wimp_ReportError
 		// (extracting text from exception where suitable method known).
@@ -417,6 +508,9 @@ void application::deliver_wimp_block(int wimpcode,os::wimp_block& wimpblock)
 				found|=ev.post();
 			}
 			if (!found) _wimp_mask|=1;
+
+			// Post timer events for any timers which have expired.
+			deliver_timers();
 		}
 		break;
 	case 1:
@@ -576,6 +670,16 @@ void application::deliver_message(int wimpcode,os::wimp_block& wimpblock)
 			_menus[0]->deliver_wimp_block(wimpcode,wimpblock,
 				wimpblock.word+8,0);
 		break;
+	case swi::Message_ModeChange:
+	case swi::Message_PaletteChange:
+		{
+			// Discard cached screen metrics, then deliver as for
+			// any other message.
+			screen_metrics::invalidate();
+			events::message ev(*this,wimpcode,wimpblock);
+			ev.post();
+		}
+		break;
 	case swi::Message_MenusDeleted:
 		if (basic_window* w=find_window(wimpblock.word[5]))
 		{
@@ -631,17 +735,57 @@ void application::deliver_message_ack(int wimpcode,os::wimp_block& wimpblock)
 	}
 }
 
-void application::send_message(int wimpcode,os::wimp_block& wimpblock,
+void application::send_message(int wimpcode,const os::wimp_block& wimpblock,
 	int whandle,int ihandle)
 {
+	// Take a block from the pool, allocating a new one if the
+	// pool is empty.
+	os::wimp_block* block=0;
+	if (_message_pool.size())
+	{
+		block=_message_pool.back();
+		_message_pool.pop_back();
+	}
+	else
+	{
+		block=new os::wimp_block;
+		++_message_stats.allocated;
+	}
+	*block=wimpblock;
+
+	// Queue the message.
 	message msg;
 	msg.wimpcode=wimpcode;
-	msg.wimpblock=&wimpblock;
+	msg.wimpblock=block;
 	msg.whandle=whandle;
 	msg.ihandle=ihandle;
+	msg.queued=0;
+	os::OS_ReadMonotonicTime(&msg.queued);
 	_message_queue.push(msg);
+
+	// Update statistics.
+	if (_message_queue.size()>_message_stats.max_depth)
+		_message_stats.max_depth=_message_queue.size();
+}
+
+void application::reset_message_statistics()
+{
+	_message_stats.sent=0;
+	_message_stats.max_depth=_message_queue.size();
+	_message_stats.total_wait=0;
+	_message_stats.max_wait=0;
+	_message_stats.allocated=_message_pool.size()+_message_queue.size();
+}
+
+application& application::layout_budget(unsigned int budget)
+{
+	_layout_budget=budget;
+	return *this;
 }
 
+void application::layout_progress(size_type pending)
+{}
+
 transfer::basic_load* application::auto_load(unsigned int filetype)
 {
 	return 0;
@@ -726,12 +870,17 @@ void application::handle_event(events::reopen_menu &ev)
 
 void application::register_window(basic_window& w)
 {
-	_whandles[w.handle()]=&w;
+	_whandles.insert(w.handle(),&w);
+}
+
+void application::register_damage(basic_window& w)
+{
+	_damaged.push_back(&w);
 }
 
 void application::register_icon(icon& ic)
 {
-	_ihandles[ic.handle()]=&ic;
+	_ihandles.insert(ic.handle(),&ic);
 }
 
 void application::register_menu_data(util::refcount* mdata,unsigned int level)
@@ -744,13 +893,38 @@ void application::register_menu_data(util::refcount* mdata,unsigned int level)
 
 void application::register_null(component& c)
 {
-	std::vector<component*>::iterator f=
-		std::find(_null.begin(),_null.end(),&c);
-	if (f==_null.end()) _null.push_back(&c);
+	if (!_null_index.find(&c))
+	{
+		_null_index.insert(&c,_null.size());
+		_null.push_back(&c);
+	}
 	_wimp_mask&=~1;
 	_null_loopvalid=false;
 }
 
+void application::register_timer(component& c,unsigned int delay,
+	unsigned int interval)
+{
+	unsigned int now=0;
+	os::OS_ReadMonotonicTime(&now);
+
+	// Record the registration, replacing any existing one.
+	// (A previous heap entry becomes stale because the serial
+	// number no longer matches.)
+	timer_info& info=_timers[&c];
+	info.deadline=now+delay;
+	info.interval=interval;
+	info.serial=++_timer_serial;
+
+	// Add an entry to the heap.
+	timer_entry entry;
+	entry.deadline=info.deadline;
+	entry.serial=info.serial;
+	entry.target=&c;
+	_timer_heap.push_back(entry);
+	std::push_heap(_timer_heap.begin(),_timer_heap.end());
+}
+
 void application::register_drag(component& c,bool sprite)
 {
 	_current_drag=&c;
@@ -773,6 +947,8 @@ void application::deregister_window(basic_window& w)
 	{
 		os::Wimp_CreateMenu(-1,point());
 	}
+	_damaged.erase(std::remove(_damaged.begin(),_damaged.end(),&w),
+		_damaged.end());
 	_whandles.erase(w.handle());
 }
 
@@ -783,12 +959,25 @@ void application::deregister_icon(icon& ic)
 
 void application::deregister_null(component& c)
 {
-	std::vector<component*>::iterator f=
-		std::find(_null.begin(),_null.end(),&c);
-	if (f!=_null.end()) _null.erase(f);
+	if (const size_type* f=_null_index.find(&c))
+	{
+		// Move the last element into the vacated position.
+		size_type index=*f;
+		component* last=_null.back();
+		_null[index]=last;
+		_null_index.insert(last,index);
+		_null.pop_back();
+		_null_index.erase(&c);
+	}
 	_null_loopvalid=false;
 }
 
+void application::deregister_timer(component& c)
+{
+	// The heap entry is left in place, but becomes stale.
+	_timers.erase(&c);
+}
+
 void application::deregister_drag(component& c)
 {
 	if (_current_drag==&c) _current_drag=0;
@@ -807,14 +996,14 @@ void application::deregister_clipboard(component& c)
 
 basic_window* application::find_window(int handle) const
 {
-	std::map<int,basic_window*>::const_iterator f=_whandles.find(handle);
-	return (f!=_whandles.end())?(*f).second:0;
+	basic_window* const* f=_whandles.find(handle);
+	return (f)?*f:0;
 }
 
 icon* application::find_icon(int handle) const
 {
-	std::map<int,icon*>::const_iterator f=_ihandles.find(handle);
-	return (f!=_ihandles.end())?(*f).second:0;
+	icon* const* f=_ihandles.find(handle);
+	return (f)?*f:0;
 }
 
 menu* application::find_menu(int handle) const
@@ -845,6 +1034,100 @@ void application::remove_menu_data(size_type level)
 	}
 }
 
+bool application::next_timer(unsigned int* _deadline)
+{
+	// Discard stale entries from the front of the heap.
+	while (_timer_heap.size())
+	{
+		const timer_entry& entry=_timer_heap.front();
+		std::map<component*,timer_info>::const_iterator f=
+			_timers.find(entry.target);
+		if ((f!=_timers.end())&&((*f).second.serial==entry.serial))
+		{
+			if (_deadline) *_deadline=entry.deadline;
+			return true;
+		}
+		std::pop_heap(_timer_heap.begin(),_timer_heap.end());
+		_timer_heap.pop_back();
+	}
+	return false;
+}
+
+void application::deliver_timers()
+{
+	unsigned int now=0;
+	os::OS_ReadMonotonicTime(&now);
+
+	// Remove expired entries from the heap before posting any events,
+	// so that a handler which reregisters its timer with a delay of
+	// zero cannot cause this loop to repeat indefinitely.
+	std::vector<timer_entry> expired;
+	unsigned int deadline;
+	while (next_timer(&deadline)&&(int(now-deadline)>=0))
+	{
+		timer_entry entry=_timer_heap.front();
+		std::pop_heap(_timer_heap.begin(),_timer_heap.end());
+		_timer_heap.pop_back();
+		expired.push_back(entry);
+
+		// Reschedule repeating timers.  If a repeating timer has
+		// fallen more than one interval behind then missed
+		// repetitions are skipped.
+		timer_info& info=_timers[entry.target];
+		if (info.interval)
+		{
+			info.deadline+=info.interval;
+			if (int(now-info.deadline)>=0) info.deadline=now+info.interval;
+			timer_entry next=entry;
+			next.deadline=info.deadline;
+			_timer_heap.push_back(next);
+			std::push_heap(_timer_heap.begin(),_timer_heap.end());
+		}
+	}
+
+	// Post timer events.  Each timer is checked immediately beforehand
+	// in case it has been deregistered or replaced by an earlier handler.
+	// One-shot timers are deregistered as they are posted.
+	for (std::vector<timer_entry>::iterator i=expired.begin();
+		i!=expired.end();++i)
+	{
+		std::map<component*,timer_info>::iterator f=
+			_timers.find((*i).target);
+		if ((f!=_timers.end())&&((*f).second.serial==(*i).serial))
+		{
+			if (!(*f).second.interval) _timers.erase(f);
+			events::timer ev(*(*i).target,(*i).deadline);
+			ev.post();
+		}
+	}
+}
+
+void application::send_queued_messages()
+{
+	if (!_message_queue.size()) return;
+	unsigned int now=0;
+	os::OS_ReadMonotonicTime(&now);
+
+	for (unsigned int n=0;(n!=message_batch)&&_message_queue.size();++n)
+	{
+		// Remove message from queue.  The block is returned to the
+		// pool before it is sent so that it cannot be lost if an
+		// exception is thrown, but it will not be reused until the
+		// next call to send_message().
+		message msg=_message_queue.front();
+		_message_queue.pop();
+		_message_pool.push_back(msg.wimpblock);
+		os::Wimp_SendMessage(msg.wimpcode,*msg.wimpblock,
+			msg.whandle,msg.ihandle,0);
+
+		// Update statistics.
+		unsigned int wait=now-msg.queued;
+		++_message_stats.sent;
+		_message_stats.total_wait+=wait;
+		if (wait>_message_stats.max_wait) _message_stats.max_wait=wait;
+	}
+}
+
 void application::defer_caret_position(component *c,point p,int height,int index)
 {
 	_defer_caret=c;
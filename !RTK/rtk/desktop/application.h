@@ -12,6 +12,7 @@
 #include <string>
 
 #include "rtk/util/refcount.h"
+#include "rtk/util/handle_table.h"
 #include "rtk/desktop/component.h"
 #include "rtk/events/quit.h"
 #include "rtk/events/datasave.h"
@@ -59,9 +60,9 @@ public:
 	typedef unsigned int size_type;
 private:
 	/** A structure to represent an outbound Wimp message.
-	 * Since this contains a pointer to (as opposed to a copy) of the
-	 * Wimp event block, the latter must remain valid for the lifetime
-	 * of this object. 
+	 * The Wimp event block is owned by the application object.  It is
+	 * taken from the message block pool when the message is queued,
+	 * and returned to the pool when the message is sent.
 	 */
 	struct message
 	{
@@ -73,6 +74,63 @@ private:
 		int whandle;
 		/** The icon handle to which the message should be sent. */
 		int ihandle;
+		/** The monotonic time at which the message was queued. */
+		unsigned int queued;
+	};
+public:
+	/** A structure to hold statistics for the outbound message queue.
+	 * Times are measured in centiseconds.
+	 */
+	struct message_stats
+	{
+		/** The number of messages sent. */
+		unsigned int sent;
+		/** The greatest number of messages queued at any one time. */
+		unsigned int max_depth;
+		/** The total time for which sent messages were queued. */
+		unsigned int total_wait;
+		/** The greatest time for which a sent message was queued. */
+		unsigned int max_wait;
+		/** The number of message blocks allocated for the pool. */
+		unsigned int allocated;
+	};
+private:
+
+	/** A structure to represent a registered timer. */
+	struct timer_info
+	{
+		/** The monotonic time at which the timer is next due to expire. */
+		unsigned int deadline;
+		/** The interval between repetitions, or 0 if not repeating. */
+		unsigned int interval;
+		/** The serial number of the registration. */
+		unsigned int serial;
+	};
+
+	/** A structure to represent an entry in the timer heap.
+	 * An entry is stale (and should be ignored) if the serial number
+	 * does not match that of the current registration for the target.
+	 */
+	struct timer_entry
+	{
+		/** The monotonic time at which the timer is due to expire. */
+		unsigned int deadline;
+		/** The serial number of the registration. */
+		unsigned int serial;
+		/** The component to which the timer event should be posted. */
+		component* target;
+
+		/** Compare deadlines.
+		 * The ordering is reversed, so that the standard heap
+		 * algorithms place the earliest deadline at the front.
+		 * Deadlines are compared modulo 2^32 to allow for wrap-around
+		 * of the monotonic clock.
+		 * @param that the entry with which to compare
+		 * @return true if this entry is due later than that one,
+		 *  otherwise false
+		 */
+		bool operator<(const timer_entry& that) const
+			{ return int(deadline-that.deadline)>0; }
 	};
 
 	/** The RISC OS task handle. */
@@ -81,17 +139,23 @@ private:
 	/** The task name. */
 	string _name;
 
-	/** A map from window handles to window components.
+	/** A table mapping window handles to window components.
 	 * All descendant windows that currently have a RISC OS window handle
 	 * are included.
 	 */
-	std::map<int,basic_window*> _whandles;
+	util::handle_table<int,basic_window*> _whandles;
 
-	/** A map from icon handles to icon components.
+	/** A table mapping icon handles to icon components.
 	 * Descendant icons are included if they are not descended from a
 	 * window and they currently have a RISC OS window handle.
 	 */
-	std::map<int,icon*> _ihandles;
+	util::handle_table<int,icon*> _ihandles;
+
+	/** A list of windows which may have deferred redraws pending.
+	 * These are the only windows which need to be visited before each
+	 * call to Wimp_Poll.  A window may be listed more than once.
+	 */
+	std::vector<basic_window*> _damaged;
 
 	/** A list of child windows.
 	 * Windows are listed if they are an immediate child of this
@@ -131,14 +195,33 @@ private:
 	 */
 	size_type _dbox_level;
 
-	/** A list of components which need to receive null events. */
+	/** A list of components which need to receive null events.
+	 * The order of this list is not significant.
+	 */
 	std::vector<component*> _null;
 
+	/** A table mapping components to their index within _null.
+	 * This allows registration and deregistration in O(1) time.
+	 */
+	util::handle_table<component*,size_type> _null_index;
+
 	/** A flag to indicate if the _null vector has been altered since
 	 *  the start of an iteration of the elements.
 	 */
 	bool _null_loopvalid;
 
+	/** A map from components to their registered timers. */
+	std::map<component*,timer_info> _timers;
+
+	/** A heap of pending timer deadlines.
+	 * This may contain stale entries, which are discarded when they
+	 * reach the front of the heap.
+	 */
+	std::vector<timer_entry> _timer_heap;
+
+	/** The serial number of the most recent timer registration. */
+	unsigned int _timer_serial;
+
 	/** The owner of the current drag action. */
 	component* _current_drag;
 
@@ -162,11 +245,17 @@ private:
 	/** The outbound message queue.
 	 * Messages are added to the back of the queue and taken from the
 	 * front.  Transmission occurs automatically once a message has
-	 * been put in the queue, but is limited to a maximum of one
-	 * message per polling interval
+	 * been put in the queue.  The queue is drained in batches, the
+	 * number of messages sent per polling interval being limited.
 	 */
 	std::queue<message> _message_queue;
 
+	/** The pool of unused message blocks. */
+	std::vector<os::wimp_block*> _message_pool;
+
+	/** The outbound message queue statistics. */
+	message_stats _message_stats;
+
 	/** The mask passed to Wimp_Poll. */
 	unsigned int _wimp_mask;
 
@@ -187,6 +276,19 @@ private:
 
 	/** The index of the defered caret */
 	int _caret_index;
+
+	/** The layout time budget, in centiseconds, or 0 if unlimited. */
+	unsigned int _layout_budget;
+
+	/** The monotonic time at which the current layout pass should end.
+	 * This is meaningful only when _layout_budget is non-zero.
+	 */
+	unsigned int _layout_deadline;
+
+	/** The number of windows for which layout was deferred (wholly
+	 * or in part) during the most recent layout pass.
+	 */
+	size_type _layout_pending;
 public:
 
 	/** Construct application.
@@ -328,8 +430,9 @@ public:
 	void deliver_message_ack(int wimpcode,os::wimp_block& wimpblock);
 
 	/** Send Wimp message.
-	 * The event block must be dynamically allocated on the heap.
-	 * It is automatically deleted once the message has been sent.
+	 * The message is queued for transmission when control next returns
+	 * to the main polling loop.  The event block is copied, so need not
+	 * remain valid once this function has returned.
 	 * @param wimpcode the Wimp event code
 	 * @param wimpblock the Wimp event block
 	 * @param whandle the window or task handle to which the message
@@ -337,8 +440,71 @@ public:
 	 * @param ihandle the icon handle to which the message should be
 	 *  send (if whandle==-2)
 	 */
-	void send_message(int wimpcode,os::wimp_block& wimpblock,int whandle,
-		int ihandle=0);
+	void send_message(int wimpcode,const os::wimp_block& wimpblock,
+		int whandle,int ihandle=0);
+
+	/** Get number of queued messages.
+	 * @return the number of messages waiting to be sent
+	 */
+	size_type message_queue_size() const
+		{ return _message_queue.size(); }
+
+	/** Get outbound message queue statistics.
+	 * @return the statistics
+	 */
+	const message_stats& message_statistics() const
+		{ return _message_stats; }
+
+	/** Reset outbound message queue statistics. */
+	void reset_message_statistics();
+
+	/** Get layout time budget.
+	 * @return the layout time budget, in centiseconds, or 0 if unlimited
+	 */
+	unsigned int layout_budget() const
+		{ return _layout_budget; }
+
+	/** Set layout time budget.
+	 * By default, the layout of every invalid window is brought up to
+	 * date before each call to Wimp_Poll.  If a budget is set then
+	 * open windows are laid out first, and within each window the
+	 * children of grid, column and row layouts which overlap the
+	 * visible area are reformatted before those which do not.  Once
+	 * the budget has been used, children outside the visible area
+	 * and windows which are not yet open are left for later passes
+	 * through the polling loop (during which null events are
+	 * requested).  The visible area of open windows, menus, dialogue
+	 * boxes and icon bar icons are always laid out in full, so that
+	 * the user never sees an inconsistent layout.
+	 * @param budget the required budget, in centiseconds, or 0 for
+	 *  no limit
+	 * @return a reference to this
+	 */
+	application& layout_budget(unsigned int budget);
+
+	/** Get number of windows awaiting layout.
+	 * @return the number of windows for which layout was deferred
+	 *  (wholly or in part) during the most recent layout pass
+	 */
+	size_type layout_pending() const
+		{ return _layout_pending; }
+
+	/** Determine whether the layout budget has been used.
+	 * This may be called by components during a layout pass, in order
+	 * to decide whether to leave some of their content for a later pass.
+	 * @return true if a budget has been set and the deadline for the
+	 *  current layout pass has been reached, otherwise false
+	 */
+	bool layout_expired() const;
+
+	/** Notify progress of budgeted layout.
+	 * This function is called at the end of any layout pass in which
+	 * one or more windows were deferred (wholly or in part), and at the
+	 * end of the first pass thereafter in which none were.  By default
+	 * it does nothing.
+	 * @param pending the number of windows still awaiting layout
+	 */
+	virtual void layout_progress(size_type pending);
 
 	/** Get load operation for filetype.
 	 * The default behaviour is not to handle any filetype,
@@ -367,6 +533,13 @@ public:
 	 */
 	void register_window(basic_window& w);
 
+	/** Register window with deferred redraws.
+	 * The window must be registered.  Any redraws deferred by it
+	 * are passed to the Wimp before the next call to Wimp_Poll.
+	 * @param w the window to be registered
+	 */
+	void register_damage(basic_window& w);
+
 	/** Register icon.
 	 * An icon should be registered while it has a Wimp icon handle in
 	 * its possession.  This allows it to receive events from the Wimp.
@@ -395,6 +568,23 @@ public:
 	 */
 	void register_null(component& c);
 
+	/** Register timer.
+	 * Once the given delay has elapsed, a timer event is posted to
+	 * the component.  If an interval is given then further timer events
+	 * are posted at that interval until the timer is deregistered.
+	 * Any existing timer for the component is replaced.
+	 *
+	 * Unlike null actions, timers do not require the application to
+	 * busy-wait: the Wimp is polled using Wimp_PollIdle, so that null
+	 * events are not returned until the earliest deadline.
+	 * @param c the component to be registered to receive timer events
+	 * @param delay the delay before the first timer event, in centiseconds
+	 * @param interval the interval between subsequent timer events,
+	 *  in centiseconds, or 0 for a one-shot timer
+	 */
+	void register_timer(component& c,unsigned int delay,
+		unsigned int interval=0);
+
 	/** Register drag action.
 	 * @param c the component to be registered as the owner of the
 	 *  current drag action
@@ -432,6 +622,11 @@ public:
 	 */
 	void deregister_null(component& c);
 
+	/** Deregister timer.
+	 * @param c the component to be deregistered
+	 */
+	void deregister_timer(component& c);
+
 	/** Deregister drag action.
 	 * @param c the component to be deregistered
 	 */
@@ -484,6 +679,27 @@ private:
 	 */
 	void remove_menu_data(size_type level);
 
+	/** Send a batch of messages from the outbound message queue. */
+	void send_queued_messages();
+
+	/** Reformat child window.
+	 * The window is resized first if necessary.
+	 * @param w the window to be reformatted
+	 */
+	void reformat_window(basic_window& w);
+
+	/** Find earliest timer deadline.
+	 * Stale entries are discarded from the front of the timer heap.
+	 * @param _deadline a buffer for the returned deadline
+	 * @return true if there is a pending timer, otherwise false
+	 */
+	bool next_timer(unsigned int* _deadline);
+
+	/** Post timer events for any timers which have expired.
+	 * Repeating timers are rescheduled, others are deregistered.
+	 */
+	void deliver_timers();
+
 public:
 	/** Defer setting the caret position to just before the next Wimp_Poll.
 	 * @internal
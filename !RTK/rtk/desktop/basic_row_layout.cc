@@ -20,6 +20,8 @@ using rtk::util::divider;
 basic_row_layout::basic_row_layout(size_type xcells):
 	_components(xcells,0),
 	_xmin(xcells+1,0),
+	_pbboxes(xcells),
+	_abbox_valid(false),
 	_xgap(0)
 {}
 
@@ -39,6 +41,7 @@ component* basic_row_layout::find(const point& p) const
 		lower_bound(_xmin.begin(),_xmin.end(),p.x()+1,std::less<int>());
 	if (xf==_xmin.begin()) return 0;
 	size_type x=(xf-_xmin.begin())-1;
+	if (x>=_components.size()) return 0;
 	component* c=_components[x];
 	if (!c) return 0;
 	box cbbox=c->bbox()+c->origin();
@@ -53,10 +56,13 @@ box basic_row_layout::bbox() const
 
 void basic_row_layout::resize() const
 {
+	// Resize only those children for which the size is invalid.
+	_abbox_valid=false;
 	for (std::vector<component*>::const_iterator i=_components.begin();
 		i!=_components.end();++i)
 	{
-		if (component* c=*i) c->resize();
+		component* c=*i;
+		if (c&&!c->size_valid()) c->resize();
 	}
 	inherited::resize();
 }
@@ -118,6 +124,7 @@ basic_row_layout& basic_row_layout::cells(size_type xcells)
 		if (component* c=_components[i]) c->remove();
 	_components.resize(xcells,0);
 	_xmin.resize(xcells+1,0);
+	_pbboxes.resize(xcells);
 	invalidate();
 	return *this;
 }
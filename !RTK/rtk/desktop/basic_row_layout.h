@@ -49,6 +49,22 @@ protected:
 	/** The cached y-baseline set for the layout. */
 	mutable ybaseline_set _ybs;
 
+	/** Vector containing the bounding box most recently passed to
+	 * each child by reformat(), with respect to its origin. */
+	std::vector<box> _pbboxes;
+
+	/** The position of this layout with respect to the work area
+	 * when it was last reformatted. */
+	point _wapos;
+
+	/** The cached result of auto_bbox(), for use by derived classes.
+	 * This is meaningful only if _abbox_valid is true and
+	 * size_valid() is true. */
+	mutable box _abbox;
+
+	/** True if _abbox is valid, otherwise false. */
+	mutable bool _abbox_valid;
+
 	/** The size of gap to be placed between cells. */
 	int _xgap;
 
@@ -166,6 +166,7 @@ void basic_window::unformat()
 			app->deregister_window(*this);
 		_registered=false;
 	}
+	_damage.clear();
 	inherited::unformat();
 }
 
@@ -481,9 +482,9 @@ void basic_window::deliver_wimp_block(int wimpcode,os::wimp_block& wimpblock)
 			{
 				ic->deliver_wimp_block(wimpcode,wimpblock);
 			}
-			else if (component* target=find_focus_target())
+			else if (component* focus=find_focus_target())
 			{
-				events::key_pressed ev(*target,wimpblock);
+				events::key_pressed ev(*focus,wimpblock);
 				ev.post();
 			}
 			else
@@ -622,6 +623,7 @@ void basic_window::uncreate()
 		os::Wimp_DeleteWindow(block);
 		_handle=0;
 		_created=false;
+		_damage.clear();
 	}
 }
 
@@ -664,6 +666,38 @@ void basic_window::force_update(const box& clip)
 	}
 }
 
+void basic_window::defer_redraw(const box& clip)
+{
+	// The application need only be told when the list of pending
+	// areas ceases to be empty.
+	if (!_damage.size())
+	{
+		if (application* app=parent_application())
+			app->register_damage(*this);
+	}
+	_damage.add(clip);
+}
+
+void basic_window::flush_redraw()
+{
+	if (_damage.size())
+	{
+		// Take a copy of the list and clear it before calling the Wimp,
+		// so that an error cannot cause the same areas to be retried
+		// indefinitely.
+		graphics::box_list damage(_damage);
+		_damage.clear();
+		if (_handle)
+		{
+			for (graphics::box_list::const_iterator i=damage.begin();
+				i!=damage.end();++i)
+			{
+				os::Wimp_ForceRedraw(_handle,*i);
+			}
+		}
+	}
+}
+
 int basic_window::behind() const
 {
 	int behind=-1;
@@ -679,7 +713,7 @@ int basic_window::behind() const
 
 void basic_window::register_icon(icon& ic)
 {
-	_ihandles[ic.handle()]=&ic;
+	_ihandles.insert(ic.handle(),&ic);
 }
 
 void basic_window::deregister_icon(icon& ic)
@@ -689,8 +723,8 @@ void basic_window::deregister_icon(icon& ic)
 
 icon* basic_window::find_icon(int handle) const
 {
-	std::map<int,icon*>::const_iterator f=_ihandles.find(handle);
-	return (f!=_ihandles.end())?(*f).second:0;
+	icon* const* f=_ihandles.find(handle);
+	return (f)?*f:0;
 }
 
 component* basic_window::find_target(const point& pos)
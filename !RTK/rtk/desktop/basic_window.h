@@ -6,9 +6,10 @@
 #ifndef _RTK_DESKTOP_BASIC_WINDOW
 #define _RTK_DESKTOP_BASIC_WINDOW
 
-#include <map>
 #include <string>
 
+#include "rtk/util/handle_table.h"
+#include "rtk/graphics/box_list.h"
 #include "rtk/desktop/component.h"
 #include "rtk/events/close_window.h"
 #include "rtk/events/auto_scroll.h"
@@ -60,11 +61,11 @@ private:
 	/** The RISC OS window handle. */
 	int _handle;
 
-	/** A map from icon handles to icon components.
+	/** A table mapping icon handles to icon components.
 	 * All descendant icons that currently have a RISC OS icon handle
 	 * are included.
 	 */
-	std::map<int,icon*> _ihandles;
+	util::handle_table<int,icon*> _ihandles;
 
 	/** The current bounding box. */
 	box _bbox;
@@ -72,6 +73,10 @@ private:
 	/** The current extent. */
 	box _extent;
 
+	/** The list of areas for which a redraw has been requested but
+	 * not yet passed to the Wimp. */
+	graphics::box_list _damage;
+
 	/** The window created flag.
 	 * True if a RISC OS window exists for this component, otherwise false.
 	 */
@@ -584,6 +589,29 @@ public:
 	 */
 	void force_update(const box& clip);
 
+	/** Defer redraw of given area.
+	 * @internal
+	 * The area is merged with any others that are pending for this
+	 * window, then passed to the Wimp when flush_redraw() is called.
+	 * @param clip the bounding box of the region to be redrawn,
+	 *  with respect to the origin of the work area
+	 */
+	void defer_redraw(const box& clip);
+
+	/** Pass pending redraw areas to the Wimp.
+	 * @internal
+	 * This is called by the application before the next call to
+	 * Wimp_Poll after a redraw has been deferred.
+	 */
+	void flush_redraw();
+
+	/** Get visible area of work area.
+	 * @return the visible area, with respect to the origin of the
+	 *  work area
+	 */
+	box visible_area() const
+		{ return (_child)?_bbox-_child->origin():_bbox; }
+
 	/** Get handle of window in front of this one.
 	 * @internal
 	 * @return the handle of the window in front of this one, or -1 if
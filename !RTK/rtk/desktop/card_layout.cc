@@ -100,6 +100,11 @@ void card_layout::reformat(const point& origin,const box& pbbox)
 		_component->reformat(cpos,_bbox-cpos);
 	}
 	inherited::reformat(origin,bbox);
+
+	// If reformatting of the child was not completed (because part of
+	// it was left for a later pass) then this layout must remain
+	// invalid.
+	if (_component&&!_component->layout_valid()) invalidate_layout();
 }
 
 void card_layout::unformat()
@@ -8,6 +8,8 @@
 
 #include "rtk/util/divider.h"
 #include "rtk/graphics/gcontext.h"
+#include "rtk/desktop/basic_window.h"
+#include "rtk/desktop/layout_deferral.h"
 #include "rtk/desktop/column_layout.h"
 
 namespace rtk {
@@ -20,6 +22,8 @@ using rtk::util::divider;
 column_layout::column_layout(size_type ycells):
 	_components(ycells,0),
 	_ymax(ycells+1,0),
+	_pbboxes(ycells),
+	_abbox_valid(false),
 	_ygap(0)
 {}
 
@@ -35,6 +39,9 @@ column_layout::~column_layout()
 
 box column_layout::auto_bbox() const
 {
+	// Return cached value if possible.
+	if (_abbox_valid&&size_valid()) return _abbox;
+
 	// Determine number of cells.
 	size_type ycells=_components.size();
 
@@ -69,8 +76,10 @@ box column_layout::auto_bbox() const
 	// corner of layout.
 	box abbox(0,-ysize,xsize,0);
 
-	// Translate to external origin and return.
+	// Translate to external origin, cache and return.
 	abbox-=external_origin(abbox,xbaseline_left,ybaseline_top);
+	_abbox=abbox;
+	_abbox_valid=true;
 	return abbox;
 }
 
@@ -80,6 +89,7 @@ component* column_layout::find(const point& p) const
 		lower_bound(_ymax.begin(),_ymax.end(),p.y()-1,std::greater<int>());
 	if (yf==_ymax.begin()) return 0;
 	size_type y=(yf-_ymax.begin())-1;
+	if (y>=_components.size()) return 0;
 	component* c=_components[y];
 	if (!c) return 0;
 	box cbbox=c->bbox()+c->origin();
@@ -94,10 +104,13 @@ box column_layout::bbox() const
 
 void column_layout::resize() const
 {
+	// Resize only those children for which the size is invalid.
+	_abbox_valid=false;
 	for (std::vector<component*>::const_iterator i=_components.begin();
 		i!=_components.end();++i)
 	{
-		if (component* c=*i) c->resize();
+		component* c=*i;
+		if (c&&!c->size_valid()) c->resize();
 	}
 	inherited::resize();
 }
@@ -119,6 +132,18 @@ void column_layout::reformat(const point& origin,const box& pbbox)
 	inherited::reformat(origin,bbox);
 	if (moved) force_redraw(true);
 
+	// If this layout has moved with respect to the work area then
+	// every child must be reformatted, because some (such as icons)
+	// are positioned with respect to the work area.
+	point wapos;
+	basic_window* w=parent_work_area(wapos);
+	bool shifted=(wapos!=_wapos);
+	_wapos=wapos;
+
+	// Children which are not visible may be reformatted last, or left
+	// for a later pass, if there is a layout budget.
+	layout_deferral deferral(w,wapos);
+
 	// Remove margin.
 	box ibox(_bbox-_margin);
 
@@ -133,7 +158,9 @@ void column_layout::reformat(const point& origin,const box& pbbox)
 	if (yspread<0) yspread=0;
 	divider ydiv(yexcess,yspread);
 
-	// Set maximum y-coordinate for each cell.
+	// Set maximum y-coordinate for each cell and place children.
+	// Since each cell depends only on those above it, both can be
+	// done in a single pass.
 	int ypos=ibox.ymax();
 	_ymax[0]=ypos;
 	for (size_type y=0;y!=ycells;++y)
@@ -147,16 +174,12 @@ void column_layout::reformat(const point& origin,const box& pbbox)
 		ypos-=ysize+ydiv(ysize);
 		ypos-=_ygap;
 		_ymax[y+1]=ypos;
-	}
 
-	// Place children.
-	for (size_type y=0;y!=ycells;++y)
-	{
-		if (component* c=_components[y])
+		if (c)
 		{
 			// Create y-baseline set for just this cell.
 			ybaseline_set ybs;
-			ybs.add(c->min_bbox(),c->ybaseline());
+			ybs.add(mcbbox,c->ybaseline());
 
 			// Construct bounding box for cell with respect to origin
 			// of layout.
@@ -173,10 +196,18 @@ void column_layout::reformat(const point& origin,const box& pbbox)
 			// Calculate origin of cell with respect to origin of layout.
 			point cpos(cbbox.xminymin()+coffset);
 
-			// Reformat child.
-			c->reformat(cpos,cbbox-cpos);
+			// Reformat child, unless its layout is valid and it would
+			// be given the same origin and bounding box as last time.
+			box cpbbox(cbbox-cpos);
+			if (shifted||!c->layout_valid()||
+				(cpos!=c->origin())||(cpbbox!=_pbboxes[y]))
+			{
+				_pbboxes[y]=cpbbox;
+				deferral.reformat(*c,cpos,cpbbox);
+			}
 		}
 	}
+	deferral.reformat();
 }
 
 void column_layout::unformat()
@@ -236,6 +267,7 @@ column_layout& column_layout::cells(size_type ycells)
 		if (component* c=_components[i]) c->remove();
 	_components.resize(ycells,0);
 	_ymax.resize(ycells+1,0);
+	_pbboxes.resize(ycells);
 	invalidate();
 	return *this;
 }
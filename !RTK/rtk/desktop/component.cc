@@ -43,7 +43,9 @@ component::component(const point& origin):
 	_yfit(true),
 	_xauto(true),
 	_yauto(true)
-{}
+{
+	for (unsigned int i=0;i!=event_type_max/32;++i) _unhandled[i]=0;
+}
 
 component::~component()
 {
@@ -225,6 +227,20 @@ void component::invalidate()
 	}
 }
 
+void component::invalidate_layout()
+{
+	// Ancestors must be invalidated even if this component is already
+	// invalid, because they may have been made valid by a reformat()
+	// which is in progress.
+	_layout_valid=false;
+	component* p=_parent;
+	while (p&&p->_layout_valid)
+	{
+		p->_layout_valid=false;
+		p=p->_parent;
+	}
+}
+
 void component::resize() const
 {
 	_size_valid=true;
@@ -259,12 +275,16 @@ void component::force_redraw(bool suppress_window)
 
 	if (!_forced_redraw&&!suppress_window)
 	{
+		notify_redraw(bbox());
 		point offset;
 		basic_window* w=as_window();
 		if (!w) w=parent_work_area(offset);
 		if (int h=(w)?w->handle():-1)
 		{
-			os::Wimp_ForceRedraw(h,bbox()+offset);
+			// Where possible, defer the redraw until the next call to
+			// Wimp_Poll so that it can be merged with others.
+			if (w) w->defer_redraw(bbox()+offset);
+			else os::Wimp_ForceRedraw(h,bbox()+offset);
 		}
 		_forced_redraw=true;
 	}
@@ -274,12 +294,14 @@ void component::force_redraw(const box& clip)
 {
 	if (!_forced_redraw)
 	{
+		notify_redraw(clip);
 		point offset;
 		basic_window* w=as_window();
 		if (!w) w=parent_work_area(offset);
 		if (int h=(w)?w->handle():-1)
 		{
-			os::Wimp_ForceRedraw(h,clip+offset);
+			if (w) w->defer_redraw(clip+offset);
+			else os::Wimp_ForceRedraw(h,clip+offset);
 		}
 	}
 }
@@ -293,6 +315,7 @@ void component::force_update(const box& clip)
 {
 	if (!_forced_redraw)
 	{
+		notify_redraw(clip);
 		point offset;
 		basic_window* w=as_window();
 		if (!w) w=parent_work_area(offset);
@@ -302,6 +325,9 @@ void component::force_update(const box& clip)
 
 void component::block_copy(const box& src,const point& dst)
 {
+	// The destination is not redrawn by the Wimp, but any retained
+	// copy of it is no longer valid.
+	notify_redraw(src-src.xminymin()+dst);
 	point offset;
 	basic_window* w=as_window();
 	if (!w) w=parent_work_area(offset);
@@ -309,6 +335,9 @@ void component::block_copy(const box& src,const point& dst)
 	{
 		if (int handle=w->handle())
 		{
+			// Any deferred redraws must be passed to the Wimp first,
+			// because they refer to the content before it is moved.
+			w->flush_redraw();
 			os::Wimp_BlockCopy(handle,src+offset,dst+offset);
 		}
 	}
@@ -382,7 +411,7 @@ void component::claim_selection()
 		}
 		else
 		{
-			app->send_message(swi::User_Message,*(block.release()),0,0);
+			app->send_message(swi::User_Message,*block,0,0);
 		}
 
 		app->register_selection(*this);
@@ -411,7 +440,7 @@ void component::claim_clipboard()
 		}
 		else
 		{
-			app->send_message(swi::User_Message,*(block.release()),0,0);
+			app->send_message(swi::User_Message,*block,0,0);
 		}
 
 	app->register_clipboard(*this);
@@ -487,6 +516,36 @@ void component::baseline_notify(const point& offset)
 	_origin+=offset;
 }
 
+void component::redraw_notify(const box& clip)
+{}
+
+void component::icon_notify(bool created)
+{}
+
+void component::notify_icon(bool created)
+{
+	if (as_window()) return;
+	component* pc=_parent;
+	while (pc&&!pc->as_window())
+	{
+		pc->icon_notify(created);
+		pc=pc->_parent;
+	}
+}
+
+void component::notify_redraw(const box& clip)
+{
+	if (as_window()) return;
+	point offset=_origin;
+	component* pc=_parent;
+	while (pc&&!pc->as_window())
+	{
+		pc->redraw_notify(clip+offset);
+		offset+=pc->_origin;
+		pc=pc->_parent;
+	}
+}
+
 point component::internal_origin(const box& bbox,xbaseline_type ixbaseline,
 	ybaseline_type iybaseline) const
 {
@@ -585,6 +644,16 @@ box component::fit(const box& pbbox) const
 	return bbox;
 }
 
+void component::unhandled(unsigned int type,bool value) const
+{
+	if (type<event_type_max)
+	{
+		unsigned int mask=1<<(type%32);
+		if (value) _unhandled[type/32]|=mask;
+		else _unhandled[type/32]&=~mask;
+	}
+}
+
 component* component::_redirected_parent() const
 {
 	component* rp=_parent;
@@ -111,6 +111,12 @@ public:
 		/** The number of allowed horizontal baseline types. */
 		ybaseline_max=ybaseline_centre+1
 	};
+	enum
+	{
+		/** The number of event types for which the absence of a
+		 * handler can be recorded. */
+		event_type_max=64
+	};
 	class xbaseline_set;
 	class ybaseline_set;
 	/** An enumeration type for specifying the direction in which
@@ -194,6 +200,15 @@ private:
 	 * calculated automatically using auto_bbox().
 	 */
 	bool _yauto:1;
+
+	/** A bitmap of event types for which this component has no handler.
+	 * Bits are initially clear.  They are set by events::event::post()
+	 * if and when delivery of the corresponding event type fails.
+	 * (This assumes that events are not posted to a component while
+	 * it is being constructed, since its dynamic type would then be
+	 * incomplete.)
+	 */
+	mutable unsigned int _unhandled[event_type_max/32];
 public:
 	/** Construct component.
 	 * @param origin the initial origin of the component, with respect
@@ -217,6 +232,24 @@ public:
 	inline component* redirected_parent() const
 		{ return (_no_redirect)?_parent:_redirected_parent(); }
 
+	/** Determine whether this component is known to have no handler
+	 * for a given type of event.
+	 * @internal
+	 * @param type the event type index
+	 * @return true if known to have no handler, otherwise false
+	 */
+	bool unhandled(unsigned int type) const
+		{ return (type<event_type_max)&&((_unhandled[type/32]>>(type%32))&1); }
+
+	/** Record whether this component is known to have no handler
+	 * for a given type of event.
+	 * @internal
+	 * Event type indices which are out of range are ignored.
+	 * @param type the event type index
+	 * @param value true if known to have no handler, otherwise false
+	 */
+	void unhandled(unsigned int type,bool value) const;
+
 	/** Get the window that owns the work area for this component.
 	 * @return the window if there is one, otherwise 0
 	 */
@@ -421,6 +454,15 @@ public:
 	 */
 	void invalidate();
 
+	/** Invalidate layout of this component and its ancestors.
+	 * Unlike invalidate(), this leaves the size valid, so only
+	 * reformat() will be called.  It is used by layouts which have
+	 * left some of their children to be reformatted during a later
+	 * pass (see application::layout_budget()).  It may be called
+	 * from within reformat().
+	 */
+	void invalidate_layout();
+
 	/** Resize component.
 	 * This function should be called when size_valid() is false.
 	 * (It is not an error to call it at other times, but there is no
@@ -621,6 +663,40 @@ protected:
 	 */
 	virtual void baseline_notify(const point& offset);
 
+	/** Notify component that part of a descendant is to be redrawn.
+	 * This function is called by force_redraw(), force_update() and
+	 * block_copy() for each ancestor of the component concerned, up to
+	 * but excluding the window that owns its work area.  It should be
+	 * overridden by components that retain a rendered copy of their
+	 * descendants, so that the affected part of the copy can be
+	 * discarded.  The default behaviour is to do nothing.
+	 * @param clip the bounding box of the region to be redrawn,
+	 *  with respect to the origin of this component
+	 */
+	virtual void redraw_notify(const box& clip);
+
+	/** Notify component that a descendant has created or deleted an icon.
+	 * This function is called by notify_icon() for each ancestor of the
+	 * component concerned, up to but excluding the window that owns its
+	 * work area.  It should be overridden by components that need to
+	 * know whether any of their descendants own icons (which are drawn
+	 * by the Wimp, not by redraw()).  The default behaviour is to do
+	 * nothing.
+	 * @param created true if an icon has been created, false if one
+	 *  has been deleted
+	 */
+	virtual void icon_notify(bool created);
+
+	/** Notify ancestors that this component has created or deleted an icon.
+	 * icon_notify() is called for each ancestor up to but excluding
+	 * the window that owns the work area.  This function should be
+	 * called by components that own icons whenever one is created or
+	 * deleted.
+	 * @param created true if an icon has been created, false if one
+	 *  has been deleted
+	 */
+	void notify_icon(bool created);
+
 	bool xauto() const
 		{ return _xauto; }
 
@@ -669,6 +745,14 @@ private:
 	 */
 	void set_parent(component* p);
 
+	/** Notify ancestors that part of this component is to be redrawn.
+	 * redraw_notify() is called for each ancestor up to but excluding
+	 * the window that owns the work area.
+	 * @param clip the bounding box of the region to be redrawn,
+	 *  with respect to the origin of this component
+	 */
+	void notify_redraw(const box& clip);
+
 	/** Get parent after redirection.
 	 * This is a non-optimised version of redirected_parent(), for use
 	 * by that function when _no_redirect is false.
@@ -8,6 +8,8 @@
 
 #include "rtk/util/divider.h"
 #include "rtk/graphics/gcontext.h"
+#include "rtk/desktop/basic_window.h"
+#include "rtk/desktop/layout_deferral.h"
 #include "rtk/desktop/grid_layout.h"
 
 namespace rtk {
@@ -25,6 +27,10 @@ grid_layout::grid_layout(size_type xcells,size_type ycells):
 	_ymax(ycells+1,0),
 	_xbs(xcells),
 	_ybs(ycells),
+	_xdirty(xcells,true),
+	_ydirty(ycells,true),
+	_pbboxes(xcells*ycells),
+	_abbox_valid(false),
 	_xgap(0),
 	_ygap(0)
 {}
@@ -41,12 +47,12 @@ grid_layout::~grid_layout()
 
 box grid_layout::auto_bbox() const
 {
-	// Reset baseline sets.
-	for (size_type x=0;x!=_xcells;++x) _xbs[x]=xbaseline_set();
-	for (size_type y=0;y!=_ycells;++y) _ybs[y]=ybaseline_set();
+	// Return cached value if possible.
+	if (_abbox_valid&&size_valid()) return _abbox;
 
-	// Request min_bbox for each cell.  Incorporate into appropriate
-	// x-baseline and y-baseline set.
+	// Mark the column and row of any cell with an invalid size.
+	// (Baseline sets cannot be updated incrementally, so a set
+	// must be rebuilt if the size of any cell within it changes.)
 	std::vector<component*>::const_iterator i=_components.begin();
 	for (size_type y=0;y!=_ycells;++y)
 	{
@@ -54,13 +60,45 @@ box grid_layout::auto_bbox() const
 		{
 			if (component* c=*i++)
 			{
-				box mcbbox=c->min_bbox();
-				_xbs[x].add(mcbbox,c->xbaseline());
-				_ybs[y].add(mcbbox,c->ybaseline());
+				if (!c->size_valid())
+				{
+					_xdirty[x]=true;
+					_ydirty[y]=true;
+				}
 			}
 		}
 	}
 
+	// Rebuild x-baseline set for each marked column.
+	for (size_type x=0;x!=_xcells;++x)
+	{
+		if (_xdirty[x])
+		{
+			_xbs[x]=xbaseline_set();
+			for (size_type y=0;y!=_ycells;++y)
+			{
+				if (component* c=_components[y*_xcells+x])
+					_xbs[x].add(c->min_bbox(),c->xbaseline());
+			}
+			_xdirty[x]=false;
+		}
+	}
+
+	// Rebuild y-baseline set for each marked row.
+	for (size_type y=0;y!=_ycells;++y)
+	{
+		if (_ydirty[y])
+		{
+			_ybs[y]=ybaseline_set();
+			for (size_type x=0;x!=_xcells;++x)
+			{
+				if (component* c=_components[y*_xcells+x])
+					_ybs[y].add(c->min_bbox(),c->ybaseline());
+			}
+			_ydirty[y]=false;
+		}
+	}
+
 	// Calculate total width and height.
 	int xsize=0;
 	int ysize=0;
@@ -81,8 +119,10 @@ box grid_layout::auto_bbox() const
 	// corner of layout.
 	box abbox(0,-ysize,xsize,0);
 
-	// Translate to external origin and return.
+	// Translate to external origin, cache and return.
 	abbox-=external_origin(abbox,xbaseline_left,ybaseline_top);
+	_abbox=abbox;
+	_abbox_valid=true;
 	return abbox;
 }
 
@@ -96,6 +136,7 @@ component* grid_layout::find(const point& p) const
 	if (yf==_ymax.begin()) return 0;
 	size_type x=(xf-_xmin.begin())-1;
 	size_type y=(yf-_ymax.begin())-1;
+	if ((x>=_xcells)||(y>=_ycells)) return 0;
 	component* c=_components[y*_xcells+x];
 	if (!c) return 0;
 	box cbbox=c->bbox()+c->origin();
@@ -110,10 +151,22 @@ box grid_layout::bbox() const
 
 void grid_layout::resize() const
 {
-	for (std::vector<component*>::const_iterator i=_components.begin();
-		i!=_components.end();++i)
+	// Resize only those children for which the size is invalid,
+	// marking the column and row of each.
+	_abbox_valid=false;
+	std::vector<component*>::const_iterator i=_components.begin();
+	for (size_type y=0;y!=_ycells;++y)
 	{
-		if (component* c=*i) c->resize();
+		for (size_type x=0;x!=_xcells;++x)
+		{
+			component* c=*i++;
+			if (c&&!c->size_valid())
+			{
+				_xdirty[x]=true;
+				_ydirty[y]=true;
+				c->resize();
+			}
+		}
 	}
 	inherited::resize();
 }
@@ -132,6 +185,18 @@ void grid_layout::reformat(const point& origin,const box& pbbox)
 	inherited::reformat(origin,bbox);
 	if (moved) force_redraw(true);
 
+	// If this layout has moved with respect to the work area then
+	// every child must be reformatted, because some (such as icons)
+	// are positioned with respect to the work area.
+	point wapos;
+	basic_window* w=parent_work_area(wapos);
+	bool shifted=(wapos!=_wapos);
+	_wapos=wapos;
+
+	// Children which are not visible may be reformatted last, or left
+	// for a later pass, if there is a layout budget.
+	layout_deferral deferral(w,wapos);
+
 	// Remove margin.
 	box ibox(_bbox-_margin);
 
@@ -180,9 +245,10 @@ void grid_layout::reformat(const point& origin,const box& pbbox)
 
 	// Place children.
 	std::vector<component*>::iterator i=_components.begin();
+	std::vector<box>::iterator j=_pbboxes.begin();
 	for (size_type y=0;y!=_ycells;++y)
 	{
-		for (size_type x=0;x!=_xcells;++x)
+		for (size_type x=0;x!=_xcells;++x,++j)
 		{
 			if (component* c=*i++)
 			{
@@ -202,11 +268,20 @@ void grid_layout::reformat(const point& origin,const box& pbbox)
 				// layout.
 				point cpos(cbbox.xminymin()+coffset);
 
-				// Reformat child.
-				c->reformat(cpos,cbbox-cpos);
+				// Reformat child, unless its layout is valid and it
+				// would be given the same origin and bounding box
+				// as last time.
+				box cpbbox(cbbox-cpos);
+				if (shifted||!c->layout_valid()||
+					(cpos!=c->origin())||(cpbbox!=*j))
+				{
+					*j=cpbbox;
+					deferral.reformat(*c,cpos,cpbbox);
+				}
 			}
 		}
 	}
+	deferral.reformat();
 }
 
 void grid_layout::unformat()
@@ -275,6 +350,9 @@ void grid_layout::remove_notify(component& c)
 		std::find(_components.begin(),_components.end(),&c);
 	if (f!=_components.end())
 	{
+		size_type index=f-_components.begin();
+		_xdirty[index%_xcells]=true;
+		_ydirty[index/_xcells]=true;
 		*f=0;
 		invalidate();
 	}
@@ -330,6 +408,9 @@ grid_layout& grid_layout::cells(size_type xcells,size_type ycells)
 	_ymax.resize(ycells+1,0);
 	_xbs.resize(xcells);
 	_ybs.resize(ycells);
+	_xdirty.assign(xcells,true);
+	_ydirty.assign(ycells,true);
+	_pbboxes.assign(xcells*ycells,box());
 
 	// Invalidate component and return.
 	invalidate();
@@ -348,6 +429,8 @@ grid_layout& grid_layout::add(component& c,size_type x,size_type y)
 
 	// Link from parent to child and child to parent. 
 	_components[y*_xcells+x]=&c;
+	_xdirty[x]=true;
+	_ydirty[y]=true;
 	link_child(c);
 
 	// Invalidate component and return.
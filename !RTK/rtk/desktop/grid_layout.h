@@ -63,6 +63,30 @@ private:
 	/** Vector containing cached y-baseline set for each cell. */
 	mutable std::vector<ybaseline_set> _ybs;
 
+	/** Vector containing a flag for each column to indicate that
+	 * its x-baseline set must be rebuilt. */
+	mutable std::vector<bool> _xdirty;
+
+	/** Vector containing a flag for each row to indicate that
+	 * its y-baseline set must be rebuilt. */
+	mutable std::vector<bool> _ydirty;
+
+	/** Vector containing the bounding box most recently passed to
+	 * each child by reformat(), with respect to its origin. */
+	std::vector<box> _pbboxes;
+
+	/** The position of this layout with respect to the work area
+	 * when it was last reformatted. */
+	point _wapos;
+
+	/** The cached result of auto_bbox().
+	 * This is meaningful only if _abbox_valid is true and
+	 * size_valid() is true. */
+	mutable box _abbox;
+
+	/** True if _abbox is valid, otherwise false. */
+	mutable bool _abbox_valid;
+
 	/** The size of gap to be placed between columns. */
 	int _xgap;
 
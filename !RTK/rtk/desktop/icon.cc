@@ -3,6 +3,10 @@
 // Distribution and use are subject to the GNU Lesser General Public License,
 // a copy of which may be found in the file !RTK.Copyright.
 
+#include <cctype>
+#include <map>
+#include <utility>
+
 #include "rtk/swi/os.h"
 #include "rtk/swi/wimp.h"
 #include "rtk/os/os.h"
@@ -11,6 +15,7 @@
 #include "rtk/desktop/icon.h"
 #include "rtk/desktop/basic_window.h"
 #include "rtk/desktop/application.h"
+#include "rtk/desktop/screen_metrics.h"
 #include "rtk/events/wimp.h"
 #include "rtk/events/mouse_click.h"
 #include "rtk/events/key_pressed.h"
@@ -178,6 +183,18 @@ void parse_validation(char*& i,unsigned int* border_type,char* sprite0,
 	}
 }
 
+/** A type for identifying a named sprite within a sprite area. */
+typedef std::pair<os::sprite_area*,std::string> sprite_key;
+
+/** A type for mapping named sprites to their dimensions. */
+typedef std::map<sprite_key,std::pair<int,int> > sprite_cache_type;
+
+/** The process-wide cache of named sprite dimensions. */
+sprite_cache_type sprite_cache;
+
+/** The mode epoch for which sprite_cache is valid. */
+unsigned int sprite_cache_epoch=0;
+
 void sprite_size(os::sprite_area* area,const char* name,
 	int* _xsize,int* _ysize)
 {
@@ -185,6 +202,32 @@ void sprite_size(os::sprite_area* area,const char* name,
 	int ysize=0;
 	if (name)
 	{
+		// Discard the cache if the screen mode has changed, since
+		// the pixel translation may be different.
+		if (sprite_cache_epoch!=screen_metrics::epoch())
+		{
+			sprite_cache.clear();
+			sprite_cache_epoch=screen_metrics::epoch();
+		}
+
+		// Sprite names are not case-sensitive, so fold the key to
+		// lower case.  The name is terminated by any control character.
+		std::string lname;
+		for (const unsigned char* p=reinterpret_cast<const unsigned char*>(name);
+			*p>=32;++p)
+		{
+			lname+=static_cast<char>(std::tolower(*p));
+		}
+		sprite_key key(area,lname);
+
+		sprite_cache_type::iterator f=sprite_cache.find(key);
+		if (f!=sprite_cache.end())
+		{
+			if (_xsize) *_xsize=(*f).second.first;
+			if (_ysize) *_ysize=(*f).second.second;
+			return;
+		}
+
 		try {
 			if (area) os::OS_SpriteOp40(area,name,&xsize,&ysize,0,0);
 			else os::Wimp_SpriteOp40(name,&xsize,&ysize,0,0);
@@ -195,9 +238,13 @@ void sprite_size(os::sprite_area* area,const char* name,
 			ysize*=scale[1];
 			xsize/=scale[2];
 			ysize/=scale[3];
+			sprite_cache[key]=std::make_pair(xsize,ysize);
 		}
 		catch (os::exception) {
-			// Supress exceptions due to the sprite not existing
+			// Supress exceptions due to the sprite not existing.
+			// The failure is not cached, because the sprite may be
+			// added later (for example, to the Wimp sprite pool by
+			// another task).
 			xsize=0;
 			ysize=0;
 		}
@@ -255,12 +302,8 @@ box make_border_box(bool border,unsigned int border_type)
 			break;
 		default:
 			// Default is 2 pixels.
-			int xeigfactor=0;
-			int yeigfactor=0;
-			os::OS_ReadModeVariable(swi::XEigFactor,&xeigfactor);
-			os::OS_ReadModeVariable(swi::YEigFactor,&yeigfactor);
-			unsigned int xpix=1<<xeigfactor;
-			unsigned int ypix=1<<yeigfactor;
+			unsigned int xpix=screen_metrics::xpix();
+			unsigned int ypix=screen_metrics::ypix();
 			bdrbox=box(-xpix,-ypix,xpix,ypix);
 			break;
 		}
@@ -289,7 +332,9 @@ icon::icon():
 	_enabled(true),
 	_fcolour(7),
 	_bcolour(1),
-	_font(0)
+	_font(0),
+	_content_valid(false),
+	_content_epoch(0)
 {}
 
 icon::~icon()
@@ -355,6 +400,7 @@ void icon::_reformat(const point& origin,const box& pbbox,int position,int prior
 			app->register_icon(*this);
 		}
 		_created=true;
+		notify_icon(true);
 	}
 	else
 	{
@@ -411,6 +457,7 @@ void icon::unformat()
 		os::Wimp_DeleteIcon(block);
 		_handle=-1;
 		_created=false;
+		notify_icon(false);
 		invalidate();
 	}
 }
@@ -441,6 +488,7 @@ icon& icon::text(const string& text,size_type capacity)
 		size_type i=text.copy(_text,_textsize);
 		_text[i]=0;
 	}
+	invalidate_content();
 	force_redraw();
 	return *this;
 }
@@ -464,6 +512,7 @@ icon& icon::validation(const string& validation,size_type capacity)
 		size_type i=validation.copy(_val,_valsize);
 		_val[i]=0;
 	}
+	invalidate_content();
 	force_redraw();
 	return *this;
 }
@@ -487,6 +536,7 @@ icon& icon::sprite_name(const string& sprite_name,size_type capacity)
 		size_type i=sprite_name.copy(_name,_namesize);
 		_name[i]=0;
 	}
+	invalidate_content();
 	force_redraw();
 	return *this;
 }
@@ -494,6 +544,7 @@ icon& icon::sprite_name(const string& sprite_name,size_type capacity)
 icon& icon::text_and_sprite(bool value)
 {
 	_text_and_sprite=value;
+	invalidate_content();
 	set_state();
 	force_redraw();
 	invalidate();
@@ -512,6 +563,7 @@ icon& icon::border(bool value)
 icon& icon::hcentre(bool value)
 {
 	_hcentre=value;
+	invalidate_content();
 	set_state();
 	force_redraw();
 	invalidate();
@@ -521,6 +573,7 @@ icon& icon::hcentre(bool value)
 icon& icon::vcentre(bool value)
 {
 	_vcentre=value;
+	invalidate_content();
 	set_state();
 	force_redraw();
 	invalidate();
@@ -538,6 +591,7 @@ icon& icon::fill(bool value)
 icon& icon::rjustify(bool value)
 {
 	_rjustify=value;
+	invalidate_content();
 	set_state();
 	force_redraw();
 	invalidate();
@@ -554,6 +608,7 @@ icon& icon::adjust_select(bool value)
 icon& icon::half_size(bool value)
 {
 	_half_size=value;
+	invalidate_content();
 	set_state();
 	force_redraw();
 	invalidate();
@@ -784,6 +839,7 @@ void icon::change_type(icon_type itype)
 			break;
 		}
 		_itype=itype;
+		invalidate_content();
 		switch (_itype)
 		{
 		case empty_icon:
@@ -824,10 +880,25 @@ void icon::set_state()
 
 box icon::content_box() const
 {
-	int xeigfactor=0;
-	int yeigfactor=0;
-	os::OS_ReadModeVariable(swi::XEigFactor,&xeigfactor);
-	os::OS_ReadModeVariable(swi::YEigFactor,&yeigfactor);
+	// Measure the content if there is no cached value, or if the
+	// cached value may have been invalidated by a mode change or
+	// by the Wimp editing the text buffer.
+	if (!_content_valid||(_content_epoch!=screen_metrics::epoch())||
+		((_itype==text_icon)&&_text&&(_content_text!=_text)))
+	{
+		_content_box=measure_content_box();
+		_content_epoch=screen_metrics::epoch();
+		if ((_itype==text_icon)&&_text) _content_text=_text;
+		else _content_text.erase();
+		_content_valid=true;
+	}
+	return _content_box;
+}
+
+box icon::measure_content_box() const
+{
+	int xeigfactor=screen_metrics::xeigfactor();
+	int yeigfactor=screen_metrics::yeigfactor();
 
 	// Initialise dimensions and border type.
 	int prefxsize=0;
@@ -943,5 +1014,10 @@ box icon::border_box() const
 	return make_border_box(_border,border_type);
 }
 
+void icon::flush_sprite_cache()
+{
+	sprite_cache.clear();
+}
+
 } /* namespace desktop */
 } /* namespace rtk */
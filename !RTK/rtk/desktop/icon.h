@@ -221,6 +221,27 @@ private:
 	 * This is used only if _has_font is true.
 	 */
 	unsigned int _font:8;
+
+	/** The content box cached flag.
+	 * True if _content_box holds the result of measure_content_box(),
+	 * otherwise false.
+	 */
+	mutable bool _content_valid:1;
+
+	/** The cached content box.
+	 * This variable is meaningful only when _content_valid is true.
+	 */
+	mutable box _content_box;
+
+	/** The mode epoch at which the content box was measured. */
+	mutable unsigned int _content_epoch;
+
+	/** The text from which the content box was measured.
+	 * This is needed because the Wimp may modify the text buffer
+	 * of a writable icon without the knowledge of this class.
+	 * It is meaningful only when _itype==text_icon.
+	 */
+	mutable string _content_text;
 public:
 	/** Construct icon.
 	 * By default an icon:
@@ -537,7 +558,32 @@ public:
 	 * @return the border box
 	 */
 	box border_box() const;
+
+	/** Flush sprite size cache.
+	 * The dimensions of named sprites are cached on a process-wide
+	 * basis, keyed by sprite area and name.  The cache is flushed
+	 * automatically when the screen mode changes.  Sprites that could
+	 * not be found are not cached.  It must be flushed explicitly if a
+	 * named sprite is replaced or resized, and whenever a user sprite
+	 * area is changed or freed (since a new area may later be
+	 * allocated at the same address).
+	 */
+	static void flush_sprite_cache();
 private:
+	/** Measure content box.
+	 * This performs the calculation for content_box() without
+	 * reference to the cached value.
+	 * @return the content box
+	 */
+	box measure_content_box() const;
+
+	/** Invalidate cached content box.
+	 * This should be called whenever the type, text, validation string,
+	 * sprite or content flags of the icon are changed.
+	 */
+	void invalidate_content()
+		{ _content_valid=false; }
+
 	/** Change icon type.
 	 * See icon_type for a description of the allowed values.
 	 * If necessary the existing RISC OS icon is deleted, to be
@@ -0,0 +1,65 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#include "rtk/desktop/basic_window.h"
+#include "rtk/desktop/application.h"
+#include "rtk/desktop/layout_deferral.h"
+
+namespace rtk {
+namespace desktop {
+
+layout_deferral::layout_deferral(basic_window* w,const point& wapos):
+	_app(0)
+{
+	// Children can be deferred only within an open window which is
+	// descended from an application with a layout budget.
+	if (w&&w->handle())
+	{
+		if (application* app=w->parent_application())
+		{
+			if (app->layout_budget())
+			{
+				_app=app;
+				_visible=w->visible_area()-wapos;
+			}
+		}
+	}
+}
+
+void layout_deferral::reformat(component& c,const point& origin,
+	const box& pbbox)
+{
+	if (_app)
+	{
+		box clip=(pbbox+origin)&_visible;
+		if ((clip.xsize()<=0)||(clip.ysize()<=0))
+		{
+			entry e;
+			e.c=&c;
+			e.origin=origin;
+			e.pbbox=pbbox;
+			_queue.push_back(e);
+			return;
+		}
+	}
+	c.reformat(origin,pbbox);
+}
+
+void layout_deferral::reformat()
+{
+	for (std::vector<entry>::iterator i=_queue.begin();i!=_queue.end();++i)
+	{
+		// Once the budget has been used, the remaining children are
+		// invalidated.  This invalidates the layout and its ancestors
+		// too, so that the application will resume from this point
+		// during the next pass.
+		if (_app->layout_expired()) (*i).c->invalidate_layout();
+		else (*i).c->reformat((*i).origin,(*i).pbbox);
+	}
+	_queue.clear();
+}
+
+} /* namespace desktop */
+} /* namespace rtk */
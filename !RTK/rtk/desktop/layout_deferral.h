@@ -0,0 +1,86 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#ifndef _RTK_DESKTOP_LAYOUT_DEFERRAL
+#define _RTK_DESKTOP_LAYOUT_DEFERRAL
+
+#include <vector>
+
+#include "rtk/graphics/point.h"
+#include "rtk/graphics/box.h"
+
+namespace rtk {
+namespace desktop {
+
+using rtk::graphics::point;
+using rtk::graphics::box;
+
+class component;
+class basic_window;
+class application;
+
+/** A class for ordering the reformatting of children by visibility.
+ * This is used by layouts during a layout pass with a time budget (see
+ * application::layout_budget()).  Children which overlap the visible
+ * area of the window are reformatted immediately.  Others are queued,
+ * then reformatted by reformat() after the visible children for as long
+ * as the budget lasts.  Any which remain are invalidated, so that they
+ * are reformatted during a later pass.
+ *
+ * If there is no budget, or the layout is not within an open window,
+ * then every child is reformatted immediately.
+ */
+class layout_deferral
+{
+private:
+	/** A structure to represent a child waiting to be reformatted. */
+	struct entry
+	{
+		/** The child. */
+		component* c;
+		/** The origin to be given to the child. */
+		point origin;
+		/** The proposed bounding box of the child. */
+		box pbbox;
+	};
+
+	/** The application with the layout budget, or 0 if children are
+	 * not to be deferred. */
+	application* _app;
+
+	/** The visible area, with respect to the origin of the layout. */
+	box _visible;
+
+	/** The children waiting to be reformatted. */
+	std::vector<entry> _queue;
+public:
+	/** Construct layout deferral object.
+	 * @param w the window containing the layout, or 0 if none
+	 * @param wapos the origin of the layout with respect to the
+	 *  origin of the work area of w
+	 */
+	layout_deferral(basic_window* w,const point& wapos);
+
+	/** Reformat child, unless it is not visible.
+	 * The arguments are as for component::reformat().
+	 * @param c the child to be reformatted
+	 * @param origin the new origin of the child, with respect to the
+	 *  layout
+	 * @param pbbox the proposed bounding box for the child, with
+	 *  respect to its own origin
+	 */
+	void reformat(component& c,const point& origin,const box& pbbox);
+
+	/** Reformat queued children.
+	 * This should be called once all visible children have been
+	 * reformatted.
+	 */
+	void reformat();
+};
+
+} /* namespace desktop */
+} /* namespace rtk */
+
+#endif
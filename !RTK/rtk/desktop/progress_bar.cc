@@ -140,6 +140,20 @@ progress_bar& progress_bar::denominator(unsigned int denominator)
 	return *this;
 }
 
+progress_bar& progress_bar::fraction(unsigned int count,unsigned int total)
+{
+	// Scale the values so that they can be multiplied by the width
+	// of the bar without overflow.
+	if (total<count) total=count;
+	unsigned int shift=0;
+	while ((total>>shift)>0xffff) ++shift;
+	_numerator=count>>shift;
+	_denominator=total>>shift;
+	if (!_denominator) _denominator=1;
+	invalidate();
+	return *this;
+}
+
 progress_bar& progress_bar::fcolour(int fcolour)
 {
 	_bar.fcolour(fcolour);
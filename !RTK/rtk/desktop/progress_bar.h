@@ -91,6 +91,18 @@ public:
 	 */
 	progress_bar& denominator(unsigned int denominator);
 
+	/** Set numerator and denominator from a count.
+	 * The values are scaled so that the bar can be drawn without
+	 * overflow, however large the count.  If the total is less than
+	 * the count (because it was an estimate) then the bar is shown
+	 * as full.
+	 * @param count the amount completed (for example, a number of
+	 *  bytes transferred)
+	 * @param total the total amount
+	 * @return a reference to this
+	 */
+	progress_bar& fraction(unsigned int count,unsigned int total);
+
 	/** Set foreground colour.
 	 * This is one of the 16 standard Wimp colours.
 	 * @param fcolour the required foreground colour
@@ -0,0 +1,217 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#include <new>
+
+#include "rtk/graphics/gcontext.h"
+#include "rtk/graphics/vdu_gcontext.h"
+#include "rtk/graphics/print_gcontext.h"
+#include "rtk/graphics/sprite_gcontext.h"
+#include "rtk/desktop/basic_window.h"
+#include "rtk/desktop/render_cache.h"
+
+namespace rtk {
+namespace desktop {
+
+namespace {
+
+/** Test whether a box is empty.
+ * @param b the box to be tested
+ * @return true if the box is empty, otherwise false
+ */
+inline bool empty(const box& b)
+{
+	return (b.xmax()<=b.xmin())||(b.ymax()<=b.ymin());
+}
+
+} /* anonymous namespace */
+
+render_cache::render_cache():
+	_content(0),
+	_sprite(0),
+	_memory_limit(0x100000),
+	_icons(0)
+{}
+
+render_cache::~render_cache()
+{
+	discard();
+	remove();
+}
+
+render_cache& render_cache::add(component& c)
+{
+	if (_content) _content->remove();
+	_content=&c;
+	link_child(c);
+	invalidate();
+	return *this;
+}
+
+render_cache& render_cache::memory_limit(unsigned int limit)
+{
+	_memory_limit=limit;
+	discard();
+	force_redraw();
+	return *this;
+}
+
+void render_cache::discard()
+{
+	delete _sprite;
+	_sprite=0;
+	_dirty=box();
+}
+
+box render_cache::auto_bbox() const
+{
+	box abbox;
+	if (_content) abbox=_content->min_bbox();
+	return abbox;
+}
+
+box render_cache::bbox() const
+{
+	box bbox;
+	if (_content) bbox=_content->bbox();
+	return bbox;
+}
+
+void render_cache::resize() const
+{
+	if (_content) _content->resize();
+	inherited::resize();
+}
+
+void render_cache::reformat(const point& origin,const box& pbbox)
+{
+	// Fit bounding box to parent.
+	box bbox=fit(pbbox);
+
+	// The rendered copy cannot be relied upon if the layout has been
+	// invalidated or the bounding box has changed.
+	if (!layout_valid()||(bbox!=this->bbox())) discard();
+
+	// Update origin and bounding box of this component, force redraw
+	// if necessary.  (This must happen before reformat() is called for
+	// the child.)
+	bool moved=(origin!=this->origin())||(bbox!=this->bbox());
+	if (moved) force_redraw(true);
+	inherited::reformat(origin,bbox);
+	if (moved) force_redraw(true);
+
+	if (_content) _content->reformat(point(0,0),bbox);
+}
+
+void render_cache::unformat()
+{
+	discard();
+	if (_content) _content->unformat();
+	inherited::unformat();
+}
+
+void render_cache::redraw(gcontext& context,const box& clip)
+{
+	if (_content)
+	{
+		if (!redraw_cached(context)) _content->redraw(context,clip);
+	}
+	inherited::redraw(context,clip);
+}
+
+void render_cache::remove_notify(component& c)
+{
+	if (&c==_content)
+	{
+		discard();
+		_content=0;
+		force_redraw();
+		invalidate();
+	}
+}
+
+void render_cache::redraw_notify(const box& clip)
+{
+	if (_sprite)
+	{
+		if (empty(_dirty)) _dirty=clip;
+		else _dirty|=clip;
+		_dirty&=bbox();
+	}
+}
+
+void render_cache::icon_notify(bool created)
+{
+	if (created) ++_icons;
+	else if (_icons) --_icons;
+	discard();
+}
+
+bool render_cache::redraw_cached(gcontext& context)
+{
+	// Icons are drawn by the Wimp before the redraw loop begins, so
+	// they would be painted over by the sprite.
+	if (_icons) return false;
+
+	// The sprite can only be drawn by a VDU graphics context, and
+	// printed output should be rendered at the resolution of the printer.
+	graphics::vdu_gcontext* vcontext=
+		dynamic_cast<graphics::vdu_gcontext*>(&context);
+	if (!vcontext) return false;
+	if (dynamic_cast<graphics::print_gcontext*>(vcontext)) return false;
+
+	// The sprite can only be cleared if the window has a background.
+	basic_window* w=parent_work_area();
+	if (!w||(w->wb_colour()==255)) return false;
+
+	// Discard the sprite if it no longer matches the screen mode
+	// or the bounding box.
+	box bbox=this->bbox();
+	point size=bbox.xmaxymax()-bbox.xminymin();
+	if (_sprite&&(!_sprite->compatible()||(_sprite->size()!=size))) discard();
+
+	// Create the sprite if necessary, unless it would be too large.
+	if (!_sprite)
+	{
+		if (empty(bbox)) return false;
+		if (graphics::sprite_gcontext::memory(size)>_memory_limit) return false;
+		try
+		{
+			_sprite=new graphics::sprite_gcontext(-bbox.xminymin(),size);
+		}
+		catch (std::bad_alloc&)
+		{
+			return false;
+		}
+		_dirty=bbox;
+	}
+
+	// Render any part of the sprite that is not valid.
+	if (!empty(_dirty))
+	{
+		try
+		{
+			_sprite->clip(_dirty);
+			_sprite->fcolour(w->wb_colour());
+			_sprite->plot(4,_dirty.xminymin());
+			_sprite->plot(101,_dirty.xmaxymax()-point(1,1));
+			_content->redraw(*_sprite,_dirty);
+		}
+		catch (...)
+		{
+			// Output must not be left redirected to the sprite.
+			graphics::vdu_gcontext::current(0);
+			discard();
+			throw;
+		}
+		_dirty=box();
+	}
+
+	vcontext->draw(*_sprite,bbox.xminymin());
+	return true;
+}
+
+} /* namespace desktop */
+} /* namespace rtk */
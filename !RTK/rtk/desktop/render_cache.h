@@ -0,0 +1,126 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#ifndef _RTK_DESKTOP_RENDER_CACHE
+#define _RTK_DESKTOP_RENDER_CACHE
+
+#include "rtk/desktop/sizeable_component.h"
+
+namespace rtk {
+namespace graphics {
+
+class gcontext;
+class sprite_gcontext;
+
+} /* namespace graphics */
+
+namespace desktop {
+
+/** A class for retaining a rendered copy of a child component.
+ * This component can contain one child component, which it draws into
+ * an off-screen sprite.  Subsequent redraws are satisfied by plotting
+ * the sprite, so that (for example) dragging a window over content that
+ * is expensive to render does not require it to be rendered again.
+ *
+ * The parts of the sprite that are affected by force_redraw(),
+ * force_update() or block_copy() (when called for the child or any of
+ * its descendants) are rendered again when next needed.  The whole
+ * sprite is discarded if the layout is invalidated, if the bounding box
+ * changes, or if the screen mode changes.
+ *
+ * The child is drawn directly, without using the sprite, if:
+ * - the child or any of its descendants owns an icon (since icons
+ *   are drawn by the Wimp, beneath the sprite);
+ * - the sprite would need more memory than the memory limit allows;
+ * - the window background is transparent;
+ * - the graphics context is not a VDU graphics context; or
+ * - the graphics context is a print graphics context.
+ */
+class render_cache:
+	public sizeable_component
+{
+private:
+	/** The class from which this one is derived. */
+	typedef sizeable_component inherited;
+
+	/** The child component. */
+	component* _content;
+
+	/** The sprite graphics context containing the rendered copy,
+	 * or 0 if there is none. */
+	graphics::sprite_gcontext* _sprite;
+
+	/** The bounding box of the region of the sprite that must be
+	 * rendered again before it is next drawn, with respect to the
+	 * origin of this component.  This is empty if the whole sprite
+	 * is valid. */
+	box _dirty;
+
+	/** The maximum amount of memory to be used by the sprite,
+	 * in bytes. */
+	unsigned int _memory_limit;
+
+	/** The number of icons owned by the child and its descendants. */
+	unsigned int _icons;
+public:
+	/** Construct render cache. */
+	render_cache();
+
+	/** Destroy render cache. */
+	virtual ~render_cache();
+
+	virtual box auto_bbox() const;
+	virtual box bbox() const;
+	virtual void resize() const;
+	virtual void reformat(const point& origin,const box& pbbox);
+	virtual void unformat();
+	virtual void redraw(gcontext& context,const box& clip);
+
+	/** Add the child component.
+	 * @param c the child component to add
+	 * @return a reference to this
+	 */
+	render_cache& add(component& c);
+
+	/** Get memory limit.
+	 * @return the maximum amount of memory to be used by the sprite,
+	 *  in bytes
+	 */
+	unsigned int memory_limit() const
+		{ return _memory_limit; }
+
+	/** Set memory limit.
+	 * If the child component would need a larger sprite than this
+	 * then it is drawn directly.
+	 * @param limit the maximum amount of memory to be used by the
+	 *  sprite, in bytes
+	 * @return a reference to this
+	 */
+	render_cache& memory_limit(unsigned int limit);
+
+	/** Discard rendered copy.
+	 * The sprite is released, and the child will be rendered again
+	 * when next needed.
+	 */
+	void discard();
+protected:
+	virtual void remove_notify(component& c);
+	virtual void redraw_notify(const box& clip);
+	virtual void icon_notify(bool created);
+private:
+	/** Redraw child component using sprite.
+	 * The sprite is created and rendered as necessary.
+	 * @param context the graphics context within which the
+	 *  redraw should take place
+	 * @return true if the child was drawn, false if it must be
+	 *  drawn directly
+	 */
+	bool redraw_cached(gcontext& context);
+};
+
+} /* namespace desktop */
+} /* namespace rtk */
+
+#endif
@@ -8,6 +8,8 @@
 
 #include "rtk/util/divider.h"
 #include "rtk/graphics/gcontext.h"
+#include "rtk/desktop/basic_window.h"
+#include "rtk/desktop/layout_deferral.h"
 #include "rtk/desktop/row_layout.h"
 
 namespace rtk {
@@ -23,6 +25,9 @@ row_layout::row_layout(size_type xcells):
 
 box row_layout::auto_bbox() const
 {
+	// Return cached value if possible.
+	if (_abbox_valid&&size_valid()) return _abbox;
+
 	// Determine number of cells.
 	size_type xcells=_components.size();
 
@@ -57,8 +62,10 @@ box row_layout::auto_bbox() const
 	// corner of layout.
 	box abbox(0,-ysize,xsize,0);
 
-	// Translate to external origin and return.
+	// Translate to external origin, cache and return.
 	abbox-=external_origin(abbox,xbaseline_left,ybaseline_top);
+	_abbox=abbox;
+	_abbox_valid=true;
 	return abbox;
 }
 
@@ -79,6 +86,18 @@ void row_layout::reformat(const point& origin,const box& pbbox)
 	inherited::reformat(origin,bbox);
 	if (moved) force_redraw(true);
 
+	// If this layout has moved with respect to the work area then
+	// every child must be reformatted, because some (such as icons)
+	// are positioned with respect to the work area.
+	point wapos;
+	basic_window* w=parent_work_area(wapos);
+	bool shifted=(wapos!=_wapos);
+	_wapos=wapos;
+
+	// Children which are not visible may be reformatted last, or left
+	// for a later pass, if there is a layout budget.
+	layout_deferral deferral(w,wapos);
+
 	// Remove margin.
 	box ibox(_bbox-_margin);
 
@@ -93,7 +112,9 @@ void row_layout::reformat(const point& origin,const box& pbbox)
 	if (xspread<0) xspread=0;
 	divider xdiv(xexcess,xspread);
 
-	// Set minimum x-coordinate for each cell.
+	// Set minimum x-coordinate for each cell and place children.
+	// Since each cell depends only on those to its left, both can be
+	// done in a single pass.
 	int xpos=ibox.xmin();
 	_xmin[0]=xpos;
 	for (size_type x=0;x!=xcells;++x)
@@ -107,16 +128,12 @@ void row_layout::reformat(const point& origin,const box& pbbox)
 		xpos+=xsize+xdiv(xsize);
 		xpos+=_xgap;
 		_xmin[x+1]=xpos;
-	}
 
-	// Place children.
-	for (size_type x=0;x!=xcells;++x)
-	{
-		if (component* c=_components[x])
+		if (c)
 		{
 			// Create x-baseline set for just this cell.
 			xbaseline_set xbs;
-			xbs.add(c->min_bbox(),c->xbaseline());
+			xbs.add(mcbbox,c->xbaseline());
 
 			// Construct bounding box for cell with respect to origin
 			// of layout.
@@ -133,10 +150,18 @@ void row_layout::reformat(const point& origin,const box& pbbox)
 			// Calculate origin of cell with respect to origin of layout.
 			point cpos(cbbox.xminymin()+coffset);
 
-			// Reformat child.
-			c->reformat(cpos,cbbox-cpos);
+			// Reformat child, unless its layout is valid and it would
+			// be given the same origin and bounding box as last time.
+			box cpbbox(cbbox-cpos);
+			if (shifted||!c->layout_valid()||
+				(cpos!=c->origin())||(cpbbox!=_pbboxes[x]))
+			{
+				_pbboxes[x]=cpbbox;
+				deferral.reformat(*c,cpos,cpbbox);
+			}
 		}
 	}
+	deferral.reformat();
 }
 
 } /* namespace desktop */
@@ -0,0 +1,38 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#include "rtk/swi/os.h"
+#include "rtk/os/os.h"
+#include "rtk/desktop/screen_metrics.h"
+
+namespace rtk {
+namespace desktop {
+
+int screen_metrics::_xeigfactor=0;
+int screen_metrics::_yeigfactor=0;
+int screen_metrics::_log2bpp=0;
+int screen_metrics::_xwindlimit=0;
+int screen_metrics::_ywindlimit=0;
+unsigned int screen_metrics::_epoch=0;
+bool screen_metrics::_valid=false;
+
+void screen_metrics::invalidate()
+{
+	_valid=false;
+	++_epoch;
+}
+
+void screen_metrics::update()
+{
+	os::OS_ReadModeVariable(swi::XEigFactor,&_xeigfactor);
+	os::OS_ReadModeVariable(swi::YEigFactor,&_yeigfactor);
+	os::OS_ReadModeVariable(swi::Log2BPP,&_log2bpp);
+	os::OS_ReadModeVariable(swi::XWindLimit,&_xwindlimit);
+	os::OS_ReadModeVariable(swi::YWindLimit,&_ywindlimit);
+	_valid=true;
+}
+
+} /* namespace desktop */
+} /* namespace rtk */
@@ -0,0 +1,117 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#ifndef _RTK_DESKTOP_SCREEN_METRICS
+#define _RTK_DESKTOP_SCREEN_METRICS
+
+namespace rtk {
+namespace desktop {
+
+/** A class for caching the properties of the current screen mode.
+ * The relevant mode variables are read once, then cached until
+ * invalidate() is called.  The application object does this whenever
+ * it receives a Message_ModeChange or Message_PaletteChange, so there
+ * should be no need for other code to call invalidate() directly.
+ *
+ * All members of this class are static, because the screen mode is
+ * a property of the machine as a whole.
+ */
+class screen_metrics
+{
+private:
+	/** The number of bits by which to shift pixels to obtain
+	 * OS units (horizontally). */
+	static int _xeigfactor;
+
+	/** The number of bits by which to shift pixels to obtain
+	 * OS units (vertically). */
+	static int _yeigfactor;
+
+	/** The number of bits per pixel, as a power of two. */
+	static int _log2bpp;
+
+	/** The width of the screen in pixels, minus one. */
+	static int _xwindlimit;
+
+	/** The height of the screen in pixels, minus one. */
+	static int _ywindlimit;
+
+	/** The mode epoch.
+	 * This is incremented each time the cached values are invalidated.
+	 */
+	static unsigned int _epoch;
+
+	/** The valid flag.
+	 * True if the cached values are valid, otherwise false.
+	 */
+	static bool _valid;
+public:
+	/** Get horizontal eigen factor.
+	 * @return the number of bits by which to shift pixels to obtain
+	 *  OS units (horizontally)
+	 */
+	static int xeigfactor()
+		{ if (!_valid) update(); return _xeigfactor; }
+
+	/** Get vertical eigen factor.
+	 * @return the number of bits by which to shift pixels to obtain
+	 *  OS units (vertically)
+	 */
+	static int yeigfactor()
+		{ if (!_valid) update(); return _yeigfactor; }
+
+	/** Get width of pixel.
+	 * @return the width of a pixel in OS units
+	 */
+	static unsigned int xpix()
+		{ return 1<<xeigfactor(); }
+
+	/** Get height of pixel.
+	 * @return the height of a pixel in OS units
+	 */
+	static unsigned int ypix()
+		{ return 1<<yeigfactor(); }
+
+	/** Get pixel depth.
+	 * @return the number of bits per pixel, as a power of two
+	 */
+	static int log2bpp()
+		{ if (!_valid) update(); return _log2bpp; }
+
+	/** Get width of screen.
+	 * @return the width of the screen in pixels, minus one
+	 */
+	static int xwindlimit()
+		{ if (!_valid) update(); return _xwindlimit; }
+
+	/** Get height of screen.
+	 * @return the height of the screen in pixels, minus one
+	 */
+	static int ywindlimit()
+		{ if (!_valid) update(); return _ywindlimit; }
+
+	/** Get mode epoch.
+	 * This changes whenever the cached values are invalidated.  It can
+	 * be used by other caches which depend on the screen mode to
+	 * determine when they too should be invalidated.
+	 * @return the mode epoch
+	 */
+	static unsigned int epoch()
+		{ return _epoch; }
+
+	/** Invalidate cached values.
+	 * The values will be re-read from the operating system when
+	 * they are next needed.
+	 */
+	static void invalidate();
+private:
+	/** Read values from operating system. */
+	static void update();
+};
+
+} /* namespace desktop */
+} /* namespace rtk */
+
+#endif
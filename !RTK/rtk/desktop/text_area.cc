@@ -5,6 +5,7 @@
 
 #include <memory>
 #include <algorithm>
+#include <limits>
 
 #include "rtk/swi/os.h"
 #include "rtk/swi/wimp.h"
@@ -14,9 +15,11 @@
 #include "rtk/os/wimp.h"
 
 #include "rtk/graphics/gcontext.h"
+#include "rtk/graphics/run_list.h"
 
 #include "rtk/desktop/basic_window.h"
 #include "rtk/desktop/application.h"
+#include "rtk/desktop/screen_metrics.h"
 #include "rtk/desktop/text_area.h"
 
 #include "rtk/events/auto_scroll.h"
@@ -71,10 +74,12 @@ control_string::control_string(char code)
 } /* anonymous namespace */
 
 text_area::text_area():
+	_layout_width(0),
 	_font(graphics::font::font_desktop),
 	_fcolour(7),
 	_bcolour(0),
 	_ccolour(11),
+	_hcolour(9),
 	_line_height(auto_line_height()),
 	_baseline_offset(auto_baseline_offset()),
 	_auto_line_height(true),
@@ -91,16 +96,11 @@ text_area::text_area():
 	_select_first(_text,0,0),
 	_select_last(_text,0,0),
 	_dragging(false),
-	_dragref(_text,0,0)
+	_dragref(_text,0,0),
+	_journal_size(0),
+	_undo_limit(0x100000),
+	_coalesce(false)
 {
-	// There must always be at least one paragraph.
-	_text.push_back(string());
-
-	// Initialise coordinate block, for the font manager.
-	// This is used to specify the split character.
-	// (The other fields do not need to be initialised.)
-	_font_coord_block.split_char=split_char;
-
 	// Initialise _bbox, _tbbox and _lines.
 	// (The width used here should be large enough to avoid
 	// excessive line wrapping, but is otherwise arbitrary.)
@@ -108,7 +108,10 @@ text_area::text_area():
 }
 
 text_area::~text_area()
-{}
+{
+	discard_layout(0,_layout.size());
+	discard_matches(0,_match_offsets.size());
+}
 
 box text_area::bbox() const
 {
@@ -118,9 +121,7 @@ box text_area::bbox() const
 box text_area::min_bbox() const
 {
 	// Determine number of OS units per pixel (horizontally).
-	int xeigfactor=0;
-	os::OS_ReadModeVariable(swi::XEigFactor,&xeigfactor);
-	unsigned int xpix=1<<xeigfactor;
+	unsigned int xpix=screen_metrics::xpix();
 
 	// Update _min_bbox_valid.
 	if (!size_valid()) resize();
@@ -128,12 +129,8 @@ box text_area::min_bbox() const
 	if (!_min_bbox_valid)
 	{
 		// Calculate width and height, without line wrap.
-		int xsize=0;
-		for (unsigned int i=0;i!=_text.size();++i)
-		{
-			const string ptext=_text[i];
-			xsize=max(xsize,line_width(ptext,0,ptext.length()));
-		}
+		// (The width of each paragraph is already known.)
+		int xsize=max(_para_widths.max(0,_para_widths.size()),0);
 		int ysize=_text.size()*line_height();
 
 		// Construct minimum bounding box, with respect to top
@@ -167,23 +164,35 @@ box text_area::min_wrap_bbox(const box& wbox) const
 	{
 		// Calculate width and height, with line wrap.
 		int xsize=wbox.xsize();
-		int ysize=0;
+		unsigned int lines=0;
 
-		for (unsigned int i=0;i!=_text.size();++i)
+		if (xsize==_layout_width)
 		{
-			// Count number of lines in paragraph.
-			unsigned int lines=1;
-			const string ptext=_text[i];
-			unsigned int j=split_line(ptext,0,xsize);
-			while (j<ptext.size())
+			// If the requested width matches the current layout
+			// then the number of lines is already known.
+			lines=_lines.sum(_lines.size());
+		}
+		else
+		{
+			for (unsigned int i=0;i!=_text.size();++i)
 			{
-				j+=split_line(ptext,j,xsize);
+				// A paragraph which is narrower than the requested
+				// width must occupy exactly one line.  Otherwise,
+				// count number of lines in paragraph.
 				++lines;
+				if (_para_widths[i]>=xsize)
+				{
+					const para_view ptext=_text[i];
+					unsigned int j=split_line(ptext,0,xsize);
+					while (j<ptext.size())
+					{
+						j+=split_line(ptext,j,xsize);
+						++lines;
+					}
+				}
 			}
-
-			// Add multiple of line height to bounding box.
-			ysize+=lines*line_height();
 		}
+		int ysize=lines*line_height();
 
 		// Construct minimum bounding box, with respect to top left-hand
 		// corner of text area.
@@ -276,86 +285,72 @@ void text_area::redraw(gcontext& context,const box& clip)
 
 	// Redraw paragraphs within clip box.
 	// Loop over paragraphs.
-	int width=tbbox().xsize();
 	for (unsigned int i=pmin;i!=pmax;++i)
 	{
 		// Extract paragraph text, determine line number.
-		const string text=_text[i];
+		// The line breaks are taken from the layout cache.
+		const para_view text=_text[i];
+		const para_layout& pl=layout(i);
 		unsigned int line=_lines.sum(i);
 
-		// Split paragraph into lines.
-		unsigned int j=0;
-		while (j<text.size())
+		// Loop over lines within paragraph, rendering only those
+		// which fall within the clip box.
+		for (unsigned int j=0;j!=pl.lines();++j,++line)
 		{
-			// Calculate coordinate for bottom of line.
-			int ymin=tbbox().ymax()-(line+1)*line_height();
-
-			// Decide where to split line.
-			unsigned int k=split_line(text,j,width);
-
-			// Render line.
-			point p(tbbox().xmin(),ymin+baseline_offset());
-			render_line(context,text,j,k,p);
+			unsigned int index=pl.start(j);
+			unsigned int count=pl.start(j+1)-index;
+			if (count&&(line>=lmin)&&(line<lmax))
+			{
+				// Calculate coordinate for bottom of line.
+				int ymin=tbbox().ymax()-(line+1)*line_height();
 
-			// Move forwards in paragraph
-			// and down one line on screen.
-			j+=k;
-			++line;
+				// Render line.
+				point p(tbbox().xmin(),ymin+baseline_offset());
+				render_line(context,i,text,index,count,p);
+			}
 		}
 	}
 
-	fixed_mark select_first_pos(*this,_select_first);
-	fixed_mark select_last_pos(*this,_select_last);
-
-	// Redraw selection.
-	if ((select_first_pos.line()<lmax)&&(select_last_pos.line()>=lmin))
+	// Redraw selection (if there is one).
+	if (has_selection())
 	{
-		// Determine how many OS units are in a pixel.
-		int xeigfactor=0;
-		int yeigfactor=0;
-		os::OS_ReadModeVariable(swi::XEigFactor,&xeigfactor);
-		os::OS_ReadModeVariable(swi::YEigFactor,&yeigfactor);
-		unsigned int xpix=1<<xeigfactor;
-		unsigned int ypix=1<<yeigfactor;
+		fixed_mark select_first_pos(*this,_select_first);
+		fixed_mark select_last_pos(*this,_select_last);
 
-		// Loop over lines that are at least partially within the selection.
-		for (unsigned int i=select_first_pos.line();i<=select_last_pos.line();
-			++i)
+		if ((select_first_pos.line()<lmax)&&(select_last_pos.line()>=lmin))
 		{
-			// Extract paragraph text for line.
-			const string text=_text[_lines.find(i)];
-
-			// Initially, assume that the selection covers the whole line.
-			int xmin=tbbox().xmin();
-			int xmax=tbbox().xmax();
-
-			// If this is the first line of the selection then it may not
-			// extend to the left margin.
-			if (i==select_first_pos.line())
-			{
-				unsigned int index=select_first_pos.index_para()-
-					select_first_pos.index_line();
-				xmin=tbbox().xmin()+
-					line_width(text,index,select_first_pos.index_line());
-			}
-
-			// If this is the last line of the selection then it may not
-			// extend to the right margin.
-			if (i==select_last_pos.line())
-			{
-				unsigned int index=select_last_pos.index_para()-
-					select_last_pos.index_line();
-				xmax=tbbox().xmin()+
-					line_width(text,index,select_last_pos.index_line());
-			}
-
-			// Provided at least part of the line remains, invert it.
-			if (xmax!=xmin)
+			// Determine how many OS units are in a pixel.
+			unsigned int xpix=screen_metrics::xpix();
+			unsigned int ypix=screen_metrics::ypix();
+
+			// Loop over lines that are at least partially within both
+			// the selection and the clip box.
+			unsigned int smin=max(select_first_pos.line(),lmin);
+			unsigned int smax=min(select_last_pos.line()+1,lmax);
+			for (unsigned int i=smin;i<smax;++i)
 			{
-				int ymax=tbbox().ymax()-i*line_height();
-				int ymin=ymax-line_height();
-				context.plot(68,point(xmin,ymin));
-				context.plot(102,point(xmax-xpix,ymax-ypix));
+				// Initially, assume that the selection covers the whole line.
+				int xmin=tbbox().xmin();
+				int xmax=tbbox().xmax();
+
+				// If this is the first line of the selection then it may not
+				// extend to the left margin.
+				if (i==select_first_pos.line())
+					xmin=select_first_pos.position().x();
+
+				// If this is the last line of the selection then it may not
+				// extend to the right margin.
+				if (i==select_last_pos.line())
+					xmax=select_last_pos.position().x();
+
+				// Provided at least part of the line remains, invert it.
+				if (xmax!=xmin)
+				{
+					int ymax=tbbox().ymax()-i*line_height();
+					int ymin=ymax-line_height();
+					context.plot(68,point(xmin,ymin));
+					context.plot(102,point(xmax-xpix,ymax-ypix));
+				}
 			}
 		}
 	}
@@ -492,6 +487,8 @@ void text_area::handle_event(events::key_pressed& ev)
 	case 0x018:handle_cut(); break;
 	case 0x01e:handle_start_of_line(); break;
 	case 0x07f:handle_delete_right(); break;
+	case 0x188:handle_undo(); break;
+	case 0x189:handle_redo(); break;
 	case 0x18b:handle_end_of_line(); break;
 	case 0x18c:handle_left_char(); break;
 	case 0x18d:handle_right_char(); break;
@@ -629,36 +626,24 @@ void text_area::handle_event(events::loaded& ev)
 
 text_area::text_type text_area::text() const
 {
-	return _text;
+	return extract(begin(),end());
 }
 
 text_area::text_type text_area::selection() const
 {
-	// Extract minimal sequence of paragraphs that contains the selection.
-	text_type selection=_text.substr(_select_first.para(),
-		_select_last.para()-_select_first.para()+1);
-
-	// Ensure that selection is at least one paragraph long.
-	if (!selection.size()) selection.push_back(string());
-
-	// Remove extraneous text from end.
-	string suffix=selection.back().substr(0,_select_last.index_para());
-	selection.pop_back();
-	selection.push_back(suffix);
-
-	// Remove extraneous text from start.
-	string prefix=selection.front().substr(_select_first.index_para(),
-		string::npos);
-	selection.pop_front();
-	selection.push_front(prefix);
-
-	// Return remaining text.
-	return selection;
+	return extract(_select_first,_select_last);
 }
 
 text_area& text_area::text(const text_type& text)
 {
-	if (!_read_only) replace(begin(),end(),text);
+	if (!_read_only)
+	{
+		// Replacing the whole text (as when a file is loaded) begins
+		// a new document, so it is not recorded as an edit and any
+		// existing journal no longer applies.
+		apply(begin(),end(),text);
+		clear_undo();
+	}
 	return *this;
 }
 
@@ -673,6 +658,192 @@ bool text_area::has_selection() const
 	return _select_last!=_select_first;
 }
 
+text_area& text_area::undo()
+{
+	if (!_undo.empty()&&!_read_only)
+	{
+		// Replace the inserted text with the removed text, then
+		// transfer the record to the redo journal.
+		edit_record er=_undo.back();
+		_undo.pop_back();
+		mark first(_text,er.para,er.index_para);
+		apply(first,end_of(first,er.inserted),er.removed);
+		_redo.push_back(er);
+		_coalesce=false;
+	}
+	return *this;
+}
+
+text_area& text_area::redo()
+{
+	if (!_redo.empty()&&!_read_only)
+	{
+		// Replace the removed text with the inserted text, then
+		// transfer the record back to the undo journal.
+		edit_record er=_redo.back();
+		_redo.pop_back();
+		mark first(_text,er.para,er.index_para);
+		apply(first,end_of(first,er.removed),er.inserted);
+		_undo.push_back(er);
+		_coalesce=false;
+	}
+	return *this;
+}
+
+text_area& text_area::clear_undo()
+{
+	_undo.clear();
+	_redo.clear();
+	_journal_size=0;
+	_coalesce=false;
+	return *this;
+}
+
+text_area& text_area::select(const mark& first,const mark& last)
+{
+	show_selection(first,last);
+	return *this;
+}
+
+bool text_area::find(const string& needle,const mark& from,mark& found) const
+{
+	util::byte_search search(needle);
+	for (unsigned int i=from.para();i<_text.size();++i)
+	{
+		const para_view ptext=_text[i];
+		unsigned int index=(i==from.para())?from.index_para():0;
+		index=search.find(ptext.data(),ptext.size(),index);
+		if (index!=util::byte_search::npos)
+		{
+			found=mark(_text,i,index);
+			return true;
+		}
+	}
+	return false;
+}
+
+unsigned int text_area::count(const string& needle) const
+{
+	util::byte_search search(needle);
+	unsigned int count=0;
+	if (!search.empty())
+	{
+		for (unsigned int i=0;i!=_text.size();++i)
+		{
+			const para_view ptext=_text[i];
+			count+=search.count(ptext.data(),ptext.size());
+		}
+	}
+	return count;
+}
+
+unsigned int text_area::replace_all(const string& needle,
+	const string& replacement)
+{
+	util::byte_search search(needle);
+	unsigned int count=0;
+	if (_read_only||search.empty()) return count;
+
+	// Construct replacement text, from the first paragraph that
+	// contains a match to the last.  Paragraphs in between that do
+	// not contain a match are copied unchanged.
+	text_type new_text;
+	unsigned int first_para=0;
+	unsigned int last_para=0;
+	for (unsigned int i=0;i!=_text.size();++i)
+	{
+		const para_view ptext=_text[i];
+		unsigned int index=search.find(ptext.data(),ptext.size());
+		if (index!=util::byte_search::npos)
+		{
+			// Copy any unchanged paragraphs since the previous match.
+			if (count)
+			{
+				for (unsigned int j=last_para+1;j!=i;++j)
+					new_text.push_back(_text[j].str());
+			}
+			else first_para=i;
+
+			// Construct replacement paragraph.
+			string new_ptext;
+			unsigned int prev=0;
+			while (index!=util::byte_search::npos)
+			{
+				new_ptext.append(ptext.data()+prev,index-prev);
+				new_ptext.append(replacement);
+				prev=index+needle.size();
+				index=search.find(ptext.data(),ptext.size(),prev);
+				++count;
+			}
+			new_ptext.append(ptext.data()+prev,ptext.size()-prev);
+			new_text.push_back(new_ptext);
+			last_para=i;
+		}
+	}
+
+	// Replace all affected paragraphs as a single edit, so that
+	// they are undone in one step.
+	if (count)
+	{
+		mark first(_text,first_para,0);
+		mark last(_text,last_para,_text[last_para].size());
+		_coalesce=false;
+		replace(first,last,new_text);
+	}
+	return count;
+}
+
+text_area& text_area::search(const string& needle)
+{
+	if (needle!=_search.needle())
+	{
+		// Find matches in each paragraph.
+		_search=util::byte_search(needle);
+		discard_matches(0,_match_offsets.size());
+		_matches=util::cumulative_sum<unsigned int>();
+		_match_offsets.clear();
+		if (!_search.empty())
+		{
+			_matches.resize(_text.size());
+			_match_offsets.resize(_text.size(),0);
+			for (unsigned int i=0;i!=_text.size();++i)
+				scan_matches(i);
+		}
+
+		// Redraw everything, to update the highlighting.
+		force_redraw();
+	}
+	return *this;
+}
+
+bool text_area::find_next(const mark& from,mark& found) const
+{
+	if (_search.empty()) return false;
+
+	// Search the remainder of the first paragraph.
+	unsigned int para=from.para();
+	if (para>=_text.size()) return false;
+	const para_view ptext=_text[para];
+	unsigned int index=_search.find(ptext.data(),ptext.size(),
+		from.index_para());
+	if (index!=util::byte_search::npos)
+	{
+		found=mark(_text,para,index);
+		return true;
+	}
+
+	// Use the match counts to locate the next paragraph that contains
+	// a match: it is the one containing the match which follows all
+	// of those up to and including the first paragraph.
+	unsigned int next=_matches.sum(para+1);
+	if (next==match_count()) return false;
+	para=_matches.find(next);
+	const para_view ntext=_text[para];
+	index=_search.find(ntext.data(),ntext.size());
+	found=mark(_text,para,index);
+	return true;
+}
+
 text_area::mark text_area::begin() const
 {
 	return mark(_text,0,0);
@@ -680,7 +851,7 @@ text_area::mark text_area::begin() const
 
 text_area::mark text_area::end() const
 {
-	return mark(_text,_text.size()-1,_text.back().size());
+	return mark(_text,_text.size()-1,_text.length(_text.size()-1));
 }
 
 void text_area::handle_left_char()
@@ -858,12 +1029,22 @@ void text_area::handle_paste()
 			block->word[9]=4;
 			block->word[10]=0xfff;
 			block->word[11]=-1;
-			app->send_message(swi::User_Message,*(block.release()),0,0);
+			app->send_message(swi::User_Message,*block,0,0);
 			app->add(_loadop);
 		}
 	}
 }
 
+void text_area::handle_undo()
+{
+	undo();
+}
+
+void text_area::handle_redo()
+{
+	redo();
+}
+
 text_area& text_area::font(const graphics::font& font)
 {
 	_font=font;
@@ -902,6 +1083,16 @@ text_area& text_area::ccolour(int ccolour)
 	return *this;
 }
 
+text_area& text_area::hcolour(int hcolour)
+{
+	if (hcolour!=_hcolour)
+	{
+		_hcolour=hcolour;
+		if (!_search.empty()) force_redraw();
+	}
+	return *this;
+}
+
 text_area& text_area::line_height(int line_height)
 {
 	_auto_line_height=!line_height;
@@ -936,6 +1127,14 @@ text_area& text_area::read_only(bool read_only)
 	return *this;
 }
 
+text_area& text_area::undo_limit(unsigned int undo_limit)
+{
+	_undo_limit=undo_limit;
+	if (!_undo_limit) clear_undo();
+	trim_undo();
+	return *this;
+}
+
 text_area& text_area::selection_model(selection_model_type selection_model)
 {
 	if (_selection_model!=selection_model)
@@ -990,58 +1189,94 @@ int text_area::auto_baseline_offset() const
 	return line_height()/4;
 }
 
-void text_area::render_line(gcontext& context,const string& ptext,
-	unsigned int index,unsigned int count,const point& p) const
+void text_area::render_line(gcontext& context,unsigned int para,
+	const para_view& ptext,unsigned int index,unsigned int count,
+	const point& p) const
 {
 	// As a precaution, place limits on index and count.
 	if (index>ptext.size()) index=ptext.size();
 	if (count>ptext.size()-index) count=ptext.size()-index;
 
+	// Find matches for the search pattern which overlap the line.
+	// The offsets were found when the paragraph was last scanned, so
+	// only a binary search is needed to locate the first one.
+	std::vector<unsigned int> hl;
+	if ((para<_match_offsets.size())&&_match_offsets[para])
+	{
+		const std::vector<unsigned int>& offsets=*_match_offsets[para];
+		unsigned int nsize=_search.needle().size();
+		std::vector<unsigned int>::const_iterator j=(index>=nsize)?
+			std::upper_bound(offsets.begin(),offsets.end(),index-nsize):
+			offsets.begin();
+		for (;(j!=offsets.end())&&(*j<index+count);++j)
+		{
+			hl.push_back(max(*j,index));
+			hl.push_back(min(*j+nsize,index+count));
+		}
+	}
+
+	// Fill the background of each match with the highlight colour.
+	if (!hl.empty())
+	{
+		unsigned int xpix=screen_metrics::xpix();
+		unsigned int ypix=screen_metrics::ypix();
+		int ymin=p.y()-baseline_offset();
+		int ymax=ymin+line_height();
+		context.fcolour(_hcolour);
+		for (unsigned int k=0;k!=hl.size();k+=2)
+		{
+			int xmin=p.x()+line_width(ptext,index,hl[k]-index);
+			int xmax=xmin+line_width(ptext,hl[k],hl[k+1]-hl[k]);
+			context.plot(4,point(xmin,ymin));
+			context.plot(101,point(xmax-xpix,ymax-ypix));
+		}
+	}
+
 	// Initialise pointers: beginning, end and iterator.
-	const char* b=ptext.c_str()+index;
+	const char* b=ptext.data()+index;
 	const char* e=b+count;
 	const char* t=b;
 
-	int x=p.x();
-	int y=p.y();
+	// Build a run list for the line, so that it can be drawn as a
+	// single operation.  Each run is confined to either highlighted
+	// or unhighlighted text.
+	graphics::run_list runs;
+	unsigned int k=0;
 	while (t!=e)
 	{
-		// Let f be a non-const pointer into the string.
-		// Note that the string must remain logically const,
-		// therefore any changes made to it must be undone.
-		char* f=const_cast<char*>(t);
+		// Determine the end of the current highlighted or
+		// unhighlighted section, and the background colour.
+		unsigned int pos=t-ptext.data();
+		while ((k!=hl.size())&&(hl[k+1]<=pos)) k+=2;
+		bool highlight=(k!=hl.size())&&(hl[k]<=pos);
+		const char* s=e;
+		if (k!=hl.size()) s=ptext.data()+(highlight?hl[k+1]:hl[k]);
+		int bcolour=highlight?_hcolour:_bcolour;
 
 		// Move f to the next non-printable character
-		// (or the end of the string if that occurs first).
-		while ((f!=e)&&isprint(*f)) ++f;
+		// (or the end of the section if that occurs first).
+		const char* f=t;
+		while ((f!=s)&&isprint(*f)) ++f;
 
 		if (f!=t)
 		{
-			// If at least one printable character then render those
-			// characters (after inserting a temporary terminator).
-			char temp=0;
-			std::swap(*f,temp);
-			context.bcolour(_bcolour);
-			context.fcolour(_fcolour);
-			context.draw(_font,t,point(x,y));
-			x+=_font.width(t,f-t);
-			std::swap(*f,temp);
+			// If at least one printable character then append those
+			// characters.
+			runs.append(t,f-t,_fcolour,bcolour);
 			t=f;
 		}
 		else
 		{
-			// If no printable characters then render the first
+			// If no printable characters then append the first
 			// non-printable character (after converting to hex).
 			control_string cs(*t++);
-			context.bcolour(_bcolour);
-			context.fcolour(_ccolour);
-			context.draw(_font,cs,point(x,y));
-			x+=_font.width(cs,cs.length());
+			runs.append(cs,cs.length(),_ccolour,bcolour);
 		}
 	}
+	if (!runs.empty()) context.draw(_font,runs,p);
 }
 
-int text_area::line_width(const string& ptext,unsigned int index,
+int text_area::line_width(const para_view& ptext,unsigned int index,
 	unsigned int count) const
 {
 	// As a precaution, place limits on index and count.
@@ -1049,30 +1284,24 @@ int text_area::line_width(const string& ptext,unsigned int index,
 	if (count>ptext.size()-index) count=ptext.size()-index;
 
 	// Initialise pointers: beginning, end and iterator.
-	const char* b=ptext.c_str()+index;
+	const char* b=ptext.data()+index;
 	const char* e=b+count;
 	const char* t=b;
 
 	int width=0;
 	while (t!=e)
 	{
-		// Let f be a non-const pointer into the string.
-		// Note that the string must remain logically const,
-		// therefore any changes made to it must be undone.
-		char* f=const_cast<char*>(t);
+		const char* f=t;
 
 		// Move f to the next non-printable character
 		// (or the end of the string if that occurs first).
 		while ((f!=e)&&isprint(*f)) ++f;
 
-		// If at least one non-printable character then measure
-		// those characters (after inserting a temporary terminator).
+		// If at least one printable character then measure
+		// those characters.
 		if (f!=t)
 		{
-			char temp=0;
-			std::swap(*f,temp);
 			width+=_font.width(t,f-t);
-			std::swap(*f,temp);
 			t=f;
 		}
 		else
@@ -1086,23 +1315,20 @@ int text_area::line_width(const string& ptext,unsigned int index,
 	return width;
 }
 
-unsigned int text_area::find_index(const string& ptext,unsigned int index,
+unsigned int text_area::find_index(const para_view& ptext,unsigned int index,
 	int x) const
 {
 	// As a precaution, place limit on index.
 	if (index>ptext.size()) index=ptext.size();
 
 	// Initialise pointers: beginning, end and iterator.
-	const char* b=ptext.c_str()+index;
+	const char* b=ptext.data()+index;
 	const char* e=b+ptext.size()-index;
 	const char* t=b;
 
 	while (x&&t!=e)
 	{
-		// Let f be a non-const pointer into the string.
-		// Note that the string must remain logically const,
-		// therefore any changes made to it must be undone.
-		char* f=const_cast<char*>(t);
+		const char* f=t;
 
 		// Move f to the next non-printable character
 		// (or the end of the string if that occurs first).
@@ -1110,24 +1336,17 @@ unsigned int text_area::find_index(const string& ptext,unsigned int index,
 
 		if (f!=t)
 		{
-			// If at least one non-printable character then search for
-			// the specified coordinate within those characters (after
-			// inserting a temporary terminator).
-			char temp=0;
-			std::swap(*f,temp);
-			point p_mp(x*400,0);
-			point bbox;
-			const char* q=t;
-			os::Font_ScanString(_font.handle(),t,0x20180,p_mp,
-				0,0,f-t,&q,&bbox,0);
-			std::swap(*f,temp);
+			// If at least one printable character then search for
+			// the specified coordinate within those characters.
+			int w=0;
+			const char* q=t+_font.find(t,f-t,x,&w);
 
-			if ((q==f)&&(x>bbox.x()/400))
+			if ((q==f)&&(x>w))
 			{
 				// If reached end of text fragment but not specified
 				// coordinate then subtract width of fragment and
 				// continue searching.
-				x-=bbox.x()/400;
+				x-=w;
 			}
 			else
 			{
@@ -1170,7 +1389,7 @@ unsigned int text_area::find_index(const string& ptext,unsigned int index,
 	return t-b;
 }
 
-unsigned int text_area::split_line(const string& ptext,unsigned int index,
+unsigned int text_area::split_line(const para_view& ptext,unsigned int index,
 	int width,bool include_trailing) const
 {
 	// As a precaution, place limits on index, count and width.
@@ -1178,7 +1397,7 @@ unsigned int text_area::split_line(const string& ptext,unsigned int index,
 	if (width<0) width=0;
 
 	// Initialise pointers: beginning, end and iterator.
-	const char* b=ptext.c_str()+index;
+	const char* b=ptext.data()+index;
 	const char* e=b+ptext.size()-index;
 	const char* t=b;
 
@@ -1187,10 +1406,7 @@ unsigned int text_area::split_line(const string& ptext,unsigned int index,
 
 	while (width&&(t!=e))
 	{
-		// Let f be a non-const pointer into the string.
-		// Note that the string must remain logically const,
-		// therefore any changes made to it must be undone.
-		char* f=const_cast<char*>(t);
+		const char* f=t;
 
 		// Move f to the next non-printable character
 		// (or the end of the string if that occurs first).
@@ -1198,40 +1414,31 @@ unsigned int text_area::split_line(const string& ptext,unsigned int index,
 
 		if (f!=t)
 		{
-			// Insert temporary terminator.
-			char temp=0;
-			std::swap(*f,temp);
-			point p_mp(width*400,0);
 			const char* q=t;
-			point bbox;
+			int w=0;
 
 			// If line wrap method is wrap_word then try to find
 			// a break point using space as a split character.
 			if (_wrap_method==wrap_word)
 			{
-				os::Font_ScanString(_font.handle(),t,0x00120,p_mp,
-					&_font_coord_block,0,0,&q,&bbox,0);
-				if (include_trailing) while (*q==split_char) ++q;
+				q=t+_font.split(t,f-t,width,split_char,&w);
+				if (include_trailing) while ((q!=f)&&(*q==split_char)) ++q;
 			}
 
 			// If no progressat all has been made (or attempted)
 			// then try again without a split character.
 			if (q==t)
 			{
-				os::Font_ScanString(_font.handle(),t,0x00100,p_mp,
-					0,0,0,&q,&bbox,0);
-				if (include_trailing) while (*q==split_char) ++q;
+				q=t+_font.split(t,f-t,width,-1,&w);
+				if (include_trailing) while ((q!=f)&&(*q==split_char)) ++q;
 			}
 
-			// Remove temporary terminator.
-			std::swap(*f,temp);
-
-			if ((q==f)&&(width>bbox.x()/400))
+			if ((q==f)&&(width>w))
 			{
 				// If reached end of text fragment but not specified
 				// width then subtract width of fragment and continue
 				// searching.
-				width-=bbox.x()/400;
+				width-=w;
 			}
 			else
 			{
@@ -1270,6 +1477,56 @@ unsigned int text_area::split_line(const string& ptext,unsigned int index,
 	return t-b;
 }
 
+void text_area::calculate_layout(const para_view& ptext,int width,
+	para_layout& pl) const
+{
+	pl.length=ptext.size();
+	pl.starts.clear();
+	pl.widths.clear();
+
+	// Split paragraph into lines, recording the start and width
+	// of each.  There is always at least one line, even if the
+	// paragraph is empty.
+	unsigned int pos=0;
+	bool first_line=true;
+	while (first_line||(pos<ptext.size()))
+	{
+		unsigned int count=split_line(ptext,pos,width);
+		pl.starts.push_back(pos);
+		pl.widths.push_back(line_width(ptext,pos,count));
+		pos+=count;
+		first_line=false;
+	}
+}
+
+int text_area::para_width(const para_view& ptext,const para_layout& pl) const
+{
+	// If the paragraph occupies a single line then its width has
+	// already been measured.
+	if (pl.lines()==1) return pl.widths[0];
+	return line_width(ptext,0,ptext.size());
+}
+
+const text_area::para_layout& text_area::layout(unsigned int para) const
+{
+	if (!_layout[para])
+	{
+		std::auto_ptr<para_layout> pl(new para_layout);
+		calculate_layout(_text[para],_layout_width,*pl);
+		_layout[para]=pl.release();
+	}
+	return *_layout[para];
+}
+
+void text_area::discard_layout(unsigned int first,unsigned int last) const
+{
+	for (unsigned int i=first;i!=last;++i)
+	{
+		delete _layout[i];
+		_layout[i]=0;
+	}
+}
+
 text_area::mark text_area::snap(const point& p) const
 {
 	unsigned int line=max(tbbox().ymax()-p.y()-1,0)/line_height();
@@ -1285,16 +1542,10 @@ text_area::mark text_area::snap(unsigned int line,int x) const
 
 	// Find paragraph that contains line.
 	unsigned int para=_lines.find(line);
-	const string ptext=_text[para];
+	const para_view ptext=_text[para];
 
-	// Find line within paragraph.
-	unsigned int i=line-_lines.sum(para);
-	unsigned int j=0;
-	while (i>0)
-	{
-		j+=split_line(ptext,j,width);
-		--i;
-	}
+	// Find start of line within paragraph.
+	unsigned int j=layout(para).start(line-_lines.sum(para));
 
 	// Find specified coordinate within line.
 	unsigned int index_line=find_index(ptext,j,x-tbbox().xmin());
@@ -1320,29 +1571,28 @@ void text_area::reflow(int old_width,int new_width)
 	// Ensure that size of location cache matches number of paragraphs.
 	_lines.resize(_text.size());
 
-	// First pass: count number of lines, determine size of bounding box.
+	// Ensure that the layout cache matches the old width.
+	_layout.resize(_text.size(),0);
+	if (_layout_width!=old_width)
+	{
+		discard_layout(0,_layout.size());
+		_layout_width=old_width;
+	}
+
+	// First pass: calculate new layout, count number of lines,
+	// determine size of bounding box.
+	// (The old layout is taken from the layout cache.)
+	std::vector<para_layout*> new_layout(_text.size(),0);
 	unsigned int old_lines=0;
 	unsigned int new_lines=0;
 	for (unsigned int i=0;i!=_text.size();++i)
 	{
-		const string ptext=_text[i];
+		std::auto_ptr<para_layout> npl(new para_layout);
+		calculate_layout(_text[i],new_width,*npl);
+		new_layout[i]=npl.release();
 
-		unsigned int old_pos=0;
-		unsigned int new_pos=0;
-		bool first_line=true;
-		while (first_line||(old_pos<ptext.size())||(new_pos<ptext.size()))
-		{
-			bool has_old_line=first_line||(old_pos<ptext.size());
-			bool has_new_line=first_line||(new_pos<ptext.size());
-
-			old_pos+=split_line(ptext,old_pos,old_width);
-			new_pos+=split_line(ptext,new_pos,new_width);
-
-			if (has_old_line) ++old_lines;
-			if (has_new_line) ++new_lines;
-
-			first_line=false;
-		}
+		old_lines+=layout(i).lines();
+		new_lines+=new_layout[i]->lines();
 	}
 
 	// Calculate old bounding box for text area as a whole.
@@ -1358,29 +1608,12 @@ void text_area::reflow(int old_width,int new_width)
 	unsigned int new_line=0;
 	for (unsigned int i=0;i!=_text.size();++i)
 	{
-		const string ptext=_text[i];
+		const para_layout& opl=layout(i);
+		const para_layout& npl=*new_layout[i];
 
-		bool can_copy=true;
-		unsigned int old_pos=0;
-		unsigned int new_pos=0;
-		unsigned int old_para_lines=0;
-		unsigned int new_para_lines=0;
-		bool first_line=true;
-		while (first_line||(old_pos<ptext.size())||(new_pos<ptext.size()))
-		{
-			bool has_old_line=first_line||(old_pos<ptext.size());
-			bool has_new_line=first_line||(new_pos<ptext.size());
-
-			old_pos+=split_line(ptext,old_pos,old_width);
-			new_pos+=split_line(ptext,new_pos,new_width);
-
-			if (new_pos!=old_pos) can_copy=false;
-
-			if (has_old_line) ++old_para_lines;
-			if (has_new_line) ++new_para_lines;
-
-			first_line=false;
-		}
+		bool can_copy=(opl.starts==npl.starts);
+		unsigned int old_para_lines=opl.lines();
+		unsigned int new_para_lines=npl.lines();
 
 		// If paragraph has identical line breaks, but has moved
 		// upwards, then copy.
@@ -1413,29 +1646,12 @@ void text_area::reflow(int old_width,int new_width)
 	// Third pass: search for paragraphs that can be copied downwards.
 	for (unsigned int i=_text.size();i!=0;--i)
 	{
-		const string ptext=_text[i-1];
-
-		bool can_copy=true;
-		unsigned int old_pos=0;
-		unsigned int new_pos=0;
-		unsigned int old_para_lines=0;
-		unsigned int new_para_lines=0;
-		bool first_line=true;
-		while (first_line||(old_pos<ptext.size())||(new_pos<ptext.size()))
-		{
-			bool has_old_line=first_line||(old_pos<ptext.size());
-			bool has_new_line=first_line||(new_pos<ptext.size());
+		const para_layout& opl=layout(i-1);
+		const para_layout& npl=*new_layout[i-1];
 
-			old_pos+=split_line(ptext,old_pos,old_width);
-			new_pos+=split_line(ptext,new_pos,new_width);
-
-			if (new_pos!=old_pos) can_copy=false;
-
-			if (has_old_line) ++old_para_lines;
-			if (has_new_line) ++new_para_lines;
-
-			first_line=false;
-		}
+		bool can_copy=(opl.starts==npl.starts);
+		unsigned int old_para_lines=opl.lines();
+		unsigned int new_para_lines=npl.lines();
 
 		// If paragraphs have identical line breaks, but has moved
 		// downwards, then copy.
@@ -1471,24 +1687,22 @@ void text_area::reflow(int old_width,int new_width)
 	for (unsigned int i=0;i!=_text.size();++i)
 	{
 		unsigned int new_line_start=new_line;
-		const string ptext=_text[i];
+		const para_layout& opl=layout(i);
+		const para_layout& npl=*new_layout[i];
 
 		bool move_required=(nbbox.ymax()-new_line*line_height()!=
 			obbox.ymax()-old_line*line_height());
 		bool can_copy=true;
-		unsigned int old_pos=0;
-		unsigned int new_pos=0;
-		bool first_line=true;
-		while (first_line||(old_pos<ptext.size())||(new_pos<ptext.size()))
+		unsigned int lines=max(opl.lines(),npl.lines());
+		for (unsigned int j=0;j!=lines;++j)
 		{
-			bool has_old_line=first_line||(old_pos<ptext.size());
-			bool has_new_line=first_line||(new_pos<ptext.size());
-
-			unsigned int old_start=old_pos;
-			unsigned int new_start=new_pos;
+			bool has_old_line=j<opl.lines();
+			bool has_new_line=j<npl.lines();
 
-			old_pos+=split_line(ptext,old_pos,old_width);
-			new_pos+=split_line(ptext,new_pos,new_width);
+			unsigned int old_start=opl.start(j);
+			unsigned int new_start=npl.start(j);
+			unsigned int old_pos=opl.start(j+1);
+			unsigned int new_pos=npl.start(j+1);
 
 			// The can_copy flag indicates whether the paragraph seen
 			// so far can be moved by copying.  If it can then check
@@ -1504,7 +1718,6 @@ void text_area::reflow(int old_width,int new_width)
 				// The area in question must be invalidated instead.
 				if (new_line!=new_line_start)
 				{
-					int old_ymin=obbox.ymax()-old_line*line_height();
 					int new_ymin=nbbox.ymax()-new_line*line_height();
 					int new_ymax=nbbox.ymax()-new_line_start*line_height();
 					box rbox(nbbox.xmin(),new_ymin,nbbox.xmax(),new_ymax);
@@ -1530,8 +1743,8 @@ void text_area::reflow(int old_width,int new_width)
 					// If only end has changed then partial redraw
 					// will suffice.
 					unsigned int count=min(new_pos,old_pos)-old_start;
-					int x=line_width(ptext,old_start,count);
-					if (!count) x=0;
+					int x=0;
+					if (count) x=line_width(_text[i],old_start,count);
 					box rbox(nbbox.xmin()+x,new_ymin,nbbox.xmax(),new_ymax);
 					force_redraw(rbox);
 				}
@@ -1539,13 +1752,16 @@ void text_area::reflow(int old_width,int new_width)
 
 			if (has_old_line) ++old_line;
 			if (has_new_line) ++new_line;
-
-			first_line=false;
 		}
 
 		_lines[i]=new_line-new_line_start;
 	}
 
+	// Replace old layout with new.
+	discard_layout(0,_layout.size());
+	_layout.swap(new_layout);
+	_layout_width=new_width;
+
 	// If bounding box has shrunk in any direction
 	// then force redraw of region vacated.
 	if (nbbox.xmin()>obbox.xmin())
@@ -1581,24 +1797,23 @@ void text_area::reflow(int old_width,int new_width)
 
 void text_area::reflow(int width)
 {
+	// Discard any existing layout, since it cannot be relied upon
+	// (even if the width is unchanged).
+	discard_layout(0,_layout.size());
+	_layout.resize(_text.size(),0);
+	_layout_width=width;
+
 	// Ensure that size of location cache matches number of paragraphs.
 	_lines.resize(_text.size());
+	_para_widths.resize(_text.size());
 
 	// Calculate number of lines in each paragraph, record in _lines.
-	unsigned int line=0;
+	// Record unwrapped width of each paragraph in _para_widths.
 	for (unsigned int i=0;i!=_text.size();++i)
 	{
-		unsigned int line_start=line;
-		const string ptext=_text[i];
-		unsigned int pos=0;
-		bool first_line=true;
-		while (first_line||(pos<ptext.size()))
-		{
-			pos+=split_line(ptext,pos,width);
-			++line;
-			first_line=false;
-		}
-		_lines[i]=line-line_start;
+		const para_layout& pl=layout(i);
+		_lines[i]=pl.lines();
+		_para_widths[i]=para_width(_text[i],pl);
 	}
 
 	// Redraw everything.
@@ -1621,21 +1836,8 @@ void text_area::load_clipboard(mark first,mark last)
 	// Ensure that last>=first.
 	if (last<first) std::swap(last,first);
 
-	// Extract minimal sequence of paragraphs that contains the sequence.
-	_oclipboard=_text.substr(first.para(),last.para()-first.para()+1);
-
-	// Ensure that sequence is at least one paragraph long.
-	if (!_oclipboard.size()) _oclipboard.push_back(string());
-
-	// Remove extraneous text from end.
-	string suffix=_oclipboard.back().substr(0,last.index_para());
-	_oclipboard.pop_back();
-	_oclipboard.push_back(suffix);
-
-	// Remove extraneous text from start.
-	string prefix=_oclipboard.front().substr(first.index_para(),string::npos);
-	_oclipboard.pop_front();
-	_oclipboard.push_front(prefix);
+	// Extract the sequence.
+	_oclipboard=extract(first,last);
 
 	// Update save operation with new clipboard content.
 	_saveop.lines(_oclipboard.begin(),_oclipboard.end());
@@ -1748,25 +1950,15 @@ void text_area::force_redraw_between(mark first,mark last)
 	// Loop over all lines potentially within the region.
 	for (unsigned int i=first_pos.line();i<=last_pos.line();++i)
 	{
-		const string ptext=_text[_lines.find(i)];
-
 		// Assume initially that redraw covers whole region.
 		int xmin=tbbox().xmin();
 		int xmax=tbbox().xmax();
 
 		// If this is the first line then adjust the left bound.
-		if (i==first_pos.line())
-		{
-			unsigned int index=first_pos.index_para()-first_pos.index_line();
-			xmin=tbbox().xmin()+line_width(ptext,index,first_pos.index_line());
-		}
+		if (i==first_pos.line()) xmin=first_pos.position().x();
 
 		// If this is the last line then adjust the right bound.
-		if (i==last_pos.line())
-		{
-			unsigned int index=last_pos.index_para()-last_pos.index_line();
-			xmax=tbbox().xmin()+line_width(ptext,index,last_pos.index_line());
-		}
+		if (i==last_pos.line()) xmax=last_pos.position().x();
 
 		// If there is anything left then redraw between bounds.
 		if (xmax!=xmin)
@@ -1791,12 +1983,20 @@ void text_area::replace(mark first,mark last,const text_type& new_text)
 	// Ensure that last>=first.
 	if (last<first) std::swap(last,first);
 
+	record_edit(first,last,new_text);
+	apply(first,last,new_text);
+}
+
+void text_area::apply(const mark& first,const mark& last,
+	const text_type& new_text)
+{
 	adjust_layout(first,last,new_text);
 	adjust_text(first,last,new_text);
 	_caret_first=adjust_mark(_caret_first,first,last,new_text);
 	_caret_last=adjust_mark(_caret_last,first,last,new_text);
 	_select_first=adjust_mark(_select_first,first,last,new_text);
 	_select_last=adjust_mark(_select_last,first,last,new_text);
+	if (!_search.empty()) adjust_matches(first,last,new_text);
 
 	if (_has_focus&&(_caret_first==_caret_last))
 	{
@@ -1812,6 +2012,13 @@ void text_area::adjust_layout(const mark& first,const mark& last,
 	int width=tbbox().xsize();
 	hide_caret();
 
+	// Ensure that the layout cache matches the current width.
+	if (_layout_width!=width)
+	{
+		discard_layout(0,_layout.size());
+		_layout_width=width;
+	}
+
 	// Calculate the number of paragraphs to be replaced (in part
 	// or in full), the number of replacement paragraphs, the
 	// existing number of lines, and the first line of the affected
@@ -1831,6 +2038,26 @@ void text_area::adjust_layout(const mark& first,const mark& last,
 		_lines.erase(first.para()+new_paras,first.para()+old_paras);
 	}
 
+	// Construct the replacement paragraphs (including any text retained
+	// from the first and last affected paragraphs) and calculate the
+	// layout of each.  The layout of the existing paragraphs is taken
+	// from the layout cache.
+	std::vector<string> new_ptexts(new_paras);
+	std::vector<para_layout*> new_layout(new_paras,0);
+	for (unsigned int i=0;i!=new_paras;++i)
+	{
+		string& new_ptext=new_ptexts[i];
+		new_ptext=new_text[i];
+		if (i==0) new_ptext.insert(0,
+			_text[first.para()].str(0,first.index_para()));
+		if (i==new_paras-1) new_ptext.append(
+			_text[last.para()].str(last.index_para()));
+
+		std::auto_ptr<para_layout> npl(new para_layout);
+		calculate_layout(new_ptext,width,*npl);
+		new_layout[i]=npl.release();
+	}
+
 	// Maintain a record of the current line number.
 	unsigned int line=first_line;
 
@@ -1846,8 +2073,10 @@ void text_area::adjust_layout(const mark& first,const mark& last,
 	// Initialise iterators.
 	unsigned int old_para=first.para();
 	unsigned int new_para=0;
-	unsigned int old_index=0;
-	unsigned int new_index=0;
+	unsigned int old_pline=0;
+	unsigned int new_pline=0;
+	para_view old_ptext;
+	if (old_para!=last.para()+1) old_ptext=_text[old_para];
 
 	// Process one line at a time, until either the old text or
 	// the new text is exhausted.
@@ -1855,17 +2084,16 @@ void text_area::adjust_layout(const mark& first,const mark& last,
 	// does not also need to move with respect to the origin.  If
 	// this is later found to be false then the whole of the
 	// affected area will be redrawn.
-	while ((old_para!=last.para()+1)&&(new_para!=new_text.size()))
+	while ((old_para!=last.para()+1)&&(new_para!=new_paras))
 	{
-		const string old_ptext=_text[old_para];
-		string new_ptext=new_text[new_para];
-		if (new_para==0) new_ptext.insert(0,
-			_text[first.para()].substr(0,first.index_para()));
-		if (new_para==new_text.size()-1) new_ptext.append(
-			_text[last.para()].substr(last.index_para(),string::npos));
+		const para_layout& opl=layout(old_para);
+		const para_layout& npl=*new_layout[new_para];
+		const string& new_ptext=new_ptexts[new_para];
 
-		unsigned int old_split=split_line(old_ptext,old_index,width);
-		unsigned int new_split=split_line(new_ptext,new_index,width);
+		unsigned int old_index=opl.start(old_pline);
+		unsigned int new_index=npl.start(new_pline);
+		unsigned int old_split=opl.start(old_pline+1)-old_index;
+		unsigned int new_split=npl.start(new_pline+1)-new_index;
 
 		unsigned int common=0;
 		while ((common!=old_split)&&(common!=new_split)&&
@@ -1874,7 +2102,8 @@ void text_area::adjust_layout(const mark& first,const mark& last,
 			++common;
 		}
 
-		unsigned int common_width=line_width(old_ptext,old_index,common);
+		unsigned int common_width=(common==old_split)?
+			opl.widths[old_pline]:line_width(old_ptext,old_index,common);
 		force_redraw(box(
 			tbbox().xmin()+common_width,
 			tbbox().ymax()-(line+1)*line_height(),
@@ -1885,19 +2114,16 @@ void text_area::adjust_layout(const mark& first,const mark& last,
 		++ilines;
 		++dlines;
 
-		old_index+=old_split;
-		if (old_index>=old_ptext.size())
+		if (++old_pline==opl.lines())
 		{
-			old_index=0;
-			++old_para;
+			old_pline=0;
+			if (++old_para!=last.para()+1) old_ptext=_text[old_para];
 		}
 
-		new_index+=new_split;
-		if (new_index>=new_ptext.size())
+		if (++new_pline==npl.lines())
 		{
-			unsigned int lines=line-_lines.sum(first.para()+new_para);
-			_lines[first.para()+new_para]=lines;
-			new_index=0;
+			_lines[first.para()+new_para]=npl.lines();
+			new_pline=0;
 			++new_para;
 		}
 	}
@@ -1906,8 +2132,7 @@ void text_area::adjust_layout(const mark& first,const mark& last,
 	// is exhausted.
 	while (old_para!=last.para()+1)
 	{
-		const string old_ptext=_text[old_para];
-		unsigned int old_split=split_line(old_ptext,old_index,width);
+		const para_layout& opl=layout(old_para);
 
 		force_redraw(box(
 			tbbox().xmin(),
@@ -1918,25 +2143,18 @@ void text_area::adjust_layout(const mark& first,const mark& last,
 		++line;
 		++dlines;
 
-		old_index+=old_split;
-		if (old_index>=old_ptext.size())
+		if (++old_pline==opl.lines())
 		{
-			old_index=0;
+			old_pline=0;
 			++old_para;
 		}
 	}
 
 	// Continue processing one line at a time, until the new text
 	// is exhausted.
-	while (new_para!=new_text.size())
+	while (new_para!=new_paras)
 	{
-		string new_ptext=new_text[new_para];
-		if (new_para==0) new_ptext.insert(0,
-			_text[first.para()].substr(0,first.index_para()));
-		if (new_para==new_text.size()-1) new_ptext.append(
-			_text[last.para()].substr(last.index_para(),string::npos));
-
-		unsigned int new_split=split_line(new_ptext,new_index,width);
+		const para_layout& npl=*new_layout[new_para];
 
 		force_redraw(box(
 			tbbox().xmin(),
@@ -1947,16 +2165,31 @@ void text_area::adjust_layout(const mark& first,const mark& last,
 		++line;
 		++ilines;
 
-		new_index+=new_split;
-		if (new_index>=new_ptext.size())
+		if (++new_pline==npl.lines())
 		{
-			unsigned int lines=line-_lines.sum(first.para()+new_para);
-			_lines[first.para()+new_para]=lines;
-			new_index=0;
+			_lines[first.para()+new_para]=npl.lines();
+			new_pline=0;
 			++new_para;
 		}
 	}
 
+	// Replace the layout of the affected paragraphs.  Those which
+	// are unaffected remain valid, since the width has not changed.
+	discard_layout(first.para(),last.para()+1);
+	_layout.erase(_layout.begin()+first.para(),
+		_layout.begin()+last.para()+1);
+	_layout.insert(_layout.begin()+first.para(),
+		new_layout.begin(),new_layout.end());
+
+	// Likewise replace the unwrapped width of the affected paragraphs.
+	_para_widths.erase(first.para(),last.para()+1);
+	_para_widths.insert(first.para(),new_paras,0);
+	for (unsigned int i=0;i!=new_paras;++i)
+	{
+		_para_widths[first.para()+i]=
+			para_width(new_ptexts[i],*new_layout[i]);
+	}
+
 	// Calculate old bounding box for text area as a whole.
 	box oibbox(0,-old_lines*line_height(),width,0);
 	box obbox=oibbox-external_origin(oibbox,xbaseline_left,ybaseline_top);
@@ -2012,26 +2245,223 @@ void text_area::adjust_layout(const mark& first,const mark& last,
 }
 
 void text_area::adjust_text(const mark& first,const mark& last,
-	text_type new_text)
+	const text_type& new_text)
+{
+	// Replace paragraphs.  The buffer combines the first and last
+	// new paragraphs with any existing text before and after the
+	// marks (and treats an empty sequence as one empty paragraph).
+	_text.replace(first.para(),first.index_para(),
+		last.para(),last.index_para(),new_text.begin(),new_text.end());
+}
+
+text_area::text_type text_area::extract(const mark& first,
+	const mark& last) const
 {
-	// Ensure that new_text contains at least one paragraph.
-	if (!new_text.size()) new_text.push_back(string());
+	// Copy each paragraph that contains part of the region,
+	// excluding any text before first or after last.
+	text_type text;
+	for (unsigned int i=first.para();i<=last.para();++i)
+	{
+		const para_view ptext=_text[i];
+		unsigned int index=(i==first.para())?first.index_para():0;
+		unsigned int count=(i==last.para())?
+			last.index_para()-index:ptext.size()-index;
+		text.push_back(ptext.str(index,count));
+	}
 
-	// Combine last new paragraph with existing text after mark.
-	string suffix(new_text.back());
-	new_text.pop_back();
-	suffix.append(_text[last.para()].substr(last.index_para(),string::npos));
-	new_text.push_back(suffix);
+	// Ensure that text is at least one paragraph long.
+	if (!text.size()) text.push_back(string());
+	return text;
+}
 
-	// Combine first new paragraph with existing text prior to mark.
-	string prefix(new_text.front());
-	new_text.pop_front();
-	prefix.insert(0,_text[first.para()].substr(0,first.index_para()));
-	new_text.push_front(prefix);
+void text_area::record_edit(const mark& first,const mark& last,
+	const text_type& new_text)
+{
+	// Ignore replacements which have no effect.
+	bool no_new_text=(new_text.size()==0)||
+		((new_text.size()==1)&&new_text.front().empty());
+	if ((first==last)&&no_new_text) return;
 
-	// Replace paragraphs.
-	_text.erase(first.para(),last.para()-first.para()+1);
-	_text.insert(first.para(),new_text);
+	// Any edits that have been undone can no longer be redone.
+	for (std::deque<edit_record>::iterator i=_redo.begin();
+		i!=_redo.end();++i)
+	{
+		_journal_size-=(*i).size;
+	}
+	_redo.clear();
+
+	// No further action if recording is disabled.
+	if (!_undo_limit) return;
+
+	// Construct record.  The inserted text shares storage with
+	// new_text, so only the removed text need be copied.
+	edit_record er;
+	er.para=first.para();
+	er.index_para=first.index_para();
+	er.removed=extract(first,last);
+	er.inserted=new_text;
+	if (!er.inserted.size()) er.inserted.push_back(string());
+	er.size=sizeof(edit_record);
+	for (unsigned int i=0;i!=er.removed.size();++i)
+		er.size+=er.removed[i].size()+1;
+	for (unsigned int i=0;i!=er.inserted.size();++i)
+		er.size+=er.inserted[i].size()+1;
+
+	// Coalesce with previous edit if possible, otherwise append.
+	if (!(_coalesce&&coalesce(er)))
+	{
+		_undo.push_back(er);
+		_journal_size+=er.size;
+	}
+	_coalesce=true;
+	trim_undo();
+}
+
+bool text_area::coalesce(const edit_record& er)
+{
+	// Only edits within a single paragraph are coalesced.
+	if (_undo.empty()) return false;
+	edit_record& prev=_undo.back();
+	if ((er.para!=prev.para)||(er.removed.size()!=1)||
+		(er.inserted.size()!=1)||(prev.removed.size()!=1)||
+		(prev.inserted.size()!=1))
+	{
+		return false;
+	}
+
+	const string removed=er.removed.front();
+	const string inserted=er.inserted.front();
+	string prev_removed=prev.removed.front();
+	string prev_inserted=prev.inserted.front();
+	if (removed.empty()&&(inserted.size()==1)&&
+		(er.index_para==prev.index_para+prev_inserted.size()))
+	{
+		// Character inserted immediately after previous insertion.
+		prev_inserted+=inserted;
+		prev.inserted=text_type();
+		prev.inserted.push_back(prev_inserted);
+	}
+	else if (inserted.empty()&&prev_inserted.empty()&&
+		(removed.size()==1)&&(er.index_para+1==prev.index_para))
+	{
+		// Character deleted immediately before previous deletion.
+		prev_removed.insert(0,removed);
+		prev.removed=text_type();
+		prev.removed.push_back(prev_removed);
+		prev.index_para=er.index_para;
+	}
+	else if (inserted.empty()&&prev_inserted.empty()&&
+		(removed.size()==1)&&(er.index_para==prev.index_para))
+	{
+		// Character deleted immediately after previous deletion.
+		prev_removed+=removed;
+		prev.removed=text_type();
+		prev.removed.push_back(prev_removed);
+	}
+	else return false;
+
+	// Each coalesced character is accounted as one byte.
+	++prev.size;
+	++_journal_size;
+	return true;
+}
+
+void text_area::trim_undo()
+{
+	// Discard redo records first, since they are the least likely
+	// to be needed, then the oldest undo records.  The most recent
+	// undo record is never discarded, even if it is larger than the
+	// limit on its own: older records cannot be undone without it,
+	// so discarding it would empty the journal.
+	while ((_journal_size>_undo_limit)&&!_redo.empty())
+	{
+		_journal_size-=_redo.front().size;
+		_redo.pop_front();
+	}
+	while ((_journal_size>_undo_limit)&&(_undo.size()>1))
+	{
+		_journal_size-=_undo.front().size;
+		_undo.pop_front();
+	}
+}
+
+void text_area::adjust_matches(const mark& first,const mark& last,
+	const text_type& new_text)
+{
+	// Adjust size of _matches if necessary.  (The text buffer treats
+	// an empty sequence of paragraphs as a single empty paragraph.)
+	unsigned int old_paras=last.para()-first.para()+1;
+	unsigned int new_paras=new_text.size()?new_text.size():1;
+	if (new_paras>old_paras)
+	{
+		_matches.insert(last.para()+1,new_paras-old_paras,0);
+		_match_offsets.insert(_match_offsets.begin()+last.para()+1,
+			new_paras-old_paras,
+			static_cast<std::vector<unsigned int>*>(0));
+	}
+	if (new_paras<old_paras)
+	{
+		_matches.erase(first.para()+new_paras,first.para()+old_paras);
+		discard_matches(first.para()+new_paras,first.para()+old_paras);
+		_match_offsets.erase(
+			_match_offsets.begin()+first.para()+new_paras,
+			_match_offsets.begin()+first.para()+old_paras);
+	}
+
+	// Rescan the replacement paragraphs, and redraw them in full
+	// (since a change at one point can create or destroy a match
+	// which begins before that point).
+	for (unsigned int i=first.para();i!=first.para()+new_paras;++i)
+		scan_matches(i);
+	unsigned int last_para=first.para()+new_paras-1;
+	force_redraw_between(mark(_text,first.para(),0),
+		mark(_text,last_para,_text.length(last_para)));
+}
+
+void text_area::scan_matches(unsigned int para)
+{
+	// The search is not restarted within a match, so that the offsets
+	// agree with those counted by byte_search::count().
+	std::auto_ptr<std::vector<unsigned int> > offsets;
+	const para_view ptext=_text[para];
+	unsigned int nsize=_search.needle().size();
+	unsigned int j=_search.find(ptext.data(),ptext.size());
+	if (j!=util::byte_search::npos)
+	{
+		offsets.reset(new std::vector<unsigned int>);
+		while (j!=util::byte_search::npos)
+		{
+			offsets->push_back(j);
+			j=_search.find(ptext.data(),ptext.size(),j+nsize);
+		}
+	}
+
+	delete _match_offsets[para];
+	_matches[para]=(offsets.get())?offsets->size():0;
+	_match_offsets[para]=offsets.release();
+}
+
+void text_area::discard_matches(unsigned int first,unsigned int last)
+{
+	for (unsigned int i=first;i!=last;++i)
+	{
+		delete _match_offsets[i];
+		_match_offsets[i]=0;
+	}
+}
+
+text_area::mark text_area::end_of(const mark& first,
+	const text_type& text) const
+{
+	unsigned int para=first.para();
+	unsigned int index_para=first.index_para();
+	if (text.size())
+	{
+		para+=text.size()-1;
+		if (text.size()>1) index_para=0;
+		index_para+=text.back().size();
+	}
+	return mark(_text,para,index_para);
 }
 
 text_area::mark text_area::adjust_mark(mark mk,const mark& first,
@@ -2072,7 +2502,7 @@ text_area::mark text_area::adjust_mark(mark mk,const mark& first,
 	return mk;
 }
 
-text_area::basic_mark::basic_mark(const text_type& text,unsigned int para,
+text_area::basic_mark::basic_mark(const buffer_type& text,unsigned int para,
 	unsigned int index_para):
 	_text(&text),
 	_para(para),
@@ -2081,18 +2511,18 @@ text_area::basic_mark::basic_mark(const text_type& text,unsigned int para,
 
 char text_area::basic_mark::operator*() const
 {
-	const string ptext=(*_text)[_para];
-	return (_index_para<ptext.size())?ptext[_index_para]:'\n';
+	return (_index_para<_text->length(_para))?
+		_text->at(_para,_index_para):'\n';
 }
 
-text_area::mark::mark(const text_type& text,unsigned int para,
+text_area::mark::mark(const buffer_type& text,unsigned int para,
 	unsigned int index_para):
 	basic_mark(text,para,index_para)
 {}
 
 text_area::mark text_area::mark::operator++()
 {
-	if (_index_para<(*_text)[_para].size())
+	if (_index_para<_text->length(_para))
 	{
 		++_index_para;
 	}
@@ -2113,7 +2543,7 @@ text_area::mark text_area::mark::operator--()
 	else if (_para)
 	{
 		--_para;
-		_index_para=(*_text)[_para].size();
+		_index_para=_text->length(_para);
 	}
 	return *this;
 }
@@ -2122,23 +2552,17 @@ text_area::mark text_area::mark::next_word() const
 {
 	unsigned int para=_para;
 	unsigned int index_para=_index_para;
-	string ptext=(*_text)[para];
+	para_view ptext=(*_text)[para];
 
 	// Search forwards for a space character in this paragraph.
 	// If the end of the paragraph is reached then stop there,
 	// because that counts as a space character.
-	{
-		const string cptext=ptext;
-		while ((index_para!=ptext.size())&&!isspace(cptext[index_para]))
-			++index_para;
-	}
+	while ((index_para!=ptext.size())&&!isspace(ptext[index_para]))
+		++index_para;
 
 	// Search forwards for a non-space character in this paragraph.
-	{
-		const string cptext=ptext;
-		while ((index_para!=ptext.size())&&isspace(cptext[index_para]))
-			++index_para;
-	}
+	while ((index_para!=ptext.size())&&isspace(ptext[index_para]))
+		++index_para;
 
 	// If the end of the paragraph is reached without finding a
 	// non-space character then search subsequent paragraphs.
@@ -2147,8 +2571,7 @@ text_area::mark text_area::mark::next_word() const
 		++para;
 		ptext=(*_text)[para];
 		index_para=0;
-		const string cptext=ptext;
-		while ((index_para!=ptext.size())&&isspace(cptext[index_para]))
+		while ((index_para!=ptext.size())&&isspace(ptext[index_para]))
 			++index_para;
 	}
 
@@ -2159,14 +2582,11 @@ text_area::mark text_area::mark::prev_word() const
 {
 	unsigned int para=_para;
 	unsigned int index_para=_index_para;
-	string ptext=(*_text)[para];
+	para_view ptext=(*_text)[para];
 
 	// Search backwards for a non-space character in this paragraph.
-	{
-		const string cptext=ptext;
-		while (index_para&&isspace(cptext[index_para-1]))
-			--index_para;
-	}
+	while (index_para&&isspace(ptext[index_para-1]))
+		--index_para;
 
 	// If the start of the paragraph is reached without finding a
 	// non-space character then search previous paragraphs.
@@ -2175,19 +2595,15 @@ text_area::mark text_area::mark::prev_word() const
 		--para;
 		ptext=(*_text)[para];
 		index_para=ptext.size();
-		const string cptext=ptext;
-		while (index_para&&isspace(cptext[index_para-1]))
+		while (index_para&&isspace(ptext[index_para-1]))
 			--index_para;
 	}
 
 	// Search backwards for a space character in this paragraph.
 	// If the start of the paragraph is reached then stop there,
 	// becausethat counts as a space character.
-	{
-		const string cptext=ptext;
-		while (index_para&&!isspace(cptext[index_para-1]))
-			--index_para;
-	}
+	while (index_para&&!isspace(ptext[index_para-1]))
+		--index_para;
 
 	return mark(*_text,para,index_para);
 }
@@ -2195,33 +2611,33 @@ text_area::mark text_area::mark::prev_word() const
 text_area::fixed_mark::fixed_mark(const text_area& area,const basic_mark& mk):
 	basic_mark(mk)
 {
-	int width=area.tbbox().xsize();
-	const string ptext=(*_text)[_para];
-
-	// Split paragraph into lines, searching for index.
-	// Record line number and index into line when found.
-	_line=area._lines.sum(_para);
-	_index_line=_index_para;
-	bool found=false;
-	while (!found)
-	{
-		unsigned int offset=_index_para-_index_line;
-		unsigned int count=area.split_line(ptext,offset,width);
-		found=(_index_line<count)||
-			((_index_line==count)&&(offset+count==ptext.size()));
-		if (!found)
-		{
-			++_line;
-			_index_line-=count;
-		}
-	}
+	// Find line containing index, using cached layout of paragraph.
+	// Record line number and index into line.
+	const para_layout& pl=area.layout(_para);
+	unsigned int line=pl.find(_index_para);
+	unsigned int offset=pl.start(line);
+	_line=area._lines.sum(_para)+line;
+	_index_line=_index_para-offset;
 
 	// Calculate coordinates of mark.
-	int x=area.line_width(ptext,_index_para-_index_line,_index_line);
+	// The text need only be measured if the mark is part way along
+	// the line.
+	int x=0;
+	if (_index_para==pl.start(line+1)) x=pl.widths[line];
+	else if (_index_line) x=area.line_width((*_text)[_para],offset,
+		_index_line);
 	int y=-(_line+1)*area.line_height();
 	_position=area.tbbox().xminymax()+point(x,y);
 }
 
+unsigned int text_area::para_layout::find(unsigned int index) const
+{
+	// Find the last line which starts at or before index.
+	// (There is always at least one, since the first line starts at 0.)
+	return std::upper_bound(starts.begin(),starts.end(),index)-
+		starts.begin()-1;
+}
+
 int operator-(const text_area::basic_mark& lhs,
 	const text_area::basic_mark& rhs)
 {
@@ -2233,11 +2649,11 @@ int operator-(const text_area::basic_mark& lhs,
 	unsigned int para=lhs.para();
 	while (para<rhs.para())
 	{
-		diff+=lhs.text()[para++].size()+1;
+		diff+=lhs.text().length(para++)+1;
 	}
 	while (para>rhs.para())
 	{
-		diff-=lhs.text()[--para].size()+1;
+		diff-=lhs.text().length(--para)+1;
 	}
 	return diff;
 }
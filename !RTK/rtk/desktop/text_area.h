@@ -7,6 +7,8 @@
 #define _RTK_DESKTOP_TEXT_AREA
 
 #include <string>
+#include <vector>
+#include <deque>
 
 #if defined(__GNUC__) && (__GNUC__<3)
 #include <rope>
@@ -16,8 +18,9 @@
 #endif
 
 #include "rtk/util/cumulative_sum.h"
-
-#include "rtk/os/font.h"
+#include "rtk/util/range_max.h"
+#include "rtk/util/text_buffer.h"
+#include "rtk/util/byte_search.h"
 
 #include "rtk/graphics/font.h"
 
@@ -90,6 +93,7 @@ public:
 	};
 
 	/** A type to represent a sequence of paragraphs.
+	 * This is the type used to pass text into and out of a text area.
 	 * The only guarantee made about this type is that it is a
 	 * container of std::string which functions begin() const
 	 * and end() const which behave in the customary manner.
@@ -98,12 +102,23 @@ public:
 	 */
 	typedef __gnu_cxx::rope<string> text_type;
 
+	/** A type to represent the text held by a text area.
+	 * Paragraphs can be read from this type without being copied,
+	 * and edited without the remainder of the text being rebuilt.
+	 */
+	typedef util::text_buffer buffer_type;
+
+	/** A type to represent a read-only view of a paragraph.
+	 * A view remains valid until the text is next modified.
+	 */
+	typedef util::text_buffer::view para_view;
+
 	/** A class to represent a location within the text. */
 	class basic_mark
 	{
 	protected:
 		/** The text to which the mark refers. */
-		const text_type* _text;
+		const buffer_type* _text;
 
 		/** The paragraph number to which the mark refers. */
 		unsigned int _para;
@@ -117,7 +132,7 @@ public:
 		 * @param index_para the byte index into the paragraph
 		 *  to which the mark refers
 		 */
-		basic_mark(const text_type& text,unsigned int para,
+		basic_mark(const buffer_type& text,unsigned int para,
 			unsigned int index_para);
 
 		char operator*() const;
@@ -125,7 +140,7 @@ public:
 		/** Get text.
 		 * @return the text to which the mark refers.
 		 */
-		const text_type& text() const
+		const buffer_type& text() const
 			{ return *_text; }
 
 		/** Get paragraph number.
@@ -157,7 +172,7 @@ public:
 		 * @param index_para the byte index into the paragraph
 		 *  to which the mark refers
 		 */
-		mark(const text_type& text,unsigned int para,
+		mark(const buffer_type& text,unsigned int para,
 			unsigned int index_para);
 
 		mark operator++();
@@ -225,12 +240,94 @@ public:
 	};
 	friend class fixed_mark;
 private:
+	/** A structure to represent the layout of a paragraph.
+	 * This records where the paragraph has been split into lines,
+	 * and the width of each line, so that neither need be measured
+	 * again until the paragraph or the width of the text area changes.
+	 */
+	struct para_layout
+	{
+	public:
+		/** The length of the paragraph. */
+		unsigned int length;
+		/** The byte index into the paragraph at which each line starts.
+		 * There is always at least one line, starting at index 0.
+		 */
+		std::vector<unsigned int> starts;
+		/** The width of each line, including any trailing spaces. */
+		std::vector<int> widths;
+
+		/** Get number of lines.
+		 * @return the number of lines in the paragraph
+		 */
+		unsigned int lines() const
+			{ return starts.size(); }
+
+		/** Get byte index at which line starts.
+		 * For convenience, lines beyond the end of the paragraph
+		 * are considered to start at the end of the paragraph.
+		 * @param line the line number, with respect to the paragraph
+		 * @return the byte index into the paragraph
+		 */
+		unsigned int start(unsigned int line) const
+			{ return (line<starts.size())?starts[line]:length; }
+
+		/** Find line containing byte index.
+		 * An index which falls on a line break is considered to be at
+		 * the start of the following line, except at the end of the
+		 * paragraph.
+		 * @param index the byte index into the paragraph
+		 * @return the line number, with respect to the paragraph
+		 */
+		unsigned int find(unsigned int index) const;
+	};
+
+	/** A structure to represent an edit recorded in the undo journal.
+	 * The removed and inserted text are held as text_type, which
+	 * shares storage when copied.  Recording an edit therefore costs
+	 * time and memory in proportion to the size of the edit, not the
+	 * size of the document.  Applying an edit (when it is made, undone
+	 * or redone) moves characters only within the blocks of the text
+	 * buffer that it affects, but if it adds or removes paragraphs then
+	 * the per-paragraph indexes are adjusted in time proportional to
+	 * the number of paragraphs which follow it.
+	 */
+	struct edit_record
+	{
+		/** The paragraph number at which the edit begins. */
+		unsigned int para;
+		/** The byte index into the paragraph at which the edit begins. */
+		unsigned int index_para;
+		/** The text removed by the edit (at least one paragraph). */
+		text_type removed;
+		/** The text inserted by the edit (at least one paragraph). */
+		text_type inserted;
+		/** The number of bytes accounted to this record. */
+		unsigned int size;
+	};
+
 	/** The text broken into paragraphs. */
-	text_type _text;
+	buffer_type _text;
 
 	/** The accumulated line counts for each paragraph. */
 	mutable util::cumulative_sum<unsigned int> _lines;
 
+	/** The cached layout for each paragraph.
+	 * There is one element for each paragraph.  An element which
+	 * is null has yet to be calculated.  All non-null elements
+	 * are valid for a width of _layout_width.
+	 */
+	mutable std::vector<para_layout*> _layout;
+
+	/** The width for which _layout is valid. */
+	mutable int _layout_width;
+
+	/** The unwrapped width of each paragraph.
+	 * This allows the minimum bounding box to be recalculated without
+	 * measuring paragraphs that have not changed.
+	 */
+	mutable util::range_max<int> _para_widths;
+
 	/** The font in which the text is displayed. */
 	graphics::font _font;
 
@@ -249,6 +346,11 @@ private:
 	 */
 	int _ccolour;
 
+	/** The highlight colour for matches of the search pattern.
+	 * This is one of the 16 standard Wimp colours.
+	 */
+	int _hcolour;
+
 	/** The line height. */
 	int _line_height;
 
@@ -360,9 +462,41 @@ private:
 	/** The inbound clipboard. */
 	text_type _iclipboard;
 
-	/** A font coordinate block.
-	 * This is needed to specify the split character. */
-	mutable os::coord_block_scanstring _font_coord_block;
+	/** The undo journal, with the most recent edit last. */
+	std::deque<edit_record> _undo;
+
+	/** The redo journal, with the most recently undone edit last. */
+	std::deque<edit_record> _redo;
+
+	/** The search pattern, or empty if there is none. */
+	util::byte_search _search;
+
+	/** The number of matches of the search pattern in each paragraph.
+	 * This is empty if there is no search pattern.  Otherwise there is
+	 * one element for each paragraph, which is recounted whenever the
+	 * paragraph is replaced.
+	 */
+	util::cumulative_sum<unsigned int> _matches;
+
+	/** The offset of each match of the search pattern in each paragraph.
+	 * This is empty if there is no search pattern.  Otherwise there is
+	 * one element for each paragraph, which is null if the paragraph
+	 * contains no matches.  Each list is in ascending order, and is
+	 * recalculated whenever the corresponding element of _matches is
+	 * recounted.
+	 */
+	std::vector<std::vector<unsigned int>*> _match_offsets;
+
+	/** The number of bytes accounted to the undo and redo journals. */
+	unsigned int _journal_size;
+
+	/** The maximum number of bytes to be accounted to the undo and
+	 * redo journals, or 0 if edits are not to be recorded. */
+	unsigned int _undo_limit;
+
+	/** True if the next edit may be coalesced with the last one
+	 * in the undo journal, otherwise false. */
+	bool _coalesce;
 public:
 	/** Construct text area.
 	 * By default:
@@ -413,6 +547,7 @@ public:
 	 * notice.  It is guaranteed to remain valid until but not
 	 * beyond the next non-const call to the text_area instance
 	 * from which it was obtained.
+	 * The text is copied, so this takes O(n) time.
 	 * @return the text, as a text_type
 	 */
 	text_type text() const;
@@ -430,6 +565,8 @@ public:
 	text_type selection() const;
 
 	/** Set text.
+	 * This is not recorded as an edit, and the undo and redo journals
+	 * are discarded.  It is therefore suitable for loading a file.
 	 * @param text the replacement text
 	 * @return a reference to this
 	 */
@@ -446,6 +583,101 @@ public:
 	 */
 	bool has_selection() const;
 
+	/** Test whether there is an edit that can be undone.
+	 * @return true if undo() would have an effect, otherwise false
+	 */
+	bool can_undo() const
+		{ return !_undo.empty(); }
+
+	/** Test whether there is an edit that can be redone.
+	 * @return true if redo() would have an effect, otherwise false
+	 */
+	bool can_redo() const
+		{ return !_redo.empty(); }
+
+	/** Undo most recent edit.
+	 * No action is taken if the text area is read-only.
+	 * @return a reference to this
+	 */
+	text_area& undo();
+
+	/** Redo most recently undone edit.
+	 * No action is taken if the text area is read-only.
+	 * @return a reference to this
+	 */
+	text_area& redo();
+
+	/** Discard undo and redo journals.
+	 * @return a reference to this
+	 */
+	text_area& clear_undo();
+
+	/** Select text.
+	 * Under the standard selection model this also moves the caret.
+	 * @param first the start of the required selection
+	 * @param last the end of the required selection
+	 * @return a reference to this
+	 */
+	text_area& select(const mark& first,const mark& last);
+
+	/** Find first match for string.
+	 * Matches do not span paragraph boundaries.  The paragraphs are
+	 * searched in place, without being copied.
+	 * @param needle the string to be found
+	 * @param from the mark at which to begin searching
+	 * @param found a buffer for the returned start of the match
+	 * @return true if a match was found, otherwise false
+	 */
+	bool find(const string& needle,const mark& from,mark& found) const;
+
+	/** Count matches for string.
+	 * Matches do not overlap or span paragraph boundaries.
+	 * @param needle the string to be counted
+	 * @return the number of matches in the whole of the text
+	 */
+	unsigned int count(const string& needle) const;
+
+	/** Replace all matches for string.
+	 * All matches are replaced as a single edit, which can be undone
+	 * in one step.
+	 * No action is taken if the text area is read-only.
+	 * @param needle the string to be replaced
+	 * @param replacement the replacement string
+	 * @return the number of matches replaced
+	 */
+	unsigned int replace_all(const string& needle,const string& replacement);
+
+	/** Get search pattern.
+	 * @return the search pattern, or the empty string if none
+	 */
+	const string& search() const
+		{ return _search.needle(); }
+
+	/** Set search pattern.
+	 * Matches for the search pattern are counted and highlighted.
+	 * The count and highlighting are kept current as the text is
+	 * edited, by rescanning only the paragraphs which change.
+	 * @param needle the required search pattern, or the empty string
+	 *  for none
+	 * @return a reference to this
+	 */
+	text_area& search(const string& needle);
+
+	/** Get number of matches for search pattern.
+	 * @return the number of matches in the whole of the text
+	 */
+	unsigned int match_count() const
+		{ return _matches.sum(_matches.size()); }
+
+	/** Find next match for search pattern.
+	 * Paragraphs that do not contain a match are skipped without
+	 * being searched.
+	 * @param from the mark at which to begin searching
+	 * @param found a buffer for the returned start of the match
+	 * @return true if a match was found, otherwise false
+	 */
+	bool find_next(const mark& from,mark& found) const;
+
 	/** Get mark for start of text.
 	 * @return a mark referring to the start of the text
 	 */
@@ -516,6 +748,12 @@ public:
 	/** Paste selection to clipboard. */
 	void handle_paste();
 
+	/** Undo most recent edit. */
+	void handle_undo();
+
+	/** Redo most recently undone edit. */
+	void handle_redo();
+
 	/** Get font.
 	 * @return the font
 	 */
@@ -543,6 +781,13 @@ public:
 	int ccolour() const
 		{ return _ccolour; }
 
+	/** Get highlight colour.
+	 * This is one of the 16 standard Wimp colours.
+	 * @return the highlight colour for matches of the search pattern
+	 */
+	int hcolour() const
+		{ return _hcolour; }
+
 	/** Get line height.
 	 * @return the line height
 	 */
@@ -573,6 +818,13 @@ public:
 	selection_model_type selection_model() const
 		{ return _selection_model; }
 
+	/** Get undo limit.
+	 * @return the maximum number of bytes of text to be held by the
+	 *  undo and redo journals, or 0 if edits are not recorded
+	 */
+	unsigned int undo_limit() const
+		{ return _undo_limit; }
+
 	/** Set font.
 	 * @param font the required font
 	 */
@@ -597,6 +849,13 @@ public:
 	 */
 	text_area& ccolour(int ccolour);
 
+	/** Set highlight colour.
+	 * @param hcolour the required highlight colour for matches of
+	 *  the search pattern
+	 * @return a reference to this
+	 */
+	text_area& hcolour(int hcolour);
+
 	/** Set line height.
 	 * This is the distance between adjacent lines.
 	 * @param line_height the required line height
@@ -626,6 +885,17 @@ public:
 	 * @return a reference to this
 	 */
 	text_area& selection_model(selection_model_type selection_model);
+
+	/** Set undo limit.
+	 * If the journals exceed this limit then the oldest edits are
+	 * discarded, except that the most recent edit is always kept
+	 * (so that it can be undone however large it is).  A limit of 0
+	 * disables recording.
+	 * @param undo_limit the maximum number of bytes of text to be held
+	 *  by the undo and redo journals
+	 * @return a reference to this
+	 */
+	text_area& undo_limit(unsigned int undo_limit);
 private:
 	/** Automatically calculate line height for font.
 	 * This function does not itself alter _line_height.
@@ -641,46 +911,45 @@ private:
 	int auto_baseline_offset() const;
 
 	/** Render line of text.
-	 * Note that the paragraph text is logically but not physically const.
-	 * (It is temporarily modified, then restored to its original value,
-	 * in order to pass string fragments to RISC OS without copying.)
+	 * The line is drawn as a single run list, with control characters
+	 * shown in hexadecimal using the control character colour.
 	 * @param context the graphics context
+	 * @param para the paragraph number
 	 * @param text the paragraph
 	 * @param index the starting index into the paragraph
 	 * @param count the number of characters to paint
 	 * @param p the point at which to start
 	 */
-	void render_line(gcontext& context,const string& text,unsigned int index,
-		unsigned int count,const point& p) const;
+	void render_line(gcontext& context,unsigned int para,
+		const para_view& text,unsigned int index,unsigned int count,
+		const point& p) const;
 
 	/** Get width of line of text.
-	 * Note that the paragraph text is logically but not physically const.
-	 * (It is temporarily modified, then restored to its original value,
-	 * in order to pass string fragments to RISC OS without copying.)
+	 * String fragments are passed to RISC OS without copying or
+	 * terminating them, so the paragraph text is not modified.
 	 * @param text the paragraph
 	 * @param index the starting index into the paragraph
 	 * @param count the number of characters to include
 	 * @return the width of the line
 	 */
-	int line_width(const string& text,unsigned int index,unsigned int count)
-		const;
+	int line_width(const para_view& text,unsigned int index,
+		unsigned int count) const;
 
 	/** Find character corresponding to given caret x-coordinate.
-	 * Note that the paragraph text is logically but not physically const.
-	 * (It is temporarily modified, then restored to its original value,
-	 * in order to pass string fragments to RISC OS without copying.)
+	 * String fragments are passed to RISC OS without copying or
+	 * terminating them, so the paragraph text is not modified.
 	 * @param text the paragraph
 	 * @param index the starting index into the paragraph
 	 * @param x the required x coordinate
 	 * @return the number of characters past the starting index
 	 *  at which the caret should be placed
 	 */
-	unsigned int find_index(const string& text,unsigned int index,int x) const;
+	unsigned int find_index(const para_view& text,unsigned int index,
+		int x) const;
 
 	/** Find next split point for paragraph.
-	 * Note that the paragraph text is logically but not physically const.
-	 * (It is temporarily modified, then restored to its original value,
-	 * in order to pass string fragments to RISC OS without copying.)
+	 * String fragments are passed to RISC OS without copying or
+	 * terminating them, so the paragraph text is not modified.
 	 * @param text the paragraph
 	 * @param index the starting index into the paragraph
 	 * @param width the width at which to split
@@ -688,8 +957,39 @@ private:
 	 * @return the number of characters past the starting index
 	 *  at which to split
 	 */
-	unsigned int split_line(const string& text,unsigned int index,int width,
-		bool include_trailing=true) const;
+	unsigned int split_line(const para_view& text,unsigned int index,
+		int width,bool include_trailing=true) const;
+
+	/** Calculate layout of paragraph.
+	 * @param text the paragraph
+	 * @param width the width at which to split
+	 * @param pl the layout to be calculated
+	 */
+	void calculate_layout(const para_view& text,int width,
+		para_layout& pl) const;
+
+	/** Get unwrapped width of paragraph.
+	 * The text is measured only if it occupies more than one line.
+	 * @param text the paragraph
+	 * @param pl the layout of the paragraph
+	 * @return the width of the paragraph without line wrap
+	 */
+	int para_width(const para_view& text,const para_layout& pl) const;
+
+	/** Get layout of paragraph.
+	 * The layout is taken from _layout if it has already been
+	 * calculated, otherwise it is calculated and cached.
+	 * @param para the paragraph number
+	 * @return the layout of the paragraph for a width of _layout_width
+	 */
+	const para_layout& layout(unsigned int para) const;
+
+	/** Discard cached layout for range of paragraphs.
+	 * The elements of _layout are set to null, but not removed.
+	 * @param first the first paragraph (inclusive)
+	 * @param last the last paragraph (exclusive)
+	 */
+	void discard_layout(unsigned int first,unsigned int last) const;
 
 	/** Find mark by snapping a point to character grid.
 	 * @param p the point to snap, with respect to the origin of the
@@ -708,14 +1008,15 @@ private:
 	mark snap(unsigned int line,int x) const;
 
 	/** Reflow text, using existing content of window.
-	 * This function updates the content of _lines.
+	 * This function updates the content of _lines and _layout.
 	 * @param old_width the previous width of the text area
 	 * @param new_width the new width of the text area
 	 */
 	void reflow(int old_width,int new_width);
 
 	/** Reflow text, without using existing content of window.
-	 * This function updates the content of _lines.
+	 * This function updates the content of _lines, _layout and
+	 * _para_widths.
 	 * @param width the new width of the text area
 	 */
 	void reflow(int width);
@@ -769,10 +1070,74 @@ public:
 	 */
 	void replace(mark first,mark last,const text_type& new_text);
 private:
+	/** Apply replacement without recording it in the undo journal.
+	 * @param first the start of the region to be replaced
+	 * @param last the end of the region to be replaced (not before first)
+	 * @param new_text the replacement paragraphs (at least one)
+	 */
+	void apply(const mark& first,const mark& last,const text_type& new_text);
+
+	/** Record replacement in the undo journal.
+	 * This must be called before the text is adjusted.  Any edits
+	 * that have been undone are discarded.
+	 * @param first the start of the region to be replaced
+	 * @param last the end of the region to be replaced (not before first)
+	 * @param new_text the replacement paragraphs
+	 */
+	void record_edit(const mark& first,const mark& last,
+		const text_type& new_text);
+
+	/** Attempt to coalesce edit with last one in undo journal.
+	 * Successive insertions of single characters, and successive
+	 * deletions of single characters to the left or right, are
+	 * combined provided that they are contiguous.
+	 * @param er the edit to be coalesced
+	 * @return true if coalesced, otherwise false
+	 */
+	bool coalesce(const edit_record& er);
+
+	/** Discard oldest edits until journals are within undo limit.
+	 * The most recent undo record is kept in any event.
+	 */
+	void trim_undo();
+
+	/** Adjust match counts during call to replace().
+	 * This function must not be called until after the layout and
+	 * the text have been adjusted.  The replacement paragraphs are
+	 * rescanned and redrawn, so that highlighting remains current.
+	 * @param first the start of the region that was replaced
+	 * @param last the end of the region that was replaced
+	 * @param new_text the replacement paragraphs
+	 */
+	void adjust_matches(const mark& first,const mark& last,
+		const text_type& new_text);
+
+	/** Find matches for the search pattern in paragraph.
+	 * The elements of _matches and _match_offsets for the paragraph
+	 * are replaced.
+	 * @param para the paragraph number
+	 */
+	void scan_matches(unsigned int para);
+
+	/** Discard match offsets for range of paragraphs.
+	 * The elements of _match_offsets are deleted and set to null.
+	 * @param first the first paragraph number
+	 * @param last the last paragraph number (exclusive)
+	 */
+	void discard_matches(unsigned int first,unsigned int last);
+
+	/** Get mark for end of text inserted at given mark.
+	 * @param first the mark at which the text begins
+	 * @param text the text
+	 * @return a mark referring to the end of the text
+	 */
+	mark end_of(const mark& first,const text_type& text) const;
+
 	/** Adjust layout during call to replace().
-	 * This function adjusts the content of _lines, and invalidates
-	 * or copies any affected parts of the work area.  It does not
-	 * alter _text, nor does it change the position of any marks.
+	 * This function adjusts the content of _lines, _layout and
+	 * _para_widths, and invalidates or copies any affected parts of the
+	 * work area.  It does not alter _text, nor does it change the
+	 * position of any marks.
 	 * It must be called before the text itself is adjusted.
 	 * @param first the start of the region to be replaced
 	 * @param last the end of the region to be replaced
@@ -788,7 +1153,15 @@ private:
 	 * @param last the end of the region to be replaced
 	 * @param new_text the replacement paragraphs (at least one)
 	 */
-	void adjust_text(const mark& first,const mark& last,text_type new_text);
+	void adjust_text(const mark& first,const mark& last,
+		const text_type& new_text);
+
+	/** Extract text between marks.
+	 * @param first the start of the region to be extracted
+	 * @param last the end of the region to be extracted
+	 * @return the text, as a sequence of at least one paragraph
+	 */
+	text_type extract(const mark& first,const mark& last) const;
 
 	/** Adjust mark during call to replace().
 	 * This function must not be called until after the layout and
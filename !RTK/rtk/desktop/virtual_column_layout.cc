@@ -18,7 +18,9 @@ using rtk::util::divider;
 virtual_column_layout::virtual_column_layout(size_type ycells):
 	_ycells(ycells),
 	_ymax(ycells+1,0),
-	_ygap(0)
+	_ypitch(0),
+	_ygap(0),
+	_uniform_rows(false)
 {}
 
 virtual_column_layout::~virtual_column_layout()
@@ -32,13 +34,26 @@ box virtual_column_layout::auto_bbox() const
 	_xbs=xbaseline_set();
 
 	// Request min_bbox for each cell.  Incorporate into x-baseline set
-	// and total height.
+	// and total height.  (In uniform-row mode, the first cell stands
+	// in for all of the others.)
 	int ysize=0;
-	for (size_type y=0;y!=_ycells;++y)
+	if (_uniform_rows)
 	{
-		box mcbbox=cell_min_bbox(y);
-		_xbs.add(mcbbox,cell_xbaseline(y));
-		ysize+=mcbbox.ysize();
+		if (_ycells)
+		{
+			box mcbbox=cell_min_bbox(0);
+			_xbs.add(mcbbox,cell_xbaseline(0));
+			ysize+=mcbbox.ysize()*_ycells;
+		}
+	}
+	else
+	{
+		for (size_type y=0;y!=_ycells;++y)
+		{
+			box mcbbox=cell_min_bbox(y);
+			_xbs.add(mcbbox,cell_xbaseline(y));
+			ysize+=mcbbox.ysize();
+		}
 	}
 
 	// Calculate combined width.
@@ -92,6 +107,27 @@ void virtual_column_layout::reformat(const point& origin,const box& pbbox)
 	yspread-=_margin.ysize();
 	if (_ycells) yspread-=(_ycells-1)*_ygap;
 	if (yspread<0) yspread=0;
+
+	if (_uniform_rows)
+	{
+		// In uniform-row mode, divide the excess equally between cells
+		// (leaving any remainder unused) so that they remain the same
+		// height.  Only the position of the first cell and the pitch
+		// need be recorded.  Only the first cell is reformatted: it
+		// stands in for all of the others.
+		int ysize=(_ycells)?yspread/int(_ycells):0;
+		int yextra=(_ycells)?yexcess/int(_ycells):0;
+		_ymax[0]=ibox.ymax();
+		_ypitch=ysize+yextra+_ygap;
+		if (_ycells)
+		{
+			box cbbox;
+			point cpos=place_cell(0,cbbox);
+			cell_reformat(0,cpos,cbbox-cpos);
+		}
+		return;
+	}
+
 	divider ydiv(yexcess,yspread);
 
 	// Set maximum y-coordinate for each cell.
@@ -112,71 +148,54 @@ void virtual_column_layout::reformat(const point& origin,const box& pbbox)
 	// Place children.
 	for (size_type y=0;y!=_ycells;++y)
 	{
-		// Create y-baseline set for just this cell.
-		ybaseline_set ybs;
-		ybs.add(cell_min_bbox(y),cell_ybaseline(y));
-
-		// Construct bounding box for cell with respect to origin
-		// of layout.
-		box cbbox(ibox.xmin(),_ymax[y+1]+_ygap,ibox.xmax(),_ymax[y]);
-
-		// Calculate offset from top left-hand corner of cell to
-		// origin of child.
-		int xoffset=_xbs.offset(xbaseline_left,cell_xbaseline(y),
-			cbbox.xsize());
-		int yoffset=ybs.offset(ybaseline_bottom,cell_ybaseline(y),
-			cbbox.ysize());
-		point coffset(xoffset,yoffset);
-
-		// Calculate origin of cell with respect to origin of layout.
-		point cpos(cbbox.xminymin()+coffset);
-
-		// Reformat child.
+		box cbbox;
+		point cpos=place_cell(y,cbbox);
 		cell_reformat(y,cpos,cbbox-cpos);
 	}
 }
 
 void virtual_column_layout::redraw(gcontext& context,const box& clip)
 {
-	// Remove margin.
-	box ibox(_bbox-_margin);
-
-	// Look for the first row with a lower edge which overlaps (or is
-	// below) the clip box: _ymax[y0+1] + _ygap < clip.ymax().
-	std::vector<int>::iterator yf0=upper_bound(
-		_ymax.begin(),_ymax.end(),clip.ymax()-_ygap,std::greater<int>());
-	size_type y0=yf0-_ymax.begin();
-	if (y0) --y0;
-
-	// Look for the first row with an upper edge which is below the
-	// clip box: _ymax[y1] <= clip.ymin().
-	std::vector<int>::iterator yf1=lower_bound(
-		_ymax.begin(),_ymax.end(),clip.ymin(),std::greater<int>());
-	size_type y1=yf1-_ymax.begin();
+	size_type y0=0;
+	size_type y1=0;
+	if (_uniform_rows)
+	{
+		if (_ypitch>0)
+		{
+			// Calculate the first row with a lower edge which overlaps
+			// (or is below) the clip box: ymax(y0+1) + _ygap < clip.ymax().
+			int dy0=_ymax[0]+_ygap-clip.ymax();
+			if (dy0>0) y0=dy0/_ypitch;
+
+			// Calculate the first row with an upper edge which is below
+			// the clip box: ymax(y1) <= clip.ymin().
+			int dy1=_ymax[0]-clip.ymin();
+			if (dy1>0) y1=(dy1+_ypitch-1)/_ypitch;
+		}
+	}
+	else
+	{
+		// Look for the first row with a lower edge which overlaps (or is
+		// below) the clip box: _ymax[y0+1] + _ygap < clip.ymax().
+		std::vector<int>::iterator yf0=upper_bound(
+			_ymax.begin(),_ymax.end(),clip.ymax()-_ygap,std::greater<int>());
+		y0=yf0-_ymax.begin();
+		if (y0) --y0;
+
+		// Look for the first row with an upper edge which is below the
+		// clip box: _ymax[y1] <= clip.ymin().
+		std::vector<int>::iterator yf1=lower_bound(
+			_ymax.begin(),_ymax.end(),clip.ymin(),std::greater<int>());
+		y1=yf1-_ymax.begin();
+	}
 	if (y1>_ycells) y1=_ycells;
 
 	// Redraw children.
 	// For safety, use an inequality in the for loop.
 	for (size_type y=y0;y<y1;++y)
 	{
-		// Create y-baseline set for just this cell.
-		ybaseline_set ybs;
-		ybs.add(cell_min_bbox(y),cell_ybaseline(y));
-
-		// Construct bounding box for cell with respect to origin
-		// of layout.
-		box cbbox(ibox.xmin(),_ymax[y+1]+_ygap,ibox.xmax(),_ymax[y]);
-
-		// Calculate offset from top left-hand corner of cell to
-		// origin of child.
-		int xoffset=_xbs.offset(xbaseline_left,cell_xbaseline(y),
-			cbbox.xsize());
-		int yoffset=ybs.offset(ybaseline_bottom,cell_ybaseline(y),
-			cbbox.ysize());
-		point coffset(xoffset,yoffset);
-
-		// Calculate origin of cell with respect to origin of layout.
-		point cpos(cbbox.xminymin()+coffset);
+		box cbbox;
+		point cpos=place_cell(y,cbbox);
 
 		// Redraw cell.
 		context+=cpos;
@@ -189,7 +208,7 @@ void virtual_column_layout::redraw(gcontext& context,const box& clip)
 virtual_column_layout& virtual_column_layout::cells(size_type ycells)
 {
 	_ycells=ycells;
-	_ymax.resize(ycells+1,0);
+	_ymax.resize((_uniform_rows)?1:ycells+1,0);
 	invalidate();
 	return *this;
 }
@@ -215,6 +234,14 @@ virtual_column_layout& virtual_column_layout::margin(int margin)
 	return *this;
 }
 
+virtual_column_layout& virtual_column_layout::uniform_rows(bool uniform_rows)
+{
+	_uniform_rows=uniform_rows;
+	_ymax.resize((_uniform_rows)?1:_ycells+1,0);
+	invalidate();
+	return *this;
+}
+
 virtual_column_layout::xbaseline_type virtual_column_layout::cell_xbaseline(
 	size_type y) const
 {
@@ -233,6 +260,18 @@ void virtual_column_layout::cell_reformat(size_type y,const point& origin,
 
 virtual_column_layout::size_type virtual_column_layout::find_y(const point& p)
 {
+	// In uniform-row mode, calculate the row which would contain the
+	// point: ymax(y) > p.y() >= ymax(y+1).
+	if (_uniform_rows)
+	{
+		if ((_ypitch<=0)||(p.y()>=_ymax[0])) return npos;
+		size_type y=(_ymax[0]-1-p.y())/_ypitch;
+
+		// Return npos if point outside cell limits, otherwise return y.
+		if ((y>=_ycells)||(p.y()<ymax(y+1)+_ygap)) return npos;
+		return y;
+	}
+
 	// Look for the first cell with a top edge which is below the point:
 	// _ymax[x] <= p.x().
 	std::vector<int>::const_iterator yf=
@@ -245,5 +284,31 @@ virtual_column_layout::size_type virtual_column_layout::find_y(const point& p)
 	return y;
 }
 
+point virtual_column_layout::place_cell(size_type y,box& cbbox) const
+{
+	// In uniform-row mode, the first cell stands in for all of the others.
+	size_type my=(_uniform_rows)?0:y;
+
+	// Create y-baseline set for just this cell.
+	ybaseline_set ybs;
+	ybs.add(cell_min_bbox(my),cell_ybaseline(my));
+
+	// Construct bounding box for cell with respect to origin
+	// of layout.
+	box ibox(_bbox-_margin);
+	cbbox=box(ibox.xmin(),ymax(y+1)+_ygap,ibox.xmax(),ymax(y));
+
+	// Calculate offset from top left-hand corner of cell to
+	// origin of child.
+	int xoffset=_xbs.offset(xbaseline_left,cell_xbaseline(my),
+		cbbox.xsize());
+	int yoffset=ybs.offset(ybaseline_bottom,cell_ybaseline(my),
+		cbbox.ysize());
+	point coffset(xoffset,yoffset);
+
+	// Calculate origin of cell with respect to origin of layout.
+	return cbbox.xminymin()+coffset;
+}
+
 } /* namespace desktop */
 } /* namespace rtk */
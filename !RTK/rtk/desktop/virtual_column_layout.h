@@ -38,9 +38,15 @@ private:
 	 * edge is obtained by adding _ygap from the top edge of the
 	 * following cell.  A hypothetical value for _ymax[ycells()] is
 	 * included in the vector so that the position of the bottom edge
-	 * of the last cell can be determined. */
+	 * of the last cell can be determined.
+	 * In uniform-row mode only _ymax[0] is present, the position of
+	 * any other cell being calculated from _ypitch. */
 	std::vector<int> _ymax;
 
+	/** The distance between the top edges of adjacent cells.
+	 * This is used only in uniform-row mode. */
+	int _ypitch;
+
 	/** The cached x-baseline set for the layout. */
 	mutable xbaseline_set _xbs;
 
@@ -52,6 +58,11 @@ private:
 
 	/** The current bounding box. */
 	box _bbox;
+
+	/** The uniform-row flag.
+	 * True if all cells are assumed to be the same as the first,
+	 * otherwise false. */
+	bool _uniform_rows;
 public:
 	/** Construct virtual column layout.
 	 * @param ycells the required number of cells (defaults to 0)
@@ -110,6 +121,29 @@ public:
 	 */
 	virtual_column_layout& margin(int margin);
 
+	/** Get uniform-row flag.
+	 * @return true if all cells are assumed to be the same as the first,
+	 *  otherwise false
+	 */
+	bool uniform_rows() const
+		{ return _uniform_rows; }
+
+	/** Set uniform-row flag.
+	 * When this flag is set, every cell is assumed to have the same
+	 * minimum bounding box and baselines as the first cell.  The layout
+	 * can then be calculated without visiting each cell, and the cell
+	 * containing a given point can be found by arithmetic rather than
+	 * by searching.  Only the first cell is passed to cell_reformat():
+	 * since every cell has the same geometry, the others differ only in
+	 * their origin, which is passed to cell_redraw() in the graphics
+	 * context.  This mode is intended for use when there are very many
+	 * cells.
+	 * @param uniform_rows true if all cells are the same as the first,
+	 *  otherwise false
+	 * @return a reference to this
+	 */
+	virtual_column_layout& uniform_rows(bool uniform_rows);
+
 	/** Get minimum bounding box for cell.
 	 * This function is equivalent to get_bbox() but acts on a virtual
 	 * child instead of a real component.
@@ -163,6 +197,24 @@ public:
 	 *  no such cell.
 	 */
 	size_type find_y(const point& p);
+private:
+	/** Get position of top edge of cell.
+	 * @param y the y-index of the cell (which may be equal to ycells(),
+	 *  in order to find the position of the bottom edge of the last cell)
+	 * @return the position of the top edge, with respect to the origin
+	 *  of the layout
+	 */
+	int ymax(size_type y) const
+		{ return (_uniform_rows)?_ymax[0]-int(y)*_ypitch:_ymax[y]; }
+
+	/** Place cell.
+	 * @param y the y-index of the cell
+	 * @param cbbox a buffer for the returned bounding box of the cell,
+	 *  with respect to the origin of the layout
+	 * @return the origin of the cell, with respect to the origin of
+	 *  the layout
+	 */
+	point place_cell(size_type y,box& cbbox) const;
 };
 
 } /* namespace desktop */
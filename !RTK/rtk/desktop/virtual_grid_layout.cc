@@ -20,10 +20,12 @@ virtual_grid_layout::virtual_grid_layout(size_type xcells,size_type ycells):
 	_ycells(ycells),
 	_xmin(xcells+1,0),
 	_ymax(ycells+1,0),
+	_ypitch(0),
 	_xbs(xcells),
 	_ybs(ycells),
 	_xgap(0),
-	_ygap(0)
+	_ygap(0),
+	_uniform_rows(false)
 {}
 
 virtual_grid_layout::~virtual_grid_layout()
@@ -35,11 +37,13 @@ box virtual_grid_layout::auto_bbox() const
 {
 	// Reset baseline sets.
 	for (size_type x=0;x!=_xcells;++x) _xbs[x]=xbaseline_set();
-	for (size_type y=0;y!=_ycells;++y) _ybs[y]=ybaseline_set();
+	for (size_type y=0;y!=_ybs.size();++y) _ybs[y]=ybaseline_set();
 
 	// Request min_bbox for each cell.  Incorporate into appropriate
-	// x-baseline and y-baseline set.
-	for (size_type y=0;y!=_ycells;++y)
+	// x-baseline and y-baseline set.  (In uniform-row mode, the first
+	// row stands in for all of the others.)
+	size_type ycells=(_uniform_rows)?_ybs.size():_ycells;
+	for (size_type y=0;y!=ycells;++y)
 	{
 		for (size_type x=0;x!=_xcells;++x)
 		{
@@ -54,8 +58,15 @@ box virtual_grid_layout::auto_bbox() const
 	int ysize=0;
 	for (size_type x=0;x!=_xcells;++x)
 		xsize+=_xbs[x].xsize();
-	for (size_type y=0;y!=_ycells;++y)
-		ysize+=_ybs[y].ysize();
+	if (_uniform_rows)
+	{
+		if (_ycells) ysize+=_ybs[0].ysize()*_ycells;
+	}
+	else
+	{
+		for (size_type y=0;y!=_ycells;++y)
+			ysize+=_ybs[y].ysize();
+	}
 
 	// Add gaps to width and height.
 	if (_xcells) xsize+=(_xcells-1)*_xgap;
@@ -126,6 +137,30 @@ void virtual_grid_layout::reformat(const point& origin,const box& pbbox)
 	yspread-=_margin.ysize();
 	if (_ycells) yspread-=(_ycells-1)*_ygap;
 	if (yspread<0) yspread=0;
+
+	if (_uniform_rows)
+	{
+		// In uniform-row mode, divide the excess equally between rows
+		// (leaving any remainder unused) so that they remain the same
+		// height.  Only the position of the first row and the pitch
+		// need be recorded.  Only the first row is reformatted: it
+		// stands in for all of the others.
+		int ysize=(_ycells)?_ybs[0].ysize():0;
+		int yextra=(_ycells)?yexcess/int(_ycells):0;
+		_ymax[0]=ibox.ymax();
+		_ypitch=ysize+yextra+_ygap;
+		if (_ycells)
+		{
+			for (size_type x=0;x!=_xcells;++x)
+			{
+				box cbbox;
+				point cpos=place_cell(x,0,cbbox);
+				cell_reformat(x,0,cpos,cbbox-cpos);
+			}
+		}
+		return;
+	}
+
 	divider ydiv(yexcess,yspread);
 
 	// Set minimum and maximum y-coordinates for each row.
@@ -144,23 +179,8 @@ void virtual_grid_layout::reformat(const point& origin,const box& pbbox)
 	{
 		for (size_type x=0;x!=_xcells;++x)
 		{
-			// Construct bounding box for cell with respect to
-			// origin of layout.
-			box cbbox(_xmin[x],_ymax[y+1]+_ygap,_xmin[x+1]-_xgap,_ymax[y]);
-
-			// Calculate offset from top left-hand corner of cell
-			// to origin of child.
-			int xoffset=_xbs[x].offset(xbaseline_left,cell_xbaseline(x,y),
-				cbbox.xsize());
-			int yoffset=_ybs[y].offset(ybaseline_bottom,cell_ybaseline(x,y),
-				cbbox.ysize());
-			point coffset(xoffset,yoffset);
-
-			// Calculate origin of cell with respect to origin of
-			// layout.
-			point cpos(cbbox.xminymin()+coffset);
-
-			// Reformat child.
+			box cbbox;
+			point cpos=place_cell(x,y,cbbox);
 			cell_reformat(x,y,cpos,cbbox-cpos);
 		}
 	}
@@ -182,18 +202,38 @@ void virtual_grid_layout::redraw(gcontext& context,const box& clip)
 	size_type x1=xf1-_xmin.begin();
 	if (x1>_xcells) x1=_xcells;
 
-	// Look for the first row with a lower edge which overlaps (or is
-	// below) the clip box: _ymax[y0+1] + _ygap < clip.ymax().
-	std::vector<int>::iterator yf0=upper_bound(
-		_ymax.begin(),_ymax.end(),clip.ymax()-_ygap,std::greater<int>());
-	size_type y0=yf0-_ymax.begin();
-	if (y0) --y0;
-
-	// Look for the first row with an upper edge which is below the
-	// clip box: _ymax[y1] <= clip.ymin().
-	std::vector<int>::iterator yf1=lower_bound(
-		_ymax.begin(),_ymax.end(),clip.ymin(),std::greater<int>());
-	size_type y1=yf1-_ymax.begin();
+	size_type y0=0;
+	size_type y1=0;
+	if (_uniform_rows)
+	{
+		if (_ypitch>0)
+		{
+			// Calculate the first row with a lower edge which overlaps
+			// (or is below) the clip box: ymax(y0+1) + _ygap < clip.ymax().
+			int dy0=_ymax[0]+_ygap-clip.ymax();
+			if (dy0>0) y0=dy0/_ypitch;
+
+			// Calculate the first row with an upper edge which is below
+			// the clip box: ymax(y1) <= clip.ymin().
+			int dy1=_ymax[0]-clip.ymin();
+			if (dy1>0) y1=(dy1+_ypitch-1)/_ypitch;
+		}
+	}
+	else
+	{
+		// Look for the first row with a lower edge which overlaps (or is
+		// below) the clip box: _ymax[y0+1] + _ygap < clip.ymax().
+		std::vector<int>::iterator yf0=upper_bound(
+			_ymax.begin(),_ymax.end(),clip.ymax()-_ygap,std::greater<int>());
+		y0=yf0-_ymax.begin();
+		if (y0) --y0;
+
+		// Look for the first row with an upper edge which is below the
+		// clip box: _ymax[y1] <= clip.ymin().
+		std::vector<int>::iterator yf1=lower_bound(
+			_ymax.begin(),_ymax.end(),clip.ymin(),std::greater<int>());
+		y1=yf1-_ymax.begin();
+	}
 	if (y1>_ycells) y1=_ycells;
 
 	// Redraw children.
@@ -202,21 +242,8 @@ void virtual_grid_layout::redraw(gcontext& context,const box& clip)
 	{
 		for (size_type x=x0;x<x1;++x)
 		{
-			// Construct bounding box for cell with respect to
-			// origin of layout.
-			box cbbox(_xmin[x],_ymax[y+1]+_ygap,_xmin[x+1]-_xgap,_ymax[y]);
-
-			// Calculate offset from top left-hand corner of cell
-			// to origin of child.
-			int xoffset=_xbs[x].offset(xbaseline_left,cell_xbaseline(x,y),
-				cbbox.xsize());
-			int yoffset=_ybs[y].offset(ybaseline_bottom,cell_ybaseline(x,y),
-				cbbox.ysize());
-			point coffset(xoffset,yoffset);
-
-			// Calculate origin of cell with respect to origin of
-			// layout.
-			point cpos(cbbox.xminymin()+coffset);
+			box cbbox;
+			point cpos=place_cell(x,y,cbbox);
 
 			// Redraw cell.
 			context+=cpos;
@@ -233,9 +260,9 @@ virtual_grid_layout& virtual_grid_layout::cells(size_type xcells,
 	_xcells=xcells;
 	_ycells=ycells;
 	_xmin.resize(xcells+1,0);
-	_ymax.resize(ycells+1,0);
+	_ymax.resize((_uniform_rows)?1:ycells+1,0);
 	_xbs.resize(xcells);
-	_ybs.resize(ycells);
+	_ybs.resize((_uniform_rows)?std::min(ycells,1U):ycells);
 	invalidate();
 	return *this;
 }
@@ -268,6 +295,15 @@ virtual_grid_layout& virtual_grid_layout::margin(int margin)
 	return *this;
 }
 
+virtual_grid_layout& virtual_grid_layout::uniform_rows(bool uniform_rows)
+{
+	_uniform_rows=uniform_rows;
+	_ymax.resize((_uniform_rows)?1:_ycells+1,0);
+	_ybs.resize((_uniform_rows)?std::min(_ycells,1U):_ycells);
+	invalidate();
+	return *this;
+}
+
 virtual_grid_layout::xbaseline_type virtual_grid_layout::cell_xbaseline(
 	size_type x,size_type y) const
 {
@@ -300,6 +336,18 @@ virtual_grid_layout::size_type virtual_grid_layout::find_x(const point& p)
 
 virtual_grid_layout::size_type virtual_grid_layout::find_y(const point& p)
 {
+	// In uniform-row mode, calculate the row which would contain the
+	// point: ymax(y) > p.y() >= ymax(y+1).
+	if (_uniform_rows)
+	{
+		if ((_ypitch<=0)||(p.y()>=_ymax[0])) return npos;
+		size_type y=(_ymax[0]-1-p.y())/_ypitch;
+
+		// Return npos if point outside cell limits, otherwise return y.
+		if ((y>=_ycells)||(p.y()<ymax(y+1)+_ygap)) return npos;
+		return y;
+	}
+
 	// Look for the first cell with a top edge which is below the point:
 	// _ymax[x] <= p.x().
 	std::vector<int>::const_iterator yf=
@@ -312,5 +360,28 @@ virtual_grid_layout::size_type virtual_grid_layout::find_y(const point& p)
 	return y;
 }
 
+point virtual_grid_layout::place_cell(size_type x,size_type y,
+	box& cbbox) const
+{
+	// In uniform-row mode, the first row stands in for all of the others.
+	size_type my=(_uniform_rows)?0:y;
+
+	// Construct bounding box for cell with respect to
+	// origin of layout.
+	cbbox=box(_xmin[x],ymax(y+1)+_ygap,_xmin[x+1]-_xgap,ymax(y));
+
+	// Calculate offset from top left-hand corner of cell
+	// to origin of child.
+	int xoffset=_xbs[x].offset(xbaseline_left,cell_xbaseline(x,my),
+		cbbox.xsize());
+	int yoffset=_ybs[my].offset(ybaseline_bottom,cell_ybaseline(x,my),
+		cbbox.ysize());
+	point coffset(xoffset,yoffset);
+
+	// Calculate origin of cell with respect to origin of
+	// layout.
+	return cbbox.xminymin()+coffset;
+}
+
 } /* namespace desktop */
 } /* namespace rtk */
@@ -49,13 +49,20 @@ private:
 	 * bottom edge is obtained by adding _ygap from the top edge of
 	 * the following cell.  A hypothetical value for _ymax[ycells()] is
 	 * included in the vector so that the position of the bottom edge
-	 * of the last cell can be determined. */
+	 * of the last cell can be determined.
+	 * In uniform-row mode only _ymax[0] is present, the position of
+	 * any other row being calculated from _ypitch. */
 	std::vector<int> _ymax;
 
+	/** The distance between the top edges of adjacent rows.
+	 * This is used only in uniform-row mode. */
+	int _ypitch;
+
 	/** A vector containing a cached x-baseline set for each column. */
 	mutable std::vector<xbaseline_set> _xbs;
 
-	/** A vector containing a cached y-baseline set for each row. */
+	/** A vector containing a cached y-baseline set for each row.
+	 * In uniform-row mode only the first row is present. */
 	mutable std::vector<ybaseline_set> _ybs;
 
 	/** The size of gap to be placed between columns. */
@@ -69,6 +76,11 @@ private:
 
 	/** The current bounding box. */
 	box _bbox;
+
+	/** The uniform-row flag.
+	 * True if all rows are assumed to be the same as the first,
+	 * otherwise false. */
+	bool _uniform_rows;
 public:
 	/** Construct virtual grid layout.
 	 * @param xcells the required number of columns (defaults to 0)
@@ -147,6 +159,29 @@ public:
 	 */
 	virtual_grid_layout& margin(int margin);
 
+	/** Get uniform-row flag.
+	 * @return true if all rows are assumed to be the same as the first,
+	 *  otherwise false
+	 */
+	bool uniform_rows() const
+		{ return _uniform_rows; }
+
+	/** Set uniform-row flag.
+	 * When this flag is set, each cell is assumed to have the same
+	 * minimum bounding box and baselines as the cell in the same column
+	 * of the first row.  The layout can then be calculated by visiting
+	 * only the first row, and the row containing a given point can be
+	 * found by arithmetic rather than by searching.  Only the cells of
+	 * the first row are passed to cell_reformat(): since every row has
+	 * the same geometry, the cells of other rows differ only in their
+	 * origin, which is passed to cell_redraw() in the graphics context.
+	 * This mode is intended for use when there are very many rows.
+	 * @param uniform_rows true if all rows are the same as the first,
+	 *  otherwise false
+	 * @return a reference to this
+	 */
+	virtual_grid_layout& uniform_rows(bool uniform_rows);
+
 	/** Get minimum bounding box for cell.
 	 * This function is equivalent to get_bbox() but acts on a virtual
 	 * child instead of a real component.
@@ -214,6 +249,25 @@ public:
 	 *  no such cell.
 	 */
 	size_type find_y(const point& p);
+private:
+	/** Get position of top edge of row.
+	 * @param y the y-index of the row (which may be equal to ycells(),
+	 *  in order to find the position of the bottom edge of the last row)
+	 * @return the position of the top edge, with respect to the origin
+	 *  of the layout
+	 */
+	int ymax(size_type y) const
+		{ return (_uniform_rows)?_ymax[0]-int(y)*_ypitch:_ymax[y]; }
+
+	/** Place cell.
+	 * @param x the x-index of the cell
+	 * @param y the y-index of the cell
+	 * @param cbbox a buffer for the returned bounding box of the cell,
+	 *  with respect to the origin of the layout
+	 * @return the origin of the cell, with respect to the origin of
+	 *  the layout
+	 */
+	point place_cell(size_type x,size_type y,box& cbbox) const;
 };
 
 } /* namespace desktop */
@@ -26,5 +26,11 @@ bool arrow_click::deliver(component& dest)
 	return h;
 }
 
+unsigned int arrow_click::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(arrow_click));
+	return index;
+}
+
 } /* namespace events */
 } /* namespace rtk */
@@ -52,6 +52,7 @@ public:
 		{ return _steps; }
 protected:
 	virtual bool deliver(desktop::component& dest);
+	virtual unsigned int type_index() const;
 };
 
 } /* namespace events */
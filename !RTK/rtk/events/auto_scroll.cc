@@ -26,5 +26,11 @@ bool auto_scroll::deliver(component& dest)
 	return h;
 }
 
+unsigned int auto_scroll::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(auto_scroll));
+	return index;
+}
+
 } /* namespace events */
 } /* namespace rtk */
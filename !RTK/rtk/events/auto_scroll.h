@@ -56,6 +56,7 @@ public:
 		{ return _bbox; }
 protected:
 	virtual bool deliver(desktop::component& dest);
+	virtual unsigned int type_index() const;
 };
 
 } /* namespace events */
@@ -37,5 +37,11 @@ bool claim_entity::deliver(component& dest)
 	return h;
 }
 
+unsigned int claim_entity::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(claim_entity));
+	return index;
+}
+
 } /* namespace events */
 } /* namespace rtk */
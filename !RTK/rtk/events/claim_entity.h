@@ -44,6 +44,7 @@ public:
 	virtual ~claim_entity();
 protected:
 	virtual bool deliver(desktop::component& dest);
+	virtual unsigned int type_index() const;
 public:
 	/** Test whether the caret or selection has been claimed.
 	 * @return true if the caret or selection has been claimed
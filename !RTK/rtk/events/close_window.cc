@@ -27,5 +27,11 @@ bool close_window::deliver(component& dest)
 	return h;
 }
 
+unsigned int close_window::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(close_window));
+	return index;
+}
+
 } /* namespace events */
 } /* namespace rtk */
@@ -66,5 +66,11 @@ bool dataload::deliver(component& dest)
 	return h;
 }
 
+unsigned int dataload::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(dataload));
+	return index;
+}
+
 } /* namespace events */
 } /* namespace rtk */
@@ -53,6 +53,7 @@ public:
 	virtual ~dataload();
 protected:
 	virtual bool deliver(desktop::component& dest);
+	virtual unsigned int type_index() const;
 public:
 	/** Get destination window handle.
 	 * @return the destination window handle
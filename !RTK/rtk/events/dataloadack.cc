@@ -59,5 +59,11 @@ bool dataloadack::deliver(component& dest)
 	return h;
 }
 
+unsigned int dataloadack::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(dataloadack));
+	return index;
+}
+
 } /* namespace events */
 } /* namespace rtk */
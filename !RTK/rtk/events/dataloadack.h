@@ -54,6 +54,7 @@ public:
 	virtual ~dataloadack();
 protected:
 	virtual bool deliver(desktop::component& dest);
+	virtual unsigned int type_index() const;
 public:
 	/** Get destination window handle.
 	 * @return the destination window handle
@@ -29,6 +29,12 @@ bool dataopen::deliver(component& dest)
 	return h;
 }
 
+unsigned int dataopen::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(dataopen));
+	return index;
+}
+
 int dataopen::whandle() const
 {
 	return wimpblock().word[5];
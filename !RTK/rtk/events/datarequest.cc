@@ -29,6 +29,12 @@ bool datarequest::deliver(component& dest)
 	return h;
 }
 
+unsigned int datarequest::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(datarequest));
+	return index;
+}
+
 int datarequest::whandle() const
 {
 	return wimpblock().word[5];
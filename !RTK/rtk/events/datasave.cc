@@ -79,5 +79,11 @@ bool datasave::deliver(component& dest)
 	return h;
 }
 
+unsigned int datasave::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(datasave));
+	return index;
+}
+
 } /* namespace events */
 } /* namespace rtk */
@@ -66,5 +66,11 @@ bool datasaveack::deliver(component& dest)
 	return h;
 }
 
+unsigned int datasaveack::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(datasaveack));
+	return index;
+}
+
 } /* namespace events */
 } /* namespace rtk */
@@ -25,5 +25,11 @@ bool discard::deliver(component& dest)
 	return h;
 }
 
+unsigned int discard::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(discard));
+	return index;
+}
+
 } /* namespace events */
 } /* namespace rtk */
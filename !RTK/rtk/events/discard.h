@@ -43,6 +43,7 @@ public:
 	virtual ~discard();
 protected:
 	virtual bool deliver(desktop::component& dest);
+	virtual unsigned int type_index() const;
 };
 
 } /* namespace events */
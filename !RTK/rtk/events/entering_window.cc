@@ -27,5 +27,11 @@ bool entering_window::deliver(component& dest)
 	return h;
 }
 
+unsigned int entering_window::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(entering_window));
+	return index;
+}
+
 } /* namespace events */
 } /* namespace rtk */
@@ -3,6 +3,8 @@
 // Distribution and use are subject to the GNU Lesser General Public License,
 // a copy of which may be found in the file !RTK.Copyright.
 
+#include <vector>
+
 #include "rtk/desktop/component.h"
 #include "rtk/events/event.h"
 
@@ -11,6 +13,13 @@ namespace events {
 
 using rtk::desktop::component;
 
+namespace {
+
+/** The class for which each event type index was allocated. */
+std::vector<const std::type_info*> type_owners;
+
+} /* anonymous namespace */
+
 event::event(component& target):
 	_target(&target)
 {}
@@ -26,17 +35,44 @@ void event::target(component& target)
 bool event::post()
 {
 	bool handled=false;
+
+	// The type index is not used if it was allocated for a base class,
+	// since a component with no handler for the base class might have
+	// a handler for this one.
+	unsigned int type=type_index();
+	if ((type!=npos)&&(*type_owners[type]!=typeid(*this))) type=npos;
+
 	component* dest=_target;
 	while (dest)
 	{
 		// Request parent before delivering event, in case component
 		// does not exist after event has been handled.
 		component* parent=dest->redirected_parent();
-		handled|=deliver(*dest);
+
+		// Skip components which are known not to have a handler.
+		// Otherwise, attempt delivery.  If that fails then no handler
+		// has been called (so the component must still exist), and
+		// the failure can safely be recorded.
+		if (!dest->unhandled(type))
+		{
+			if (deliver(*dest)) handled=true;
+			else dest->unhandled(type,true);
+		}
 		dest=parent;
 	}
 	return handled;
 }
 
+unsigned int event::type_index() const
+{
+	return npos;
+}
+
+unsigned int event::allocate_type_index(const std::type_info& type)
+{
+	type_owners.push_back(&type);
+	return type_owners.size()-1;
+}
+
 } /* namespace events */
 } /* namespace rtk */
@@ -6,6 +6,8 @@
 #ifndef _RTK_EVENTS_EVENT
 #define _RTK_EVENTS_EVENT
 
+#include <typeinfo>
+
 namespace rtk {
 namespace graphics {}
 
@@ -21,6 +23,9 @@ namespace events {
  */
 class event
 {
+public:
+	/** A type index which indicates that delivery should not be cached. */
+	static const unsigned int npos=static_cast<unsigned int>(-1);
 private:
 	/** The target of the event. */
 	desktop::component* _target;
@@ -49,11 +54,37 @@ public:
 	 * Search upwards from the target for a component with a suitable
 	 * handler for this event, then pass this event to that handler.
 	 * Continue until all suitable handlers have been called.
+	 *
+	 * Components which are found not to have a suitable handler are
+	 * remembered (for each type of event), so that they can be skipped
+	 * without the need for a dynamic cast when subsequent events of the
+	 * same type are posted.  This is done only if the dynamic type of
+	 * the event is the class for which its type index was allocated.
 	 * @return true if one or more suitable handlers were found,
 	 *  otherwise false
 	 */
 	bool post();
 protected:
+	/** Get event type index.
+	 * Each event class which provides its own implementation of
+	 * deliver() should also provide an implementation of this function,
+	 * returning an index allocated by allocate_type_index().  The
+	 * default implementation returns npos, which disables caching.
+	 *
+	 * A derived class which does not provide its own implementation
+	 * inherits the index of its base class, but the index is ignored
+	 * when posting an event of the derived class (so caching is
+	 * disabled, rather than shared with the base class).
+	 * @return the event type index
+	 */
+	virtual unsigned int type_index() const;
+
+	/** Allocate event type index.
+	 * @param type the class for which the index is allocated
+	 * @return a newly allocated event type index
+	 */
+	static unsigned int allocate_type_index(const std::type_info& type);
+
 	/** Deliver event to component.
 	 * If the specified destination has a handler method for this event
 	 * then call that method.
@@ -40,6 +40,12 @@ bool help_request::deliver(component& dest)
 	return h;
 }
 
+unsigned int help_request::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(help_request));
+	return index;
+}
+
 void help_request::reply(const string& text) const
 {
 	os::wimp_block block;
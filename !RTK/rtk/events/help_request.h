@@ -91,6 +91,7 @@ public:
 	void reply(const string& text) const;
 protected:
 	virtual bool deliver(desktop::component& dest);
+	virtual unsigned int type_index() const;
 };
 
 } /* namespace events */
@@ -36,6 +36,12 @@ bool key_pressed::deliver(component& dest)
 	return h;
 }
 
+unsigned int key_pressed::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(key_pressed));
+	return index;
+}
+
 void key_pressed::processed(bool value)
 {
 	_processed=value;
@@ -84,6 +84,7 @@ public:
 	void processed(bool value);
 protected:
 	virtual bool deliver(desktop::component& dest);
+	virtual unsigned int type_index() const;
 };
 
 } /* namespace events */
@@ -27,5 +27,11 @@ bool leaving_window::deliver(component& dest)
 	return h;
 }
 
+unsigned int leaving_window::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(leaving_window));
+	return index;
+}
+
 } /* namespace events */
 } /* namespace rtk */
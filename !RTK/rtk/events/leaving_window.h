@@ -53,6 +53,7 @@ public:
 		{ return (desktop::basic_window*)target(); }
 protected:
 	virtual bool deliver(desktop::component& dest);
+	virtual unsigned int type_index() const;
 };
 
 } /* namespace events */
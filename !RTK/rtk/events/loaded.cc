@@ -27,5 +27,11 @@ bool loaded::deliver(component& dest)
 	return h;
 }
 
+unsigned int loaded::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(loaded));
+	return index;
+}
+
 } /* namespace events */
 } /* namespace rtk */
@@ -57,6 +57,7 @@ public:
 		{ return *_loadop; }
 protected:
 	virtual bool deliver(desktop::component& dest);
+	virtual unsigned int type_index() const;
 };
 
 } /* namespace events */
@@ -37,5 +37,11 @@ bool menu_selection::deliver(component& dest)
 	return h;
 }
 
+unsigned int menu_selection::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(menu_selection));
+	return index;
+}
+
 } /* namespace events */
 } /* namespace rtk */
@@ -64,6 +64,7 @@ public:
 		{ return _buttons; }
 protected:
 	virtual bool deliver(desktop::component& dest);
+	virtual unsigned int type_index() const;
 };
 
 } /* namespace events */
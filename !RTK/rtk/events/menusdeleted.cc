@@ -25,5 +25,11 @@ bool menusdeleted::deliver(component& dest)
 	return h;
 }
 
+unsigned int menusdeleted::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(menusdeleted));
+	return index;
+}
+
 } /* namespace events */
 } /* namespace rtk */
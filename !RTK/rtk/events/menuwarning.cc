@@ -25,5 +25,11 @@ bool menuwarning::deliver(component& dest)
 	return h;
 }
 
+unsigned int menuwarning::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(menuwarning));
+	return index;
+}
+
 } /* namespace events */
 } /* namespace rtk */
@@ -41,6 +41,7 @@ public:
 	virtual ~menuwarning();
 protected:
 	virtual bool deliver(desktop::component& dest);
+	virtual unsigned int type_index() const;
 };
 
 } /* namespace events */
@@ -52,5 +52,11 @@ bool message::deliver(component& dest)
 	return h;
 }
 
+unsigned int message::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(message));
+	return index;
+}
+
 } /* namespace events */
 } /* namespace rtk */
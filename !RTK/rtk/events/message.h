@@ -101,6 +101,7 @@ public:
 	void prepare_reply(os::wimp_block& reply,int msgcode,size_type size) const;
 protected:
 	virtual bool deliver(desktop::component& dest);
+	virtual unsigned int type_index() const;
 };
 
 } /* namespace events */
@@ -45,5 +45,11 @@ bool mouse_click::deliver(component& dest)
 	return h;
 }
 
+unsigned int mouse_click::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(mouse_click));
+	return index;
+}
+
 } /* namespace events */
 } /* namespace rtk */
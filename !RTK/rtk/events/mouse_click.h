@@ -93,6 +93,7 @@ public:
 		{ return _shift; }
 protected:
 	virtual bool deliver(desktop::component& dest);
+	virtual unsigned int type_index() const;
 };
 
 } /* namespace events */
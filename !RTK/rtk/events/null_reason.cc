@@ -25,5 +25,11 @@ bool null_reason::deliver(component& dest)
 	return h;
 }
 
+unsigned int null_reason::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(null_reason));
+	return index;
+}
+
 } /* namespace events */
 } /* namespace rtk */
@@ -25,5 +25,11 @@ bool quit::deliver(component& dest)
 	return h;
 }
 
+unsigned int quit::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(quit));
+	return index;
+}
+
 } /* namespace events */
 } /* namespace rtk */
@@ -41,6 +41,7 @@ public:
 	virtual ~quit();
 protected:
 	virtual bool deliver(desktop::component& dest);
+	virtual unsigned int type_index() const;
 };
 
 } /* namespace events */
@@ -48,5 +48,11 @@ bool ramfetch::deliver(component& dest)
 	return h;
 }
 
+unsigned int ramfetch::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(ramfetch));
+	return index;
+}
+
 } /* namespace events */
 } /* namespace rtk */
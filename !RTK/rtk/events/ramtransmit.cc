@@ -48,5 +48,11 @@ bool ramtransmit::deliver(component& dest)
 	return h;
 }
 
+unsigned int ramtransmit::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(ramtransmit));
+	return index;
+}
+
 } /* namespace events */
 } /* namespace rtk */
@@ -49,6 +49,7 @@ public:
 	virtual ~ramtransmit();
 protected:
 	virtual bool deliver(desktop::component& dest);
+	virtual unsigned int type_index() const;
 public:
 	/** Get data transfer buffer.
 	 * @return the data transfer buffer
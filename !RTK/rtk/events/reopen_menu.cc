@@ -25,5 +25,11 @@ bool reopen_menu::deliver(component& dest)
 	return h;
 }
 
+unsigned int reopen_menu::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(reopen_menu));
+	return index;
+}
+
 } /* namespace events */
 } /* namespace rtk */
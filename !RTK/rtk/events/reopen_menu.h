@@ -42,6 +42,7 @@ public:
 	virtual ~reopen_menu();
 protected:
 	virtual bool deliver(desktop::component& dest);
+	virtual unsigned int type_index() const;
 };
 
 } /* namespace events */
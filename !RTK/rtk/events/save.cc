@@ -25,5 +25,11 @@ bool save::deliver(component& dest)
 	return h;
 }
 
+unsigned int save::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(save));
+	return index;
+}
+
 } /* namespace events */
 } /* namespace rtk */
@@ -43,6 +43,7 @@ public:
 	virtual ~save();
 protected:
 	virtual bool deliver(desktop::component& dest);
+	virtual unsigned int type_index() const;
 };
 
 } /* namespace events */
@@ -42,5 +42,11 @@ bool save_to_app::deliver(component& dest)
 	return h;
 }
 
+unsigned int save_to_app::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(save_to_app));
+	return index;
+}
+
 } /* namespace events */
 } /* namespace rtk */
@@ -95,6 +95,7 @@ public:
 		{ return _leafname; }
 protected:
 	virtual bool deliver(desktop::component& dest);
+	virtual unsigned int type_index() const;
 };
 
 } /* namespace events */
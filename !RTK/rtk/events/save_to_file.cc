@@ -28,5 +28,11 @@ bool save_to_file::deliver(component& dest)
 	return h;
 }
 
+unsigned int save_to_file::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(save_to_file));
+	return index;
+}
+
 } /* namespace events */
 } /* namespace rtk */
@@ -70,6 +70,7 @@ public:
 		{ return _selection; }
 protected:
 	virtual bool deliver(desktop::component& dest);
+	virtual unsigned int type_index() const;
 };
 
 } /* namespace events */
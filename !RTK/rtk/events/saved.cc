@@ -27,5 +27,11 @@ bool saved::deliver(component& dest)
 	return h;
 }
 
+unsigned int saved::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(saved));
+	return index;
+}
+
 } /* namespace events */
 } /* namespace rtk */
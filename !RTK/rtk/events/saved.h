@@ -57,6 +57,7 @@ public:
 		{ return *_saveop; }
 protected:
 	virtual bool deliver(desktop::component& dest);
+	virtual unsigned int type_index() const;
 };
 
 } /* namespace events */
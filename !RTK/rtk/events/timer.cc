@@ -0,0 +1,36 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#include "rtk/desktop/component.h"
+#include "rtk/events/timer.h"
+
+namespace rtk {
+namespace events {
+
+using rtk::desktop::component;
+
+timer::timer(component& target,unsigned int deadline):
+	event(target),
+	_deadline(deadline)
+{}
+
+timer::~timer()
+{}
+
+bool timer::deliver(component& dest)
+{
+	handler* h=dynamic_cast<handler*>(&dest);
+	if (h) h->handle_event(*this);
+	return h;
+}
+
+unsigned int timer::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(timer));
+	return index;
+}
+
+} /* namespace events */
+} /* namespace rtk */
@@ -0,0 +1,64 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#ifndef _RTK_EVENTS_TIMER
+#define _RTK_EVENTS_TIMER
+
+#include "rtk/events/event.h"
+
+namespace rtk {
+namespace events {
+
+/** An event class to indicate that a timer has expired.
+ * Timers are scheduled using application::register_timer().
+ */
+class timer:
+	public event
+{
+private:
+	/** The time at which the timer was due to expire. */
+	unsigned int _deadline;
+public:
+	/** A mixin class for handling timer events.
+	 * If a class wishes to receive timer events then it should
+	 * inherit from this mixin class and provide an implementation for
+	 * handle_event().
+	 */
+	class handler
+	{
+	public:
+		/** Handle timer event.
+		 * @param ev the timer event to be handled
+		 */
+		virtual void handle_event(timer& ev)=0;
+	};
+
+	/** Construct timer event.
+	 * @param target the target of the event
+	 * @param deadline the monotonic time at which the timer was due
+	 *  to expire
+	 */
+	timer(desktop::component& target,unsigned int deadline);
+
+	/** Destroy timer event. */
+	virtual ~timer();
+
+	/** Get deadline.
+	 * This may be earlier than the time at which the event was
+	 * delivered.
+	 * @return the monotonic time at which the timer was due to expire,
+	 *  in centiseconds
+	 */
+	unsigned int deadline() const
+		{ return _deadline; }
+protected:
+	virtual bool deliver(desktop::component& dest);
+	virtual unsigned int type_index() const;
+};
+
+} /* namespace events */
+} /* namespace rtk */
+
+#endif
@@ -43,5 +43,11 @@ bool user_drag_box::deliver(component& dest)
 	return h;
 }
 
+unsigned int user_drag_box::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(user_drag_box));
+	return index;
+}
+
 } /* namespace events */
 } /* namespace rtk */
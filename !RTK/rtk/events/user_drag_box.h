@@ -62,6 +62,7 @@ public:
 		{ return _dbox; }
 protected:
 	virtual bool deliver(desktop::component& dest);
+	virtual unsigned int type_index() const;
 };
 
 } /* namespace events */
@@ -27,5 +27,11 @@ bool wimp::deliver(component& dest)
 	return h;
 }
 
+unsigned int wimp::type_index() const
+{
+	static unsigned int index=allocate_type_index(typeid(wimp));
+	return index;
+}
+
 } /* namespace events */
 } /* namespace rtk */
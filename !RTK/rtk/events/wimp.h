@@ -70,6 +70,7 @@ public:
 	const os::wimp_block& event_data();
 protected:
 	virtual bool deliver(desktop::component& dest);
+	virtual unsigned int type_index() const;
 };
 
 } /* namespace events */
@@ -0,0 +1,90 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#include "rtk/graphics/box_list.h"
+
+namespace rtk {
+namespace graphics {
+
+namespace {
+
+/** A type for holding the area of a box.
+ * A 64-bit integer is used to avoid overflow without recourse to
+ * floating point, which is emulated in software on most targets.
+ */
+typedef unsigned long long area_type;
+
+/** Calculate area of box.
+ * @param b the box
+ * @return the area, or zero if the box is empty
+ */
+inline area_type area(const box& b)
+{
+	int xsize=b.xsize();
+	int ysize=b.ysize();
+	return ((xsize>0)&&(ysize>0))?
+		area_type(unsigned(xsize))*unsigned(ysize):0;
+}
+
+} /* anonymous namespace */
+
+box_list::box_list(size_type max_size):
+	_max_size((max_size)?max_size:1)
+{}
+
+void box_list::add(const box& b)
+{
+	if ((b.xsize()<=0)||(b.ysize()<=0)) return;
+
+	box nb(b);
+	bool merged=true;
+	while (merged)
+	{
+		merged=false;
+
+		// Look for a box which can be merged without significant
+		// waste: that is, where the area of the union is no greater
+		// than the sum of the two areas.  (This includes the case
+		// where one box contains the other, and the case where
+		// boxes of equal width or height adjoin.)
+		for (std::vector<box>::iterator i=_boxes.begin();
+			i!=_boxes.end();++i)
+		{
+			box u=nb|*i;
+			if (area(u)<=area(nb)+area(*i))
+			{
+				nb=u;
+				_boxes.erase(i);
+				merged=true;
+				break;
+			}
+		}
+
+		// If no such box was found but the list is full, merge with
+		// the box that minimises the increase in area.
+		if (!merged&&(_boxes.size()>=_max_size))
+		{
+			std::vector<box>::iterator best=_boxes.begin();
+			area_type best_cost=area(nb|*best)-area(*best);
+			for (std::vector<box>::iterator i=best+1;
+				i!=_boxes.end();++i)
+			{
+				area_type cost=area(nb|*i)-area(*i);
+				if (cost<best_cost)
+				{
+					best=i;
+					best_cost=cost;
+				}
+			}
+			nb|=*best;
+			_boxes.erase(best);
+			merged=true;
+		}
+	}
+	_boxes.push_back(nb);
+}
+
+} /* namespace graphics */
+} /* namespace rtk */
@@ -0,0 +1,77 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#ifndef _RTK_GRAPHICS_BOX_LIST
+#define _RTK_GRAPHICS_BOX_LIST
+
+#include <vector>
+
+#include "rtk/graphics/box.h"
+
+namespace rtk {
+namespace graphics {
+
+/** A class for accumulating a list of boxes.
+ * This is intended for recording areas that need to be redrawn.
+ * Boxes which overlap or adjoin are merged when this does not increase
+ * the total area covered by more than the area of the overlap.  The
+ * number of boxes is limited: once that limit has been reached, each
+ * new box is merged with whichever existing box minimises the increase
+ * in area.  The union of the boxes in the list always contains the
+ * union of the boxes that have been added.
+ */
+class box_list
+{
+public:
+	/** A type for representing the number of boxes. */
+	typedef unsigned int size_type;
+
+	/** A type for iterating over the boxes. */
+	typedef std::vector<box>::const_iterator const_iterator;
+private:
+	/** The maximum number of boxes. */
+	size_type _max_size;
+
+	/** The boxes. */
+	std::vector<box> _boxes;
+public:
+	/** Construct box list.
+	 * @param max_size the maximum number of boxes (at least 1)
+	 */
+	box_list(size_type max_size=8);
+
+	/** Add box.
+	 * Boxes with zero or negative width or height are ignored.
+	 * @param b the box to be added
+	 */
+	void add(const box& b);
+
+	/** Remove all boxes. */
+	void clear()
+		{ _boxes.clear(); }
+
+	/** Get number of boxes.
+	 * @return the number of boxes
+	 */
+	size_type size() const
+		{ return _boxes.size(); }
+
+	/** Get iterator for start of list.
+	 * @return an iterator pointing to the first box
+	 */
+	const_iterator begin() const
+		{ return _boxes.begin(); }
+
+	/** Get iterator for end of list.
+	 * @return an iterator pointing to one past the last box
+	 */
+	const_iterator end() const
+		{ return _boxes.end(); }
+};
+
+} /* namespace graphics */
+} /* namespace rtk */
+
+#endif
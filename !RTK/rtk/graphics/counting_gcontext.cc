@@ -0,0 +1,70 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#include <cstring>
+
+#include "rtk/graphics/run_list.h"
+#include "rtk/graphics/counting_gcontext.h"
+
+namespace rtk {
+namespace graphics {
+
+counting_gcontext::counting_gcontext(const point& origin,bool update):
+	gcontext(origin,update),
+	_plots(0),
+	_draws(0),
+	_chars(0),
+	_colour_changes(0)
+{}
+
+counting_gcontext::~counting_gcontext()
+{}
+
+void counting_gcontext::plot(int code,const point& p)
+{
+	++_plots;
+}
+
+void counting_gcontext::draw(const char* s,const point& p)
+{
+	++_draws;
+	_chars+=strlen(s);
+}
+
+void counting_gcontext::draw(const font& f,const char* s,const point& p)
+{
+	++_draws;
+	_chars+=strlen(s);
+}
+
+void counting_gcontext::draw(const font& f,const run_list& runs,
+	const point& p)
+{
+	++_draws;
+	_chars+=runs.text().length();
+}
+
+void counting_gcontext::reset()
+{
+	_plots=0;
+	_draws=0;
+	_chars=0;
+	_colour_changes=0;
+}
+
+void counting_gcontext::fcolour_notify(int fcolour)
+{
+	++_colour_changes;
+	inherited::fcolour_notify(fcolour);
+}
+
+void counting_gcontext::bcolour_notify(int bcolour)
+{
+	++_colour_changes;
+	inherited::bcolour_notify(bcolour);
+}
+
+} /* namespace graphics */
+} /* namespace rtk */
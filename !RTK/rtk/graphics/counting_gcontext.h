@@ -0,0 +1,92 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#ifndef _RTK_GRAPHICS_COUNTING_GCONTEXT
+#define _RTK_GRAPHICS_COUNTING_GCONTEXT
+
+#include "rtk/graphics/gcontext.h"
+
+namespace rtk {
+namespace graphics {
+
+/** A class to represent a graphics context which counts operations.
+ * No output is produced.  Instead, a count is kept of each type of
+ * operation requested.  This is intended for measuring the amount of
+ * work done by a redraw (for example, to check that a component draws
+ * only what lies within the clip box) without the cost or side-effects
+ * of producing output.
+ */
+class counting_gcontext:
+	public gcontext
+{
+private:
+	/** The class from which this one is derived. */
+	typedef gcontext inherited;
+
+	/** The number of calls to plot(). */
+	unsigned int _plots;
+
+	/** The number of calls to draw(). */
+	unsigned int _draws;
+
+	/** The number of characters passed to draw(). */
+	unsigned int _chars;
+
+	/** The number of changes to the foreground or background colour. */
+	unsigned int _colour_changes;
+public:
+	/** Construct counting graphics context.
+	 * @param origin the initial origin
+	 * @param update true if this graphics context refers to an existing
+	 *  valid area to be updated, false if it must be completely redrawn
+	 */
+	explicit counting_gcontext(const point& origin=point(),
+		bool update=false);
+
+	/** Destroy counting graphics context. */
+	virtual ~counting_gcontext();
+
+	virtual void plot(int code,const point& p);
+	virtual void draw(const char* s,const point& p);
+	virtual void draw(const font& f,const char* s,const point& p);
+	virtual void draw(const font& f,const run_list& runs,const point& p);
+
+	/** Get number of plot operations.
+	 * @return the number of calls to plot()
+	 */
+	unsigned int plots() const
+		{ return _plots; }
+
+	/** Get number of draw operations.
+	 * A run list counts as a single draw operation.
+	 * @return the number of calls to draw(), for any font
+	 */
+	unsigned int draws() const
+		{ return _draws; }
+
+	/** Get number of characters drawn.
+	 * @return the total length of the strings passed to draw()
+	 */
+	unsigned int chars() const
+		{ return _chars; }
+
+	/** Get number of colour changes.
+	 * @return the number of changes to the foreground or background
+	 *  colour
+	 */
+	unsigned int colour_changes() const
+		{ return _colour_changes; }
+
+	/** Reset all counts to zero. */
+	void reset();
+protected:
+	virtual void fcolour_notify(int fcolour);
+	virtual void bcolour_notify(int bcolour);
+};
+
+} /* namespace graphics */
+} /* namespace rtk */
+
+#endif
@@ -4,25 +4,83 @@
 // a copy of which may be found in the file !RTK.Copyright.
 
 #include "rtk/graphics/point.h"
+#include "rtk/graphics/box.h"
 #include "rtk/graphics/font.h"
 
 #include "rtk/os/font.h"
 #include "rtk/os/colourtrans.h"
 #include "rtk/os/wimp.h"
+#include "rtk/desktop/screen_metrics.h"
 
 namespace rtk {
 namespace graphics {
 
+namespace {
+
+/** The number of character codes for which advance widths are cached.
+ * This is limited to 7-bit character codes because their meaning is
+ * common to all alphabets (including UTF-8, in which characters with
+ * codes of 128 and above may be encoded as more than one byte).
+ */
+const unsigned int advance_count=0x80;
+
+/** Test whether advance width of character can be cached.
+ * This is true for printable 7-bit characters.  Control characters
+ * are excluded because they have special meanings to the font manager.
+ * @param c the character code
+ * @return true if the advance width can be cached, otherwise false
+ */
+inline bool cacheable(char c)
+{
+	return (c>=0x20)&&(c<0x7f);
+}
+
+/** Test whether width of string can be calculated from cached
+ * advance widths.
+ * @param s the string
+ * @param length the length of the string
+ * @return true if the width can be calculated, otherwise false
+ */
+bool cacheable(const char* s,unsigned int length)
+{
+	for (unsigned int i=0;i!=length;++i)
+	{
+		if (!cacheable(s[i])) return false;
+	}
+	return true;
+}
+
+} /* anonymous namespace */
+
 class font::basic_font
 {
 	friend class font;
 private:
 	unsigned int _refcount;
+
+	/** The font handle to which _advance refers, or -1 if none.
+	 * (0 is a valid handle: it refers to the system font.) */
+	mutable int _advance_handle;
+
+	/** The advance width of each character (in millipoints),
+	 * or -1 if not yet measured. */
+	mutable int _advance[advance_count];
 public:
 	basic_font(unsigned int refcount);
 	virtual ~basic_font();
 	virtual int handle() const=0;
 	static basic_font* select_default_font(default_font_type type);
+
+	/** Get advance width of character.
+	 * The width is measured using Font_ScanString the first time it
+	 * is requested, then cached until the font handle changes.  Kerning
+	 * is not applied, so the width of a string is equal to the sum
+	 * of the widths of its characters.
+	 * @param handle the current font handle
+	 * @param c the character code, which must be cacheable
+	 * @return the advance width (in millipoints)
+	 */
+	int advance(int handle,char c) const;
 };
 
 class font::desktop_font:
@@ -53,7 +111,8 @@ public:
 };
 
 font::basic_font::basic_font(unsigned int refcount):
-	_refcount(refcount)
+	_refcount(refcount),
+	_advance_handle(-1)
 {}
 
 font::basic_font::~basic_font()
@@ -74,6 +133,27 @@ font::basic_font* font::basic_font::select_default_font(default_font_type type)
 	}
 }
 
+int font::basic_font::advance(int handle,char c) const
+{
+	// Discard cached advance widths if the font handle has changed
+	// (as it may for the desktop and symbol fonts).
+	if (handle!=_advance_handle)
+	{
+		for (unsigned int i=0;i!=advance_count;++i) _advance[i]=-1;
+		_advance_handle=handle;
+	}
+
+	int& adv=_advance[(unsigned char)c];
+	if (adv<0)
+	{
+		char s[2]={c,0};
+		point size;
+		os::Font_ScanString(handle,s,0x180,point(-1,0),0,0,1,0,&size,0);
+		adv=size.x();
+	}
+	return adv;
+}
+
 font::desktop_font::desktop_font():
 	basic_font(1)
 {}
@@ -156,11 +236,120 @@ void font::paint(const string& s,const point& p) const
 int font::width(const char* s,unsigned int length) const
 {
 	int handle=_f->handle();
+
+	// If possible, sum the cached advance widths.
+	if (cacheable(s,length))
+	{
+		int width=0;
+		for (unsigned int i=0;i!=length;++i)
+			width+=_f->advance(handle,s[i]);
+		return width/400;
+	}
+
+	// Otherwise, measure the string.
 	point size;
 	os::Font_ScanString(handle,s,0x180,point(-1,0),0,0,length,0,&size,0);
 	return size.x()/400;
 }
 
+unsigned int font::split(const char* s,unsigned int length,int width,
+	int split_char,int* _width) const
+{
+	int handle=_f->handle();
+
+	// If the advance widths cannot be cached then use the font manager.
+	if (!cacheable(s,length))
+	{
+		os::coord_block_scanstring coord;
+		coord.space_offset=point();
+		coord.letter_offset=point();
+		coord.split_char=split_char;
+		const char* q=s;
+		point size;
+		os::Font_ScanString(handle,s,(split_char!=-1)?0x1a0:0x180,
+			point(width*400,0),&coord,0,length,&q,&size,0);
+		if (_width) *_width=size.x()/400;
+		return q-s;
+	}
+
+	// Otherwise, accumulate advance widths until the limit is exceeded,
+	// recording the position of the last split character.
+	int limit=width*400;
+	int x=0;
+	unsigned int split_index=0;
+	int split_x=0;
+	unsigned int i=0;
+	while (i!=length)
+	{
+		if (s[i]==split_char)
+		{
+			split_index=i;
+			split_x=x;
+		}
+		int adv=_f->advance(handle,s[i]);
+		if (x+adv>limit) break;
+		x+=adv;
+		++i;
+	}
+
+	// If the limit was exceeded, and there is a split character,
+	// then split at the last occurrence of it.
+	if ((i!=length)&&(split_char!=-1))
+	{
+		i=split_index;
+		x=split_x;
+	}
+
+	if (_width) *_width=x/400;
+	return i;
+}
+
+unsigned int font::find(const char* s,unsigned int length,int x,
+	int* _x) const
+{
+	int handle=_f->handle();
+
+	// If the advance widths cannot be cached then use the font manager.
+	if (!cacheable(s,length))
+	{
+		const char* q=s;
+		point size;
+		os::Font_ScanString(handle,s,0x20180,point(x*400,0),
+			0,0,length,&q,&size,0);
+		if (_x) *_x=size.x()/400;
+		return q-s;
+	}
+
+	// Otherwise, accumulate advance widths until the next caret
+	// position would be further from the x-coordinate than the
+	// current one.
+	int limit=x*400;
+	int pos=0;
+	unsigned int i=0;
+	while (i!=length)
+	{
+		int adv=_f->advance(handle,s[i]);
+		if ((limit-pos)*2<adv) break;
+		pos+=adv;
+		++i;
+	}
+
+	if (_x) *_x=pos/400;
+	return i;
+}
+
+box font::bbox() const
+{
+	// Font_ReadInfo returns the bounding box in pixels, so it must
+	// be converted to OS units.
+	box bbox;
+	os::Font_ReadInfo(_f->handle(),&bbox);
+	int xpix=desktop::screen_metrics::xpix();
+	int ypix=desktop::screen_metrics::ypix();
+	return box(bbox.xmin()*xpix,bbox.ymin()*ypix,
+		bbox.xmax()*xpix,bbox.ymax()*ypix);
+}
+
 int font::handle() const
 {
 	return _f->handle();
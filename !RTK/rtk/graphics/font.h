@@ -12,6 +12,7 @@ namespace rtk {
 namespace graphics {
 
 class point;
+class box;
 
 using std::string;
 
@@ -73,6 +74,22 @@ public:
 	 */
 	font& operator=(const font& f);
 
+	/** Compare font objects.
+	 * Font objects are equal if they share the same underlying font
+	 * data (as they do if one was copied from the other).
+	 * @param f the font to be compared
+	 * @return true if the font objects are equal, otherwise false
+	 */
+	bool operator==(const font& f) const
+		{ return _f==f._f; }
+
+	/** Compare font objects.
+	 * @param f the font to be compared
+	 * @return true if the font objects are not equal, otherwise false
+	 */
+	bool operator!=(const font& f) const
+		{ return _f!=f._f; }
+
 	/** Plot string to screen using font.
 	 * @param s the string to plot
 	 * @param p the point at which to begin plotting (in OS units)
@@ -93,6 +110,42 @@ public:
 	int width(const string& s) const
 		{ return width(s.c_str(),s.length()); }
 
+	/** Find point at which to split string to fit within given width.
+	 * If a split character is specified then the string is split
+	 * immediately before the last occurrence of that character
+	 * which fits within the given width, or not at all if there is
+	 * no such occurrence.  Otherwise, it is split after the last
+	 * character which fits within the given width.  If the whole
+	 * of the string fits then the result is equal to length.
+	 * @param s the string to split
+	 * @param length the length of the string
+	 * @param width the available width (in OS units)
+	 * @param split_char the split character, or -1 if none
+	 * @param _width a buffer for the returned width of the characters
+	 *  preceding the split point (in OS units), or 0 if not required
+	 * @return the number of characters preceding the split point
+	 */
+	unsigned int split(const char* s,unsigned int length,int width,
+		int split_char,int* _width=0) const;
+
+	/** Find caret position nearest to given x-coordinate.
+	 * @param s the string to search
+	 * @param length the length of the string
+	 * @param x the x-coordinate, with respect to the start of the
+	 *  string (in OS units)
+	 * @param _x a buffer for the returned x-coordinate of the caret
+	 *  position (in OS units), or 0 if not required
+	 * @return the number of characters preceding the caret position
+	 */
+	unsigned int find(const char* s,unsigned int length,int x,
+		int* _x=0) const;
+
+	/** Get bounding box of font.
+	 * @return a box large enough to contain any character, with respect
+	 *  to the point at which it is plotted (in OS units)
+	 */
+	box bbox() const;
+
 	/** Get font handle.
 	 * @return the handle for this font
 	 */
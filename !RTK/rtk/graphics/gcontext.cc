@@ -4,6 +4,7 @@
 // a copy of which may be found in the file !RTK.Copyright.
 
 #include "rtk/graphics/font.h"
+#include "rtk/graphics/run_list.h"
 #include "rtk/graphics/gcontext.h"
 
 namespace rtk {
@@ -19,6 +20,20 @@ gcontext::gcontext(const point& origin,bool update):
 gcontext::~gcontext()
 {}
 
+void gcontext::draw(const font& f,const run_list& runs,const point& p)
+{
+	const string& text=runs.text();
+	point q(p);
+	for (unsigned int i=0;i!=runs.size();++i)
+	{
+		string s(text,runs[i].index,runs.length(i));
+		bcolour(runs[i].bcolour);
+		fcolour(runs[i].fcolour);
+		draw(f,s,q);
+		q+=point(f.width(s),0);
+	}
+}
+
 void gcontext::fcolour(int fcolour)
 {
 	if (fcolour!=_fcolour)
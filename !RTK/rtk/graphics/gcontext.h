@@ -14,6 +14,7 @@ namespace rtk {
 namespace graphics {
 
 class font;
+class run_list;
 
 using std::string;
 
@@ -107,6 +108,18 @@ public:
 	void draw(const font& f,const string& s,const point& p)
 		{ draw(f,s.c_str(),p); } 
 
+	/** Draw run list to graphics context using specified font.
+	 * The default implementation draws each run separately, in its
+	 * own colours, using the font to determine where each run begins.
+	 * Subclasses should override this if the runs can be drawn more
+	 * efficiently as a single operation.  On return, the current
+	 * colours are unspecified.
+	 * @param f the font to be used
+	 * @param runs the run list to be drawn
+	 * @param p the point at which to begin
+	 */
+	virtual void draw(const font& f,const run_list& runs,const point& p);
+
 	/** Get current foreground colour.
 	 * This is one of the 16 standard Wimp colours.
 	 * @return the current foreground colour
@@ -25,6 +25,7 @@ void print_gcontext::activate()
 		os::PDriver_SelectJob(_handle,0,0);
 	}
 
+	forget_colours();
 	inherited::activate();
 }
 
@@ -41,6 +42,8 @@ void print_gcontext::deactivate()
 	{
 		os::PDriver_SelectJob(0,0,0);
 	}
+
+	forget_colours();
 }
 
 } /* namespace graphics */
@@ -0,0 +1,407 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#include <cstring>
+#include <limits>
+
+#include "rtk/graphics/recording_gcontext.h"
+
+namespace rtk {
+namespace graphics {
+
+namespace {
+
+/** The margin by which the extent of a plot operation is expanded
+ * to allow for the size of a pixel (in OS units). */
+const int plot_margin=4;
+
+/** Test whether plot code is a move.
+ * @param code the plot code
+ * @return true if the plot code moves without drawing, otherwise false
+ */
+inline bool is_move(int code)
+{
+	return (code&3)==0;
+}
+
+/** Count previous points referred to by plot code.
+ * @param code the plot code
+ * @return the number of points preceding the point plotted which
+ *  affect the outcome (at most 2)
+ */
+inline unsigned int plot_refs(int code)
+{
+	switch (code&~7)
+	{
+	case 0x00:
+	case 0x08:
+	case 0x10:
+	case 0x18:
+	case 0x20:
+	case 0x28:
+	case 0x30:
+	case 0x38:
+	case 0x60:
+		// Line or rectangle.
+		return 1;
+	case 0x40:
+		// Point.
+		return (code&4)?0:1;
+	default:
+		// Triangle, parallelogram, or an operation (such as a
+		// circle or flood fill) which may refer to either point.
+		return 2;
+	}
+}
+
+/** Test whether two boxes intersect.
+ * @param ba the first box
+ * @param bb the second box
+ * @return true if the boxes intersect, otherwise false
+ */
+inline bool intersects(const box& ba,const box& bb)
+{
+	return (ba.xmin()<bb.xmax())&&(ba.xmax()>bb.xmin())&&
+		(ba.ymin()<bb.ymax())&&(ba.ymax()>bb.ymin());
+}
+
+/** Calculate extent of plot operation.
+ * This is possible for lines, points, triangles, rectangles and
+ * parallelograms, which lie within the bounding box of the point
+ * plotted and the points that precede it.
+ * @param code the plot code
+ * @param p0 the point plotted
+ * @param p1 the previous point
+ * @param p2 the point before that
+ * @param _extent a buffer for the returned extent
+ * @return true if the extent is known, otherwise false
+ */
+bool plot_extent(int code,const point& p0,const point& p1,const point& p2,
+	box* _extent)
+{
+	box extent(p0,p0);
+	switch (code&~7)
+	{
+	case 0x00:
+	case 0x08:
+	case 0x10:
+	case 0x18:
+	case 0x20:
+	case 0x28:
+	case 0x30:
+	case 0x38:
+		// Line.
+		extent=extent|p1;
+		break;
+	case 0x40:
+		// Point.
+		break;
+	case 0x50:
+		// Triangle.
+		extent=extent|p1;
+		extent=extent|p2;
+		break;
+	case 0x60:
+		// Rectangle.
+		extent=extent|p1;
+		break;
+	case 0x70:
+		// Parallelogram, for which the fourth vertex is implied.
+		extent=extent|p1;
+		extent=extent|p2;
+		extent=extent|(p0-p1+p2);
+		break;
+	default:
+		return false;
+	}
+	*_extent=extent+box(-plot_margin,-plot_margin,plot_margin,plot_margin);
+	return true;
+}
+
+/** A clip box which contains every bounded operation. */
+const box everything(
+	std::numeric_limits<int>::min(),std::numeric_limits<int>::min(),
+	std::numeric_limits<int>::max(),std::numeric_limits<int>::max());
+
+} /* anonymous namespace */
+
+recording_gcontext::recording_gcontext(const point& origin,bool update):
+	gcontext(origin,update),
+	_initial_fcolour(fcolour()),
+	_initial_bcolour(bcolour())
+{}
+
+recording_gcontext::~recording_gcontext()
+{}
+
+void recording_gcontext::plot(int code,const point& p)
+{
+	// As for vdu_gcontext, the origin is added whether or not the
+	// plot code is relative.
+	op o;
+	o.type=op_plot;
+	o.code=code;
+	o.p=origin()+p;
+	o.index=0;
+	o.length=0;
+
+	// Track the points plotted, so that the extent of operations
+	// which refer to previous points can be calculated.
+	point abs=(code&4)?o.p:_pen[0]+o.p;
+	o.pen[0]=_pen[0];
+	o.pen[1]=_pen[1];
+	o.bounded=!is_move(code)&&plot_extent(code,abs,_pen[0],_pen[1],&o.extent);
+	_pen[1]=_pen[0];
+	_pen[0]=abs;
+
+	_ops.push_back(o);
+}
+
+void recording_gcontext::draw(const char* s,const point& p)
+{
+	op o;
+	o.type=op_text;
+	o.bounded=false;
+	o.code=0;
+	o.p=origin()+p;
+	o.index=_text.length();
+	o.length=strlen(s);
+
+	// Each string is terminated within _text so that it can be
+	// replayed without being copied.
+	_text.append(s,o.length);
+	_text+=char(0);
+	_ops.push_back(o);
+}
+
+void recording_gcontext::draw(const font& f,const char* s,const point& p)
+{
+	op o;
+	o.type=op_font_text;
+	o.bounded=true;
+	o.code=font_index(f);
+	o.p=origin()+p;
+	o.index=_text.length();
+	o.length=strlen(s);
+
+	// The extent is conservative: it allows for the widest character
+	// of the font extending beyond the end of the string.
+	const box& fbbox=_font_bboxes[o.code];
+	int width=f.width(s,o.length);
+	o.extent=box(o.p.x()+fbbox.xmin(),o.p.y()+fbbox.ymin(),
+		o.p.x()+width+fbbox.xmax(),o.p.y()+fbbox.ymax());
+
+	_text.append(s,o.length);
+	_text+=char(0);
+	_ops.push_back(o);
+}
+
+void recording_gcontext::draw(const font& f,const run_list& runs,
+	const point& p)
+{
+	op o;
+	o.type=op_runs;
+	o.bounded=true;
+	o.code=font_index(f);
+	o.p=origin()+p;
+	o.index=_runs.size();
+	o.length=0;
+
+	const box& fbbox=_font_bboxes[o.code];
+	int width=f.width(runs.text());
+	o.extent=box(o.p.x()+fbbox.xmin(),o.p.y()+fbbox.ymin(),
+		o.p.x()+width+fbbox.xmax(),o.p.y()+fbbox.ymax());
+
+	_runs.push_back(runs);
+	_ops.push_back(o);
+}
+
+void recording_gcontext::clear()
+{
+	_ops.clear();
+	_text.erase();
+	_fonts.clear();
+	_font_bboxes.clear();
+	_runs.clear();
+	_initial_fcolour=fcolour();
+	_initial_bcolour=bcolour();
+	_pen[0]=point();
+	_pen[1]=point();
+}
+
+void recording_gcontext::replay(gcontext& context) const
+{
+	replay(context,everything);
+}
+
+void recording_gcontext::replay(gcontext& context,const box& clip) const
+{
+	int fcolour=_initial_fcolour;
+	int bcolour=_initial_bcolour;
+	for (std::vector<op>::const_iterator i=_ops.begin();i!=_ops.end();++i)
+	{
+		const op& o=*i;
+		if (o.type==op_fcolour) fcolour=o.code;
+		else if (o.type==op_bcolour) bcolour=o.code;
+		else if (!visible(o,clip))
+		{
+			// A culled plot is replayed as a move, so that the
+			// previous points are as expected by later plots.
+			if (o.type==op_plot) context.plot(o.code&4,o.p);
+		}
+		else
+		{
+			// The colours are set before each operation because
+			// drawing a run list may change them.
+			context.fcolour(fcolour);
+			context.bcolour(bcolour);
+			switch (o.type)
+			{
+			case op_plot:
+				context.plot(o.code,o.p);
+				break;
+			case op_text:
+				context.draw(_text.c_str()+o.index,o.p);
+				break;
+			case op_font_text:
+				context.draw(_fonts[o.code],_text.c_str()+o.index,o.p);
+				break;
+			case op_runs:
+				context.draw(_fonts[o.code],_runs[o.index],o.p);
+				break;
+			}
+		}
+	}
+}
+
+bool recording_gcontext::same(const recording_gcontext& rc,
+	const box& clip) const
+{
+	int fcolour=_initial_fcolour;
+	int bcolour=_initial_bcolour;
+	int rc_fcolour=rc._initial_fcolour;
+	int rc_bcolour=rc._initial_bcolour;
+	unsigned int i=0;
+	unsigned int j=0;
+	while (true)
+	{
+		i=next_drawn(i,clip,fcolour,bcolour);
+		j=rc.next_drawn(j,clip,rc_fcolour,rc_bcolour);
+		if ((i==size())||(j==rc.size()))
+			return (i==size())&&(j==rc.size());
+		if ((fcolour!=rc_fcolour)||(bcolour!=rc_bcolour)) return false;
+		if (!same(i,rc,j)) return false;
+		++i;
+		++j;
+	}
+}
+
+void recording_gcontext::fcolour_notify(int fcolour)
+{
+	op o;
+	o.type=op_fcolour;
+	o.bounded=false;
+	o.code=fcolour;
+	o.index=0;
+	o.length=0;
+	_ops.push_back(o);
+	inherited::fcolour_notify(fcolour);
+}
+
+void recording_gcontext::bcolour_notify(int bcolour)
+{
+	op o;
+	o.type=op_bcolour;
+	o.bounded=false;
+	o.code=bcolour;
+	o.index=0;
+	o.length=0;
+	_ops.push_back(o);
+	inherited::bcolour_notify(bcolour);
+}
+
+unsigned int recording_gcontext::font_index(const font& f)
+{
+	// Few fonts are used by any one redraw, so a linear search suffices.
+	for (unsigned int i=0;i!=_fonts.size();++i)
+	{
+		if (_fonts[i]==f) return i;
+	}
+	_fonts.push_back(f);
+	_font_bboxes.push_back(f.bbox());
+	return _fonts.size()-1;
+}
+
+bool recording_gcontext::visible(const op& o,const box& clip)
+{
+	if ((o.type==op_fcolour)||(o.type==op_bcolour)) return true;
+	if ((o.type==op_plot)&&is_move(o.code)) return true;
+	if (!o.bounded) return true;
+	return intersects(o.extent,clip);
+}
+
+unsigned int recording_gcontext::next_drawn(unsigned int i,const box& clip,
+	int& fcolour,int& bcolour) const
+{
+	while (i!=_ops.size())
+	{
+		const op& o=_ops[i];
+		if (o.type==op_fcolour) fcolour=o.code;
+		else if (o.type==op_bcolour) bcolour=o.code;
+		else if ((o.type==op_plot)&&is_move(o.code));
+		else if (visible(o,clip)) return i;
+		++i;
+	}
+	return i;
+}
+
+bool recording_gcontext::same(unsigned int i,const recording_gcontext& rc,
+	unsigned int j) const
+{
+	const op& a=_ops[i];
+	const op& b=rc._ops[j];
+	if ((a.type!=b.type)||(a.p!=b.p)||(a.bounded!=b.bounded)) return false;
+	if (a.bounded&&(a.extent!=b.extent)) return false;
+
+	switch (a.type)
+	{
+	case op_plot:
+		{
+			// A plot may depend on previous points (including those
+			// set by moves, which are not compared separately).
+			if (a.code!=b.code) return false;
+			unsigned int refs=plot_refs(a.code);
+			for (unsigned int k=0;k!=refs;++k)
+			{
+				if (a.pen[k]!=b.pen[k]) return false;
+			}
+			return true;
+		}
+	case op_text:
+		return (a.length==b.length)&&
+			!memcmp(_text.data()+a.index,rc._text.data()+b.index,a.length);
+	case op_font_text:
+		return (_fonts[a.code]==rc._fonts[b.code])&&(a.length==b.length)&&
+			!memcmp(_text.data()+a.index,rc._text.data()+b.index,a.length);
+	case op_runs:
+		{
+			if (_fonts[a.code]!=rc._fonts[b.code]) return false;
+			const run_list& ra=_runs[a.index];
+			const run_list& rb=rc._runs[b.index];
+			if ((ra.size()!=rb.size())||(ra.text()!=rb.text())) return false;
+			for (unsigned int k=0;k!=ra.size();++k)
+			{
+				if ((ra[k].index!=rb[k].index)||
+					(ra[k].fcolour!=rb[k].fcolour)||
+					(ra[k].bcolour!=rb[k].bcolour)) return false;
+			}
+			return true;
+		}
+	}
+	return true;
+}
+
+} /* namespace graphics */
+} /* namespace rtk */
@@ -0,0 +1,211 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#ifndef _RTK_GRAPHICS_RECORDING_GCONTEXT
+#define _RTK_GRAPHICS_RECORDING_GCONTEXT
+
+#include <vector>
+
+#include "rtk/graphics/box.h"
+#include "rtk/graphics/font.h"
+#include "rtk/graphics/run_list.h"
+#include "rtk/graphics/gcontext.h"
+
+namespace rtk {
+namespace graphics {
+
+/** A class to represent a graphics context which records a display list.
+ * No output is produced.  Instead, each plot, draw and colour change is
+ * appended to a display list, which can later be replayed into any other
+ * graphics context (for example, a vdu_gcontext for the screen or a
+ * print_gcontext for a print job).
+ *
+ * Coordinates are recorded with respect to the origin of the recording
+ * context when it was constructed, translated by any subsequent changes
+ * to that origin (as they would have been by a vdu_gcontext).  When
+ * replayed, they are with respect to the origin of the target context.
+ *
+ * Where possible, the bounding box of each operation is recorded so that
+ * operations lying wholly outside a given clip box can be culled when
+ * the list is replayed, and so that the lists from two redraws can be
+ * compared within a clip box.  Operations with no known bounding box
+ * (for example, flood fills, circles and text in the desktop font)
+ * are never culled.
+ */
+class recording_gcontext:
+	public gcontext
+{
+private:
+	/** The class from which this one is derived. */
+	typedef gcontext inherited;
+
+	/** An enumeration to identify the type of a recorded operation. */
+	enum op_type
+	{
+		/** A call to plot(). */
+		op_plot,
+		/** A call to draw() using the desktop font. */
+		op_text,
+		/** A call to draw() using a specified font. */
+		op_font_text,
+		/** A call to draw() using a run list. */
+		op_runs,
+		/** A change to the foreground colour. */
+		op_fcolour,
+		/** A change to the background colour. */
+		op_bcolour
+	};
+
+	/** A structure to represent a recorded operation. */
+	struct op
+	{
+		/** The type of operation. */
+		unsigned char type;
+		/** True if the extent of the operation is known, otherwise
+		 * false. */
+		bool bounded;
+		/** The plot code, the index into _fonts or the colour,
+		 * depending on the type of operation. */
+		int code;
+		/** The point, with respect to the origin of the display list. */
+		point p;
+		/** For a plot operation, the last two points plotted before it
+		 * (most recent first), with respect to the origin of the
+		 * display list. */
+		point pen[2];
+		/** The extent of the operation, if bounded. */
+		box extent;
+		/** The index of the first character in _text, or the index
+		 * into _runs. */
+		unsigned int index;
+		/** The number of characters in _text. */
+		unsigned int length;
+	};
+
+	/** The recorded operations. */
+	std::vector<op> _ops;
+
+	/** The text drawn by op_text and op_font_text operations. */
+	string _text;
+
+	/** The fonts used by op_font_text and op_runs operations. */
+	std::vector<font> _fonts;
+
+	/** The bounding box of each font in _fonts. */
+	std::vector<box> _font_bboxes;
+
+	/** The run lists drawn by op_runs operations. */
+	std::vector<run_list> _runs;
+
+	/** The foreground colour when recording began. */
+	int _initial_fcolour;
+
+	/** The background colour when recording began. */
+	int _initial_bcolour;
+
+	/** The last two points plotted, most recent first, with respect
+	 * to the origin of the display list. */
+	point _pen[2];
+public:
+	/** Construct recording graphics context.
+	 * @param origin the initial origin
+	 * @param update true if this graphics context refers to an existing
+	 *  valid area to be updated, false if it must be completely redrawn
+	 */
+	explicit recording_gcontext(const point& origin=point(),
+		bool update=false);
+
+	/** Destroy recording graphics context. */
+	virtual ~recording_gcontext();
+
+	virtual void plot(int code,const point& p);
+	virtual void draw(const char* s,const point& p);
+	virtual void draw(const font& f,const char* s,const point& p);
+	virtual void draw(const font& f,const run_list& runs,const point& p);
+
+	/** Get number of recorded operations.
+	 * @return the number of operations, including colour changes
+	 */
+	unsigned int size() const
+		{ return _ops.size(); }
+
+	/** Discard display list.
+	 * Recording begins again, starting from the current colours.
+	 */
+	void clear();
+
+	/** Replay display list.
+	 * @param context the graphics context into which the list is to be
+	 *  replayed
+	 */
+	void replay(gcontext& context) const;
+
+	/** Replay part of display list.
+	 * Operations which lie wholly outside the clip box are culled.
+	 * Culled plot operations are replayed as moves, so that any later
+	 * operation that refers to previous points is unaffected.
+	 * @param context the graphics context into which the list is to be
+	 *  replayed
+	 * @param clip the clip box, with respect to the origin of the
+	 *  display list
+	 */
+	void replay(gcontext& context,const box& clip) const;
+
+	/** Compare part of display list with another.
+	 * The lists are considered the same if, after culling, they contain
+	 * the same drawing operations in the same order, drawn in the same
+	 * colours.  Moves are not compared as such, but the previous points
+	 * to which each plot operation refers are.
+	 * @param rc the recording graphics context to be compared
+	 * @param clip the clip box, with respect to the origin of the
+	 *  display lists
+	 * @return true if the lists are the same within the clip box,
+	 *  otherwise false
+	 */
+	bool same(const recording_gcontext& rc,const box& clip) const;
+protected:
+	virtual void fcolour_notify(int fcolour);
+	virtual void bcolour_notify(int bcolour);
+private:
+	/** Find or add font.
+	 * @param f the font
+	 * @return the index of the font in _fonts
+	 */
+	unsigned int font_index(const font& f);
+
+	/** Test whether operation must be replayed.
+	 * @param o the operation
+	 * @param clip the clip box
+	 * @return true if the operation is a colour change or move, or if it
+	 *  may intersect the clip box, otherwise false
+	 */
+	static bool visible(const op& o,const box& clip);
+
+	/** Find next visible drawing operation.
+	 * Colour changes are applied to the given colours as they are
+	 * passed.
+	 * @param i the index at which to begin searching
+	 * @param clip the clip box
+	 * @param fcolour the foreground colour, updated on exit
+	 * @param bcolour the background colour, updated on exit
+	 * @return the index of the operation, or size() if there is none
+	 */
+	unsigned int next_drawn(unsigned int i,const box& clip,
+		int& fcolour,int& bcolour) const;
+
+	/** Compare two drawing operations.
+	 * @param i the index of the operation within this list
+	 * @param rc the other list
+	 * @param j the index of the operation within the other list
+	 * @return true if the operations are the same, otherwise false
+	 */
+	bool same(unsigned int i,const recording_gcontext& rc,
+		unsigned int j) const;
+};
+
+} /* namespace graphics */
+} /* namespace rtk */
+
+#endif
@@ -0,0 +1,49 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#include "rtk/graphics/run_list.h"
+
+namespace rtk {
+namespace graphics {
+
+run_list::run_list()
+{}
+
+run_list& run_list::append(const char* s,unsigned int length,int fcolour,
+	int bcolour)
+{
+	if (length)
+	{
+		// Begin a new run unless the colours match those of the last one.
+		if (_runs.empty()||(_runs.back().fcolour!=fcolour)||
+			(_runs.back().bcolour!=bcolour))
+		{
+			run r;
+			r.index=_text.length();
+			r.fcolour=fcolour;
+			r.bcolour=bcolour;
+			_runs.push_back(r);
+		}
+		_text.append(s,length);
+	}
+	return *this;
+}
+
+run_list& run_list::clear()
+{
+	_text.erase();
+	_runs.clear();
+	return *this;
+}
+
+unsigned int run_list::length(unsigned int index) const
+{
+	unsigned int last=(index+1<_runs.size())?
+		_runs[index+1].index:_text.length();
+	return last-_runs[index].index;
+}
+
+} /* namespace graphics */
+} /* namespace rtk */
@@ -0,0 +1,114 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#ifndef _RTK_GRAPHICS_RUN_LIST
+#define _RTK_GRAPHICS_RUN_LIST
+
+#include <string>
+#include <vector>
+
+namespace rtk {
+namespace graphics {
+
+using std::string;
+
+/** A class to represent a sequence of coloured runs of text.
+ * A run list can be drawn to a graphics context as a single operation,
+ * which for the screen means a single call to Font_Paint with the
+ * colour changes embedded as control sequences.  The runs are drawn
+ * contiguously, each beginning where the previous one ended.
+ *
+ * The text must not contain control characters.
+ */
+class run_list
+{
+public:
+	/** A structure to represent a single run. */
+	struct run
+	{
+		/** The index of the first character of the run. */
+		unsigned int index;
+		/** The foreground colour of the run.
+		 * This is one of the 16 standard Wimp colours.
+		 */
+		int fcolour;
+		/** The background colour of the run.
+		 * This is one of the 16 standard Wimp colours.
+		 */
+		int bcolour;
+	};
+private:
+	/** The text of all runs, concatenated. */
+	string _text;
+
+	/** The runs, in order. */
+	std::vector<run> _runs;
+public:
+	/** Construct empty run list. */
+	run_list();
+
+	/** Append characters to run list.
+	 * If the colours are the same as those of the last run then that
+	 * run is extended, otherwise a new run is begun.
+	 * @param s the characters to append
+	 * @param length the number of characters to append
+	 * @param fcolour the required foreground colour
+	 * @param bcolour the required background colour
+	 * @return a reference to this
+	 */
+	run_list& append(const char* s,unsigned int length,int fcolour,
+		int bcolour);
+
+	/** Append string to run list.
+	 * @param s the string to append
+	 * @param fcolour the required foreground colour
+	 * @param bcolour the required background colour
+	 * @return a reference to this
+	 */
+	run_list& append(const string& s,int fcolour,int bcolour)
+		{ return append(s.data(),s.length(),fcolour,bcolour); }
+
+	/** Remove all runs.
+	 * The storage used is retained for re-use.
+	 * @return a reference to this
+	 */
+	run_list& clear();
+
+	/** Get text of all runs.
+	 * @return the text of all runs, concatenated
+	 */
+	const string& text() const
+		{ return _text; }
+
+	/** Get number of runs.
+	 * @return the number of runs
+	 */
+	unsigned int size() const
+		{ return _runs.size(); }
+
+	/** Test whether run list is empty.
+	 * @return true if there are no runs, otherwise false
+	 */
+	bool empty() const
+		{ return _runs.empty(); }
+
+	/** Get run.
+	 * @param index the index of the run
+	 * @return a reference to the run
+	 */
+	const run& operator[](unsigned int index) const
+		{ return _runs[index]; }
+
+	/** Get length of run.
+	 * @param index the index of the run
+	 * @return the number of characters in the run
+	 */
+	unsigned int length(unsigned int index) const;
+};
+
+} /* namespace graphics */
+} /* namespace rtk */
+
+#endif
@@ -0,0 +1,126 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#include "rtk/graphics/sprite_gcontext.h"
+#include "rtk/os/os.h"
+#include "rtk/desktop/screen_metrics.h"
+
+namespace rtk {
+namespace graphics {
+
+namespace {
+
+/** The size of a sprite area header, in bytes. */
+const unsigned int area_header_size=16;
+
+/** The size of a sprite header without a palette, in bytes. */
+const unsigned int sprite_header_size=44;
+
+} /* anonymous namespace */
+
+sprite_gcontext::sprite_gcontext(const point& origin,const point& size):
+	vdu_gcontext(origin,false),
+	_area((memory(size)+3)/4),
+	_mode(screen_mode()),
+	_size(size),
+	_clip(point(0,0),size)
+{
+	int xeig=desktop::screen_metrics::xeigfactor();
+	int yeig=desktop::screen_metrics::yeigfactor();
+
+	// Initialise the sprite area, then create a sprite within it
+	// without a palette (so that pixel values are used unchanged
+	// when it is drawn to the screen).
+	_area[0]=_area.size()*4;
+	_area[2]=area_header_size;
+	os::OS_SpriteOp9(area());
+	os::OS_SpriteOp15(area(),"cache",false,
+		(size.x()+(1<<xeig)-1)>>xeig,(size.y()+(1<<yeig)-1)>>yeig,_mode);
+}
+
+sprite_gcontext::~sprite_gcontext()
+{
+	// This cannot be left to the base class, because deactivate()
+	// must be called before the sprite area is released.
+	if (current()==this) current(0);
+}
+
+bool sprite_gcontext::compatible() const
+{
+	return _mode==screen_mode();
+}
+
+void sprite_gcontext::clip(const box& clip)
+{
+	_clip=clip+origin();
+	if (current()==this) select_clip();
+}
+
+os::sprite_area* sprite_gcontext::area() const
+{
+	return (os::sprite_area*)&_area[0];
+}
+
+os::sprite* sprite_gcontext::sprite() const
+{
+	// The area contains only one sprite.
+	return (os::sprite*)((const char*)&_area[0]+_area[2]);
+}
+
+unsigned int sprite_gcontext::memory(const point& size)
+{
+	int xeig=desktop::screen_metrics::xeigfactor();
+	int yeig=desktop::screen_metrics::yeigfactor();
+	int log2bpp=desktop::screen_metrics::log2bpp();
+
+	// Each row of pixels is padded to a whole number of words.
+	unsigned int xpix=(size.x()+(1<<xeig)-1)>>xeig;
+	unsigned int ypix=(size.y()+(1<<yeig)-1)>>yeig;
+	unsigned int row=(((xpix<<log2bpp)+31)>>5)<<2;
+	return area_header_size+sprite_header_size+row*ypix;
+}
+
+void sprite_gcontext::activate()
+{
+	os::OS_SpriteOp60(area(),sprite(),0,_restore);
+	forget_colours();
+	select_clip();
+	inherited::activate();
+}
+
+void sprite_gcontext::deactivate()
+{
+	inherited::deactivate();
+	os::OS_SpriteOp60(_restore);
+	forget_colours();
+}
+
+void sprite_gcontext::select_clip()
+{
+	// VDU 24 takes inclusive coordinates.
+	int coords[4]={_clip.xmin(),_clip.ymin(),_clip.xmax()-1,_clip.ymax()-1};
+	char vdu[9];
+	vdu[0]=24;
+	for (unsigned int i=0;i!=4;++i)
+	{
+		vdu[i*2+1]=coords[i]&0xff;
+		vdu[i*2+2]=(coords[i]>>8)&0xff;
+	}
+	os::OS_WriteN(vdu,sizeof(vdu));
+}
+
+int sprite_gcontext::screen_mode()
+{
+	int xeig=desktop::screen_metrics::xeigfactor();
+	int yeig=desktop::screen_metrics::yeigfactor();
+	int log2bpp=desktop::screen_metrics::log2bpp();
+
+	// Construct a sprite type word: type in bits 27-31, vertical
+	// and horizontal resolution in dpi in bits 14-26 and 1-13.
+	return ((log2bpp+1)<<27)|((180>>yeig)<<14)|((180>>xeig)<<1)|1;
+}
+
+} /* namespace graphics */
+} /* namespace rtk */
@@ -0,0 +1,123 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#ifndef _RTK_GRAPHICS_SPRITE_GCONTEXT
+#define _RTK_GRAPHICS_SPRITE_GCONTEXT
+
+#include <vector>
+
+#include "rtk/graphics/box.h"
+#include "rtk/graphics/vdu_gcontext.h"
+
+namespace rtk {
+namespace os {
+
+struct sprite;
+struct sprite_area;
+
+} /* namespace os */
+
+namespace graphics {
+
+/** A class to represent a graphics context associated with an
+ * off-screen sprite.
+ * Each graphics context of this type owns a sprite area containing a
+ * single sprite, created for the screen mode that was current when the
+ * context was constructed.  While the context is active, VDU output is
+ * redirected to that sprite.  Within the sprite, the point (0,0) is
+ * its bottom left-hand corner.
+ *
+ * The content of the sprite can be drawn to another VDU graphics
+ * context using vdu_gcontext::draw().
+ */
+class sprite_gcontext:
+	public vdu_gcontext
+{
+private:
+	/** The class from which this is derived. */
+	typedef vdu_gcontext inherited;
+
+	/** The sprite area, held as an array of words. */
+	std::vector<int> _area;
+
+	/** The sprite type word for the mode in which the sprite was
+	 * created. */
+	int _mode;
+
+	/** The size of the sprite, in OS units. */
+	point _size;
+
+	/** The graphics window, with respect to the bottom left-hand
+	 * corner of the sprite. */
+	box _clip;
+
+	/** The values to be passed to OS_SpriteOp to restore the
+	 * previous output destination. */
+	int _restore[4];
+public:
+	/** Construct sprite graphics context.
+	 * @param origin the initial origin
+	 * @param size the required size of the sprite, in OS units
+	 */
+	sprite_gcontext(const point& origin,const point& size);
+
+	/** Destroy sprite graphics context. */
+	virtual ~sprite_gcontext();
+
+	/** Get size of sprite.
+	 * @return the size of the sprite, in OS units
+	 */
+	const point& size() const
+		{ return _size; }
+
+	/** Test whether sprite matches the current screen mode.
+	 * If it does not then its content cannot be drawn to the screen
+	 * without colour translation, and it should be discarded.
+	 * @return true if the sprite matches the current screen mode,
+	 *  otherwise false
+	 */
+	bool compatible() const;
+
+	/** Set graphics window.
+	 * Output to the sprite is restricted to the given box until this
+	 * function is next called.
+	 * @param clip the bounding box of the region to which output is
+	 *  to be restricted, with respect to the origin of this context
+	 */
+	void clip(const box& clip);
+
+	/** Get sprite area.
+	 * @return a pointer to the sprite area
+	 */
+	os::sprite_area* area() const;
+
+	/** Get sprite.
+	 * @return a pointer to the sprite
+	 */
+	os::sprite* sprite() const;
+
+	/** Get memory needed by sprite.
+	 * @param size the size of the sprite, in OS units
+	 * @return the number of bytes needed to hold a sprite of that size
+	 *  in the current screen mode
+	 */
+	static unsigned int memory(const point& size);
+protected:
+	virtual void activate();
+	virtual void deactivate();
+private:
+	/** Select graphics window from _clip. */
+	void select_clip();
+
+	/** Get sprite type word for current screen mode.
+	 * @return the sprite type word
+	 */
+	static int screen_mode();
+};
+
+} /* namespace graphics */
+} /* namespace rtk */
+
+#endif
@@ -4,6 +4,8 @@
 // a copy of which may be found in the file !RTK.Copyright.
 
 #include "rtk/graphics/font.h"
+#include "rtk/graphics/run_list.h"
+#include "rtk/graphics/sprite_gcontext.h"
 #include "rtk/graphics/vdu_gcontext.h"
 #include "rtk/os/os.h"
 #include "rtk/os/wimp.h"
@@ -22,6 +24,14 @@ vdu_gcontext::~vdu_gcontext()
 
 vdu_gcontext* vdu_gcontext::_current=0;
 
+vdu_gcontext::colour_state vdu_gcontext::_state={-1,-1,-1,-1,-1,-1};
+
+vdu_gcontext::colour_stats vdu_gcontext::_stats={0,0,0,0};
+
+unsigned int vdu_gcontext::_palette[20];
+
+bool vdu_gcontext::_palette_valid=false;
+
 vdu_gcontext* vdu_gcontext::current()
 {
 	return _current;
@@ -34,48 +44,161 @@ void vdu_gcontext::current(vdu_gcontext* current)
 		if (_current) _current->deactivate();
 		_current=current;
 		if (_current) _current->activate();
+		else
+		{
+			// The VDU drivers may be used by other agents while
+			// there is no current context.
+			forget_colours();
+			_palette_valid=false;
+		}
 	}
 }
 
+void vdu_gcontext::reset_colour_statistics()
+{
+	_stats.requests=0;
+	_stats.set_colour=0;
+	_stats.text_colour=0;
+	_stats.font_colours=0;
+}
+
+void vdu_gcontext::forget_colours()
+{
+	colour_state unknown={-1,-1,-1,-1,-1,-1};
+	_state=unknown;
+}
+
 void vdu_gcontext::plot(int code,const point& p)
 {
 	current(this);
+	sync_graphics();
 	os::OS_Plot(code,origin()+p);
 }
 
 void vdu_gcontext::draw(const char* s,const point& p)
 {
 	current(this);
+	// Depending on whether the desktop font is the system font or
+	// an outline font, any of the colours might be used.
+	sync_graphics();
+	sync_text();
+	sync_font();
 	os::Wimp_TextOp2(s,origin()+p);
 }
 
 void vdu_gcontext::draw(const font& f,const char* s,const point& p)
 {
+	current(this);
+	sync_font();
+	f.paint(s,origin()+p);
+}
+
+void vdu_gcontext::draw(const font& f,const run_list& runs,const point& p)
+{
+	// Build a single string in which each run is preceded by a
+	// Font_Paint colour change sequence: 19, background RGB,
+	// foreground RGB, maximum offset.
+	const string& text=runs.text();
+	string s;
+	s.reserve(text.length()+runs.size()*8);
+	for (unsigned int i=0;i!=runs.size();++i)
+	{
+		unsigned int bpal=palette(runs[i].bcolour);
+		unsigned int fpal=palette(runs[i].fcolour);
+		s+=char(19);
+		s+=char(bpal>>8);
+		s+=char(bpal>>16);
+		s+=char(bpal>>24);
+		s+=char(fpal>>8);
+		s+=char(fpal>>16);
+		s+=char(fpal>>24);
+		s+=char(14);
+		s.append(text,runs[i].index,runs.length(i));
+	}
+
 	current(this);
 	f.paint(s,origin()+p);
+
+	// The font colours are left as set by the last run, which is
+	// not necessarily the same as Wimp_SetFontColours would choose.
+	_state.ffcolour=-1;
+	_state.fbcolour=-1;
+}
+
+void vdu_gcontext::draw(const sprite_gcontext& sc,const point& p)
+{
+	current(this);
+	os::OS_SpriteOp34(sc.area(),sc.sprite(),origin()+p,0);
 }
 
 void vdu_gcontext::fcolour_notify(int fcolour)
 {
-	os::Wimp_SetColour(fcolour);
-	os::Wimp_TextColour(fcolour);
-	os::Wimp_SetFontColours(bcolour(),fcolour);
+	// The colour is selected when it is next needed.
+	++_stats.requests;
 }
 
 void vdu_gcontext::bcolour_notify(int bcolour)
 {
-	os::Wimp_SetColour(bcolour|0x80);
-	os::Wimp_TextColour(bcolour|0x80);
-	os::Wimp_SetFontColours(bcolour,fcolour());
+	// The colour is selected when it is next needed.
+	++_stats.requests;
 }
 
 void vdu_gcontext::activate()
 {
-	os::Wimp_SetColour(fcolour());
-	os::Wimp_SetColour(bcolour()|0x80);
-	os::Wimp_TextColour(fcolour());
-	os::Wimp_TextColour(bcolour()|0x80);
-	os::Wimp_SetFontColours(bcolour(),fcolour());
+	// The colours of this context are selected when next needed.
+}
+
+void vdu_gcontext::sync_graphics()
+{
+	if (_state.gfcolour!=fcolour())
+	{
+		os::Wimp_SetColour(fcolour());
+		_state.gfcolour=fcolour();
+		++_stats.set_colour;
+	}
+	if (_state.gbcolour!=bcolour())
+	{
+		os::Wimp_SetColour(bcolour()|0x80);
+		_state.gbcolour=bcolour();
+		++_stats.set_colour;
+	}
+}
+
+void vdu_gcontext::sync_text()
+{
+	if (_state.tfcolour!=fcolour())
+	{
+		os::Wimp_TextColour(fcolour());
+		_state.tfcolour=fcolour();
+		++_stats.text_colour;
+	}
+	if (_state.tbcolour!=bcolour())
+	{
+		os::Wimp_TextColour(bcolour()|0x80);
+		_state.tbcolour=bcolour();
+		++_stats.text_colour;
+	}
+}
+
+unsigned int vdu_gcontext::palette(int colour)
+{
+	if (!_palette_valid)
+	{
+		os::Wimp_ReadPalette(_palette);
+		_palette_valid=true;
+	}
+	return _palette[colour&0x0f];
+}
+
+void vdu_gcontext::sync_font()
+{
+	if ((_state.ffcolour!=fcolour())||(_state.fbcolour!=bcolour()))
+	{
+		os::Wimp_SetFontColours(bcolour(),fcolour());
+		_state.ffcolour=fcolour();
+		_state.fbcolour=bcolour();
+		++_stats.font_colours;
+	}
 }
 
 void vdu_gcontext::deactivate()
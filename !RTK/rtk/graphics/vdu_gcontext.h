@@ -11,19 +11,69 @@
 namespace rtk {
 namespace graphics {
 
+class sprite_gcontext;
+
 /** A class to represent a graphics context linked to the RISC OS VDU drivers.
  * For efficiency, this class assumes that it has exclusive control over
  * the RISC OS VDU drivers unless told otherwise.  If there is a posiblility
  * that the driver state has been changed by another agent (for example,
  * after a call to Wimp_Poll), then vdu_context::current() must be called
  * to ensure that the required state is re-established.
+ *
+ * The colours selected by the VDU drivers are tracked, and are set only
+ * when needed by a plot or draw operation, and only if they differ from
+ * those already selected.
  */
 class vdu_gcontext:
 	public gcontext
 {
+public:
+	/** A structure for counting colour-setting SWIs. */
+	struct colour_stats
+	{
+		/** The number of colour changes requested by any context. */
+		unsigned int requests;
+		/** The number of calls to Wimp_SetColour. */
+		unsigned int set_colour;
+		/** The number of calls to Wimp_TextColour. */
+		unsigned int text_colour;
+		/** The number of calls to Wimp_SetFontColours. */
+		unsigned int font_colours;
+	};
 private:
+	/** A structure to represent the colours selected by the VDU drivers.
+	 * Each field is -1 if the corresponding colour is unknown.
+	 */
+	struct colour_state
+	{
+		/** The graphics foreground colour. */
+		int gfcolour;
+		/** The graphics background colour. */
+		int gbcolour;
+		/** The text foreground colour. */
+		int tfcolour;
+		/** The text background colour. */
+		int tbcolour;
+		/** The font foreground colour. */
+		int ffcolour;
+		/** The font background colour. */
+		int fbcolour;
+	};
+
 	/** The current VDU graphics context. */
 	static vdu_gcontext* _current;
+
+	/** The colours currently selected by the VDU drivers. */
+	static colour_state _state;
+
+	/** The colour-setting SWI statistics. */
+	static colour_stats _stats;
+
+	/** The Wimp palette, as read by Wimp_ReadPalette. */
+	static unsigned int _palette[20];
+
+	/** True if _palette is valid, otherwise false. */
+	static bool _palette_valid;
 public:
 	/** Get current VDU graphics context.
 	 * @return the current context
@@ -33,10 +83,21 @@ public:
 	/** Set current VDU graphics context.
 	 * If the current context is unchanged then no action is taken.
 	 * If it is changed then any assumed state (currently the foreground
-	 * and background colours) is re-established.
+	 * and background colours) is re-established before it is next used.
+	 * Setting the current context to 0 causes the colours selected by
+	 * the VDU drivers to be treated as unknown.
 	 * @param current the required current context
 	 */
 	static void current(vdu_gcontext* current);
+
+	/** Get colour-setting SWI statistics.
+	 * @return the statistics
+	 */
+	static const colour_stats& colour_statistics()
+		{ return _stats; }
+
+	/** Reset colour-setting SWI statistics. */
+	static void reset_colour_statistics();
 public:
 	/** Construct VDU graphics context.
 	 * @param origin the initial origin
@@ -52,6 +113,15 @@ public:
 	virtual void plot(int code,const point& p);
 	virtual void draw(const char* s,const point& p);
 	virtual void draw(const font& f,const char* s,const point& p);
+	virtual void draw(const font& f,const run_list& runs,const point& p);
+
+	/** Draw content of sprite graphics context.
+	 * The sprite is plotted without colour translation, so it should
+	 * have been created for the current screen mode.
+	 * @param sc the sprite graphics context to be drawn
+	 * @param p the point at which to place its bottom left-hand corner
+	 */
+	void draw(const sprite_gcontext& sc,const point& p);
 
 protected:
 	virtual void fcolour_notify(int fcolour);
@@ -70,6 +140,31 @@ protected:
 	 * graphics context.
 	 */
 	virtual void deactivate();
+
+	/** Forget colours selected by VDU drivers.
+	 * This function should be called by any subclass which redirects
+	 * VDU output, both when output is redirected and when it is
+	 * restored, because the selected colours are not shared between
+	 * output destinations.
+	 */
+	static void forget_colours();
+private:
+	/** Select graphics colours, if they are not already selected. */
+	void sync_graphics();
+
+	/** Select text colours, if they are not already selected. */
+	void sync_text();
+
+	/** Select font colours, if they are not already selected. */
+	void sync_font();
+
+	/** Get palette entry for standard Wimp colour.
+	 * The palette is read when first needed, then cached until the
+	 * current context is set to 0.
+	 * @param colour the standard Wimp colour
+	 * @return the palette entry, of the form 0xBBGGRRxx
+	 */
+	static unsigned int palette(int colour);
 };
 
 } /* namespace graphics */
@@ -0,0 +1,228 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#include <cstring>
+#include <strings.h>
+
+#include "rtk/swi/os.h"
+#include "rtk/host/system.h"
+#include "rtk/host/display.h"
+
+namespace rtk {
+namespace host {
+
+namespace {
+
+/** The size of a sprite area header, in bytes. */
+const int area_header_size=16;
+
+/** The size of a sprite header without a palette, in bytes. */
+const int sprite_header_size=44;
+
+/** The size of the sprites in the Wimp sprite area, in pixels. */
+const int wimp_sprite_size=17;
+
+/** Find sprite in sprite area.
+ * @param area the sprite area
+ * @param name the sprite name
+ * @return a pointer to the sprite, or 0 if not found
+ */
+int* find_sprite(int* area,const char* name)
+{
+	char* base=reinterpret_cast<char*>(area);
+	int offset=area[2];
+	for (int i=0;i!=area[1];++i)
+	{
+		int* sp=reinterpret_cast<int*>(base+offset);
+		if (!strncasecmp(reinterpret_cast<char*>(sp+1),name,12)) return sp;
+		offset+=sp[0];
+	}
+	return 0;
+}
+
+} /* anonymous namespace */
+
+display::display():
+	_xpixels(1920),
+	_ypixels(1080),
+	_xeigfactor(1),
+	_yeigfactor(1),
+	_log2bpp(5)
+{
+	_output[0]=0x3c;
+	_output[1]=0;
+	_output[2]=0;
+	_output[3]=0;
+	reset_counts();
+}
+
+display& display::mode(int xpixels,int ypixels,int xeigfactor,
+	int yeigfactor,int log2bpp)
+{
+	_xpixels=xpixels;
+	_ypixels=ypixels;
+	_xeigfactor=xeigfactor;
+	_yeigfactor=yeigfactor;
+	_log2bpp=log2bpp;
+	return *this;
+}
+
+void display::reset_counts()
+{
+	_plots=0;
+	_sprite_plots=0;
+	_vdu_bytes=0;
+	_switches=0;
+}
+
+_kernel_oserror* display::swi(int number,_kernel_swi_regs& regs)
+{
+	switch (number)
+	{
+	case swi::OS_Byte:
+		// Only OS_Byte 161 (read CMOS RAM) is supported.  All locations
+		// read as zero.
+		if (regs.r[0]!=161) return error(0x1e6,"OS_Byte not supported");
+		regs.r[2]=0;
+		break;
+	case swi::OS_Plot:
+		++_plots;
+		break;
+	case swi::OS_WriteN:
+		_vdu_bytes+=regs.r[1];
+		break;
+	case swi::OS_ReadModeVariable:
+		switch (regs.r[1])
+		{
+		case swi::XEigFactor:
+			regs.r[2]=_xeigfactor;
+			break;
+		case swi::YEigFactor:
+			regs.r[2]=_yeigfactor;
+			break;
+		case swi::Log2BPP:
+		case swi::Log2BPC:
+			regs.r[2]=_log2bpp;
+			break;
+		case swi::XWindLimit:
+			regs.r[2]=_xpixels-1;
+			break;
+		case swi::YWindLimit:
+			regs.r[2]=_ypixels-1;
+			break;
+		default:
+			regs.r[2]=0;
+			break;
+		}
+		break;
+	case swi::OS_SpriteOp:
+		return sprite_op(regs);
+	}
+	return 0;
+}
+
+_kernel_oserror* display::sprite_op(_kernel_swi_regs& regs)
+{
+	// Bits 8-9 of R0 indicate whether the sprite is in the system
+	// area (or for Wimp_SpriteOp, the Wimp area), is in a user area
+	// and specified by name, or is specified by pointer.
+	int reason=regs.r[0]&0xff;
+	int* area=pointer<int>(regs.r[1]);
+	int* sp=0;
+	if ((regs.r[0]&0x300)==0x200) sp=pointer<int>(regs.r[2]);
+	else if (((regs.r[0]&0x300)==0x100)&&(reason!=9)&&(reason!=15))
+	{
+		sp=find_sprite(area,pointer<const char>(regs.r[2]));
+		if (!sp) return error(0x86,"Sprite doesn't exist");
+	}
+
+	switch (reason)
+	{
+	case 9:
+		// Initialise sprite area.
+		area[1]=0;
+		area[2]=area_header_size;
+		area[3]=area_header_size;
+		break;
+	case 15:
+		{
+			// Create sprite (without a palette).  The mode is given
+			// as a sprite type word, from which the number of bits
+			// per pixel can be found.
+			int xpix=regs.r[4];
+			int ypix=regs.r[5];
+			int type=static_cast<unsigned int>(regs.r[6])>>27;
+			int log2bpp=(type)?type-1:_log2bpp;
+			int row=(((xpix<<log2bpp)+31)>>5)<<2;
+			int size=sprite_header_size+row*ypix;
+			if (area[3]+size>area[0])
+				return error(0x82,"No room to get sprite");
+			char* base=reinterpret_cast<char*>(area);
+			sp=reinterpret_cast<int*>(base+area[3]);
+			std::memset(sp,0,sprite_header_size);
+			sp[0]=size;
+			std::strncpy(reinterpret_cast<char*>(sp+1),
+				pointer<const char>(regs.r[2]),12);
+			sp[4]=(row>>2)-1;
+			sp[5]=ypix-1;
+			sp[6]=0;
+			sp[7]=((xpix<<log2bpp)-1)&31;
+			sp[8]=sprite_header_size;
+			sp[9]=sprite_header_size;
+			sp[10]=regs.r[6];
+			area[1]+=1;
+			area[3]+=size;
+		}
+		break;
+	case 28:
+	case 34:
+	case 52:
+		// Put sprite.
+		++_sprite_plots;
+		break;
+	case 40:
+		// Read sprite information.
+		if (sp)
+		{
+			int type=static_cast<unsigned int>(sp[10])>>27;
+			int log2bpp=(type)?type-1:_log2bpp;
+			int bits=(sp[4]+1)*32-sp[6]-(31-sp[7]);
+			regs.r[3]=bits>>log2bpp;
+			regs.r[4]=sp[5]+1;
+			regs.r[5]=sp[9]!=sp[8];
+			regs.r[6]=sp[10];
+		}
+		else
+		{
+			// Sprites in the system or Wimp area are assumed to
+			// be of a fixed size, and to exist.
+			regs.r[3]=wimp_sprite_size;
+			regs.r[4]=wimp_sprite_size;
+			regs.r[5]=0;
+			regs.r[6]=((_log2bpp+1)<<27)|((180>>_yeigfactor)<<14)|
+				((180>>_xeigfactor)<<1)|1;
+		}
+		break;
+	case 60:
+		{
+			// Switch output to sprite (or back to the screen, if
+			// R2 is zero).  The previous destination is returned
+			// in R0-R3, in a form suitable for restoring it.
+			int previous[4];
+			for (unsigned int i=0;i!=4;++i) previous[i]=_output[i];
+			_output[0]=(regs.r[2])?0x23c:0x3c;
+			_output[1]=regs.r[1];
+			_output[2]=regs.r[2];
+			_output[3]=regs.r[3];
+			if (regs.r[2]) ++_switches;
+			for (unsigned int i=0;i!=4;++i) regs.r[i]=previous[i];
+		}
+		break;
+	}
+	return 0;
+}
+
+} /* namespace host */
+} /* namespace rtk */
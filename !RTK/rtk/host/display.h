@@ -0,0 +1,127 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#ifndef _RTK_HOST_DISPLAY
+#define _RTK_HOST_DISPLAY
+
+#include "kernel.h"
+
+namespace rtk {
+namespace host {
+
+/** A class to represent the screen of a simulated RISC OS machine.
+ * This provides the mode variables, and handles the graphics calls
+ * made by the toolkit (OS_Plot, OS_WriteN and OS_SpriteOp).  Nothing
+ * is actually drawn, but each operation is counted.  Sprites are
+ * created and sized within sprite areas as they would be by RISC OS,
+ * so that output can be redirected to them.
+ */
+class display
+{
+private:
+	/** The width of the screen in pixels. */
+	int _xpixels;
+
+	/** The height of the screen in pixels. */
+	int _ypixels;
+
+	/** The horizontal eigen factor. */
+	int _xeigfactor;
+
+	/** The vertical eigen factor. */
+	int _yeigfactor;
+
+	/** The log2 of the number of bits per pixel. */
+	int _log2bpp;
+
+	/** The current output destination (as R0-R3 for OS_SpriteOp 60). */
+	int _output[4];
+
+	/** The number of calls to OS_Plot. */
+	unsigned int _plots;
+
+	/** The number of sprites plotted. */
+	unsigned int _sprite_plots;
+
+	/** The number of VDU bytes written. */
+	unsigned int _vdu_bytes;
+
+	/** The number of times output has been switched to a sprite. */
+	unsigned int _switches;
+public:
+	/** Construct screen.
+	 * The initial mode is 1920 by 1080 pixels with 32 bits per pixel,
+	 * and eigen factors of 1.
+	 */
+	display();
+
+	/** Set screen mode.
+	 * An application would expect to be sent a Message_ModeChange
+	 * after this has happened: it is the responsibility of the
+	 * script to do so.
+	 * @param xpixels the width of the screen in pixels
+	 * @param ypixels the height of the screen in pixels
+	 * @param xeigfactor the horizontal eigen factor
+	 * @param yeigfactor the vertical eigen factor
+	 * @param log2bpp the log2 of the number of bits per pixel
+	 * @return a reference to this
+	 */
+	display& mode(int xpixels,int ypixels,int xeigfactor,int yeigfactor,
+		int log2bpp);
+
+	/** Get horizontal eigen factor.
+	 * @return the horizontal eigen factor
+	 */
+	int xeigfactor() const
+		{ return _xeigfactor; }
+
+	/** Get vertical eigen factor.
+	 * @return the vertical eigen factor
+	 */
+	int yeigfactor() const
+		{ return _yeigfactor; }
+
+	/** Get number of calls to OS_Plot.
+	 * @return the number of calls
+	 */
+	unsigned int plots() const
+		{ return _plots; }
+
+	/** Get number of sprites plotted.
+	 * @return the number of sprites
+	 */
+	unsigned int sprite_plots() const
+		{ return _sprite_plots; }
+
+	/** Get number of VDU bytes written.
+	 * @return the number of bytes
+	 */
+	unsigned int vdu_bytes() const
+		{ return _vdu_bytes; }
+
+	/** Get number of times output has been switched to a sprite.
+	 * @return the number of switches
+	 */
+	unsigned int switches() const
+		{ return _switches; }
+
+	/** Reset counters. */
+	void reset_counts();
+
+	/** Handle software interrupt.
+	 * @param number the software interrupt number (without the X bit)
+	 * @param regs the register state (for input and output)
+	 * @return a pointer to an error block, or 0 if no error occurred
+	 */
+	_kernel_oserror* swi(int number,_kernel_swi_regs& regs);
+private:
+	/** Handle OS_SpriteOp. */
+	_kernel_oserror* sprite_op(_kernel_swi_regs& regs);
+};
+
+} /* namespace host */
+} /* namespace rtk */
+
+#endif
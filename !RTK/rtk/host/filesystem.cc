@@ -0,0 +1,387 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+
+#include "rtk/swi/os.h"
+#include "rtk/host/system.h"
+#include "rtk/host/filesystem.h"
+
+namespace rtk {
+namespace host {
+
+namespace {
+
+/** The object type of a file, as returned by OS_File. */
+const int objtype_file=1;
+
+/** The object type of a directory, as returned by OS_File. */
+const int objtype_dir=2;
+
+/** The default attributes of a newly created file. */
+const unsigned int default_attr=0x33;
+
+/** Make load address for filetype.
+ * @param filetype the filetype
+ * @return the corresponding load address (with a zero date)
+ */
+inline unsigned int typed_loadaddr(unsigned int filetype)
+{
+	return 0xfff00000|((filetype&0xfff)<<8);
+}
+
+} /* anonymous namespace */
+
+bool filesystem::name_less::operator()(const string& lhs,
+	const string& rhs) const
+{
+	// Filenames are compared without regard to case.
+	string::size_type n=std::min(lhs.length(),rhs.length());
+	for (string::size_type i=0;i!=n;++i)
+	{
+		int lc=std::tolower(static_cast<unsigned char>(lhs[i]));
+		int rc=std::tolower(static_cast<unsigned char>(rhs[i]));
+		if (lc!=rc) return lc<rc;
+	}
+	return lhs.length()<rhs.length();
+}
+
+filesystem::filesystem():
+	_next_handle(255),
+	_bytes_read(0),
+	_bytes_written(0)
+{}
+
+filesystem& filesystem::write(const string& name,const string& data,
+	unsigned int filetype)
+{
+	file& f=_files[name];
+	f.data=data;
+	f.loadaddr=typed_loadaddr(filetype);
+	f.execaddr=0;
+	f.attr=default_attr;
+	return *this;
+}
+
+string filesystem::read(const string& name) const
+{
+	std::map<string,file,name_less>::const_iterator f=_files.find(name);
+	return (f!=_files.end())?(*f).second.data:string();
+}
+
+bool filesystem::exists(const string& name) const
+{
+	return _files.find(name)!=_files.end();
+}
+
+int filesystem::filetype(const string& name) const
+{
+	std::map<string,file,name_less>::const_iterator f=_files.find(name);
+	if (f==_files.end()) return -1;
+	unsigned int loadaddr=(*f).second.loadaddr;
+	return ((loadaddr&0xfff00000)==0xfff00000)?(loadaddr>>8)&0xfff:-1;
+}
+
+filesystem& filesystem::remove(const string& name)
+{
+	_files.erase(name);
+	_dirs.erase(name);
+	return *this;
+}
+
+_kernel_oserror* filesystem::swi(int number,_kernel_swi_regs& regs)
+{
+	switch (number)
+	{
+	case swi::OS_File:
+		return os_file(regs);
+	case swi::OS_Find:
+		return os_find(regs);
+	case swi::OS_GBPB:
+		return os_gbpb(regs);
+	case swi::OS_Args:
+		return os_args(regs);
+	case swi::OS_FSControl:
+		return os_fscontrol(regs);
+	}
+	return 0;
+}
+
+bool filesystem::dir_exists(const string& name) const
+{
+	// A directory exists if it has been created explicitly, or if it
+	// contains a file.
+	if ((name=="$")||(_dirs.find(name)!=_dirs.end())) return true;
+	string prefix=name+".";
+	std::map<string,file,name_less>::const_iterator f=
+		_files.lower_bound(prefix);
+	if (f==_files.end()) return false;
+	const string& found=(*f).first;
+	return (found.length()>prefix.length())&&
+		!name_less()(found.substr(0,prefix.length()),prefix)&&
+		!name_less()(prefix,found.substr(0,prefix.length()));
+}
+
+void filesystem::read_info(const string& name,_kernel_swi_regs& regs) const
+{
+	std::map<string,file,name_less>::const_iterator f=_files.find(name);
+	if (f!=_files.end())
+	{
+		const file& fl=(*f).second;
+		regs.r[0]=objtype_file;
+		regs.r[2]=fl.loadaddr;
+		regs.r[3]=fl.execaddr;
+		regs.r[4]=fl.data.length();
+		regs.r[5]=fl.attr;
+	}
+	else if (dir_exists(name))
+	{
+		regs.r[0]=objtype_dir;
+		regs.r[2]=typed_loadaddr(0x1000);
+		regs.r[3]=0;
+		regs.r[4]=0;
+		regs.r[5]=default_attr;
+	}
+	else
+	{
+		regs.r[0]=0;
+	}
+}
+
+filesystem::channel* filesystem::find_channel(int handle)
+{
+	std::map<int,channel>::iterator f=_channels.find(handle);
+	return (f!=_channels.end())?&(*f).second:0;
+}
+
+_kernel_oserror* filesystem::os_file(_kernel_swi_regs& regs)
+{
+	string name(pointer<const char>(regs.r[1]));
+	std::map<string,file,name_less>::iterator f=_files.find(name);
+	switch (regs.r[0])
+	{
+	case 1:
+		// Write catalogue information.
+		if (f==_files.end())
+			return error(0xd6,"File '"+name+"' not found");
+		(*f).second.loadaddr=regs.r[2];
+		(*f).second.execaddr=regs.r[3];
+		(*f).second.attr=regs.r[5];
+		break;
+	case 4:
+		// Write attributes.
+		if (f==_files.end())
+			return error(0xd6,"File '"+name+"' not found");
+		(*f).second.attr=regs.r[5];
+		break;
+	case 6:
+		// Delete object.
+		read_info(name,regs);
+		if (f!=_files.end()) _files.erase(f);
+		else _dirs.erase(name);
+		break;
+	case 8:
+		// Create directory.
+		if (f!=_files.end())
+			return error(0xbd,"'"+name+"' is a file");
+		_dirs.insert(name);
+		break;
+	case 17:
+		// Read catalogue information.
+		read_info(name,regs);
+		break;
+	case 18:
+		// Set filetype.
+		if (f==_files.end())
+			return error(0xd6,"File '"+name+"' not found");
+		(*f).second.loadaddr=typed_loadaddr(regs.r[2]);
+		break;
+	default:
+		return error(0x1e6,"OS_File reason code not supported");
+	}
+	return 0;
+}
+
+_kernel_oserror* filesystem::os_find(_kernel_swi_regs& regs)
+{
+	int code=regs.r[0];
+	if (!(code&0xc0))
+	{
+		// Close file.
+		if (!regs.r[1])
+		{
+			_channels.clear();
+			return 0;
+		}
+		if (!_channels.erase(regs.r[1]))
+			return error(0xde,"Channel number not valid");
+		return 0;
+	}
+
+	// Open file.  Bit 3 of the reason code indicates that an error
+	// should be returned (rather than a zero handle) if the file
+	// does not exist.
+	string name(pointer<const char>(regs.r[1]));
+	std::map<string,file,name_less>::iterator f=_files.find(name);
+	if ((code&0xc0)==0x80)
+	{
+		if (dir_exists(name))
+			return error(0xa8,"'"+name+"' is a directory");
+		write(name,string());
+	}
+	else if (f==_files.end())
+	{
+		if (dir_exists(name)&&(code&0x04))
+			return error(0xa8,"'"+name+"' is a directory");
+		if (code&0x08)
+			return error(0xd6,"File '"+name+"' not found");
+		regs.r[0]=0;
+		return 0;
+	}
+
+	// Handles are allocated downwards from 255, skipping any which
+	// are in use.
+	while (_channels.find(_next_handle)!=_channels.end())
+		if (!--_next_handle) _next_handle=255;
+	int handle=_next_handle;
+	if (!--_next_handle) _next_handle=255;
+
+	channel& ch=_channels[handle];
+	ch.name=name;
+	ch.ptr=0;
+	regs.r[0]=handle;
+	return 0;
+}
+
+_kernel_oserror* filesystem::os_gbpb(_kernel_swi_regs& regs)
+{
+	channel* ch=find_channel(regs.r[1]);
+	if (!ch) return error(0xde,"Channel number not valid");
+	string& data=_files[ch->name].data;
+	size_type count=static_cast<unsigned int>(regs.r[3]);
+	switch (regs.r[0])
+	{
+	case 2:
+		// Write bytes to current file pointer.
+		{
+			const char* buffer=pointer<const char>(regs.r[2]);
+			if (data.length()<ch->ptr) data.resize(ch->ptr);
+			data.replace(ch->ptr,std::min(count,data.length()-ch->ptr),
+				buffer,count);
+			ch->ptr+=count;
+			_bytes_written+=count;
+			regs.r[2]+=count;
+			regs.r[3]=0;
+			regs.r[4]=ch->ptr;
+		}
+		break;
+	case 4:
+		// Read bytes from current file pointer.
+		{
+			char* buffer=pointer<char>(regs.r[2]);
+			size_type available=(ch->ptr<data.length())?
+				data.length()-ch->ptr:0;
+			size_type n=std::min(count,available);
+			std::memcpy(buffer,data.data()+ch->ptr,n);
+			ch->ptr+=n;
+			_bytes_read+=n;
+			regs.r[2]+=n;
+			regs.r[3]=count-n;
+			regs.r[4]=ch->ptr;
+		}
+		break;
+	default:
+		return error(0x1e6,"OS_GBPB reason code not supported");
+	}
+	return 0;
+}
+
+_kernel_oserror* filesystem::os_args(_kernel_swi_regs& regs)
+{
+	channel* ch=find_channel(regs.r[1]);
+	if (!ch) return error(0xde,"Channel number not valid");
+	string& data=_files[ch->name].data;
+	switch (regs.r[0])
+	{
+	case 0:
+		// Read file pointer.
+		regs.r[2]=ch->ptr;
+		break;
+	case 1:
+		// Write file pointer (extending the file if necessary).
+		ch->ptr=static_cast<unsigned int>(regs.r[2]);
+		if (data.length()<ch->ptr) data.resize(ch->ptr);
+		break;
+	case 2:
+		// Read extent.
+		regs.r[2]=data.length();
+		break;
+	case 3:
+		// Write extent.
+		data.resize(static_cast<unsigned int>(regs.r[2]));
+		if (ch->ptr>data.length()) ch->ptr=data.length();
+		break;
+	case 5:
+		// Read end-of-file status.
+		regs.r[2]=(ch->ptr>=data.length())?-1:0;
+		break;
+	default:
+		return error(0x1e6,"OS_Args reason code not supported");
+	}
+	return 0;
+}
+
+_kernel_oserror* filesystem::os_fscontrol(_kernel_swi_regs& regs)
+{
+	switch (regs.r[0])
+	{
+	case 25:
+		// Rename object.
+		{
+			string src(pointer<const char>(regs.r[1]));
+			string dst(pointer<const char>(regs.r[2]));
+			std::map<string,file,name_less>::iterator f=_files.find(src);
+			if (f==_files.end())
+				return error(0xd6,"File '"+src+"' not found");
+			file fl=(*f).second;
+			_files.erase(f);
+			_files[dst]=fl;
+		}
+		break;
+	case 26:
+		// Copy object.
+		{
+			string src(pointer<const char>(regs.r[1]));
+			string dst(pointer<const char>(regs.r[2]));
+			std::map<string,file,name_less>::iterator f=_files.find(src);
+			if (f==_files.end())
+				return error(0xd6,"File '"+src+"' not found");
+			file fl=(*f).second;
+			_files[dst]=fl;
+		}
+		break;
+	case 37:
+		// Canonicalise pathname.  There are no path variables or
+		// filing system prefixes, so names are already canonical.
+		{
+			const char* pathname=pointer<const char>(regs.r[1]);
+			int length=std::strlen(pathname);
+			char* buffer=pointer<char>(regs.r[2]);
+			int size=regs.r[5];
+			if (buffer&&(size>length))
+				std::memcpy(buffer,pathname,length+1);
+			regs.r[5]=size-(length+1);
+		}
+		break;
+	default:
+		return error(0x1e6,"OS_FSControl reason code not supported");
+	}
+	return 0;
+}
+
+} /* namespace host */
+} /* namespace rtk */
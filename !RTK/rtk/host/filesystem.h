@@ -0,0 +1,182 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#ifndef _RTK_HOST_FILESYSTEM
+#define _RTK_HOST_FILESYSTEM
+
+#include <map>
+#include <set>
+#include <string>
+
+#include "kernel.h"
+
+namespace rtk {
+namespace host {
+
+using std::string;
+
+/** A class to represent a simulated filesystem held in memory.
+ * This handles OS_File, OS_Find, OS_GBPB, OS_Args and OS_FSControl,
+ * to the extent that they are used by the toolkit.  As with RISC OS,
+ * pathnames are not case-sensitive and use '.' as a separator.
+ * Directories exist if they have been created explicitly, or if they
+ * contain any objects.
+ */
+class filesystem
+{
+public:
+	/** A type for representing a file size. */
+	typedef string::size_type size_type;
+private:
+	/** A function object for comparing pathnames.
+	 * The comparison is not case-sensitive.
+	 */
+	struct name_less
+	{
+		bool operator()(const string& lhs,const string& rhs) const;
+	};
+
+	/** A structure to represent a file. */
+	struct file
+	{
+		/** The content of the file. */
+		string data;
+		/** The load address. */
+		unsigned int loadaddr;
+		/** The execution address. */
+		unsigned int execaddr;
+		/** The attributes. */
+		unsigned int attr;
+	};
+
+	/** A structure to represent an open file. */
+	struct channel
+	{
+		/** The pathname of the file. */
+		string name;
+		/** The sequential file pointer. */
+		size_type ptr;
+	};
+
+	/** The files, indexed by pathname. */
+	std::map<string,file,name_less> _files;
+
+	/** The directories which have been created explicitly. */
+	std::set<string,name_less> _dirs;
+
+	/** The open files, indexed by file handle. */
+	std::map<int,channel> _channels;
+
+	/** The handle to be given to the next file opened. */
+	int _next_handle;
+
+	/** The number of bytes read. */
+	unsigned long long _bytes_read;
+
+	/** The number of bytes written. */
+	unsigned long long _bytes_written;
+public:
+	/** Construct empty filesystem. */
+	filesystem();
+
+	/** Write file.
+	 * The file is created if it does not exist, and replaced if it does.
+	 * @param name the pathname
+	 * @param data the content of the file
+	 * @param filetype the filetype
+	 * @return a reference to this
+	 */
+	filesystem& write(const string& name,const string& data,
+		unsigned int filetype=0xfff);
+
+	/** Read file.
+	 * @param name the pathname
+	 * @return the content of the file, or the empty string if it does
+	 *  not exist
+	 */
+	string read(const string& name) const;
+
+	/** Test whether file exists.
+	 * @param name the pathname
+	 * @return true if the file exists, otherwise false
+	 */
+	bool exists(const string& name) const;
+
+	/** Get filetype.
+	 * @param name the pathname
+	 * @return the filetype, or -1 if the file does not exist or is
+	 *  not typed
+	 */
+	int filetype(const string& name) const;
+
+	/** Remove file.
+	 * @param name the pathname
+	 * @return a reference to this
+	 */
+	filesystem& remove(const string& name);
+
+	/** Get number of open files.
+	 * @return the number of open files
+	 */
+	unsigned int open_count() const
+		{ return _channels.size(); }
+
+	/** Get number of bytes read.
+	 * @return the number of bytes read using OS_GBPB
+	 */
+	unsigned long long bytes_read() const
+		{ return _bytes_read; }
+
+	/** Get number of bytes written.
+	 * @return the number of bytes written using OS_GBPB
+	 */
+	unsigned long long bytes_written() const
+		{ return _bytes_written; }
+
+	/** Handle software interrupt.
+	 * @param number the software interrupt number (without the X bit)
+	 * @param regs the register state (for input and output)
+	 * @return a pointer to an error block, or 0 if no error occurred
+	 */
+	_kernel_oserror* swi(int number,_kernel_swi_regs& regs);
+private:
+	/** Test whether directory exists.
+	 * @param name the pathname
+	 * @return true if the directory exists, otherwise false
+	 */
+	bool dir_exists(const string& name) const;
+
+	/** Read catalogue information.
+	 * @param name the pathname
+	 * @param regs the registers to fill in (R0 and R2-R5)
+	 */
+	void read_info(const string& name,_kernel_swi_regs& regs) const;
+
+	/** Find open file.
+	 * @param handle the file handle
+	 * @return a pointer to the open file, or 0 if not found
+	 */
+	channel* find_channel(int handle);
+
+	/** Handle OS_File. */
+	_kernel_oserror* os_file(_kernel_swi_regs& regs);
+
+	/** Handle OS_Find. */
+	_kernel_oserror* os_find(_kernel_swi_regs& regs);
+
+	/** Handle OS_GBPB. */
+	_kernel_oserror* os_gbpb(_kernel_swi_regs& regs);
+
+	/** Handle OS_Args. */
+	_kernel_oserror* os_args(_kernel_swi_regs& regs);
+
+	/** Handle OS_FSControl. */
+	_kernel_oserror* os_fscontrol(_kernel_swi_regs& regs);
+};
+
+} /* namespace host */
+} /* namespace rtk */
+
+#endif
@@ -0,0 +1,276 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#include <climits>
+#include <cstring>
+#include <cstdio>
+#include <strings.h>
+
+#include "rtk/swi/font.h"
+#include "rtk/os/font.h"
+#include "rtk/host/system.h"
+#include "rtk/host/font_manager.h"
+
+namespace rtk {
+namespace host {
+
+namespace {
+
+/** The nominal size of the desktop and symbol fonts,
+ * in 1/16ths of a point. */
+const int desktop_font_size=12*16;
+
+/** The number of millipoints per OS unit. */
+const int millipoints_per_os=400;
+
+/** Divide, rounding towards minus infinity.
+ * @param a the dividend
+ * @param b the divisor (which must be positive)
+ * @return the quotient
+ */
+inline int div_floor(int a,int b)
+{
+	return (a>=0)?a/b:-((-a+b-1)/b);
+}
+
+/** Divide, rounding towards plus infinity.
+ * @param a the dividend
+ * @param b the divisor (which must be positive)
+ * @return the quotient
+ */
+inline int div_ceil(int a,int b)
+{
+	return -div_floor(-a,b);
+}
+
+/** Get length of control-terminated string.
+ * @param s the string
+ * @return the number of characters before the first control character
+ */
+int ctrl_length(const char* s)
+{
+	int n=0;
+	while (static_cast<unsigned char>(s[n])>=32) ++n;
+	return n;
+}
+
+} /* anonymous namespace */
+
+font_manager::font_manager():
+	_desktop_font(0),
+	_symbol_font(0)
+{
+	_desktop_font=find_font("Homerton.Medium",desktop_font_size,
+		desktop_font_size);
+	_symbol_font=find_font("Sidney",desktop_font_size,desktop_font_size);
+	reset_counts();
+}
+
+int font_manager::advance(int handle) const
+{
+	const font* f=find(handle);
+	return (f)?f->xsize*1000/32:0;
+}
+
+void font_manager::reset_counts()
+{
+	_paints=0;
+	_painted=0;
+	_scans=0;
+}
+
+const font_manager::font* font_manager::find(int handle) const
+{
+	std::map<int,font>::const_iterator f=_fonts.find(handle);
+	return (f!=_fonts.end())?&(*f).second:0;
+}
+
+int font_manager::find_font(const string& id,int xsize,int ysize)
+{
+	// Reuse an existing handle if the font has been found already.
+	for (std::map<int,font>::iterator i=_fonts.begin();
+		i!=_fonts.end();++i)
+	{
+		font& f=(*i).second;
+		if (!strcasecmp(f.id.c_str(),id.c_str())&&
+			(f.xsize==xsize)&&(f.ysize==ysize))
+		{
+			++f.usage;
+			return (*i).first;
+		}
+	}
+
+	// Otherwise allocate the lowest free handle (starting from 1).
+	int handle=1;
+	while (_fonts.find(handle)!=_fonts.end()) ++handle;
+	font& f=_fonts[handle];
+	f.id=id;
+	f.xsize=xsize;
+	f.ysize=ysize;
+	f.usage=1;
+	return handle;
+}
+
+_kernel_oserror* font_manager::swi(int number,_kernel_swi_regs& regs)
+{
+	if (number==swi::Font_FindFont)
+	{
+		const char* id=pointer<const char>(regs.r[1]);
+		regs.r[0]=find_font(string(id,id+ctrl_length(id)),
+			regs.r[2],regs.r[3]);
+		regs.r[4]=90;
+		regs.r[5]=90;
+		return 0;
+	}
+
+	std::map<int,font>::iterator f=_fonts.find(regs.r[0]);
+	if (f==_fonts.end()) return error(0x209,"Undefined font handle");
+	font& fn=(*f).second;
+
+	// Every character has the same bounding box, in millipoints.
+	int adv=fn.xsize*1000/32;
+	int ascent=fn.ysize*1000*3/64;
+	int descent=fn.ysize*1000/64;
+
+	switch (number)
+	{
+	case swi::Font_LoseFont:
+		if (!--fn.usage) _fonts.erase(f);
+		break;
+	case swi::Font_ReadDefn:
+		if (regs.r[3]==0x4c4c5546)
+		{
+			regs.r[2]=fn.id.length()+1;
+		}
+		else
+		{
+			if (char* buffer=pointer<char>(regs.r[1]))
+				std::strcpy(buffer,fn.id.c_str());
+			regs.r[2]=fn.xsize;
+			regs.r[3]=fn.ysize;
+			regs.r[4]=90;
+			regs.r[5]=90;
+			regs.r[6]=0;
+			regs.r[7]=fn.usage;
+		}
+		break;
+	case swi::Font_ReadInfo:
+		{
+			// The bounding box is returned in pixels.
+			display& screen=system::current().screen();
+			int xos=millipoints_per_os<<screen.xeigfactor();
+			int yos=millipoints_per_os<<screen.yeigfactor();
+			regs.r[1]=0;
+			regs.r[2]=div_floor(-descent,yos);
+			regs.r[3]=div_ceil(adv,xos);
+			regs.r[4]=div_ceil(ascent,yos);
+		}
+		break;
+	case swi::Font_CharBBox:
+		if (regs.r[2]&0x10)
+		{
+			// Bounding box in OS units.
+			regs.r[1]=0;
+			regs.r[2]=div_floor(-descent,millipoints_per_os);
+			regs.r[3]=div_ceil(adv,millipoints_per_os);
+			regs.r[4]=div_ceil(ascent,millipoints_per_os);
+		}
+		else
+		{
+			// Bounding box in millipoints.
+			regs.r[1]=0;
+			regs.r[2]=-descent;
+			regs.r[3]=adv;
+			regs.r[4]=ascent;
+		}
+		break;
+	case swi::Font_Paint:
+		{
+			const char* s=pointer<const char>(regs.r[1]);
+			++_paints;
+			_painted+=(regs.r[2]&0x80)?regs.r[7]:ctrl_length(s);
+		}
+		break;
+	case swi::Font_ScanString:
+		return scan_string(regs);
+	default:
+		{
+			char buffer[32];
+			std::sprintf(buffer,"SWI &%X not known",number);
+			return error(0x1e6,buffer);
+		}
+	}
+	return 0;
+}
+
+_kernel_oserror* font_manager::scan_string(_kernel_swi_regs& regs)
+{
+	++_scans;
+	int adv=advance(regs.r[0]);
+	const char* s=pointer<const char>(regs.r[1]);
+	int flags=regs.r[2];
+	int limit=regs.r[3];
+	int length=(flags&0x80)?regs.r[7]:INT_MAX;
+
+	// Read the coordinate block, if there is one.
+	point space_offset;
+	point letter_offset;
+	int split_char=-1;
+	if (flags&0x20)
+	{
+		const os::coord_block_scanstring& coord=
+			*pointer<const os::coord_block_scanstring>(regs.r[5]);
+		space_offset=coord.space_offset;
+		letter_offset=coord.letter_offset;
+		split_char=coord.split_char;
+	}
+
+	// Accumulate advance widths until the end of the string, or until
+	// the limit is exceeded.  If finding the caret position, stop at
+	// the character boundary nearest to the limit instead.
+	int x=0;
+	int i=0;
+	int split_index=0;
+	int split_x=0;
+	bool overflow=false;
+	while ((i<length)&&(static_cast<unsigned char>(s[i])>=32))
+	{
+		if (s[i]==split_char)
+		{
+			split_index=i;
+			split_x=x;
+		}
+		int a=adv+letter_offset.x();
+		if (s[i]==' ') a+=space_offset.x();
+		if (flags&0x20000)
+		{
+			if ((limit-x)*2<a) break;
+		}
+		else if (x+a>limit)
+		{
+			overflow=true;
+			break;
+		}
+		x+=a;
+		++i;
+	}
+
+	// If the limit was exceeded, and there is a split character,
+	// then split at the last occurrence of it.
+	if (overflow&&(split_char!=-1))
+	{
+		i=split_index;
+		x=split_x;
+	}
+
+	regs.r[1]=word(s+i);
+	regs.r[3]=x;
+	regs.r[4]=0;
+	regs.r[7]=i;
+	return 0;
+}
+
+} /* namespace host */
+} /* namespace rtk */
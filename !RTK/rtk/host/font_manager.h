@@ -0,0 +1,136 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#ifndef _RTK_HOST_FONT_MANAGER
+#define _RTK_HOST_FONT_MANAGER
+
+#include <map>
+#include <string>
+
+#include "kernel.h"
+
+namespace rtk {
+namespace host {
+
+using std::string;
+
+/** A class to represent a simulated font manager.
+ * Every character of every font has the same metrics, which depend
+ * only upon the size of the font:
+ * - the advance width is half of the nominal width;
+ * - the ascent is three quarters of the nominal height; and
+ * - the descent is one quarter of the nominal height.
+ *
+ * Text is measured exactly as it would be by the RISC OS font manager
+ * (for the operations used by the toolkit), but it is not painted.
+ * Calls to Font_Paint are counted.
+ */
+class font_manager
+{
+private:
+	/** A structure to represent a font. */
+	struct font
+	{
+		/** The font identifier. */
+		string id;
+		/** The nominal width, in 1/16ths of a point. */
+		int xsize;
+		/** The nominal height, in 1/16ths of a point. */
+		int ysize;
+		/** The usage count. */
+		int usage;
+	};
+
+	/** The fonts, indexed by handle. */
+	std::map<int,font> _fonts;
+
+	/** The handle of the desktop font. */
+	int _desktop_font;
+
+	/** The handle of the symbol font. */
+	int _symbol_font;
+
+	/** The number of calls to Font_Paint. */
+	unsigned int _paints;
+
+	/** The number of characters painted. */
+	unsigned int _painted;
+
+	/** The number of calls to Font_ScanString. */
+	unsigned int _scans;
+public:
+	/** Construct font manager.
+	 * The desktop and symbol fonts are 12 point.
+	 */
+	font_manager();
+
+	/** Get desktop font handle.
+	 * @return the handle of the desktop font
+	 */
+	int desktop_font() const
+		{ return _desktop_font; }
+
+	/** Get symbol font handle.
+	 * @return the handle of the symbol font
+	 */
+	int symbol_font() const
+		{ return _symbol_font; }
+
+	/** Get advance width.
+	 * @param handle the font handle
+	 * @return the advance width of each character, in millipoints
+	 */
+	int advance(int handle) const;
+
+	/** Get number of calls to Font_Paint.
+	 * @return the number of calls
+	 */
+	unsigned int paints() const
+		{ return _paints; }
+
+	/** Get number of characters painted.
+	 * @return the number of characters
+	 */
+	unsigned int painted() const
+		{ return _painted; }
+
+	/** Get number of calls to Font_ScanString.
+	 * @return the number of calls
+	 */
+	unsigned int scans() const
+		{ return _scans; }
+
+	/** Reset counters. */
+	void reset_counts();
+
+	/** Handle software interrupt.
+	 * @param number the software interrupt number (without the X bit)
+	 * @param regs the register state (for input and output)
+	 * @return a pointer to an error block, or 0 if no error occurred
+	 */
+	_kernel_oserror* swi(int number,_kernel_swi_regs& regs);
+private:
+	/** Find font.
+	 * @param handle the font handle
+	 * @return a pointer to the font, or 0 if not found
+	 */
+	const font* find(int handle) const;
+
+	/** Find or create font.
+	 * @param id the font identifier
+	 * @param xsize the nominal width, in 1/16ths of a point
+	 * @param ysize the nominal height, in 1/16ths of a point
+	 * @return the font handle
+	 */
+	int find_font(const string& id,int xsize,int ysize);
+
+	/** Handle Font_ScanString. */
+	_kernel_oserror* scan_string(_kernel_swi_regs& regs);
+};
+
+} /* namespace host */
+} /* namespace rtk */
+
+#endif
@@ -0,0 +1,37 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#ifndef __kernel_h
+#define __kernel_h
+
+/* A minimal replacement for the RISC OS C library header kernel.h,
+ * for use when the toolkit is built for a host machine.  Only those
+ * parts used by the toolkit are provided.  Software interrupts are
+ * expected to be handled by a hook (see rtk::os::swi_hook()): in the
+ * absence of one, _kernel_swi() returns an error. */
+
+typedef struct
+{
+	int r[10];
+} _kernel_swi_regs;
+
+typedef struct
+{
+	int errnum;
+	char errmess[252];
+} _kernel_oserror;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+_kernel_oserror* _kernel_swi(int no,_kernel_swi_regs* in,
+	_kernel_swi_regs* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,93 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#include <cstdlib>
+#include <malloc.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+
+#include "rtk/host/runtime.h"
+
+namespace rtk {
+namespace host {
+
+namespace {
+
+#ifdef MAP_32BIT
+
+/** The size of the stack on which the body is run, in bytes. */
+const size_t stack_size=64<<20;
+
+/** The preferred address of the stack. */
+void* const stack_hint=reinterpret_cast<void*>(0x80000000-stack_size);
+
+/** The body of the program. */
+body_type run_body=0;
+
+/** The number of command line arguments. */
+int run_argc=0;
+
+/** The command line arguments. */
+char** run_argv=0;
+
+/** The exit status returned by the body. */
+int run_status=0;
+
+/** Call the body of the program. */
+void call_body()
+{
+	run_status=run_body(run_argc,run_argv);
+}
+
+#endif
+
+} /* anonymous namespace */
+
+int run(body_type body,int argc,char** argv)
+{
+#ifdef MAP_32BIT
+	if (sizeof(void*)>4)
+	{
+		// Prevent large blocks from being allocated using mmap (which
+		// would place them above the low 4GB).
+		mallopt(M_MMAP_MAX,0);
+
+		// Allocate a stack at the top of the low 2GB (leaving as much
+		// room as possible for the heap to grow beneath it), and run
+		// the body on it.
+		void* stack=mmap(stack_hint,stack_size,PROT_READ|PROT_WRITE,
+			MAP_PRIVATE|MAP_ANONYMOUS,-1,0);
+		if ((stack!=MAP_FAILED)&&(stack!=stack_hint))
+		{
+			munmap(stack,stack_size);
+			stack=MAP_FAILED;
+		}
+		if (stack==MAP_FAILED)
+		{
+			stack=mmap(0,stack_size,PROT_READ|PROT_WRITE,
+				MAP_PRIVATE|MAP_ANONYMOUS|MAP_32BIT,-1,0);
+		}
+		if (stack==MAP_FAILED) return EXIT_FAILURE;
+
+		run_body=body;
+		run_argc=argc;
+		run_argv=argv;
+		ucontext_t caller;
+		ucontext_t callee;
+		getcontext(&callee);
+		callee.uc_stack.ss_sp=stack;
+		callee.uc_stack.ss_size=stack_size;
+		callee.uc_link=&caller;
+		makecontext(&callee,call_body,0);
+		swapcontext(&caller,&callee);
+		munmap(stack,stack_size);
+		return run_status;
+	}
+#endif
+	return body(argc,argv);
+}
+
+} /* namespace host */
+} /* namespace rtk */
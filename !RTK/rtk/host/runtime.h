@@ -0,0 +1,37 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#ifndef _RTK_HOST_RUNTIME
+#define _RTK_HOST_RUNTIME
+
+namespace rtk {
+namespace host {
+
+/** A type for representing the body of a host program.
+ * @param argc the number of command line arguments
+ * @param argv the command line arguments
+ * @return the exit status
+ */
+typedef int (*body_type)(int argc,char** argv);
+
+/** Run the body of a host program.
+ * The toolkit passes pointers to the operating system in 32-bit
+ * registers, so every object which it might pass must be addressable
+ * with 32 bits.  This is always the case for a 32-bit host (which
+ * should be used where possible).  For a 64-bit host, the program must
+ * be linked statically at a fixed address: the heap is then confined
+ * to the program break, and the body is run on a stack allocated in
+ * the low 2GB of the address space.
+ * @param body the body of the program
+ * @param argc the number of command line arguments
+ * @param argv the command line arguments
+ * @return the exit status returned by the body
+ */
+int run(body_type body,int argc,char** argv);
+
+} /* namespace host */
+} /* namespace rtk */
+
+#endif
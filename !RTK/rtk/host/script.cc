@@ -0,0 +1,309 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#include <cstring>
+
+#include "rtk/swi/wimp.h"
+#include "rtk/host/system.h"
+#include "rtk/host/script.h"
+
+namespace rtk {
+namespace host {
+
+namespace {
+
+/** The task handle given to the task being run. */
+const int own_task=0x10000;
+
+/** The task handle of the (notional) task from which scripted
+ * messages are sent. */
+const int other_task=0x20000;
+
+/** The Wimp version number returned by Wimp_Initialise. */
+const int wimp_version=380;
+
+/** The action code of Message_Quit. */
+const int message_quit=0;
+
+} /* anonymous namespace */
+
+script::script():
+	_at_end(0),
+	_at_end_handle(0),
+	_task(0),
+	_my_ref(0),
+	_polls(0),
+	_nulls(0)
+{}
+
+script& script::post(int wimpcode,const os::wimp_block& wimpblock)
+{
+	step s;
+	s.type=step_event;
+	s.wimpcode=wimpcode;
+	s.wimpblock=wimpblock;
+	s.function=0;
+	s.handle=0;
+	s.count=0;
+	_steps.push_back(s);
+	return *this;
+}
+
+script& script::message(int action,int wimpcode)
+{
+	os::wimp_block wimpblock;
+	std::memset(&wimpblock,0,sizeof(wimpblock));
+	wimpblock.word[0]=20;
+	wimpblock.word[1]=other_task;
+	wimpblock.word[4]=action;
+	return post(wimpcode,wimpblock);
+}
+
+script& script::mouse_click(int whandle,int ihandle,const point& p,
+	int buttons)
+{
+	os::wimp_block wimpblock;
+	std::memset(&wimpblock,0,sizeof(wimpblock));
+	wimpblock.word[0]=p.x();
+	wimpblock.word[1]=p.y();
+	wimpblock.word[2]=buttons;
+	wimpblock.word[3]=whandle;
+	wimpblock.word[4]=ihandle;
+	return post(6,wimpblock);
+}
+
+script& script::key_pressed(int code)
+{
+	// The remainder of the block is filled in from the caret position
+	// when the event is delivered.
+	os::wimp_block wimpblock;
+	std::memset(&wimpblock,0,sizeof(wimpblock));
+	wimpblock.word[6]=code;
+	return post(8,wimpblock);
+}
+
+script& script::call(function_type function,void* handle)
+{
+	step s;
+	s.type=step_call;
+	s.wimpcode=0;
+	s.function=function;
+	s.handle=handle;
+	s.count=0;
+	_steps.push_back(s);
+	return *this;
+}
+
+script& script::idle(unsigned int count)
+{
+	step s;
+	s.type=step_idle;
+	s.wimpcode=0;
+	s.function=0;
+	s.handle=0;
+	s.count=count;
+	_steps.push_back(s);
+	return *this;
+}
+
+script& script::at_end(function_type function,void* handle)
+{
+	_at_end=function;
+	_at_end_handle=handle;
+	return *this;
+}
+
+void script::clear_record()
+{
+	_sent.clear();
+	_errors.clear();
+	_tasks.clear();
+}
+
+_kernel_oserror* script::swi(int number,_kernel_swi_regs& regs)
+{
+	switch (number)
+	{
+	case swi::Wimp_Initialise:
+		_task=own_task;
+		_name=pointer<const char>(regs.r[2]);
+		regs.r[0]=wimp_version;
+		regs.r[1]=_task;
+		break;
+	case swi::Wimp_Poll:
+		regs.r[0]=poll(regs.r[0],*pointer<os::wimp_block>(regs.r[1]),0);
+		break;
+	case swi::Wimp_PollIdle:
+		{
+			unsigned int earliest=regs.r[2];
+			regs.r[0]=poll(regs.r[0],*pointer<os::wimp_block>(regs.r[1]),
+				&earliest);
+		}
+		break;
+	case swi::Wimp_SendMessage:
+		regs.r[2]=send(regs.r[0],*pointer<os::wimp_block>(regs.r[1]),
+			regs.r[2],regs.r[3]);
+		break;
+	case swi::Wimp_ReportError:
+		{
+			// The error is recorded, and the OK button is deemed
+			// to have been clicked.
+			const _kernel_oserror* err=
+				pointer<const _kernel_oserror>(regs.r[0]);
+			_errors.push_back(err->errmess);
+			regs.r[1]=1;
+		}
+		break;
+	case swi::Wimp_StartTask:
+		_tasks.push_back(pointer<const char>(regs.r[0]));
+		regs.r[0]=0;
+		break;
+	case swi::Wimp_ProcessKey:
+		// There are no other tasks to which the key could be passed.
+		break;
+	case swi::Wimp_TransferBlock:
+		std::memmove(pointer<char>(regs.r[3]),pointer<const char>(regs.r[1]),
+			regs.r[4]);
+		break;
+	}
+	return 0;
+}
+
+int script::poll(int mask,os::wimp_block& wimpblock,
+	const unsigned int* earliest)
+{
+	++_polls;
+	window_stack& windows=system::current().windows();
+	while (true)
+	{
+		// Messages which the task has sent to itself take priority.
+		if (!_queue.empty())
+		{
+			sent_message m=_queue.front();
+			_queue.pop_front();
+			wimpblock=m.wimpblock;
+			return m.wimpcode;
+		}
+
+		// Then redraw requests.
+		if (int handle=windows.next_redraw())
+		{
+			wimpblock.word[0]=handle;
+			return 1;
+		}
+
+		// When the script is exhausted, call the end-of-script
+		// function (once).  If that does not add any further steps
+		// then deliver Message_Quit.
+		if (_steps.empty())
+		{
+			if (function_type function=_at_end)
+			{
+				_at_end=0;
+				function(_at_end_handle);
+				continue;
+			}
+			std::memset(&wimpblock,0,20);
+			wimpblock.word[0]=20;
+			wimpblock.word[1]=other_task;
+			wimpblock.word[2]=++_my_ref;
+			wimpblock.word[4]=message_quit;
+			return 17;
+		}
+
+		// Otherwise perform the next step.
+		step& s=_steps.front();
+		switch (s.type)
+		{
+		case step_event:
+			{
+				int wimpcode=s.wimpcode;
+				wimpblock=s.wimpblock;
+				_steps.pop_front();
+				switch (wimpcode)
+				{
+				case 6:
+					// Mouse_Click: move the pointer.
+					windows.pointer(point(wimpblock.word[0],
+						wimpblock.word[1]),wimpblock.word[2]);
+					break;
+				case 8:
+					// Key_Pressed: direct the key to the caret.
+					std::memcpy(&wimpblock,&windows.caret(),
+						sizeof(os::caret_position_get));
+					break;
+				case 17:
+				case 18:
+					if (!wimpblock.word[2]) wimpblock.word[2]=++_my_ref;
+					break;
+				}
+				return wimpcode;
+			}
+		case step_call:
+			{
+				function_type function=s.function;
+				void* handle=s.handle;
+				_steps.pop_front();
+				function(handle);
+			}
+			break;
+		case step_idle:
+			if ((mask&1)||!s.count)
+			{
+				_steps.pop_front();
+				break;
+			}
+			--s.count;
+			if (earliest)
+			{
+				// Advance the clock as if the machine had been idle
+				// until the earliest return time.
+				system& sys=system::current();
+				int interval=*earliest-sys.monotonic_time();
+				if (interval>0) sys.advance_time(interval);
+			}
+			++_nulls;
+			return 0;
+		}
+	}
+}
+
+int script::send(int wimpcode,os::wimp_block& wimpblock,int thandle,
+	int ihandle)
+{
+	// Fill in the sender and reference number.
+	if ((wimpcode==17)||(wimpcode==18))
+	{
+		wimpblock.word[1]=_task;
+		wimpblock.word[2]=++_my_ref;
+	}
+
+	sent_message m;
+	m.wimpcode=wimpcode;
+	m.wimpblock=wimpblock;
+	m.thandle=thandle;
+	m.ihandle=ihandle;
+	_sent.push_back(m);
+
+	// Messages addressed to this task, to one of its windows, to the
+	// icon bar or to all tasks are queued for delivery to this task.
+	// Messages addressed to any other task are recorded, but are not
+	// otherwise acted upon.
+	window_stack& windows=system::current().windows();
+	if ((thandle==_task)||(thandle==-2)||windows.find(thandle))
+	{
+		_queue.push_back(m);
+		return _task;
+	}
+	if (!thandle)
+	{
+		_queue.push_back(m);
+		return 0;
+	}
+	return thandle;
+}
+
+} /* namespace host */
+} /* namespace rtk */
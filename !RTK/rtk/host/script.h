@@ -0,0 +1,268 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#ifndef _RTK_HOST_SCRIPT
+#define _RTK_HOST_SCRIPT
+
+#include <deque>
+#include <vector>
+#include <string>
+
+#include "kernel.h"
+
+#include "rtk/graphics/point.h"
+#include "rtk/os/wimp.h"
+
+namespace rtk {
+namespace host {
+
+using std::string;
+using rtk::graphics::point;
+
+/** A class to represent a script of Wimp events.
+ * The script is consumed by Wimp_Poll and Wimp_PollIdle, which allows
+ * application::run() to be driven without a desktop.  When polled,
+ * events are returned in the following order of priority:
+ * - messages which the task has sent to itself;
+ * - redraw requests for windows which have been invalidated;
+ * - the next step of the script.
+ *
+ * A step may be an event, a call to a function (which is made from
+ * within Wimp_Poll, and may inspect the state of the application or
+ * add further steps), or a period of idleness (during which null
+ * events are returned for as long as the application requests them).
+ *
+ * When the script is exhausted, the end-of-script function is called
+ * if there is one.  Otherwise, and if the function does not add any
+ * further steps, a Message_Quit is delivered.
+ *
+ * Other Wimp calls which concern the task as a whole are also handled
+ * here: messages sent by the task are recorded, as are errors reported
+ * and tasks started, so that the script can inspect and respond to them.
+ */
+class script
+{
+public:
+	/** A type for representing a function called by the script.
+	 * @param handle the handle passed when the step was added
+	 */
+	typedef void (*function_type)(void* handle);
+
+	/** A structure to represent a message sent by the task. */
+	struct sent_message
+	{
+		/** The Wimp event code. */
+		int wimpcode;
+		/** The message block. */
+		os::wimp_block wimpblock;
+		/** The destination task or window handle. */
+		int thandle;
+		/** The destination icon handle. */
+		int ihandle;
+	};
+private:
+	/** An enumeration for identifying the type of a step. */
+	enum step_type
+	{
+		/** A step which delivers an event. */
+		step_event,
+		/** A step which calls a function. */
+		step_call,
+		/** A step which delivers null events. */
+		step_idle
+	};
+
+	/** A structure to represent one step of the script. */
+	struct step
+	{
+		/** The type of step. */
+		step_type type;
+		/** The Wimp event code (for event steps). */
+		int wimpcode;
+		/** The Wimp event block (for event steps). */
+		os::wimp_block wimpblock;
+		/** The function (for call steps). */
+		function_type function;
+		/** The function handle (for call steps). */
+		void* handle;
+		/** The maximum number of null events (for idle steps). */
+		unsigned int count;
+	};
+
+	/** The steps remaining. */
+	std::deque<step> _steps;
+
+	/** The messages which the task has sent to itself. */
+	std::deque<sent_message> _queue;
+
+	/** The end-of-script function, or 0 if none. */
+	function_type _at_end;
+
+	/** The end-of-script function handle. */
+	void* _at_end_handle;
+
+	/** The messages sent by the task. */
+	std::vector<sent_message> _sent;
+
+	/** The errors reported by the task. */
+	std::vector<string> _errors;
+
+	/** The commands passed to Wimp_StartTask. */
+	std::vector<string> _tasks;
+
+	/** The task handle. */
+	int _task;
+
+	/** The task name. */
+	string _name;
+
+	/** The reference number given to the next message sent. */
+	int _my_ref;
+
+	/** The number of times the Wimp has been polled. */
+	unsigned int _polls;
+
+	/** The number of null events returned. */
+	unsigned int _nulls;
+public:
+	/** Construct empty script. */
+	script();
+
+	/** Add event step.
+	 * @param wimpcode the Wimp event code
+	 * @param wimpblock the Wimp event block
+	 * @return a reference to this
+	 */
+	script& post(int wimpcode,const os::wimp_block& wimpblock);
+
+	/** Add message step.
+	 * The message is given a size of 20 bytes, and appears to have
+	 * come from another task.
+	 * @param action the message action code
+	 * @param wimpcode the Wimp event code (17 or 18)
+	 * @return a reference to this
+	 */
+	script& message(int action,int wimpcode=17);
+
+	/** Add mouse click step.
+	 * @param whandle the window handle
+	 * @param ihandle the icon handle (-1 for the work area)
+	 * @param p the pointer position, with respect to the screen
+	 * @param buttons the mouse button state
+	 * @return a reference to this
+	 */
+	script& mouse_click(int whandle,int ihandle,const point& p,
+		int buttons=4);
+
+	/** Add key pressed step.
+	 * The event is delivered to the window and icon which have the
+	 * caret when it is delivered.
+	 * @param code the character or key code
+	 * @return a reference to this
+	 */
+	script& key_pressed(int code);
+
+	/** Add function call step.
+	 * @param function the function to call
+	 * @param handle a handle to be passed to the function
+	 * @return a reference to this
+	 */
+	script& call(function_type function,void* handle=0);
+
+	/** Add idle step.
+	 * Null events are returned for as long as the application requests
+	 * them (by leaving bit 0 of the poll mask clear), up to the given
+	 * limit.  For Wimp_PollIdle the monotonic clock is advanced to the
+	 * earliest return time, as if the machine had been idle until then.
+	 * @param count the maximum number of null events
+	 * @return a reference to this
+	 */
+	script& idle(unsigned int count=1000);
+
+	/** Set end-of-script function.
+	 * @param function the function to call, or 0 if none
+	 * @param handle a handle to be passed to the function
+	 * @return a reference to this
+	 */
+	script& at_end(function_type function,void* handle=0);
+
+	/** Test whether script is exhausted.
+	 * @return true if there are no steps remaining, otherwise false
+	 */
+	bool empty() const
+		{ return _steps.empty(); }
+
+	/** Get task handle.
+	 * @return the task handle returned by Wimp_Initialise
+	 */
+	int task() const
+		{ return _task; }
+
+	/** Get messages sent by the task.
+	 * @return the messages, in the order they were sent
+	 */
+	const std::vector<sent_message>& sent() const
+		{ return _sent; }
+
+	/** Get errors reported by the task.
+	 * @return the error messages, in the order they were reported
+	 */
+	const std::vector<string>& errors() const
+		{ return _errors; }
+
+	/** Get tasks started by the task.
+	 * @return the commands, in the order they were started
+	 */
+	const std::vector<string>& tasks() const
+		{ return _tasks; }
+
+	/** Clear record of messages, errors and tasks. */
+	void clear_record();
+
+	/** Get number of times the Wimp has been polled.
+	 * @return the number of polls
+	 */
+	unsigned int polls() const
+		{ return _polls; }
+
+	/** Get number of null events returned.
+	 * @return the number of null events
+	 */
+	unsigned int nulls() const
+		{ return _nulls; }
+
+	/** Handle software interrupt.
+	 * @param number the software interrupt number (without the X bit)
+	 * @param regs the register state (for input and output)
+	 * @return a pointer to an error block, or 0 if no error occurred
+	 */
+	_kernel_oserror* swi(int number,_kernel_swi_regs& regs);
+private:
+	/** Poll for next event.
+	 * @param mask the poll mask
+	 * @param wimpblock the event block to be filled in
+	 * @param earliest the earliest time at which to return a null
+	 *  event, or 0 if it may be returned immediately
+	 * @return the Wimp event code
+	 */
+	int poll(int mask,os::wimp_block& wimpblock,
+		const unsigned int* earliest);
+
+	/** Send message.
+	 * @param wimpcode the Wimp event code
+	 * @param wimpblock the message block (updated with the sender
+	 *  and reference number)
+	 * @param thandle the destination task or window handle
+	 * @param ihandle the destination icon handle
+	 * @return the destination task handle
+	 */
+	int send(int wimpcode,os::wimp_block& wimpblock,int thandle,
+		int ihandle);
+};
+
+} /* namespace host */
+} /* namespace rtk */
+
+#endif
@@ -0,0 +1,277 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#include <cstring>
+#include <cstdio>
+#include <sys/time.h>
+
+#include "rtk/swi/os.h"
+#include "rtk/swi/wimp.h"
+#include "rtk/swi/font.h"
+#include "rtk/swi/colourtrans.h"
+#include "rtk/swi/dragasprite.h"
+#include "rtk/swi/messagetrans.h"
+#include "rtk/swi/pdriver.h"
+#include "rtk/host/system.h"
+
+extern "C" _kernel_oserror* _kernel_swi(int no,_kernel_swi_regs* in,
+	_kernel_swi_regs* out)
+{
+	return rtk::host::error(0x1e6,"No operating system");
+}
+
+namespace rtk {
+namespace host {
+
+namespace {
+
+/** Read real monotonic clock.
+ * @return the time, in centiseconds
+ */
+unsigned int real_time()
+{
+	struct timeval tv;
+	gettimeofday(&tv,0);
+	return tv.tv_sec*100+tv.tv_usec/10000;
+}
+
+/** Substitute arguments into message.
+ * @param message the message, containing %0 to %3
+ * @param args the arguments (R4-R7), any of which may be 0
+ * @return the message with arguments substituted
+ */
+string substitute(const string& message,const int* args)
+{
+	string result;
+	for (string::size_type i=0;i!=message.length();++i)
+	{
+		char c=message[i];
+		if ((c=='%')&&(i+1!=message.length())&&
+			(message[i+1]>='0')&&(message[i+1]<='3'))
+		{
+			if (const char* arg=pointer<const char>(args[message[++i]-'0']))
+				result+=arg;
+		}
+		else result+=c;
+	}
+	return result;
+}
+
+} /* anonymous namespace */
+
+_kernel_oserror* error(int errnum,const string& message)
+{
+	static _kernel_oserror err;
+	err.errnum=errnum;
+	std::strncpy(err.errmess,message.c_str(),sizeof(err.errmess)-1);
+	err.errmess[sizeof(err.errmess)-1]=0;
+	return &err;
+}
+
+system* system::_current=0;
+
+system::system():
+	_old_hook(0),
+	_time_base(real_time()),
+	_time_offset(0),
+	_dragasprite(false)
+{
+	_current=this;
+	_old_hook=os::swi_hook(hook);
+}
+
+system::~system()
+{
+	os::swi_hook(_old_hook);
+	_current=0;
+}
+
+unsigned int system::monotonic_time() const
+{
+	return real_time()-_time_base+_time_offset;
+}
+
+void system::advance_time(unsigned int interval)
+{
+	_time_offset+=interval;
+}
+
+string system::var(const string& name) const
+{
+	std::map<string,string>::const_iterator f=_vars.find(name);
+	return (f!=_vars.end())?(*f).second:string();
+}
+
+_kernel_oserror* system::dispatch(int number,_kernel_swi_regs& regs)
+{
+	const int X=0x20000;
+	number&=~X;
+	switch (number)
+	{
+	case swi::OS_Byte:
+	case swi::OS_Plot:
+	case swi::OS_WriteN:
+	case swi::OS_ReadModeVariable:
+	case swi::OS_SpriteOp:
+		return _screen.swi(number,regs);
+	case swi::OS_File:
+	case swi::OS_Args:
+	case swi::OS_GBPB:
+	case swi::OS_Find:
+	case swi::OS_FSControl:
+		return _files.swi(number,regs);
+	case swi::OS_ReadMonotonicTime:
+		regs.r[0]=monotonic_time();
+		return 0;
+	case swi::OS_SetVarVal:
+		{
+			string name(pointer<const char>(regs.r[0]));
+			if (regs.r[2]<0) _vars.erase(name);
+			else
+			{
+				const char* value=pointer<const char>(regs.r[1]);
+				_vars[name]=string(value,value+regs.r[2]);
+			}
+		}
+		return 0;
+	case swi::Wimp_Initialise:
+	case swi::Wimp_Poll:
+	case swi::Wimp_PollIdle:
+	case swi::Wimp_SendMessage:
+	case swi::Wimp_ReportError:
+	case swi::Wimp_StartTask:
+	case swi::Wimp_ProcessKey:
+	case swi::Wimp_TransferBlock:
+		return _events.swi(number,regs);
+	case swi::ColourTrans_SetFontColours:
+		// The colours are returned unchanged, as if they could be
+		// reproduced exactly.
+		return 0;
+	case swi::DragASprite_Start:
+		_dragasprite=true;
+		return 0;
+	case swi::DragASprite_Stop:
+		_dragasprite=false;
+		return 0;
+	case swi::MessageTrans_FileInfo:
+	case swi::MessageTrans_OpenFile:
+	case swi::MessageTrans_Lookup:
+	case swi::MessageTrans_CloseFile:
+		return messagetrans_swi(number,regs);
+	default:
+		if ((number&~0x3f)==swi::Wimp_Initialise)
+			return _windows.swi(number,regs);
+		if ((number&~0x3f)==swi::Font_CacheAddr)
+			return _fonts.swi(number,regs);
+		if ((number&~0x3f)==swi::PDriver_Info)
+			return error(0x5c0,"No printer driver");
+		break;
+	}
+	char buffer[32];
+	std::sprintf(buffer,"SWI &%X not known",number);
+	return error(0x1e6,buffer);
+}
+
+_kernel_oserror* system::hook(int number,_kernel_swi_regs* regs)
+{
+	return _current->dispatch(number,*regs);
+}
+
+_kernel_oserror* system::messagetrans_swi(int number,_kernel_swi_regs& regs)
+{
+	switch (number)
+	{
+	case swi::MessageTrans_FileInfo:
+		{
+			string pathname(pointer<const char>(regs.r[1]));
+			if (!_files.exists(pathname))
+				return error(0xd6,"File '"+pathname+"' not found");
+			regs.r[0]=0;
+			regs.r[2]=_files.read(pathname).length()+1;
+		}
+		break;
+	case swi::MessageTrans_OpenFile:
+		{
+			// Parse the file into tokens.  Each line has the form
+			// token:value.  Lines beginning with '#' are comments.
+			string pathname(pointer<const char>(regs.r[1]));
+			if (!_files.exists(pathname))
+				return error(0xd6,"File '"+pathname+"' not found");
+			string data=_files.read(pathname);
+			message_table& table=
+				_message_files[pointer<const int>(regs.r[0])];
+			table.clear();
+			string::size_type i=0;
+			while (i<data.length())
+			{
+				string::size_type j=data.find('\n',i);
+				if (j==string::npos) j=data.length();
+				string line=data.substr(i,j-i);
+				string::size_type k=line.find(':');
+				if (line.length()&&(line[0]!='#')&&(k!=string::npos))
+					table[line.substr(0,k)]=line.substr(k+1);
+				i=j+1;
+			}
+			// Copy the file into the buffer, if one was given.
+			if (char* buffer=pointer<char>(regs.r[2]))
+			{
+				std::memcpy(buffer,data.c_str(),data.length()+1);
+			}
+		}
+		break;
+	case swi::MessageTrans_Lookup:
+		{
+			std::map<const int*,message_table>::iterator f=
+				_message_files.find(pointer<const int>(regs.r[0]));
+			if (f==_message_files.end())
+				return error(0xac0,"Message file not open");
+			message_table& table=(*f).second;
+
+			// A token may be followed by a default value.
+			string token(pointer<const char>(regs.r[1]));
+			string value;
+			string::size_type k=token.find(':');
+			if (k!=string::npos)
+			{
+				value=token.substr(k+1);
+				token=token.substr(0,k);
+			}
+			message_table::iterator g=table.find(token);
+			if (g!=table.end()) value=(*g).second;
+			else if (k==string::npos)
+				return error(0xac2,"Message token "+token+" not found");
+
+			// If there is no buffer then return a pointer to the
+			// message held by the message file, or to the default
+			// value within the token (without substitution).
+			char* buffer=pointer<char>(regs.r[2]);
+			if (!buffer)
+			{
+				if (g!=table.end()) regs.r[2]=word((*g).second.c_str());
+				else regs.r[2]=regs.r[1]+k+1;
+				regs.r[3]=value.length();
+				break;
+			}
+
+			// Otherwise substitute arguments and copy to the buffer.
+			string result=substitute(value,regs.r+4);
+			unsigned int size=regs.r[3];
+			if (size)
+			{
+				if (result.length()>=size) result.resize(size-1);
+				std::memcpy(buffer,result.c_str(),result.length()+1);
+			}
+			regs.r[3]=result.length();
+		}
+		break;
+	case swi::MessageTrans_CloseFile:
+		_message_files.erase(pointer<const int>(regs.r[0]));
+		break;
+	}
+	return 0;
+}
+
+} /* namespace host */
+} /* namespace rtk */
@@ -0,0 +1,199 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#ifndef _RTK_HOST_SYSTEM
+#define _RTK_HOST_SYSTEM
+
+#include <map>
+#include <string>
+
+#include "kernel.h"
+
+#include "rtk/os/call_swi.h"
+#include "rtk/host/display.h"
+#include "rtk/host/window_stack.h"
+#include "rtk/host/font_manager.h"
+#include "rtk/host/filesystem.h"
+#include "rtk/host/script.h"
+
+namespace rtk {
+namespace host {
+
+using std::string;
+
+/** Convert register value to pointer.
+ * @param value the register value
+ * @return the corresponding pointer
+ */
+template<class T>
+inline T* pointer(int value)
+{
+	return reinterpret_cast<T*>(
+		static_cast<unsigned long>(static_cast<unsigned int>(value)));
+}
+
+/** Convert pointer to register value.
+ * @param p the pointer
+ * @return the corresponding register value
+ */
+inline int word(const void* p)
+{
+	return static_cast<int>(reinterpret_cast<unsigned long>(p));
+}
+
+/** Make error block.
+ * As with RISC OS, the block is static: it remains valid until the
+ * next error is made.
+ * @param errnum the error number
+ * @param message the error message
+ * @return a pointer to the error block
+ */
+_kernel_oserror* error(int errnum,const string& message);
+
+/** A class to represent a simulated RISC OS machine.
+ * Constructing an instance of this class installs a software interrupt
+ * hook (see os::swi_hook()) which handles the calls made by the
+ * toolkit without reference to the operating system.  The machine
+ * provides:
+ * - a window stack, with icons, redraw rectangles and a caret;
+ * - a font manager in which every character has the same metrics;
+ * - a filesystem held in memory;
+ * - a screen which counts, but does not perform, graphics operations;
+ * - a script of Wimp events, which is used to drive application::run().
+ *
+ * This allows applications (or parts of them) to be run on a host
+ * machine for the purpose of testing or profiling.  Only one instance
+ * may exist at a time.  The hook is removed when it is destroyed.
+ */
+class system
+{
+private:
+	/** A type for holding the tokens of a message file. */
+	typedef std::map<string,string> message_table;
+
+	/** The current instance, or 0 if none. */
+	static system* _current;
+
+	/** The software interrupt hook that was previously installed. */
+	os::swi_hook_type _old_hook;
+
+	/** The value of the real monotonic clock when this machine was
+	 * created (in centiseconds). */
+	unsigned int _time_base;
+
+	/** The amount by which the monotonic clock has been advanced
+	 * (in centiseconds). */
+	unsigned int _time_offset;
+
+	/** The system variables. */
+	std::map<string,string> _vars;
+
+	/** The open message files, indexed by descriptor address. */
+	std::map<const int*,message_table> _message_files;
+
+	/** The drag-a-sprite flag.
+	 * True if DragASprite_Start has been called, but not yet
+	 * DragASprite_Stop, otherwise false.
+	 */
+	bool _dragasprite;
+
+	/** The screen. */
+	host::display _screen;
+
+	/** The window stack. */
+	host::window_stack _windows;
+
+	/** The font manager. */
+	host::font_manager _fonts;
+
+	/** The filesystem. */
+	host::filesystem _files;
+
+	/** The script of Wimp events. */
+	host::script _events;
+public:
+	/** Construct machine and install software interrupt hook. */
+	system();
+
+	/** Remove software interrupt hook and destroy machine. */
+	~system();
+
+	/** Get current machine.
+	 * @return the machine which is currently installed
+	 */
+	static system& current()
+		{ return *_current; }
+
+	/** Get screen.
+	 * @return the screen
+	 */
+	host::display& screen()
+		{ return _screen; }
+
+	/** Get window stack.
+	 * @return the window stack
+	 */
+	host::window_stack& windows()
+		{ return _windows; }
+
+	/** Get font manager.
+	 * @return the font manager
+	 */
+	host::font_manager& fonts()
+		{ return _fonts; }
+
+	/** Get filesystem.
+	 * @return the filesystem
+	 */
+	host::filesystem& files()
+		{ return _files; }
+
+	/** Get script of Wimp events.
+	 * @return the script
+	 */
+	host::script& events()
+		{ return _events; }
+
+	/** Get monotonic time.
+	 * This is the real time elapsed since the machine was created,
+	 * plus any amount by which the clock has been advanced.
+	 * @return the monotonic time (in centiseconds)
+	 */
+	unsigned int monotonic_time() const;
+
+	/** Advance monotonic clock.
+	 * This allows a script to simulate the passage of time without
+	 * waiting for it.
+	 * @param interval the interval (in centiseconds)
+	 */
+	void advance_time(unsigned int interval);
+
+	/** Get system variable.
+	 * @param name the name of the variable
+	 * @return the value of the variable, or the empty string if
+	 *  it is not set
+	 */
+	string var(const string& name) const;
+
+	/** Handle software interrupt.
+	 * @param number the software interrupt number (with the X bit set)
+	 * @param regs the register state (for input and output)
+	 * @return a pointer to an error block, or 0 if no error occurred
+	 */
+	_kernel_oserror* dispatch(int number,_kernel_swi_regs& regs);
+private:
+	/** Software interrupt hook.
+	 * This passes the call to the current machine.
+	 */
+	static _kernel_oserror* hook(int number,_kernel_swi_regs* regs);
+
+	/** Handle MessageTrans software interrupt. */
+	_kernel_oserror* messagetrans_swi(int number,_kernel_swi_regs& regs);
+};
+
+} /* namespace host */
+} /* namespace rtk */
+
+#endif
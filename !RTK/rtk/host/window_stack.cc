@@ -0,0 +1,583 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#include <algorithm>
+#include <cstdio>
+
+#include "rtk/swi/wimp.h"
+#include "rtk/swi/os.h"
+#include "rtk/host/system.h"
+#include "rtk/host/window_stack.h"
+
+namespace rtk {
+namespace host {
+
+namespace {
+
+/** The Wimp palette (as returned by Wimp_ReadPalette). */
+const unsigned int wimp_palette[20]={
+	0xffffff00,0xdddddd00,0xbbbbbb00,0x99999900,
+	0x77777700,0x55555500,0x33333300,0x00000000,
+	0x99440000,0x00eeee00,0x00cc0000,0x0000dd00,
+	0xbbeeee00,0x00885500,0x00bbff00,0xffbb0000,
+	0x00000000,0x0000ff00,0x00ffff00,0xff000000};
+
+/** The width of a character in the system font, in OS units. */
+const int system_font_width=16;
+
+/** The icon flag which indicates that an icon has been deleted. */
+const int icon_deleted=0x00800000;
+
+/** The window flag which indicates that a window is open. */
+const int window_open_flag=0x00010000;
+
+/** The window flag which indicates that a window is at the front. */
+const int window_top_flag=0x00020000;
+
+/** Calculate origin of work area.
+ * @param w the window
+ * @return the position of the work area origin, with respect to
+ *  the screen
+ */
+inline point work_origin(const window_stack::window& w)
+{
+	return w.bbox.xminymax()-w.scroll;
+}
+
+/** Get length of control-terminated string.
+ * @param s the string
+ * @return the number of characters before the first control character
+ */
+int ctrl_length(const char* s)
+{
+	int n=0;
+	while (static_cast<unsigned char>(s[n])>=32) ++n;
+	return n;
+}
+
+} /* anonymous namespace */
+
+window_stack::window_stack():
+	_next_handle(0x1000),
+	_redraw_handle(0),
+	_redraw_pending(false),
+	_buttons(0),
+	_menu(-1),
+	_drag_type(-1)
+{
+	_caret.whandle=-1;
+	_caret.ihandle=-1;
+	_caret.height=-1;
+	_caret.index=-1;
+	reset_counts();
+}
+
+const window_stack::window* window_stack::find(int handle) const
+{
+	std::map<int,window>::const_iterator f=_windows.find(handle);
+	return (f!=_windows.end())?&(*f).second:0;
+}
+
+window_stack::window* window_stack::_find(int handle)
+{
+	std::map<int,window>::iterator f=_windows.find(handle);
+	return (f!=_windows.end())?&(*f).second:0;
+}
+
+std::vector<os::icon>* window_stack::find_icons(int whandle)
+{
+	if (whandle==-2) return &_iconbar;
+	window* w=_find(whandle);
+	return (w)?&w->icons:0;
+}
+
+int window_stack::find(const point& p,int* _ihandle) const
+{
+	int ihandle=-1;
+	int whandle=-1;
+	for (std::vector<int>::const_iterator i=_stack.begin();
+		(whandle==-1)&&(i!=_stack.end());++i)
+	{
+		const window& w=*find(*i);
+		if (p<=w.bbox)
+		{
+			whandle=w.handle;
+			point wp=p-work_origin(w);
+			for (unsigned int j=w.icons.size();j--;)
+			{
+				const os::icon& ic=w.icons[j];
+				if (!(ic.flags&icon_deleted)&&(wp<=ic.bbox))
+				{
+					ihandle=j;
+					break;
+				}
+			}
+		}
+	}
+	if (_ihandle) *_ihandle=ihandle;
+	return whandle;
+}
+
+void window_stack::invalidate(int handle,const box& clip)
+{
+	if (window* w=_find(handle))
+	{
+		if (w->open)
+		{
+			w->invalid.add(clip);
+			_redraw_pending=true;
+		}
+	}
+}
+
+int window_stack::next_redraw() const
+{
+	if (!_redraw_pending) return 0;
+	for (std::vector<int>::const_iterator i=_stack.begin();
+		i!=_stack.end();++i)
+	{
+		if (find(*i)->invalid.size()) return *i;
+	}
+	_redraw_pending=false;
+	return 0;
+}
+
+window_stack& window_stack::pointer(const point& p,int buttons)
+{
+	_pointer=p;
+	_buttons=buttons;
+	return *this;
+}
+
+void window_stack::reset_counts()
+{
+	_rectangles=0;
+	_area=0;
+}
+
+_kernel_oserror* window_stack::swi(int number,_kernel_swi_regs& regs)
+{
+	switch (number)
+	{
+	case swi::Wimp_CreateWindow:
+		{
+			const os::window_create& block=
+				*host::pointer<const os::window_create>(regs.r[1]);
+			int handle=_next_handle;
+			_next_handle+=0x40;
+			window& w=_windows[handle];
+			w.handle=handle;
+			w.flags=block.wflags&~(window_open_flag|window_top_flag);
+			w.bbox=block.bbox;
+			w.scroll=block.scroll;
+			w.extent=block.workarea;
+			w.open=false;
+			w.redraws=0;
+			const os::icon* icons=
+				reinterpret_cast<const os::icon*>(&block+1);
+			w.icons.assign(icons,icons+block.numicons);
+			regs.r[0]=handle;
+		}
+		break;
+	case swi::Wimp_DeleteWindow:
+		{
+			int handle=host::pointer<const os::window_delete>(regs.r[1])->handle;
+			if (!_find(handle)) return error(0x288,"Illegal window handle");
+			close_window(handle);
+			_windows.erase(handle);
+		}
+		break;
+	case swi::Wimp_CreateIcon:
+		{
+			const os::icon_create& block=
+				*host::pointer<const os::icon_create>(regs.r[1]);
+			std::vector<os::icon>* icons=find_icons(block.whandle);
+			if (block.whandle==-1) icons=&_iconbar;
+			if (!icons) return error(0x288,"Illegal window handle");
+
+			// Reuse the first deleted icon, if there is one.
+			unsigned int ihandle=0;
+			while ((ihandle!=icons->size())&&
+				!((*icons)[ihandle].flags&icon_deleted)) ++ihandle;
+			if (ihandle==icons->size()) icons->push_back(block.icon);
+			else (*icons)[ihandle]=block.icon;
+			invalidate(block.whandle,block.icon.bbox);
+			regs.r[0]=ihandle;
+		}
+		break;
+	case swi::Wimp_DeleteIcon:
+		{
+			const os::icon_delete& block=
+				*host::pointer<const os::icon_delete>(regs.r[1]);
+			std::vector<os::icon>* icons=find_icons(block.whandle);
+			if (!icons||(block.ihandle<0)||
+				(block.ihandle>=static_cast<int>(icons->size())))
+				return error(0x28a,"Illegal icon handle");
+			os::icon& ic=(*icons)[block.ihandle];
+			invalidate(block.whandle,ic.bbox);
+			ic.flags|=icon_deleted;
+		}
+		break;
+	case swi::Wimp_OpenWindow:
+		return open_window(*host::pointer<const os::window_open>(regs.r[1]));
+	case swi::Wimp_CloseWindow:
+		{
+			int handle=host::pointer<const os::window_close>(regs.r[1])->handle;
+			if (!_find(handle)) return error(0x288,"Illegal window handle");
+			close_window(handle);
+		}
+		break;
+	case swi::Wimp_RedrawWindow:
+		{
+			os::window_redraw& block=
+				*host::pointer<os::window_redraw>(regs.r[1]);
+			window* w=_find(block.handle);
+			if (!w) return error(0x288,"Illegal window handle");
+
+			// Return the invalid areas of the window, then mark
+			// the window as valid.
+			_redraw_handle=w->handle;
+			_rects.clear();
+			point origin=work_origin(*w);
+			for (graphics::box_list::const_iterator i=w->invalid.begin();
+				i!=w->invalid.end();++i)
+			{
+				box clip=((*i)+origin)&w->bbox;
+				if ((clip.xsize()>0)&&(clip.ysize()>0))
+					_rects.push_back(clip);
+			}
+			w->invalid.clear();
+			++w->redraws;
+			regs.r[0]=next_rectangle(block);
+		}
+		break;
+	case swi::Wimp_UpdateWindow:
+		{
+			os::window_redraw& block=
+				*host::pointer<os::window_redraw>(regs.r[1]);
+			window* w=_find(block.handle);
+			if (!w) return error(0x288,"Illegal window handle");
+
+			// Return the requested area of the window (on entry,
+			// block.bbox is with respect to the work area).
+			_redraw_handle=w->handle;
+			_rects.clear();
+			if (w->open)
+			{
+				box clip=(block.bbox+work_origin(*w))&w->bbox;
+				if ((clip.xsize()>0)&&(clip.ysize()>0))
+					_rects.push_back(clip);
+			}
+			regs.r[0]=next_rectangle(block);
+		}
+		break;
+	case swi::Wimp_GetRectangle:
+		regs.r[0]=next_rectangle(*host::pointer<os::window_redraw>(regs.r[1]));
+		break;
+	case swi::Wimp_GetWindowState:
+		{
+			os::window_state_get& block=
+				*host::pointer<os::window_state_get>(regs.r[1]);
+			const window* w=find(block.handle);
+			if (!w) return error(0x288,"Illegal window handle");
+			block.bbox=w->bbox;
+			block.scroll=w->scroll;
+			block.behind=-1;
+			block.wflags=w->flags;
+			std::vector<int>::iterator f=
+				std::find(_stack.begin(),_stack.end(),w->handle);
+			if (f!=_stack.end())
+			{
+				block.wflags|=window_open_flag;
+				if (f==_stack.begin()) block.wflags|=window_top_flag;
+				if (f+1!=_stack.end()) block.behind=*(f+1);
+				else block.behind=-2;
+			}
+		}
+		break;
+	case swi::Wimp_SetIconState:
+		{
+			const os::icon_state_set& block=
+				*host::pointer<const os::icon_state_set>(regs.r[1]);
+			std::vector<os::icon>* icons=find_icons(block.whandle);
+			if (!icons||(block.ihandle<0)||
+				(block.ihandle>=static_cast<int>(icons->size())))
+				return error(0x28a,"Illegal icon handle");
+			os::icon& ic=(*icons)[block.ihandle];
+			ic.flags=(ic.flags&~block.bic)^block.eor;
+			invalidate(block.whandle,ic.bbox);
+		}
+		break;
+	case swi::Wimp_GetIconState:
+		{
+			os::icon_state_get& block=
+				*host::pointer<os::icon_state_get>(regs.r[1]);
+			std::vector<os::icon>* icons=find_icons(block.whandle);
+			if (!icons||(block.ihandle<0)||
+				(block.ihandle>=static_cast<int>(icons->size())))
+				return error(0x28a,"Illegal icon handle");
+			block.icon=(*icons)[block.ihandle];
+		}
+		break;
+	case swi::Wimp_ResizeIcon:
+		{
+			std::vector<os::icon>* icons=find_icons(regs.r[0]);
+			if (!icons||(regs.r[1]<0)||
+				(regs.r[1]>=static_cast<int>(icons->size())))
+				return error(0x28a,"Illegal icon handle");
+			os::icon& ic=(*icons)[regs.r[1]];
+			invalidate(regs.r[0],ic.bbox);
+			ic.bbox=box(regs.r[2],regs.r[3],regs.r[4],regs.r[5]);
+			invalidate(regs.r[0],ic.bbox);
+		}
+		break;
+	case swi::Wimp_GetPointerInfo:
+		{
+			os::pointer_info_get& block=
+				*host::pointer<os::pointer_info_get>(regs.r[1]);
+			block.p=_pointer;
+			block.buttons=_buttons;
+			block.whandle=find(_pointer,&block.ihandle);
+		}
+		break;
+	case swi::Wimp_DragBox:
+		{
+			const os::drag_box* block=
+				host::pointer<const os::drag_box>(regs.r[1]);
+			_drag_type=(block&&(block->type>=0))?block->type:-1;
+		}
+		break;
+	case swi::Wimp_ForceRedraw:
+		{
+			box clip(regs.r[1],regs.r[2],regs.r[3],regs.r[4]);
+			if (regs.r[0]==-1)
+			{
+				// Coordinates are with respect to the screen.
+				for (std::vector<int>::iterator i=_stack.begin();
+					i!=_stack.end();++i)
+				{
+					window& w=*_find(*i);
+					box wclip=clip&w.bbox;
+					if ((wclip.xsize()>0)&&(wclip.ysize()>0))
+					{
+						w.invalid.add(wclip-work_origin(w));
+						_redraw_pending=true;
+					}
+				}
+			}
+			else
+			{
+				if (!_find(regs.r[0]))
+					return error(0x288,"Illegal window handle");
+				invalidate(regs.r[0],clip);
+			}
+		}
+		break;
+	case swi::Wimp_SetCaretPosition:
+		_caret.whandle=regs.r[0];
+		_caret.ihandle=regs.r[1];
+		_caret.p=point(regs.r[2],regs.r[3]);
+		_caret.height=regs.r[4];
+		_caret.index=regs.r[5];
+		break;
+	case swi::Wimp_GetCaretPosition:
+		*host::pointer<os::caret_position_get>(regs.r[1])=_caret;
+		break;
+	case swi::Wimp_CreateMenu:
+	case swi::Wimp_CreateSubMenu:
+		_menu=regs.r[1];
+		break;
+	case swi::Wimp_GetMenuState:
+		host::pointer<int>(regs.r[1])[0]=-1;
+		break;
+	case swi::Wimp_SetExtent:
+		{
+			window* w=_find(regs.r[0]);
+			if (!w) return error(0x288,"Illegal window handle");
+			w->extent=*host::pointer<const box>(regs.r[1]);
+		}
+		break;
+	case swi::Wimp_BlockCopy:
+		// The content of the window is not held, so there is
+		// nothing to copy.
+		break;
+	case swi::Wimp_ReadPalette:
+		{
+			unsigned int* palette=host::pointer<unsigned int>(regs.r[1]);
+			std::copy(wimp_palette,wimp_palette+20,palette);
+		}
+		break;
+	case swi::Wimp_ReadPixTrans:
+		{
+			// Sprites are plotted at their natural size, without
+			// colour translation.
+			if (int* scale=host::pointer<int>(regs.r[6]))
+			{
+				for (unsigned int i=0;i!=4;++i) scale[i]=1;
+			}
+			if (unsigned char* table=host::pointer<unsigned char>(regs.r[7]))
+			{
+				for (unsigned int i=0;i!=16;++i) table[i]=i;
+			}
+		}
+		break;
+	case swi::Wimp_SpriteOp:
+		return system::current().screen().swi(swi::OS_SpriteOp,regs);
+	case swi::Wimp_ReadSysInfo:
+		if (regs.r[0]==8)
+		{
+			regs.r[0]=system::current().fonts().desktop_font();
+			regs.r[1]=system::current().fonts().symbol_font();
+		}
+		else regs.r[0]=0;
+		break;
+	case swi::Wimp_SetColour:
+	case swi::Wimp_TextColour:
+	case swi::Wimp_SetFontColours:
+		break;
+	case swi::Wimp_TextOp:
+		{
+			font_manager& fonts=system::current().fonts();
+			int advance=fonts.advance(fonts.desktop_font())/400;
+			if (!advance) advance=system_font_width;
+			const char* s=host::pointer<const char>(regs.r[1]);
+			switch (regs.r[0])
+			{
+			case 1:
+				{
+					int count=regs.r[2];
+					if (!count) count=ctrl_length(s);
+					regs.r[0]=count*advance;
+				}
+				break;
+			case 2:
+				system::current().screen().swi(swi::OS_WriteN,regs);
+				break;
+			case 3:
+				{
+					// Find the point at which to split the string
+					// so that it fits within the given width.
+					int length=ctrl_length(s);
+					int fit=regs.r[2]/advance;
+					int split=length;
+					if (fit<length)
+					{
+						split=fit;
+						if (regs.r[3]>0)
+						{
+							int i=fit;
+							while ((i>0)&&(s[i]!=regs.r[3])) --i;
+							if (s[i]==regs.r[3]) split=i;
+						}
+					}
+					regs.r[0]=word(s+split);
+				}
+				break;
+			}
+		}
+		break;
+	default:
+		{
+			char buffer[32];
+			std::sprintf(buffer,"SWI &%X not known",number);
+			return error(0x1e6,buffer);
+		}
+	}
+	return 0;
+}
+
+_kernel_oserror* window_stack::open_window(const os::window_open& block)
+{
+	window* w=_find(block.handle);
+	if (!w) return error(0x288,"Illegal window handle");
+
+	// The size of the visible area is limited by the extent, and the
+	// scroll offsets are limited so that the visible area lies within
+	// the extent.
+	box bbox=block.bbox;
+	if (bbox.xsize()>w->extent.xsize())
+		bbox.xmax(bbox.xmin()+w->extent.xsize());
+	if (bbox.ysize()>w->extent.ysize())
+		bbox.ymin(bbox.ymax()-w->extent.ysize());
+	point scroll=block.scroll;
+	scroll.x(std::max(w->extent.xmin(),
+		std::min(scroll.x(),w->extent.xmax()-bbox.xsize())));
+	scroll.y(std::min(w->extent.ymax(),
+		std::max(scroll.y(),w->extent.ymin()+bbox.ysize())));
+
+	// If the window was not already open, or if its size or scroll
+	// offsets have changed, then the whole visible area must be
+	// redrawn.  (A window which has only moved can be block-copied.)
+	bool redraw=!w->open||(bbox.xsize()!=w->bbox.xsize())||
+		(bbox.ysize()!=w->bbox.ysize())||(scroll!=w->scroll);
+	w->bbox=bbox;
+	w->scroll=scroll;
+	w->open=true;
+	if (redraw)
+	{
+		w->invalid.clear();
+		w->invalid.add(w->bbox-work_origin(*w));
+		_redraw_pending=true;
+	}
+
+	// Place the window in the stack.
+	std::vector<int>::iterator f=
+		std::find(_stack.begin(),_stack.end(),w->handle);
+	if (f!=_stack.end()) _stack.erase(f);
+	std::vector<int>::iterator pos=_stack.begin();
+	if (block.behind==-2) pos=_stack.end();
+	else if (block.behind!=-1)
+	{
+		pos=std::find(_stack.begin(),_stack.end(),block.behind);
+		if (pos!=_stack.end()) ++pos;
+	}
+	_stack.insert(pos,w->handle);
+	return 0;
+}
+
+void window_stack::close_window(int handle)
+{
+	std::vector<int>::iterator f=
+		std::find(_stack.begin(),_stack.end(),handle);
+	if (f!=_stack.end()) _stack.erase(f);
+	if (window* w=_find(handle))
+	{
+		w->open=false;
+		w->invalid.clear();
+	}
+	if (_redraw_handle==handle)
+	{
+		_redraw_handle=0;
+		_rects.clear();
+	}
+	if (_caret.whandle==handle)
+	{
+		_caret.whandle=-1;
+		_caret.ihandle=-1;
+	}
+}
+
+bool window_stack::next_rectangle(os::window_redraw& block)
+{
+	window* w=_find(_redraw_handle);
+	if (!w||_rects.empty())
+	{
+		_redraw_handle=0;
+		_rects.clear();
+		return false;
+	}
+	block.handle=w->handle;
+	block.bbox=w->bbox;
+	block.scroll=w->scroll;
+	block.clip=_rects.front();
+	_rects.erase(_rects.begin());
+	++_rectangles;
+	_area+=static_cast<unsigned long long>(block.clip.xsize())*
+		block.clip.ysize();
+	return true;
+}
+
+} /* namespace host */
+} /* namespace rtk */
@@ -0,0 +1,248 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#ifndef _RTK_HOST_WINDOW_STACK
+#define _RTK_HOST_WINDOW_STACK
+
+#include <map>
+#include <vector>
+
+#include "kernel.h"
+
+#include "rtk/graphics/point.h"
+#include "rtk/graphics/box.h"
+#include "rtk/graphics/box_list.h"
+#include "rtk/os/wimp.h"
+
+namespace rtk {
+namespace host {
+
+using rtk::graphics::point;
+using rtk::graphics::box;
+
+/** A class to represent the window stack of a simulated window manager.
+ * This handles those Wimp calls which concern windows, icons, redraw,
+ * the caret, the pointer, menus and drags.  Calls which concern the
+ * task as a whole (polling and messages) are handled by the script.
+ *
+ * Areas which need to be redrawn are accumulated for each window, and
+ * returned as redraw requests when the window manager is polled.  No
+ * account is taken of one window obscuring another.
+ */
+class window_stack
+{
+public:
+	/** A type for representing a count of windows. */
+	typedef unsigned int size_type;
+
+	/** A structure to represent a simulated window. */
+	struct window
+	{
+		/** The window handle. */
+		int handle;
+		/** The window flags. */
+		int flags;
+		/** The visible area, with respect to the screen. */
+		box bbox;
+		/** The scroll offsets. */
+		point scroll;
+		/** The work area extent. */
+		box extent;
+		/** The open flag. */
+		bool open;
+		/** The icons (including any which have been deleted). */
+		std::vector<os::icon> icons;
+		/** The areas needing to be redrawn, with respect to
+		 * the work area. */
+		graphics::box_list invalid;
+		/** The number of redraw requests delivered. */
+		unsigned int redraws;
+	};
+private:
+	/** The windows, indexed by handle. */
+	std::map<int,window> _windows;
+
+	/** The handles of open windows, from front to back. */
+	std::vector<int> _stack;
+
+	/** The icons on the icon bar (including any which have been
+	 * deleted). */
+	std::vector<os::icon> _iconbar;
+
+	/** The handle to be given to the next window created. */
+	int _next_handle;
+
+	/** The handle of the window being redrawn or updated,
+	 * or 0 if none. */
+	int _redraw_handle;
+
+	/** True if any window may have an area needing to be redrawn,
+	 * false if none has.  This allows next_redraw() to return without
+	 * searching the stack (which it is asked to do before every
+	 * Wimp event). */
+	mutable bool _redraw_pending;
+
+	/** The rectangles remaining to be returned for the window
+	 * being redrawn or updated, with respect to the screen. */
+	std::vector<box> _rects;
+
+	/** The pointer position. */
+	point _pointer;
+
+	/** The mouse button state. */
+	int _buttons;
+
+	/** The caret position (as returned by Wimp_GetCaretPosition). */
+	os::caret_position_get _caret;
+
+	/** The handle of the current menu, or -1 if none. */
+	int _menu;
+
+	/** The current drag type, or -1 if none. */
+	int _drag_type;
+
+	/** The number of redraw rectangles returned. */
+	unsigned int _rectangles;
+
+	/** The total area of the redraw rectangles returned,
+	 * in square OS units. */
+	unsigned long long _area;
+public:
+	/** Construct window stack. */
+	window_stack();
+
+	/** Find window.
+	 * @param handle the window handle
+	 * @return a pointer to the window, or 0 if not found
+	 */
+	const window* find(int handle) const;
+
+	/** Get number of windows.
+	 * @return the number of windows which have been created
+	 *  and not deleted
+	 */
+	size_type size() const
+		{ return _windows.size(); }
+
+	/** Get open windows.
+	 * @return the handles of the open windows, from front to back
+	 */
+	const std::vector<int>& stack() const
+		{ return _stack; }
+
+	/** Find window at point.
+	 * @param p the point, with respect to the screen
+	 * @param _ihandle a buffer for the returned icon handle
+	 *  (-1 if none)
+	 * @return the handle of the frontmost open window containing
+	 *  the point, or -1 if none
+	 */
+	int find(const point& p,int* _ihandle) const;
+
+	/** Invalidate area of window.
+	 * @param handle the window handle
+	 * @param clip the area to invalidate, with respect to the work area
+	 */
+	void invalidate(int handle,const box& clip);
+
+	/** Get next window needing to be redrawn.
+	 * @return the handle of the frontmost open window with an area
+	 *  needing to be redrawn, or 0 if none
+	 */
+	int next_redraw() const;
+
+	/** Set pointer state.
+	 * @param p the pointer position, with respect to the screen
+	 * @param buttons the mouse button state
+	 * @return a reference to this
+	 */
+	window_stack& pointer(const point& p,int buttons=0);
+
+	/** Get pointer position.
+	 * @return the pointer position, with respect to the screen
+	 */
+	const point& pointer() const
+		{ return _pointer; }
+
+	/** Get caret position.
+	 * @return the caret position
+	 */
+	const os::caret_position_get& caret() const
+		{ return _caret; }
+
+	/** Get current menu.
+	 * @return the handle of the current menu, or -1 if none
+	 */
+	int menu() const
+		{ return _menu; }
+
+	/** Get current drag type.
+	 * @return the type of the current drag, or -1 if none
+	 */
+	int drag_type() const
+		{ return _drag_type; }
+
+	/** End drag.
+	 * This should be called by a script when it delivers the
+	 * corresponding User_Drag_Box event.
+	 */
+	void end_drag()
+		{ _drag_type=-1; }
+
+	/** Get number of redraw rectangles returned.
+	 * @return the number of rectangles
+	 */
+	unsigned int rectangles() const
+		{ return _rectangles; }
+
+	/** Get area of redraw rectangles returned.
+	 * @return the total area, in square OS units
+	 */
+	unsigned long long area() const
+		{ return _area; }
+
+	/** Reset counters. */
+	void reset_counts();
+
+	/** Handle software interrupt.
+	 * @param number the software interrupt number (without the X bit)
+	 * @param regs the register state (for input and output)
+	 * @return a pointer to an error block, or 0 if no error occurred
+	 */
+	_kernel_oserror* swi(int number,_kernel_swi_regs& regs);
+private:
+	/** Find window.
+	 * @param handle the window handle
+	 * @return a pointer to the window, or 0 if not found
+	 */
+	window* _find(int handle);
+
+	/** Find icons of window.
+	 * @param whandle the window handle (-2 for the icon bar)
+	 * @return a pointer to the icons, or 0 if the window was not found
+	 */
+	std::vector<os::icon>* find_icons(int whandle);
+
+	/** Open window.
+	 * @param block the window position and stacking order
+	 */
+	_kernel_oserror* open_window(const os::window_open& block);
+
+	/** Close window.
+	 * @param handle the window handle
+	 */
+	void close_window(int handle);
+
+	/** Return next redraw rectangle.
+	 * @param block the block to be filled in
+	 * @return true if there was a rectangle, otherwise false
+	 */
+	bool next_rectangle(os::window_redraw& block);
+};
+
+} /* namespace host */
+} /* namespace rtk */
+
+#endif
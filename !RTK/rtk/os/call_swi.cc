@@ -0,0 +1,21 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#include "rtk/os/call_swi.h"
+
+namespace rtk {
+namespace os {
+
+swi_hook_type _swi_hook=0;
+
+swi_hook_type swi_hook(swi_hook_type hook)
+{
+	swi_hook_type old_hook=_swi_hook;
+	_swi_hook=hook;
+	return old_hook;
+}
+
+} /* namespace os */
+} /* namespace rtk */
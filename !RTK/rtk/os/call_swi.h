@@ -13,6 +13,37 @@
 namespace rtk {
 namespace os {
 
+/** A type for representing a software interrupt hook.
+ * A hook, if installed, is called in place of the operating system
+ * whenever a software interrupt is issued using call_swi().  This
+ * allows the toolkit to be run against an alternative implementation
+ * of the operating system interface (for example, a simulated Wimp on
+ * a host machine for the purpose of testing or profiling).
+ * @param number the software interrupt number (with the X bit set)
+ * @param regs the register state (for input and output)
+ * @return a pointer to an error block, or 0 if no error occurred
+ */
+typedef _kernel_oserror* (*swi_hook_type)(int number,_kernel_swi_regs* regs);
+
+/** The current software interrupt hook, or 0 if none.
+ * @internal
+ * This should be accessed using swi_hook().
+ */
+extern swi_hook_type _swi_hook;
+
+/** Get software interrupt hook.
+ * @return the current hook, or 0 if none
+ */
+inline swi_hook_type swi_hook()
+	{ return _swi_hook; }
+
+/** Set software interrupt hook.
+ * @param hook the required hook, or 0 to call the operating system
+ *  directly
+ * @return the previous hook, or 0 if none
+ */
+swi_hook_type swi_hook(swi_hook_type hook);
+
 /** Call a RISC OS software interrupt.
  * @param number the software interrupt number
  * @param regs the register state (for input and output)
@@ -20,7 +51,8 @@ namespace os {
 inline void call_swi(unsigned int number,_kernel_swi_regs* regs)
 {
 	const int X=0x20000;
-	_kernel_oserror* err=_kernel_swi(X+number,regs,regs);
+	_kernel_oserror* err=(_swi_hook)?_swi_hook(X+number,regs):
+		_kernel_swi(X+number,regs,regs);
 	if (err) throw exception(err);
 }
 
@@ -59,6 +59,14 @@ void Font_ReadDefn(int handle,char* _id,int* _xsize,int* _ysize,
 	if (_usage_count) *_usage_count=regs.r[7];
 }
 
+void Font_ReadInfo(int handle,box* _bbox)
+{
+	_kernel_swi_regs regs;
+	regs.r[0]=handle;
+	call_swi(swi::Font_ReadInfo,&regs);
+	if (_bbox) *_bbox=box(regs.r[1],regs.r[2],regs.r[3],regs.r[4]);
+}
+
 void Font_CharBBox(int handle,int code,int flags,box* _bbox)
 {
 	_kernel_swi_regs regs;
@@ -69,6 +69,12 @@ void Font_ReadDefn(int handle,int* _buffer_size);
 void Font_ReadDefn(int handle,char* _id,int* _xsize,int* _ysize,
 	int* _xres,int* _yres,int* _age,int* _usage_count);
 
+/** Get bounding box large enough to contain any character of a font.
+ * @param handle the font handle
+ * @param _bbox a buffer for the returned bounding box (in pixels)
+ */
+void Font_ReadInfo(int handle,box* _bbox);
+
 /** Get bounding box of a character.
  * @param handle the font handle
  * @param code the character code
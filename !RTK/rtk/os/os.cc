@@ -88,6 +88,15 @@ void OS_File18(const char* name,unsigned int filetype)
 	call_swi(swi::OS_File,&regs);
 }
 
+void OS_Args2(int handle,unsigned int* _extent)
+{
+	_kernel_swi_regs regs;
+	regs.r[0]=2;
+	regs.r[1]=handle;
+	call_swi(swi::OS_Args,&regs);
+	if (_extent) *_extent=regs.r[2];
+}
+
 void OS_Args5(int handle,bool* _eof)
 {
 	_kernel_swi_regs regs;
@@ -212,6 +221,40 @@ void OS_FSControl37(const char* pathname,char* buffer,const char* pathvar,
 	if (_size) *_size=regs.r[5];
 }
 
+void OS_SpriteOp9(sprite_area* area)
+{
+	_kernel_swi_regs regs;
+	regs.r[0]=0x109;
+	regs.r[1]=(int)area;
+	call_swi(swi::OS_SpriteOp,&regs);
+}
+
+void OS_SpriteOp15(sprite_area* area,const char* name,bool palette,
+	int xsize,int ysize,int mode)
+{
+	_kernel_swi_regs regs;
+	regs.r[0]=0x10f;
+	regs.r[1]=(int)area;
+	regs.r[2]=(int)name;
+	regs.r[3]=palette;
+	regs.r[4]=xsize;
+	regs.r[5]=ysize;
+	regs.r[6]=mode;
+	call_swi(swi::OS_SpriteOp,&regs);
+}
+
+void OS_SpriteOp34(sprite_area* area,sprite* sp,const point& p,int action)
+{
+	_kernel_swi_regs regs;
+	regs.r[0]=0x222;
+	regs.r[1]=(int)area;
+	regs.r[2]=(int)sp;
+	regs.r[3]=p.x();
+	regs.r[4]=p.y();
+	regs.r[5]=action;
+	call_swi(swi::OS_SpriteOp,&regs);
+}
+
 void OS_SpriteOp40(sprite_area* area,sprite* sp,int* _xsize,int* _ysize,
 	int* _mask,int* _mode)
 {
@@ -240,6 +283,27 @@ void OS_SpriteOp40(sprite_area* area,const char* name,int* _xsize,int* _ysize,
 	if (_mode) *_mode=regs.r[6];
 }
 
+void OS_SpriteOp60(sprite_area* area,sprite* sp,void* save,int* _state)
+{
+	_kernel_swi_regs regs;
+	regs.r[0]=0x23c;
+	regs.r[1]=(int)area;
+	regs.r[2]=(int)sp;
+	regs.r[3]=(int)save;
+	call_swi(swi::OS_SpriteOp,&regs);
+	if (_state)
+	{
+		for (unsigned int i=0;i!=4;++i) _state[i]=regs.r[i];
+	}
+}
+
+void OS_SpriteOp60(const int* state)
+{
+	_kernel_swi_regs regs;
+	for (unsigned int i=0;i!=4;++i) regs.r[i]=state[i];
+	call_swi(swi::OS_SpriteOp,&regs);
+}
+
 void OS_ReadModeVariable(int index,int* _value)
 {
 	_kernel_swi_regs regs;
@@ -258,6 +322,14 @@ void OS_Plot(int code,const point& p)
 	call_swi(swi::OS_Plot,&regs);
 }
 
+void OS_WriteN(const char* s,unsigned int count)
+{
+	_kernel_swi_regs regs;
+	regs.r[0]=(int)s;
+	regs.r[1]=count;
+	call_swi(swi::OS_WriteN,&regs);
+}
+
 void OS_ReadMonotonicTime(unsigned int* _time)
 {
 	_kernel_swi_regs regs;
@@ -84,6 +84,12 @@ void OS_File17(const char* name,unsigned int* _objtype,unsigned int* _loadaddr,
  */
 void OS_File18(const char* name,unsigned int filetype);
 
+/** Read file extent.
+ * @param handle the file handle
+ * @param _extent a buffer for the returned extent in bytes
+ */
+void OS_Args2(int handle,unsigned int* _extent);
+
 /** Read EOF status.
  * @param handle the file handle
  * @param _eof a buffer for the returned EOF status (true=EOF)
@@ -179,6 +185,32 @@ void OS_FSControl26(const char* src_name,const char* dst_name,
 void OS_FSControl37(const char* name,char* buffer,const char* pathvar,
 	const char* path,unsigned int size,unsigned int* _size);
 
+/** Initialise sprite area.
+ * The first and second words of the area (its size and the offset to
+ * the first sprite) must have been set by the caller.
+ * @param area the sprite area
+ */
+void OS_SpriteOp9(sprite_area* area);
+
+/** Create sprite.
+ * @param area the sprite area
+ * @param name the sprite name
+ * @param palette true if the sprite is to have a palette, otherwise false
+ * @param xsize the required width, in pixels
+ * @param ysize the required height, in pixels
+ * @param mode the required screen mode or sprite type word
+ */
+void OS_SpriteOp15(sprite_area* area,const char* name,bool palette,
+	int xsize,int ysize,int mode);
+
+/** Put sprite at user coordinates (given pointer).
+ * @param area the sprite area
+ * @param sp the sprite pointer
+ * @param p the coordinates of the bottom left-hand corner
+ * @param action the plot action
+ */
+void OS_SpriteOp34(sprite_area* area,sprite* sp,const point& p,int action);
+
 /** Read sprite information (given pointer).
  * @param area the sprite area
  * @param sp the sprite pointer
@@ -201,6 +233,20 @@ void OS_SpriteOp40(sprite_area* area,sprite* sp,int* _xsize,int* _ysize,
 void OS_SpriteOp40(sprite_area* area,const char* name,int* _xsize,int* _ysize,
 	int* _mask,int* _mode);
 
+/** Switch output to sprite (given pointer).
+ * @param area the sprite area
+ * @param sp the sprite pointer
+ * @param save the save area, or 0 if none
+ * @param _state a buffer for the four words which, if passed to
+ *  OS_SpriteOp60(const int*), will restore the previous output destination
+ */
+void OS_SpriteOp60(sprite_area* area,sprite* sp,void* save,int* _state);
+
+/** Restore output destination.
+ * @param state the four words returned by OS_SpriteOp60
+ */
+void OS_SpriteOp60(const int* state);
+
 /** Read mode variable.
  * @param index the variable number
  * @param _value a buffer for the returned value
@@ -218,6 +264,12 @@ void OS_ReadMonotonicTime(unsigned int* _time);
  */
 void OS_Plot(int code,const point& p);
 
+/** Write bytes to VDU drivers.
+ * @param s the bytes to be written
+ * @param count the number of bytes to be written
+ */
+void OS_WriteN(const char* s,unsigned int count);
+
 } /* namespace os */
 } /* namespace rtk */
 
@@ -3,6 +3,8 @@
 // Distribution and use are subject to the GNU Lesser General Public License,
 // a copy of which may be found in the file !RTK.Copyright.
 
+#include <cstring>
+
 #include "rtk/swi/wimp.h"
 #include "rtk/os/call_swi.h"
 #include "rtk/os/wimp.h"
@@ -88,6 +90,18 @@ void Wimp_Poll(int mask,wimp_block& block,int* pollword,int* _code)
 	if (_code) *_code=regs.r[0];
 }
 
+void Wimp_PollIdle(int mask,wimp_block& block,unsigned int earliest,
+	int* pollword,int* _code)
+{
+	_kernel_swi_regs regs;
+	regs.r[0]=mask;
+	regs.r[1]=(int)&block;
+	regs.r[2]=earliest;
+	regs.r[3]=(int)pollword;
+	call_swi(swi::Wimp_PollIdle,&regs);
+	if (_code) *_code=regs.r[0];
+}
+
 void Wimp_RedrawWindow(window_redraw& block,int* _more)
 {
 	_kernel_swi_regs regs;
@@ -237,6 +251,13 @@ void Wimp_ReportError(int errnum,const char* message,const char* title,
 	if (_result) *_result=regs.r[1];
 }
 
+void Wimp_ReadPalette(unsigned int* palette)
+{
+	_kernel_swi_regs regs;
+	regs.r[1]=(int)palette;
+	call_swi(swi::Wimp_ReadPalette,&regs);
+}
+
 void Wimp_SetColour(int colour)
 {
 	_kernel_swi_regs regs;
@@ -344,6 +344,17 @@ void Wimp_CloseWindow(const window_close& block);
  */
 void Wimp_Poll(int mask,wimp_block& block,int* pollword,int* _code);
 
+/** Poll Wimp, returning null events no earlier than a given time.
+ * @param mask the event mask
+ * @param block the event block
+ * @param earliest the earliest monotonic time at which a null event
+ *  should be returned
+ * @param pollword the pollword
+ * @param _code a buffer for the returned event code
+ */
+void Wimp_PollIdle(int mask,wimp_block& block,unsigned int earliest,
+	int* pollword,int* _code);
+
 /** Begin redraw of window (in response to Wimp_Poll).
  * @param block the redraw block
  * @param _more a buffer for the returned control flag (true if more to do,
@@ -464,6 +475,14 @@ void Wimp_ReportError(const _kernel_oserror& block,const char* title,
 void Wimp_ReportError(int errnum,const char* message,const char* title,
 	int flags,int* _result);
 
+/** Read current Wimp palette.
+ * Each palette entry has the form 0xBBGGRRxx.  The first 16 entries
+ * correspond to the standard Wimp colours, the next entry to the
+ * border colour, and the remaining 3 entries to the pointer colours.
+ * @param palette a buffer for the returned palette (20 words)
+ */
+void Wimp_ReadPalette(unsigned int* palette);
+
 /** Set graphics colour to a standard Wimp colour.
  * @param colour the required standard colour (bits 0-3), GCOL action
  *  (bits 4-6) and foreground (bit 7=0) or background (bit 7=1) flag
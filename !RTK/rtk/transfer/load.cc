@@ -3,10 +3,13 @@
 // Distribution and use are subject to the GNU Lesser General Public License,
 // a copy of which may be found in the file !RTK.Copyright.
 
+#include <algorithm>
+
 #include "rtk/swi/wimp.h"
 #include "rtk/os/os.h"
 #include "rtk/os/wimp.h"
 #include "rtk/desktop/application.h"
+#include "rtk/desktop/progress_bar.h"
 #include "rtk/events/wimp.h"
 #include "rtk/events/message.h"
 #include "rtk/events/ramfetch.h"
@@ -17,19 +20,38 @@
 namespace rtk {
 namespace transfer {
 
+using std::min;
+
+namespace {
+
+/** The default chunk size for asynchronous mode. */
+const load::size_type default_chunk_size=0x10000;
+
+} /* anonymous namespace */
+
 load::load():
 	_state(state_idle),
 	_allow_ram_transfer(true),
 	_ldata(0),
-	_lsize(0)
+	_lsize(0),
+	_asynchronous(false),
+	_chunk_size(default_chunk_size),
+	_fhandle(0),
+	_fcount(0),
+	_ftotal(0),
+	_progress(0)
 {}
 
 load::~load()
-{}
+{
+	close_file();
+}
 
 void load::handle_event(events::datasave& ev)
 {
 	// A Message_DataSave is acted upon at any time.
+	// Abandon any asynchronous copy that is in progress.
+	close_file();
 	if (_allow_ram_transfer)
 	{
 		// If RAM transfers are enabled then reply with Message_RAMFetch.
@@ -55,14 +77,37 @@ void load::handle_event(events::datasave& ev)
 
 void load::handle_event(events::dataload& ev)
 {
-	inherited::handle_event(ev);
-	_state=state_idle;
+	if (_asynchronous&&parent_application())
+	{
+		// Acknowledge immediately, then copy the data during
+		// subsequent null events.  The acknowledgement cannot be
+		// deferred: Message_DataLoad is sent as a recorded message,
+		// so it would be returned to the sender as a bounce at the
+		// next call to Wimp_Poll.
+		ev.reply();
+		begin_file(ev.pathname(),ev.estsize());
+	}
+	else
+	{
+		close_file();
+		inherited::handle_event(ev);
+		_state=state_idle;
+	}
 }
 
 void load::handle_event(events::dataopen& ev)
 {
-	inherited::handle_event(ev);
-	_state=state_idle;
+	if (_asynchronous&&parent_application())
+	{
+		ev.reply();
+		begin_file(ev.pathname(),0);
+	}
+	else
+	{
+		close_file();
+		inherited::handle_event(ev);
+		_state=state_idle;
+	}
 }
 
 void load::handle_event(events::ramfetch& ev)
@@ -104,12 +149,87 @@ void load::handle_event(events::ramtransmit& ev)
 	}
 }
 
+void load::handle_event(events::null_reason& ev)
+{
+	// Null events are acted upon while an asynchronous copy is
+	// in progress.
+	if (_state==state_file)
+	{
+		try
+		{
+			// Copy at most one chunk.
+			size_type count=0;
+			bool eof=false;
+			os::OS_Args5(_fhandle,&eof);
+			while (!eof&&(count<_chunk_size))
+			{
+				_ldata=0;
+				_lsize=0;
+				get_block(&_ldata,&_lsize);
+				size_type size=min(_lsize,_chunk_size-count);
+				unsigned int excess=0;
+				os::OS_GBPB4(_fhandle,_ldata,size,&excess,0);
+				put_block(size-excess);
+				count+=size-excess;
+				os::OS_Args5(_fhandle,&eof);
+			}
+			_fcount+=count;
+			progress_notify(_fcount,_ftotal);
+
+			if (eof)
+			{
+				close_file();
+				_state=state_idle;
+				finish();
+				events::loaded ev2(*this,*this);
+				ev2.post();
+				remove();
+			}
+		}
+		catch (...)
+		{
+			// Abandon the copy, so that the error is reported once.
+			close_file();
+			_state=state_idle;
+			throw;
+		}
+	}
+}
+
 load& load::allow_ram_transfer(bool value)
 {
 	_allow_ram_transfer=value;
 	return *this;
 }
 
+load& load::asynchronous(bool value)
+{
+	_asynchronous=value;
+	return *this;
+}
+
+load& load::chunk_size(size_type size)
+{
+	_chunk_size=(size)?size:1;
+	return *this;
+}
+
+load& load::progress(desktop::progress_bar* pb)
+{
+	_progress=pb;
+	return *this;
+}
+
+void load::cancel()
+{
+	if (_state==state_file)
+	{
+		close_file();
+		_state=state_idle;
+		remove();
+	}
+}
+
 void load::put_file(const string& pathname,size_type estsize)
 {
 	start(estsize);
@@ -131,5 +251,37 @@ void load::put_file(const string& pathname,size_type estsize)
 	finish();
 }
 
+void load::progress_notify(size_type count,size_type total)
+{
+	if (_progress) _progress->fraction(count,total);
+}
+
+void load::begin_file(const string& pathname,size_type estsize)
+{
+	// Abandon any copy that is already in progress.
+	close_file();
+
+	start(estsize);
+	os::OS_Find(0x4f,pathname.c_str(),0,&_fhandle);
+	_fcount=0;
+	_ftotal=estsize;
+	os::OS_Args2(_fhandle,&_ftotal);
+	_state=state_file;
+	if (desktop::application* app=parent_application())
+		app->register_null(*this);
+	progress_notify(_fcount,_ftotal);
+}
+
+void load::close_file()
+{
+	if (_fhandle)
+	{
+		os::OS_Find0(_fhandle);
+		_fhandle=0;
+		if (desktop::application* app=parent_application())
+			app->deregister_null(*this);
+	}
+}
+
 } /* namespace transfer */
 } /* namespace rtk */
@@ -10,9 +10,16 @@
 
 #include "rtk/events/ramfetch.h"
 #include "rtk/events/ramtransmit.h"
+#include "rtk/events/null_reason.h"
 #include "rtk/transfer/basic_load.h"
 
 namespace rtk {
+namespace desktop {
+
+class progress_bar;
+
+} /* namespace desktop */
+
 namespace transfer {
 
 using std::string;
@@ -23,11 +30,18 @@ using std::string;
  * finish to define what is done with the data.  They may additionally
  * override put_file if it is advantageous to handle the data
  * differently should it be transferred as a file.
+ *
+ * If asynchronous mode is enabled then data transferred as a file is
+ * copied in chunks during null events, so that the desktop remains
+ * responsive while a large file is loaded.  The same sequence of calls
+ * to start, get, put and finish is made as in synchronous mode, but
+ * put_file is bypassed.
  */
 class load:
 	public rtk::transfer::basic_load,
 	public rtk::events::ramfetch::handler,
-	public rtk::events::ramtransmit::handler
+	public rtk::events::ramtransmit::handler,
+	public rtk::events::null_reason::handler
 {
 private:
 	/** The class from which this one is derived. */
@@ -45,7 +59,10 @@ private:
 		state_ramfetch_first,
 		/** The state in which the load operation has sent an intermediate
 		 * Message_RAMFetch and is waiting for a Message_RAMTransmit. */
-		state_ramfetch
+		state_ramfetch,
+		/** The state in which the load operation is copying data from
+		 * a file during null events. */
+		state_file
 	};
 
 	/** The current state of the load operation. */
@@ -65,6 +82,26 @@ private:
 	 * the Message_RAMFetch is negatively acknowledged.
 	 */
 	os::wimp_block _datasave_block;
+
+	/** The asynchronous mode flag. */
+	bool _asynchronous;
+
+	/** The maximum number of bytes to copy per null event
+	 * in asynchronous mode. */
+	size_type _chunk_size;
+
+	/** The handle of the file being copied in asynchronous mode,
+	 * or 0 if none. */
+	int _fhandle;
+
+	/** The number of bytes copied so far in asynchronous mode. */
+	size_type _fcount;
+
+	/** The size of the file being copied in asynchronous mode. */
+	size_type _ftotal;
+
+	/** The progress bar to be updated, or 0 if none. */
+	desktop::progress_bar* _progress;
 public:
 	/** Construct load object.
 	 * By default, RAM transfers are allowed.
@@ -79,6 +116,7 @@ public:
 	virtual void handle_event(events::dataopen& ev);
 	virtual void handle_event(events::ramfetch& ev);
 	virtual void handle_event(events::ramtransmit& ev);
+	virtual void handle_event(events::null_reason& ev);
 
 	/** Get RAM transfer allowed flag.
 	 * @return true if RAM transfers are allowed, otherwise false
@@ -94,6 +132,61 @@ public:
 	 * @return a reference to this
 	 */
 	load& allow_ram_transfer(bool value);
+
+	/** Get asynchronous mode flag.
+	 * @return true if asynchronous mode is enabled, otherwise false
+	 */
+	bool asynchronous() const
+		{ return _asynchronous; }
+
+	/** Set asynchronous mode flag.
+	 * Asynchronous mode has no effect unless this component is
+	 * descended from an application, since that is the source of
+	 * null events.
+	 * @param value true to enable asynchronous mode, otherwise false
+	 * @return a reference to this
+	 */
+	load& asynchronous(bool value);
+
+	/** Get chunk size.
+	 * @return the maximum number of bytes copied per null event
+	 */
+	size_type chunk_size() const
+		{ return _chunk_size; }
+
+	/** Set chunk size.
+	 * @param size the maximum number of bytes to be copied per
+	 *  null event in asynchronous mode
+	 * @return a reference to this
+	 */
+	load& chunk_size(size_type size);
+
+	/** Get progress bar.
+	 * @return the progress bar, or 0 if none
+	 */
+	desktop::progress_bar* progress() const
+		{ return _progress; }
+
+	/** Set progress bar.
+	 * If a progress bar is specified then the default implementation
+	 * of progress_notify() updates it as data is copied.
+	 * @param pb the progress bar, or 0 for none
+	 * @return a reference to this
+	 */
+	load& progress(desktop::progress_bar* pb);
+
+	/** Determine whether an asynchronous copy is in progress.
+	 * @return true if in progress, otherwise false
+	 */
+	bool busy() const
+		{ return _state==state_file; }
+
+	/** Cancel asynchronous copy.
+	 * If a copy is in progress then the file is closed and this
+	 * component is removed from its parent.  finish() is not called,
+	 * and no loaded event is posted.
+	 */
+	void cancel();
 protected:
 	/** Start new load operation.
 	 * If start is called before a previous operation has been completed
@@ -130,6 +223,26 @@ protected:
 	 * @param estsize the estimated file size in bytes
 	 */
 	virtual void put_file(const string& pathname,size_type estsize);
+
+	/** Notify progress of asynchronous copy.
+	 * This is called when an asynchronous copy begins, and after each
+	 * chunk has been copied.  The default implementation updates the
+	 * progress bar, if there is one.
+	 * @param count the number of bytes copied so far
+	 * @param total the size of the file in bytes
+	 */
+	virtual void progress_notify(size_type count,size_type total);
+private:
+	/** Begin asynchronous copy from file.
+	 * @param pathname the pathname from which the data should be copied
+	 * @param estsize the estimated file size in bytes
+	 */
+	void begin_file(const string& pathname,size_type estsize);
+
+	/** Close file used for asynchronous copy, if there is one,
+	 * and cease to request null events.
+	 */
+	void close_file();
 };
 
 } /* namespace transfer */
@@ -3,6 +3,9 @@
 // Distribution and use are subject to the GNU Lesser General Public License,
 // a copy of which may be found in the file !RTK.Copyright.
 
+#include <cstring>
+#include <algorithm>
+
 #include "rtk/swi/wimp.h"
 #include "rtk/os/os.h"
 #include "rtk/os/wimp.h"
@@ -18,37 +21,56 @@
 namespace rtk {
 namespace transfer {
 
-std::string load_lines::null_sink::back() const
+load_lines::basic_sink::~basic_sink()
+{}
+
+load_lines::forward_sink::forward_sink(basic_sink& sink):
+	_sink(sink)
+{}
+
+void load_lines::forward_sink::push_back(const char* first,const char* last)
 {
-	return std::string();
+	_sink.push_back(first,last);
 }
 
-void load_lines::null_sink::push_back(const std::string& line)
-{}
+void load_lines::forward_sink::clear()
+{
+	_sink.clear();
+}
 
-void load_lines::null_sink::pop_back()
+void load_lines::null_sink::push_back(const char* first,const char* last)
 {}
 
 void load_lines::null_sink::clear()
 {}
 
-load_lines::load_lines(size_type buffer_size):
+load_lines::load_lines(size_type buffer_size,size_type max_buffer_size):
 	load(),
 	_sink(new null_sink),
 	_buffer(new char[buffer_size]),
 	_buffer_size(buffer_size),
-	_newline(true)
+	_min_buffer_size(buffer_size),
+	_max_buffer_size(std::max(buffer_size,max_buffer_size)),
+	_final_newline(true)
 {}
 
 load_lines::~load_lines()
 {
 	delete[] _buffer;
+	delete _sink;
 }
 
 void load_lines::start(size_type estsize)
 {
 	_sink->clear();
-	_newline=true;
+	_carry.erase();
+
+	// Choose a buffer size which is large enough to receive the whole
+	// of the data in one block if possible, within the permitted limits.
+	size_type buffer_size=_min_buffer_size;
+	if ((estsize!=npos)&&(estsize>buffer_size))
+		buffer_size=std::min(estsize,_max_buffer_size);
+	resize_buffer(buffer_size);
 }
 
 void load_lines::get_block(void** data,size_type* size)
@@ -59,47 +81,57 @@ void load_lines::get_block(void** data,size_type* size)
 
 void load_lines::put_block(size_type count)
 {
-	char* p=_buffer;
-	char* q=p;
-	for (size_type i=0;i!=count;++i)
+	const char* p=_buffer;
+	const char* end=_buffer+count;
+	while (const char* q=static_cast<const char*>(memchr(p,'\n',end-p)))
 	{
-		if (*p++=='\n')
+		if (_carry.length())
 		{
-			std::string s;
-			if (!_newline)
-			{
-				s+=_sink->back();
-				_sink->pop_back();
-			}
-			s+=std::string(q,p-1);
-			_sink->push_back(s);
-			q=p;
-			_newline=true;
+			// Complete the line held in the carry buffer.  Erasing
+			// the carry buffer (as opposed to replacing it) allows
+			// its capacity to be reused.
+			_carry.append(p,q);
+			const char* data=_carry.data();
+			_sink->push_back(data,data+_carry.length());
+			_carry.erase();
 		}
-	}
-	if (p!=q)
-	{
-		std::string s;
-		if (!_newline)
+		else
 		{
-			s+=_sink->back();
-			_sink->pop_back();
+			// Pass the line directly from the receive buffer.
+			_sink->push_back(p,q);
 		}
-		s+=std::string(q,p);
-		_sink->push_back(s);
-		q=p;
-		_newline=false;
+		p=q+1;
 	}
+
+	// Carry any incomplete line forward to the next block.
+	_carry.append(p,end);
 }
 
 void load_lines::finish()
-{}
+{
+	// Pass on any final line which is not terminated by a newline.
+	_final_newline=!_carry.length();
+	if (!_final_newline)
+	{
+		const char* data=_carry.data();
+		_sink->push_back(data,data+_carry.length());
+	}
+
+	// Release the carry buffer, and return the receive buffer to
+	// its minimum size.
+	std::string().swap(_carry);
+	resize_buffer(_min_buffer_size);
+}
+
+load_lines& load_lines::sink(basic_sink& sink)
+{
+	replace_sink(new forward_sink(sink));
+	return *this;
+}
 
 load_lines& load_lines::clear()
 {
-	basic_sink* null=new null_sink;
-	delete _sink;
-	_sink=null;
+	replace_sink(new null_sink);
 	return *this;
 }
 
@@ -114,5 +146,22 @@ load_lines& load_lines::final_newline(bool value)
 	return *this;
 }
 
+void load_lines::replace_sink(basic_sink* new_sink)
+{
+	delete _sink;
+	_sink=new_sink;
+}
+
+void load_lines::resize_buffer(size_type buffer_size)
+{
+	if (buffer_size!=_buffer_size)
+	{
+		char* new_buffer=new char[buffer_size];
+		delete[] _buffer;
+		_buffer=new_buffer;
+		_buffer_size=buffer_size;
+	}
+}
+
 } /* namespace transfer */
 } /* namespace rtk */
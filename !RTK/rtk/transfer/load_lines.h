@@ -15,34 +15,41 @@ namespace transfer {
 
 /** A class for loading lines of text.
  * Any standard container that supports push_back() and clear()
- * may be used to hold the result.
+ * may be used to hold the result.  Alternatively, lines may be passed
+ * to a user-supplied sink as spans of characters, avoiding the need
+ * for an intermediate string to be constructed for each line.
+ *
+ * Data is parsed into lines as it arrives.  A line which spans more
+ * than one block is accumulated in a carry buffer, and is passed to
+ * the sink only once it is complete, so the time taken is linear in
+ * the size of the data regardless of line length.  The size of the
+ * receive buffer is chosen when the transfer starts, using the
+ * estimated size of the data.
  */
 class load_lines:
 	public load
 {
-private:
+public:
 	/** An abstract base class to represent a line sink. */
 	class basic_sink
 	{
 	public:
-		/** Get final line.
-		 * It is an error if no lines have been appended.
-		 * @return the final line
+		/** Destroy line sink. */
+		virtual ~basic_sink();
+
+		/** Push line at back.
+		 * The characters are valid only for the duration of the call.
+		 * They do not include the terminating newline.
+		 * @param first a pointer to the first character of the line
+		 * @param last a pointer to one past the last character of
+		 *  the line
 		 */
-		virtual std::string back() const=0;
-
-		/** Push line at back
-		 * @param line the line to be pushed
-		 */
-		virtual void push_back(const std::string& line)=0;
-
-		/** Pop line at back. */
-		virtual void pop_back()=0;
+		virtual void push_back(const char* first,const char* last)=0;
 
 		/** Erase all lines. */
 		virtual void clear()=0;
 	};
-
+private:
 	/** A class to represent a container as a line sink. */
 	template<class container>
 	class push_back_sink:
@@ -58,9 +65,24 @@ private:
 		 */
 		push_back_sink(container& lines);
 
-		virtual std::string back() const;
-		virtual void push_back(const std::string& line);
-		virtual void pop_back();
+		virtual void push_back(const char* first,const char* last);
+		virtual void clear();
+	};
+
+	/** A class to forward lines to a user-supplied line sink. */
+	class forward_sink:
+		public basic_sink
+	{
+	private:
+		/** The sink to which lines are to be forwarded. */
+		basic_sink& _sink;
+	public:
+		/** Construct forwarding line sink.
+		 * @param sink the sink to which lines are to be forwarded
+		 */
+		forward_sink(basic_sink& sink);
+
+		virtual void push_back(const char* first,const char* last);
 		virtual void clear();
 	};
 
@@ -69,9 +91,7 @@ private:
 		public basic_sink
 	{
 	public:
-		virtual std::string back() const;
-		virtual void push_back(const std::string& line);
-		virtual void pop_back();
+		virtual void push_back(const char* first,const char* last);
 		virtual void clear();
 	};
 
@@ -86,11 +106,16 @@ private:
 	/** The size of _buffer. */
 	size_type _buffer_size;
 
-	/** The newline flag.
-	 * True if the next character parsed should begin a new line,
-	 * false if it should be appended to the previous line.
+	/** The minimum size of _buffer. */
+	size_type _min_buffer_size;
+
+	/** The maximum size of _buffer. */
+	size_type _max_buffer_size;
+
+	/** The carry buffer.
+	 * This holds the start of a line which has not yet been terminated.
 	 */
-	bool _newline;
+	std::string _carry;
 
 	/** The final newline flag.
 	 * True if the final line is terminated by a newline character,
@@ -98,8 +123,11 @@ private:
 	 */
 	bool _final_newline;
 public:
-	/** Construct load_lines object. */
-	load_lines(size_type buffer_size=0x400);
+	/** Construct load_lines object.
+	 * @param buffer_size the minimum size of the receive buffer
+	 * @param max_buffer_size the maximum size of the receive buffer
+	 */
+	load_lines(size_type buffer_size=0x400,size_type max_buffer_size=0x100000);
 
 	/** Destroy load_lines object. */
 	virtual ~load_lines();
@@ -116,10 +144,18 @@ public:
 	template<class container>
 	load_lines& lines(container& lines);
 
+	/** Set line sink.
+	 * The sink must remain valid until it is replaced or this object
+	 * is destroyed.
+	 * @param sink the sink to which lines are to be passed
+	 */
+	load_lines& sink(basic_sink& sink);
+
 	/** Clear line destination. */
 	load_lines& clear();
 
 	/** Get final newline flag.
+	 * This is set when a load operation finishes.
 	 * @return true if the final line is terminated by a newline character,
 	 *  otherwise false
 	 */
@@ -130,6 +166,17 @@ public:
 	 *  character, otherwise false
 	 */
 	load_lines& final_newline(bool value);
+private:
+	/** Replace line sink.
+	 * @param new_sink the new line sink, which becomes owned by this object
+	 */
+	void replace_sink(basic_sink* new_sink);
+
+	/** Resize receive buffer.
+	 * The content of the buffer is not preserved.
+	 * @param buffer_size the required size
+	 */
+	void resize_buffer(size_type buffer_size);
 };
 
 template<class container>
@@ -138,21 +185,10 @@ load_lines::push_back_sink<container>::push_back_sink(container& lines):
 {}
 
 template<class container>
-std::string load_lines::push_back_sink<container>::back() const
-{
-	return _lines.back();
-}
-
-template<class container>
-void load_lines::push_back_sink<container>::push_back(const std::string& line)
-{
-	_lines.push_back(line);
-}
-
-template<class container>
-void load_lines::push_back_sink<container>::pop_back()
+void load_lines::push_back_sink<container>::push_back(const char* first,
+	const char* last)
 {
-	_lines.pop_back();
+	_lines.push_back(std::string(first,last));
 }
 
 template<class container>
@@ -164,10 +200,7 @@ void load_lines::push_back_sink<container>::clear()
 template<class container>
 load_lines& load_lines::lines(container& lines)
 {
-	push_back_sink<container>* new_sink=
-		new push_back_sink<container>(lines);
-	delete _sink;
-	_sink=new_sink;
+	replace_sink(new push_back_sink<container>(lines));
 	return *this;
 }
 
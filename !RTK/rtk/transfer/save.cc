@@ -10,6 +10,7 @@
 #include "rtk/os/os.h"
 #include "rtk/os/wimp.h"
 #include "rtk/desktop/application.h"
+#include "rtk/desktop/progress_bar.h"
 #include "rtk/events/wimp.h"
 #include "rtk/events/message.h"
 #include "rtk/events/datasave.h"
@@ -26,6 +27,13 @@ namespace transfer {
 using std::min;
 using std::max;
 
+namespace {
+
+/** The default chunk size for asynchronous mode. */
+const save::size_type default_chunk_size=0x10000;
+
+} /* anonymous namespace */
+
 save::save():
 	_state(state_idle),
 	_thandle(0),
@@ -33,13 +41,22 @@ save::save():
 	_allow_ram_transfer(true),
 	_secure(false),
 	_ldata(0),
-	_lsize(0)
+	_lsize(0),
+	_asynchronous(false),
+	_chunk_size(default_chunk_size),
+	_fhandle(0),
+	_fcount(0),
+	_ftotal(0),
+	_freply(false),
+	_progress(0)
 {
 	os::Wimp_ReadSysInfo(5,&_thandle,0);
 }
 
 save::~save()
-{}
+{
+	close_file();
+}
 
 graphics::box save::min_bbox() const
 {
@@ -51,11 +68,23 @@ void save::handle_event(events::datasaveack& ev)
 	// A Message_DataSaveAck is acted upon in response to a Message_DataSave.
 	if (_state==state_datasave)
 	{
-		get_file(ev.pathname());
-		_pathname=ev.pathname();
-		_secure=ev.estsize()!=static_cast<size_type>(-1);
-		ev.reply();
-		_state=state_dataload;
+		if (_asynchronous&&parent_application())
+		{
+			// Keep a copy of the Message_DataSaveAck so that a
+			// Message_DataLoad can be sent once the file is complete.
+			unsigned int size=(ev.wimpblock().word[0]+3)>>2;
+			for (unsigned int i=0;i!=size;++i)
+				_datasaveack_block.word[i]=ev.wimpblock().word[i];
+			begin_file(ev.pathname(),true);
+		}
+		else
+		{
+			get_file(ev.pathname());
+			_pathname=ev.pathname();
+			_secure=ev.estsize()!=static_cast<size_type>(-1);
+			ev.reply();
+			_state=state_dataload;
+		}
 	}
 }
 
@@ -79,6 +108,7 @@ void save::handle_event(events::ramfetch& ev)
 	{
 		size_type rfree=ev.buffer_size();
 		void* rdata=ev.buffer();
+		block_size(rfree);
 		if (!_lsize) get_block(&_ldata,&_lsize);
 		while (rfree&&_lsize)
 		{
@@ -111,7 +141,10 @@ void save::handle_event(events::ramfetch& ev)
 
 void save::handle_event(events::save_to_app& ev)
 {
-	os::wimp_block& block=*new os::wimp_block;
+	// Abandon any asynchronous write that is in progress.
+	close_file();
+
+	os::wimp_block block;
 	block.word[3]=0;
 	block.word[4]=swi::Message_DataSave;
 	block.word[5]=ev.whandle();
@@ -135,18 +168,27 @@ void save::handle_event(events::save_to_app& ev)
 
 void save::handle_event(events::save_to_file& ev)
 {
+	close_file();
 	_pathname=string();
 	_secure=false;
-	get_file(ev.pathname());
-	_pathname=ev.pathname();
-	_secure=true;
-	_state=state_idle;
-	events::saved ev2(*this,*this);
-	ev2.post();
+	if (_asynchronous&&parent_application())
+	{
+		begin_file(ev.pathname(),false);
+	}
+	else
+	{
+		get_file(ev.pathname());
+		_pathname=ev.pathname();
+		_secure=true;
+		_state=state_idle;
+		events::saved ev2(*this,*this);
+		ev2.post();
+	}
 }
 
 void save::handle_event(events::datarequest& ev)
 {
+	close_file();
 	ev.reply(filetype(),estsize());
 	start();
 	_ldata=0;
@@ -162,12 +204,73 @@ save& save::filetype(unsigned int filetype)
 	return *this;
 }
 
+void save::handle_event(events::null_reason& ev)
+{
+	// Null events are acted upon while an asynchronous write is
+	// in progress.
+	if (_state==state_file)
+	{
+		try
+		{
+			// Write at most one chunk.
+			size_type count=0;
+			while (_lsize&&(count<_chunk_size))
+			{
+				size_type size=min(_lsize,_chunk_size-count);
+				os::OS_GBPB2(_fhandle,_ldata,size,0);
+				_ldata=static_cast<const char*>(_ldata)+size;
+				_lsize-=size;
+				count+=size;
+				if (!_lsize) get_block(&_ldata,&_lsize);
+			}
+			_fcount+=count;
+			progress_notify(_fcount,_ftotal);
+
+			if (!_lsize) end_file();
+		}
+		catch (...)
+		{
+			// Abandon the write, so that the error is reported once.
+			close_file();
+			_state=state_idle;
+			throw;
+		}
+	}
+}
+
 save& save::allow_ram_transfer(bool value)
 {
 	_allow_ram_transfer=value;
 	return *this;
 }
 
+save& save::asynchronous(bool value)
+{
+	_asynchronous=value;
+	return *this;
+}
+
+save& save::chunk_size(size_type size)
+{
+	_chunk_size=(size)?size:1;
+	return *this;
+}
+
+save& save::progress(desktop::progress_bar* pb)
+{
+	_progress=pb;
+	return *this;
+}
+
+void save::cancel()
+{
+	if (_state==state_file)
+	{
+		close_file();
+		_state=state_idle;
+	}
+}
+
 void save::deliver_wimp_block(int wimpcode,os::wimp_block& wimpblock)
 {
 	switch (wimpcode)
@@ -235,6 +338,9 @@ void save::deliver_message(int wimpcode,os::wimp_block& wimpblock)
 	}
 }
 
+void save::block_size(size_type size)
+{}
+
 void save::get_file(const string& pathname)
 {
 	start();
@@ -251,5 +357,65 @@ void save::get_file(const string& pathname)
 	finish();
 }
 
+void save::progress_notify(size_type count,size_type total)
+{
+	if (_progress) _progress->fraction(count,(total!=npos)?total:count);
+}
+
+void save::begin_file(const string& pathname,bool reply)
+{
+	// Abandon any write that is already in progress.
+	close_file();
+
+	start();
+	os::OS_Find(0x83,pathname.c_str(),0,&_fhandle);
+	_fpathname=pathname;
+	_fcount=0;
+	_ftotal=estsize();
+	_freply=reply;
+	_ldata=0;
+	_lsize=0;
+	block_size(_chunk_size);
+	get_block(&_ldata,&_lsize);
+	_state=state_file;
+	if (desktop::application* app=parent_application())
+		app->register_null(*this);
+	progress_notify(_fcount,_ftotal);
+}
+
+void save::end_file()
+{
+	close_file();
+	os::OS_File18(_fpathname.c_str(),filetype());
+	finish();
+	_pathname=_fpathname;
+	if (_freply)
+	{
+		// Send Message_DataLoad in reply to the Message_DataSaveAck.
+		events::datasaveack ev(*this,swi::User_Message,_datasaveack_block);
+		_secure=ev.estsize()!=static_cast<size_type>(-1);
+		ev.reply();
+		_state=state_dataload;
+	}
+	else
+	{
+		_secure=true;
+		_state=state_idle;
+		events::saved ev(*this,*this);
+		ev.post();
+	}
+}
+
+void save::close_file()
+{
+	if (_fhandle)
+	{
+		os::OS_Find0(_fhandle);
+		_fhandle=0;
+		if (desktop::application* app=parent_application())
+			app->deregister_null(*this);
+	}
+}
+
 } /* namespace transfer */
 } /* namespace rtk */
@@ -8,6 +8,7 @@
 
 #include <string>
 
+#include "rtk/os/wimp.h"
 #include "rtk/desktop/component.h"
 #include "rtk/events/datasaveack.h"
 #include "rtk/events/dataloadack.h"
@@ -15,14 +16,15 @@
 #include "rtk/events/save_to_app.h"
 #include "rtk/events/save_to_file.h"
 #include "rtk/events/datarequest.h"
+#include "rtk/events/null_reason.h"
 #include "rtk/events/redirection.h"
 
 namespace rtk {
-namespace os {
+namespace desktop {
 
-union wimp_block;
+class progress_bar;
 
-} /* namespace os */
+} /* namespace desktop */
 
 namespace transfer {
 
@@ -32,6 +34,12 @@ using std::string;
  * data transfer protocol.
  * Implementations must override start(), get(), finish() and estsize()
  * to define the source of the data.
+ *
+ * If asynchronous mode is enabled then data transferred as a file is
+ * written in chunks during null events, so that the desktop remains
+ * responsive while a large file is saved.  The same sequence of calls
+ * to start(), get() and finish() is made as in synchronous mode, but
+ * get_file() is bypassed.
  */
 class save:
 	public desktop::component,
@@ -41,6 +49,7 @@ class save:
 	public events::save_to_app::handler,
 	public events::save_to_file::handler,
 	public events::datarequest::handler,
+	public events::null_reason::handler,
 	public events::redirection
 {
 public:
@@ -67,7 +76,10 @@ private:
 		/** The state in which the save operation has sent an initial or
 		 * intermediate Message_RAMTransmit and is waiting for a
 		 * Message_RAMFetch. */
-		state_ramtransmit
+		state_ramtransmit,
+		/** The state in which the save operation is writing data to
+		 * a file during null events. */
+		state_file
 	};
 
 	/** The current state of the save operation. */
@@ -93,6 +105,42 @@ private:
 
 	/** The current local data buffer size. */
 	size_type _lsize;
+
+	/** The asynchronous mode flag. */
+	bool _asynchronous;
+
+	/** The maximum number of bytes to write per null event
+	 * in asynchronous mode. */
+	size_type _chunk_size;
+
+	/** The handle of the file being written in asynchronous mode,
+	 * or 0 if none. */
+	int _fhandle;
+
+	/** The pathname of the file being written in asynchronous mode. */
+	string _fpathname;
+
+	/** The number of bytes written so far in asynchronous mode. */
+	size_type _fcount;
+
+	/** The estimated number of bytes to be written in
+	 * asynchronous mode. */
+	size_type _ftotal;
+
+	/** The reply-required flag.
+	 * True if a Message_DataLoad should be sent once the file
+	 * has been written in asynchronous mode, otherwise false.
+	 */
+	bool _freply;
+
+	/** A copy of the Message_DataSaveAck message block.
+	 * This is needed to produce the Message_DataLoad that is sent
+	 * once the file has been written in asynchronous mode.
+	 */
+	os::wimp_block _datasaveack_block;
+
+	/** The progress bar to be updated, or 0 if none. */
+	desktop::progress_bar* _progress;
 public:
 	/** Construct save object. */
 	save();
@@ -108,6 +156,7 @@ public:
 	virtual void handle_event(events::save_to_app& ev);
 	virtual void handle_event(events::save_to_file& ev);
 	virtual void handle_event(events::datarequest& ev);
+	virtual void handle_event(events::null_reason& ev);
 
 	/** Get filetype.
 	 * @return the filetype of the data to be saved
@@ -152,6 +201,60 @@ public:
 	 */
 	save& allow_ram_transfer(bool value);
 
+	/** Get asynchronous mode flag.
+	 * @return true if asynchronous mode is enabled, otherwise false
+	 */
+	bool asynchronous() const
+		{ return _asynchronous; }
+
+	/** Set asynchronous mode flag.
+	 * Asynchronous mode has no effect unless this component is
+	 * descended from an application, since that is the source of
+	 * null events.
+	 * @param value true to enable asynchronous mode, otherwise false
+	 * @return a reference to this
+	 */
+	save& asynchronous(bool value);
+
+	/** Get chunk size.
+	 * @return the maximum number of bytes written per null event
+	 */
+	size_type chunk_size() const
+		{ return _chunk_size; }
+
+	/** Set chunk size.
+	 * @param size the maximum number of bytes to be written per
+	 *  null event in asynchronous mode
+	 * @return a reference to this
+	 */
+	save& chunk_size(size_type size);
+
+	/** Get progress bar.
+	 * @return the progress bar, or 0 if none
+	 */
+	desktop::progress_bar* progress() const
+		{ return _progress; }
+
+	/** Set progress bar.
+	 * If a progress bar is specified then the default implementation
+	 * of progress_notify() updates it as data is written.
+	 * @param pb the progress bar, or 0 for none
+	 * @return a reference to this
+	 */
+	save& progress(desktop::progress_bar* pb);
+
+	/** Determine whether an asynchronous write is in progress.
+	 * @return true if in progress, otherwise false
+	 */
+	bool busy() const
+		{ return _state==state_file; }
+
+	/** Cancel asynchronous write.
+	 * If a write is in progress then the file is closed, but not
+	 * deleted.  finish() is not called, and no saved event is posted.
+	 */
+	void cancel();
+
 	/** Deliver Wimp event block.
 	 * @internal
 	 * @param wimpcode the Wimp event code
@@ -181,6 +284,16 @@ protected:
 	 */
 	virtual void get_block(const void** data,size_type* count)=0;
 
+	/** Set preferred block size.
+	 * This is called before get_block() to indicate how much data the
+	 * recipient is able to accept at once.  Implementations may use it
+	 * to decide how much data to return from each call to get_block(),
+	 * but are not obliged to do so.  The default implementation does
+	 * nothing.
+	 * @param size the preferred block size in bytes
+	 */
+	virtual void block_size(size_type size);
+
 	/** Finish save operation. */
 	virtual void finish()=0;
 
@@ -198,6 +311,30 @@ protected:
 	 * @param pathname the pathname to which the data should be copied
 	 */
 	virtual void get_file(const string& pathname);
+
+	/** Notify progress of asynchronous write.
+	 * This is called when an asynchronous write begins, and after each
+	 * chunk has been written.  The default implementation updates the
+	 * progress bar, if there is one.
+	 * @param count the number of bytes written so far
+	 * @param total the estimated size of the data in bytes
+	 */
+	virtual void progress_notify(size_type count,size_type total);
+private:
+	/** Begin asynchronous write to file.
+	 * @param pathname the pathname to which the data should be written
+	 * @param reply true if a Message_DataLoad should be sent once the
+	 *  file has been written, otherwise false
+	 */
+	void begin_file(const string& pathname,bool reply);
+
+	/** Complete asynchronous write to file. */
+	void end_file();
+
+	/** Close file used for asynchronous write, if there is one,
+	 * and cease to request null events.
+	 */
+	void close_file();
 };
 
 } /* namespace transfer */
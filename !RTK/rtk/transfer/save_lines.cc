@@ -3,11 +3,30 @@
 // Distribution and use are subject to the GNU Lesser General Public License,
 // a copy of which may be found in the file !RTK.Copyright.
 
+#include <cstring>
+#include <algorithm>
+
 #include "rtk/transfer/save_lines.h"
 
 namespace rtk {
 namespace transfer {
 
+using std::min;
+using std::max;
+
+namespace {
+
+/** The block size used if the recipient does not specify one. */
+const save::size_type default_block_size=0x4000;
+
+/** The maximum size of the staging buffer. */
+const save::size_type max_block_size=0x100000;
+
+} /* anonymous namespace */
+
+save_lines::basic_source::~basic_source()
+{}
+
 std::string save_lines::null_source::operator()()
 {
 	return std::string();
@@ -28,75 +47,85 @@ save_lines::size_type save_lines::null_source::estsize() const
 
 save_lines::save_lines():
 	_source(new null_source),
+	_offset(0),
 	_eol(false),
+	_buffer(0),
+	_buffer_size(0),
+	_block_size(default_block_size),
 	_final_newline(true)
 {}
 
 save_lines::~save_lines()
 {
+	delete[] _buffer;
 	delete _source;
 }
 
 void save_lines::start()
 {
 	_source->reset();
+	_line.erase();
+	_offset=0;
 	_eol=false;
 }
 
 void save_lines::get_block(const void** data,size_type* count)
 {
-	if (_eol)
-	{
-		// A line has been sent but the corresponding newline has not.
-		static char linefeed='\n';
-		if (data) *data=&linefeed;
-		if (count) *count=1;
-		_eol=false;
-	}
-	else if (!_source->eof())
-	{
-		// Fetch line from source.
-		const std::string& s=(*_source)();
+	// Ensure that the staging buffer matches the preferred block size.
+	resize_buffer(_block_size);
 
-		// Decide whether line is terminated by a newline character.
-		bool has_newline=_final_newline||!_source->eof();
-
-		if (s.length())
+	// Fill the staging buffer from the source.
+	char* p=_buffer;
+	size_type free=_buffer_size;
+	while (free)
+	{
+		if (_offset!=_line.length())
 		{
-			// Line was not empty.
-			if (data) *data=s.data();
-			if (count) *count=s.length();
-			_eol=has_newline;
+			// Copy as much of the current line as will fit.
+			size_type n=min(free,size_type(_line.length()-_offset));
+			memcpy(p,_line.data()+_offset,n);
+			p+=n;
+			free-=n;
+			_offset+=n;
 		}
-		else if (has_newline)
+		else if (_eol)
 		{
-			// Line was empty but has a newline.
-			// Cannot return a block of length 0 (because that would
-			// terminate the save operation), so must return a newline
-			// now.
-			static char linefeed='\n';
-			if (data) *data=&linefeed;
-			if (count) *count=1;
+			// Append the newline which terminates the current line.
+			*p++='\n';
+			--free;
 			_eol=false;
 		}
-		else
+		else if (!_source->eof())
 		{
-			// Line was empty and does not have a newline.  It must be
-			// the final line, so finish by returning an empty block.
-			if (data) *data=0;
-			if (count) *count=0;
+			// Fetch the next line from the source, and decide whether
+			// it is terminated by a newline character.  (A copy is made
+			// so that it remains valid for as long as it is needed.)
+			_line=(*_source)();
+			_offset=0;
+			_eol=_final_newline||!_source->eof();
 		}
+		else break;
 	}
-	else
-	{
-		// If finished then return an empty block.
-		if (data) *data=0;
-		if (count) *count=0;
-	}
+
+	// Return the content of the staging buffer.  This will be empty
+	// only if there is no more data.
+	if (data) *data=_buffer;
+	if (count) *count=_buffer_size-free;
+}
+
+void save_lines::block_size(size_type size)
+{
+	_block_size=max(min(size,max_block_size),size_type(1));
 }
 
 void save_lines::finish()
-{}
+{
+	// Release the current line and the staging buffer.
+	string().swap(_line);
+	_offset=0;
+	resize_buffer(0);
+	_block_size=default_block_size;
+}
 
 save_lines::size_type save_lines::estsize()
 {
@@ -122,5 +151,16 @@ save_lines& save_lines::final_newline(bool value)
 	return *this;
 }
 
+void save_lines::resize_buffer(size_type buffer_size)
+{
+	if (buffer_size!=_buffer_size)
+	{
+		char* new_buffer=(buffer_size)?new char[buffer_size]:0;
+		delete[] _buffer;
+		_buffer=new_buffer;
+		_buffer_size=buffer_size;
+	}
+}
+
 } /* namespace transfer */
 } /* namespace rtk */
@@ -19,6 +19,10 @@ namespace transfer {
  * that the container must not change while the save operation is in
  * progress (or at least, not in a way that might invalidate iterators
  * that point into the specified sequence.)
+ *
+ * Lines and their terminating newline characters are packed into a
+ * staging buffer, so that each block returned by get_block() contains
+ * as many lines as the recipient is able to accept.
  */
 class save_lines:
 	public save
@@ -28,6 +32,9 @@ private:
 	class basic_source
 	{
 	public:
+		/** Destroy line source. */
+		virtual ~basic_source();
+
 		/** Get next line from source.
 		 * @return the next line from the source
 		 */
@@ -87,12 +94,27 @@ private:
 	/** The sequence of lines. */
 	basic_source* _source;
 
+	/** A copy of the line currently being saved. */
+	string _line;
+
+	/** The number of characters of _line which have been saved. */
+	size_type _offset;
+
 	/** The end-of-line flag.
-	 * When true, a line of text has been saved but the associated newline
-	 * character has not.
+	 * When true, the current line is terminated by a newline character
+	 * which has not yet been saved.
 	 */
 	bool _eol;
 
+	/** The staging buffer. */
+	char* _buffer;
+
+	/** The size of _buffer. */
+	size_type _buffer_size;
+
+	/** The preferred block size. */
+	size_type _block_size;
+
 	/** The final newline flag.
 	 * True if the final line is terminated by a newline character,
 	 * otherwise false
@@ -109,6 +131,7 @@ public:
 protected:
 	virtual void start();
 	virtual void get_block(const void** data,size_type* count);
+	virtual void block_size(size_type size);
 	virtual void finish();
 	virtual size_type estsize();
 public:
@@ -135,6 +158,12 @@ public:
 	 *  character, otherwise false
 	 */
 	save_lines& final_newline(bool value);
+private:
+	/** Resize staging buffer.
+	 * The content of the buffer is not preserved.
+	 * @param buffer_size the required size
+	 */
+	void resize_buffer(size_type buffer_size);
 };
 
 template<class iterator>
@@ -0,0 +1,85 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#include <cstring>
+
+#include "rtk/util/byte_search.h"
+
+namespace rtk {
+namespace util {
+
+const unsigned int byte_search::npos;
+
+const unsigned int byte_search::horspool_threshold;
+
+byte_search::byte_search()
+{}
+
+byte_search::byte_search(const string& needle):
+	_needle(needle)
+{
+	// Build the skip table.  The distance for a byte is measured from
+	// its last occurrence in the pattern (excluding the final byte)
+	// to the end of the pattern.
+	unsigned int size=_needle.size();
+	if (size>=horspool_threshold)
+	{
+		for (unsigned int i=0;i!=256;++i) _skip[i]=size;
+		for (unsigned int i=0;i!=size-1;++i)
+			_skip[(unsigned char)_needle[i]]=size-1-i;
+	}
+}
+
+unsigned int byte_search::find(const char* data,unsigned int size,
+	unsigned int index) const
+{
+	unsigned int nsize=_needle.size();
+	if ((!nsize)||(index>size)||(nsize>size-index)) return npos;
+	const char* needle=_needle.data();
+	unsigned int limit=size-nsize;
+
+	if (nsize<horspool_threshold)
+	{
+		// Use memchr to find each candidate for the first byte,
+		// then compare the remainder of the pattern.
+		while (index<=limit)
+		{
+			const char* p=static_cast<const char*>(
+				std::memchr(data+index,needle[0],limit-index+1));
+			if (!p) return npos;
+			index=p-data;
+			if (!std::memcmp(p+1,needle+1,nsize-1)) return index;
+			++index;
+		}
+		return npos;
+	}
+
+	// Compare the last byte of the pattern first, and if there is no
+	// match then skip according to the byte found.
+	unsigned int last=nsize-1;
+	while (index<=limit)
+	{
+		char c=data[index+last];
+		if ((c==needle[last])&&!std::memcmp(data+index,needle,last))
+			return index;
+		index+=_skip[(unsigned char)c];
+	}
+	return npos;
+}
+
+unsigned int byte_search::count(const char* data,unsigned int size) const
+{
+	unsigned int count=0;
+	unsigned int index=find(data,size,0);
+	while (index!=npos)
+	{
+		++count;
+		index=find(data,size,index+_needle.size());
+	}
+	return count;
+}
+
+} /* namespace util */
+} /* namespace rtk */
@@ -0,0 +1,83 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#ifndef _RTK_UTIL_BYTE_SEARCH
+#define _RTK_UTIL_BYTE_SEARCH
+
+#include <string>
+
+namespace rtk {
+namespace util {
+
+using std::string;
+
+/** A class for searching a sequence of bytes for a fixed pattern.
+ * Short patterns are found by using memchr() to locate candidates for
+ * the first byte, then comparing the remainder.  Longer patterns are
+ * found using the Boyer-Moore-Horspool algorithm, which can skip up to
+ * the length of the pattern after each comparison.
+ *
+ * An empty pattern does not match anything.
+ */
+class byte_search
+{
+public:
+	/** A value returned by find() to indicate that there is no match. */
+	static const unsigned int npos=~0U;
+private:
+	/** The pattern length at and above which Horspool skips are used. */
+	static const unsigned int horspool_threshold=4;
+
+	/** The pattern. */
+	string _needle;
+
+	/** The Horspool skip distance for each byte value.
+	 * This is only valid if the pattern is at least horspool_threshold
+	 * bytes long.
+	 */
+	unsigned int _skip[256];
+public:
+	/** Construct byte search with empty pattern. */
+	byte_search();
+
+	/** Construct byte search.
+	 * @param needle the pattern
+	 */
+	explicit byte_search(const string& needle);
+
+	/** Get pattern.
+	 * @return the pattern
+	 */
+	const string& needle() const
+		{ return _needle; }
+
+	/** Test whether pattern is empty.
+	 * @return true if the pattern is empty, otherwise false
+	 */
+	bool empty() const
+		{ return _needle.empty(); }
+
+	/** Find first match.
+	 * @param data the bytes to be searched
+	 * @param size the number of bytes to be searched
+	 * @param index the index at which to begin searching
+	 * @return the index of the first match at or after index,
+	 *  or npos if there is none
+	 */
+	unsigned int find(const char* data,unsigned int size,
+		unsigned int index=0) const;
+
+	/** Count non-overlapping matches.
+	 * @param data the bytes to be searched
+	 * @param size the number of bytes to be searched
+	 * @return the number of matches
+	 */
+	unsigned int count(const char* data,unsigned int size) const;
+};
+
+} /* namespace util */
+} /* namespace rtk */
+
+#endif
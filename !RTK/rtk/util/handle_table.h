@@ -0,0 +1,292 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#ifndef _RTK_UTIL_HANDLE_TABLE
+#define _RTK_UTIL_HANDLE_TABLE
+
+#include <vector>
+
+namespace rtk {
+namespace util {
+
+/** Calculate hash value for integer handle.
+ * RISC OS window handles are typically word-aligned addresses,
+ * so the low-order bits must not be relied upon.
+ * @param key the handle
+ * @return the hash value
+ */
+inline unsigned int handle_hash(int key)
+{
+	unsigned int h=static_cast<unsigned int>(key)*0x9e3779b1U;
+	return h^(h>>16);
+}
+
+/** Calculate hash value for pointer handle.
+ * @param key the pointer
+ * @return the hash value
+ */
+inline unsigned int handle_hash(const void* key)
+{
+	unsigned int h=static_cast<unsigned int>(
+		reinterpret_cast<unsigned long>(key))*0x9e3779b1U;
+	return h^(h>>16);
+}
+
+/** A class for mapping handles to values using an open-addressed
+ * hash table.
+ * Lookup, insertion and erasure execute in O(1) expected time.
+ * Collisions are resolved by linear probing, and erasure shifts
+ * subsequent entries backwards so that no tombstones are needed.
+ *
+ * The key type must be one for which a handle_hash() function
+ * exists (as is the case for int and pointer types).
+ */
+template<class key_type,class value_type>
+class handle_table
+{
+public:
+	/** A type for representing the number of entries. */
+	typedef unsigned int size_type;
+
+	/** A type for representing one entry in the table. */
+	struct slot
+	{
+		/** The key. */
+		key_type key;
+		/** The value. */
+		value_type value;
+		/** True if this slot is in use, otherwise false. */
+		bool used;
+	};
+
+	class const_iterator;
+private:
+	/** The slots, the number of which is zero or a power of two. */
+	std::vector<slot> _slots;
+
+	/** The number of slots in use. */
+	size_type _size;
+public:
+	/** Construct empty handle table. */
+	handle_table();
+
+	/** Find value corresponding to key.
+	 * @param key the key
+	 * @return a pointer to the value, or 0 if the key is not present
+	 */
+	const value_type* find(const key_type& key) const;
+
+	/** Insert or replace entry.
+	 * @param key the key
+	 * @param value the value
+	 */
+	void insert(const key_type& key,const value_type& value);
+
+	/** Erase entry.
+	 * @param key the key
+	 * @return true if the key was present, otherwise false
+	 */
+	bool erase(const key_type& key);
+
+	/** Erase all entries. */
+	void clear();
+
+	/** Get number of entries.
+	 * @return the number of entries
+	 */
+	size_type size() const
+		{ return _size; }
+
+	/** Get const iterator for start of table.
+	 * Entries are visited in no particular order.
+	 * @return the iterator
+	 */
+	const_iterator begin() const;
+
+	/** Get const iterator for end of table.
+	 * @return the iterator
+	 */
+	const_iterator end() const;
+private:
+	/** Find slot index for key.
+	 * The table must contain at least one unused slot.
+	 * @param key the key
+	 * @return the index of the slot containing the key if it is
+	 *  present, otherwise the index of the slot where it should go
+	 */
+	size_type probe(const key_type& key) const;
+
+	/** Change number of slots.
+	 * All existing entries are reinserted.
+	 * @param capacity the required number of slots (a power of two)
+	 */
+	void rehash(size_type capacity);
+};
+
+/** A const iterator class for handle_table. */
+template<class key_type,class value_type>
+class handle_table<key_type,value_type>::const_iterator
+{
+private:
+	/** A pointer to the current slot. */
+	const slot* _p;
+
+	/** A pointer to the end of the slots. */
+	const slot* _end;
+public:
+	/** Construct iterator.
+	 * The iterator is advanced to the first slot in use.
+	 * @param p a pointer to the initial slot
+	 * @param end a pointer to the end of the slots
+	 */
+	const_iterator(const slot* p,const slot* end):
+		_p(p),_end(end)
+		{ while ((_p!=_end)&&!_p->used) ++_p; }
+
+	/** Dereference iterator.
+	 * @return a reference to the current slot
+	 */
+	const slot& operator*() const
+		{ return *_p; }
+
+	/** Advance iterator to next slot in use.
+	 * @return a reference to this
+	 */
+	const_iterator& operator++()
+		{ do ++_p; while ((_p!=_end)&&!_p->used); return *this; }
+
+	/** Test for equality.
+	 * @param that the iterator with which to compare
+	 * @return true if equal, otherwise false
+	 */
+	bool operator==(const const_iterator& that) const
+		{ return _p==that._p; }
+
+	/** Test for inequality.
+	 * @param that the iterator with which to compare
+	 * @return true if not equal, otherwise false
+	 */
+	bool operator!=(const const_iterator& that) const
+		{ return _p!=that._p; }
+};
+
+template<class key_type,class value_type>
+handle_table<key_type,value_type>::handle_table():
+	_size(0)
+{}
+
+template<class key_type,class value_type>
+const value_type* handle_table<key_type,value_type>::find(
+	const key_type& key) const
+{
+	if (!_size) return 0;
+	const slot& s=_slots[probe(key)];
+	return (s.used)?&s.value:0;
+}
+
+template<class key_type,class value_type>
+void handle_table<key_type,value_type>::insert(const key_type& key,
+	const value_type& value)
+{
+	// Keep the load factor at or below 3/4, so that probe sequences
+	// remain short and there is always at least one unused slot.
+	if ((_size+1)*4>_slots.size()*3)
+	{
+		rehash((_slots.size())?_slots.size()*2:16);
+	}
+
+	slot& s=_slots[probe(key)];
+	if (!s.used)
+	{
+		s.key=key;
+		s.used=true;
+		++_size;
+	}
+	s.value=value;
+}
+
+template<class key_type,class value_type>
+bool handle_table<key_type,value_type>::erase(const key_type& key)
+{
+	if (!_size) return false;
+	size_type mask=_slots.size()-1;
+	size_type i=probe(key);
+	if (!_slots[i].used) return false;
+
+	// Shift back any subsequent entries in the same cluster which
+	// would otherwise become unreachable.
+	size_type j=i;
+	while (true)
+	{
+		j=(j+1)&mask;
+		if (!_slots[j].used) break;
+		size_type k=handle_hash(_slots[j].key)&mask;
+		// Entry j may be moved to hole i unless its home slot k
+		// lies cyclically within the range (i,j].
+		if ((i<=j)?((i<k)&&(k<=j)):((i<k)||(k<=j))) continue;
+		_slots[i]=_slots[j];
+		i=j;
+	}
+	_slots[i].used=false;
+	_slots[i].value=value_type();
+	--_size;
+	return true;
+}
+
+template<class key_type,class value_type>
+void handle_table<key_type,value_type>::clear()
+{
+	_slots.clear();
+	_size=0;
+}
+
+template<class key_type,class value_type>
+class handle_table<key_type,value_type>::const_iterator
+handle_table<key_type,value_type>::begin() const
+{
+	const slot* p=(_slots.size())?&_slots[0]:0;
+	return const_iterator(p,p+_slots.size());
+}
+
+template<class key_type,class value_type>
+class handle_table<key_type,value_type>::const_iterator
+handle_table<key_type,value_type>::end() const
+{
+	const slot* p=(_slots.size())?&_slots[0]:0;
+	return const_iterator(p+_slots.size(),p+_slots.size());
+}
+
+template<class key_type,class value_type>
+typename handle_table<key_type,value_type>::size_type
+handle_table<key_type,value_type>::probe(const key_type& key) const
+{
+	size_type mask=_slots.size()-1;
+	size_type i=handle_hash(key)&mask;
+	while (_slots[i].used&&!(_slots[i].key==key)) i=(i+1)&mask;
+	return i;
+}
+
+template<class key_type,class value_type>
+void handle_table<key_type,value_type>::rehash(size_type capacity)
+{
+	slot empty;
+	empty.key=key_type();
+	empty.value=value_type();
+	empty.used=false;
+
+	std::vector<slot> slots(capacity,empty);
+	slots.swap(_slots);
+	_size=0;
+	for (typename std::vector<slot>::const_iterator i=slots.begin();
+		i!=slots.end();++i)
+	{
+		if ((*i).used) insert((*i).key,(*i).value);
+	}
+}
+
+} /* namespace util */
+} /* namespace rtk */
+
+#endif
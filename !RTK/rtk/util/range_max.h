@@ -0,0 +1,256 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#ifndef _RTK_UTIL_RANGE_MAX
+#define _RTK_UTIL_RANGE_MAX
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace rtk {
+namespace util {
+
+/** A class for quickly calculating the maximum of a range of elements.
+ * Elements may be indexed using operator[].  It is also possible to
+ * obtain the maximum value within a given range of indices.  Both of
+ * these operations execute in O(log n) time.  Insertion and erasure
+ * execute in O(n) time.
+ *
+ * The value type must be one for which std::numeric_limits<>::min()
+ * is the lowest possible value (as is the case for integral types).
+ */
+template<class value_type>
+class range_max
+{
+public:
+	/** The type of the index of an element. */
+	typedef unsigned int index_type;
+private:
+	/** The number of elements. */
+	index_type _size;
+
+	/** A vector of partial maxima, arranged as a binary tree.
+	 * Element 1 is the root and the children of element i are
+	 * elements 2i and 2i+1.  The second half of the vector contains
+	 * the elements themselves, padded with the lowest possible value.
+	 * Element 0 is unused.
+	 */
+	std::vector<value_type> _values;
+
+	class reference_type;
+public:
+	/** Construct range maximum object. */
+	range_max();
+
+	/** Index into range maximum object.
+	 * Note that the result is a helper object, as opposed to a
+	 * true reference.
+	 */
+	reference_type operator[](index_type index);
+
+	/** Get maximum value within a given range of indices.
+	 * A std::out_of_range exception is thrown if first>last or
+	 * last>size().  If the range is empty then the result is the
+	 * lowest possible value.
+	 * @param first the first index (inclusive)
+	 * @param last the last index (exclusive)
+	 * @return the maximum value
+	 */
+	value_type max(index_type first,index_type last) const;
+
+	/** Erase elements.
+	 * @param first the first element to be erased
+	 * @param last the last element plus one to be erased
+	 */
+	void erase(unsigned int first,unsigned int last);
+
+	/** Insert elements.
+	 * @param pos the index at which to insert
+	 * @param count the number of elements to insert
+	 * @param value the value of the elements to insert
+	 */
+	void insert(unsigned int pos,unsigned int count,value_type value);
+
+	/** Get number of elements.
+	 * @return the number of elements
+	 */
+	index_type size() const
+		{ return _size; }
+
+	/** Set number of elements.
+	 * Any new elements are given the lowest possible value.
+	 * @param size the required number of elements
+	 */
+	void resize(index_type size);
+private:
+	/** Replace elements.
+	 * The tree is rebuilt from scratch.
+	 * @param values the required values of the elements
+	 */
+	void assign(const std::vector<value_type>& values);
+
+	/** Get elements.
+	 * @return a vector containing the values of the elements
+	 */
+	std::vector<value_type> elements() const;
+};
+
+/** A helper class for use by range_max<>::operator[]. */
+template<class value_type>
+class range_max<value_type>::reference_type
+{
+private:
+	/** A reference to the vector of partial maxima. */
+	std::vector<value_type>& _values;
+
+	/** The index of the element to which this object refers. */
+	index_type _index;
+public:
+	/** Create helper object.
+	 * @param values the vector of partial maxima
+	 * @param index the index of the element to which this object refers
+	 */
+	reference_type(std::vector<value_type>& values,index_type index);
+
+	/** Set value of element.
+	 * @param value the required value of the element
+	 */
+	reference_type& operator=(const value_type& value);
+
+	/** Get value of element.
+	 * @return the value of the element
+	 */
+	operator value_type() const;
+};
+
+template<class value_type>
+range_max<value_type>::range_max():
+	_size(0),
+	_values(2,std::numeric_limits<value_type>::min())
+{}
+
+template<class value_type>
+class range_max<value_type>::reference_type
+range_max<value_type>::operator[](index_type index)
+{
+	if (index>=_size)
+	{
+		throw std::out_of_range(
+			"index out of range in rtk::util::range_max");
+	}
+	return reference_type(_values,index);
+}
+
+template<class value_type>
+value_type range_max<value_type>::max(index_type first,index_type last) const
+{
+	if ((first>last)||(last>_size)) throw std::out_of_range(
+		"index out of range in rtk::util::range_max");
+
+	// Work upwards from the leaves, accumulating the maxima of any
+	// subtrees which lie wholly within the range.
+	value_type value=std::numeric_limits<value_type>::min();
+	index_type leaves=_values.size()/2;
+	index_type i=first+leaves;
+	index_type j=last+leaves;
+	while (i<j)
+	{
+		if (i&1) value=std::max(value,_values[i++]);
+		if (j&1) value=std::max(value,_values[--j]);
+		i>>=1;
+		j>>=1;
+	}
+	return value;
+}
+
+template<class value_type>
+void range_max<value_type>::erase(unsigned int first,unsigned int last)
+{
+	if ((first>last)||(last>_size)) throw std::out_of_range(
+		"index out of range in rtk::util::range_max");
+	std::vector<value_type> values(elements());
+	values.erase(values.begin()+first,values.begin()+last);
+	assign(values);
+}
+
+template<class value_type>
+void range_max<value_type>::insert(unsigned int pos,unsigned int count,
+	value_type value)
+{
+	if (pos>_size) throw std::out_of_range(
+		"index out of range in rtk::util::range_max");
+	std::vector<value_type> values(elements());
+	values.insert(values.begin()+pos,count,value);
+	assign(values);
+}
+
+template<class value_type>
+void range_max<value_type>::resize(index_type size)
+{
+	std::vector<value_type> values(elements());
+	values.resize(size,std::numeric_limits<value_type>::min());
+	assign(values);
+}
+
+template<class value_type>
+void range_max<value_type>::assign(const std::vector<value_type>& values)
+{
+	// Choose a number of leaves which is a power of two.
+	index_type leaves=1;
+	while (leaves<values.size()) leaves<<=1;
+
+	// Copy the elements into the leaves, then calculate
+	// the partial maxima.
+	_size=values.size();
+	_values.assign(leaves*2,std::numeric_limits<value_type>::min());
+	std::copy(values.begin(),values.end(),_values.begin()+leaves);
+	for (index_type i=leaves-1;i!=0;--i)
+	{
+		_values[i]=std::max(_values[i*2],_values[i*2+1]);
+	}
+}
+
+template<class value_type>
+std::vector<value_type> range_max<value_type>::elements() const
+{
+	index_type leaves=_values.size()/2;
+	return std::vector<value_type>(_values.begin()+leaves,
+		_values.begin()+leaves+_size);
+}
+
+template<class value_type>
+range_max<value_type>::reference_type::reference_type(
+	std::vector<value_type>& values,index_type index):
+	_values(values),
+	_index(index)
+{}
+
+template<class value_type>
+class range_max<value_type>::reference_type&
+range_max<value_type>::reference_type::operator=(const value_type& value)
+{
+	// Update the leaf, then the partial maxima above it.
+	index_type i=_values.size()/2+_index;
+	_values[i]=value;
+	while (i>1)
+	{
+		i>>=1;
+		_values[i]=std::max(_values[i*2],_values[i*2+1]);
+	}
+	return *this;
+}
+
+template<class value_type>
+range_max<value_type>::reference_type::operator value_type() const
+{
+	return _values[_values.size()/2+_index];
+}
+
+} /* namespace util */
+} /* namespace rtk */
+
+#endif
@@ -0,0 +1,312 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+#include "rtk/util/text_buffer.h"
+
+namespace rtk {
+namespace util {
+
+namespace {
+
+/** The nominal size of a block, in bytes.
+ * A block is split when it reaches twice this size, and merged with
+ * its successor when the two together are no larger than this size.
+ */
+const unsigned int block_size=0x4000;
+
+} /* anonymous namespace */
+
+text_buffer::text_buffer()
+{
+	std::auto_ptr<block> b(new block);
+	b->data.push_back('\n');
+	_blocks.push_back(b.get());
+	b.release();
+	_block_paras.insert(0,1,1);
+	_lengths.insert(0,1,1);
+}
+
+text_buffer::~text_buffer()
+{
+	for (std::vector<block*>::iterator i=_blocks.begin();
+		i!=_blocks.end();++i)
+	{
+		delete *i;
+	}
+}
+
+unsigned int text_buffer::para(unsigned int offset) const
+{
+	unsigned int para=_lengths.find(offset);
+	if (para>=size()) para=size()-1;
+	return para;
+}
+
+char text_buffer::at(unsigned int para,unsigned int index) const
+{
+	unsigned int b=block_of(para);
+	const block& bk=*_blocks[b];
+	return bk.data[bk.physical(offset(para,index)-block_offset(b))];
+}
+
+text_buffer::view text_buffer::operator[](unsigned int para) const
+{
+	if (para>=size()) throw std::out_of_range(
+		"index out of range in rtk::util::text_buffer");
+
+	// If the gap lies within the paragraph then move it to
+	// whichever end is nearer.
+	unsigned int b=block_of(para);
+	block& bk=*_blocks[b];
+	unsigned int first=offset(para)-block_offset(b);
+	unsigned int last=first+length(para);
+	if ((bk.gap>first)&&(bk.gap<last))
+	{
+		bk.move_gap((bk.gap-first<last-bk.gap)?first:last);
+	}
+	return view(&bk.data[bk.physical(first)],last-first);
+}
+
+void text_buffer::splice(unsigned int first_para,unsigned int first_index,
+	unsigned int last_para,unsigned int last_index,
+	const string& text,std::vector<unsigned int>& lengths)
+{
+	if ((first_para>last_para)||(last_para>=size())||
+		(first_index>length(first_para))||(last_index>length(last_para)))
+	{
+		throw std::out_of_range(
+			"index out of range in rtk::util::text_buffer");
+	}
+
+	// Locate the region to be replaced.  The first and last
+	// paragraphs may lie in different blocks.
+	unsigned int first_block=block_of(first_para);
+	unsigned int last_block=block_of(last_para);
+	unsigned int first_offset=offset(first_para,first_index)-
+		block_offset(first_block);
+	unsigned int last_offset=offset(last_para,last_index)-
+		block_offset(last_block);
+	if ((first_block==last_block)&&(first_offset>last_offset))
+	{
+		throw std::out_of_range(
+			"index out of range in rtk::util::text_buffer");
+	}
+	unsigned int old_paras=last_para-first_para+1;
+	unsigned int new_paras=lengths.size();
+	unsigned int block_paras=_block_paras.sum(last_block+1)-
+		_block_paras.sum(first_block)-old_paras+new_paras;
+
+	// Replace the characters.  The separator which follows the last
+	// paragraph is retained, so the separator which follows the last
+	// replacement paragraph is not inserted.
+	block& bk=*_blocks[first_block];
+	unsigned int count=text.size()-1;
+	unsigned int suffix=length(last_para)-last_index;
+	if (first_block==last_block)
+	{
+		bk.move_gap(first_offset);
+		bk.reserve_gap(count);
+		bk.gap_size+=last_offset-first_offset;
+	}
+	else
+	{
+		// Discard the remainder of the first block, then append the
+		// remainder of the last block after the gap.  Any blocks in
+		// between are discarded.
+		block& lbk=*_blocks[last_block];
+		lbk.move_gap(last_offset);
+		unsigned int tail=lbk.size()-last_offset;
+		bk.move_gap(first_offset);
+		unsigned int required=first_offset+count+tail;
+		if (bk.data.size()<required)
+		{
+			bk.data.resize(std::max(bk.data.size()*2,
+				static_cast<std::vector<char>::size_type>(required)));
+		}
+		bk.gap_size=bk.data.size()-bk.gap;
+		std::copy(lbk.data.end()-tail,lbk.data.end(),bk.data.end()-tail);
+		bk.gap_size-=tail;
+		for (unsigned int i=first_block+1;i<=last_block;++i)
+		{
+			delete _blocks[i];
+		}
+		_blocks.erase(_blocks.begin()+first_block+1,
+			_blocks.begin()+last_block+1);
+		_block_paras.erase(first_block+1,last_block+1);
+	}
+	std::copy(text.begin(),text.begin()+count,bk.data.begin()+bk.gap);
+	bk.gap+=count;
+	bk.gap_size-=count;
+	_block_paras[first_block]=block_paras;
+
+	// Add the retained prefix and suffix to the lengths of the
+	// first and last replacement paragraphs.
+	lengths.front()+=first_index;
+	lengths.back()+=suffix;
+
+	// Update the paragraph lengths.  Where the number of paragraphs
+	// is unchanged (as when editing within a paragraph) the lengths
+	// are assigned in place.
+	unsigned int common=std::min(old_paras,new_paras);
+	for (unsigned int i=0;i!=common;++i)
+	{
+		_lengths[first_para+i]=lengths[i];
+	}
+	if (new_paras<old_paras)
+	{
+		_lengths.erase(first_para+new_paras,first_para+old_paras);
+	}
+	else if (new_paras>old_paras)
+	{
+		unsigned int pos=first_para+old_paras;
+		_lengths.insert(pos,new_paras-old_paras,0);
+		for (unsigned int i=old_paras;i!=new_paras;++i)
+		{
+			_lengths[first_para+i]=lengths[i];
+		}
+	}
+
+	// Keep the block close to its nominal size.
+	split_block(first_block);
+	merge_block(first_block);
+	if (first_block) merge_block(first_block-1);
+}
+
+void text_buffer::split_block(unsigned int b)
+{
+	block& bk=*_blocks[b];
+	if (bk.size()<block_size*2) return;
+
+	// Divide the paragraphs into groups of approximately the nominal
+	// size.  A paragraph is never divided.
+	unsigned int first_para=_block_paras.sum(b);
+	unsigned int last_para=_block_paras.sum(b+1);
+	std::vector<unsigned int> counts;
+	std::vector<unsigned int> sizes;
+	unsigned int count=0;
+	unsigned int size=0;
+	for (unsigned int i=first_para;i!=last_para;++i)
+	{
+		unsigned int len=length(i)+1;
+		if (count&&(size+len>block_size))
+		{
+			counts.push_back(count);
+			sizes.push_back(size);
+			count=0;
+			size=0;
+		}
+		++count;
+		size+=len;
+	}
+	counts.push_back(count);
+	sizes.push_back(size);
+	if (counts.size()==1) return;
+
+	// Copy each group other than the first into a new block.
+	bk.move_gap(bk.size());
+	std::vector<block*> blocks;
+	try
+	{
+		unsigned int offset=sizes[0];
+		for (unsigned int i=1;i!=sizes.size();++i)
+		{
+			std::auto_ptr<block> nb(new block);
+			nb->data.assign(bk.data.begin()+offset,
+				bk.data.begin()+offset+sizes[i]);
+			nb->gap=sizes[i];
+			blocks.push_back(nb.get());
+			nb.release();
+			offset+=sizes[i];
+		}
+		_blocks.insert(_blocks.begin()+b+1,blocks.begin(),blocks.end());
+	}
+	catch (...)
+	{
+		for (unsigned int i=0;i!=blocks.size();++i) delete blocks[i];
+		throw;
+	}
+
+	// Truncate the first block, releasing the memory used by the
+	// other groups.
+	std::vector<char>(bk.data.begin(),bk.data.begin()+sizes[0]).
+		swap(bk.data);
+	bk.gap=sizes[0];
+	bk.gap_size=0;
+
+	_block_paras.insert(b+1,counts.size()-1,0);
+	for (unsigned int i=0;i!=counts.size();++i)
+	{
+		_block_paras[b+i]=counts[i];
+	}
+}
+
+void text_buffer::merge_block(unsigned int b)
+{
+	if (b+1>=_blocks.size()) return;
+	block& bk=*_blocks[b];
+	block& nbk=*_blocks[b+1];
+	if (bk.size()+nbk.size()>block_size) return;
+
+	// Append the content of the next block after the gap.
+	nbk.move_gap(nbk.size());
+	unsigned int tail=nbk.size();
+	bk.move_gap(bk.size());
+	bk.reserve_gap(tail);
+	std::copy(nbk.data.begin(),nbk.data.begin()+tail,bk.data.begin()+bk.gap);
+	bk.gap+=tail;
+	bk.gap_size-=tail;
+
+	_block_paras[b]=_block_paras.sum(b+2)-_block_paras.sum(b);
+	_block_paras.erase(b+1,b+2);
+	delete _blocks[b+1];
+	_blocks.erase(_blocks.begin()+b+1);
+}
+
+void text_buffer::block::move_gap(unsigned int offset)
+{
+	if (offset<gap)
+	{
+		// Move characters between offset and gap to after the gap.
+		std::copy_backward(data.begin()+offset,data.begin()+gap,
+			data.begin()+gap+gap_size);
+	}
+	else if (offset>gap)
+	{
+		// Move characters between gap and offset to before the gap.
+		std::copy(data.begin()+gap+gap_size,
+			data.begin()+offset+gap_size,data.begin()+gap);
+	}
+	gap=offset;
+}
+
+void text_buffer::block::reserve_gap(unsigned int size)
+{
+	if (gap_size<size)
+	{
+		// Grow the buffer geometrically, so that the cost of insertion
+		// is amortised, then move the characters which follow the gap
+		// to the end of the buffer.
+		unsigned int old_size=data.size();
+		unsigned int new_size=std::max(old_size*2,old_size+size-gap_size);
+		data.resize(new_size);
+		std::copy_backward(data.begin()+gap+gap_size,
+			data.begin()+old_size,data.end());
+		gap_size+=new_size-old_size;
+	}
+}
+
+string text_buffer::view::str(unsigned int index,unsigned int count) const
+{
+	if (index>_size) index=_size;
+	if (count>_size-index) count=_size-index;
+	return string(_data+index,count);
+}
+
+} /* namespace util */
+} /* namespace rtk */
@@ -0,0 +1,315 @@
+// This file is part of the RISC OS Toolkit (RTK).
+// Copyright  2007 Graham Shaw.
+// Distribution and use are subject to the GNU Lesser General Public License,
+// a copy of which may be found in the file !RTK.Copyright.
+
+#ifndef _RTK_UTIL_TEXT_BUFFER
+#define _RTK_UTIL_TEXT_BUFFER
+
+#include <string>
+#include <vector>
+
+#include "rtk/util/cumulative_sum.h"
+
+namespace rtk {
+namespace util {
+
+using std::string;
+
+/** A class to represent a sequence of paragraphs of text.
+ * The characters are divided into blocks of whole paragraphs, each of
+ * which is held in its own gap buffer with each paragraph followed by
+ * a separator.  Blocks are split when they grow to twice their nominal
+ * size (unless they contain only one paragraph) and merged with their
+ * successor when small, so an edit moves no more than a block's worth
+ * of characters in addition to the characters inserted.  The paragraph
+ * boundaries are recorded separately as a cumulative sum of paragraph
+ * lengths, so that paragraphs may contain any character (including the
+ * separator) and the start of any paragraph can be found in O(log n)
+ * time.  The number of paragraphs in each block is recorded in the same
+ * way, so that the block containing any paragraph can also be found in
+ * O(log n) time.
+ *
+ * Paragraphs are read through views, which refer directly to the
+ * content of the buffer and so do not require the text to be copied.
+ * Obtaining a view may move the gap within a block (if the gap lies
+ * within the paragraph in question), but that can happen at most once
+ * after each modification.  A view therefore remains valid until the
+ * buffer is next modified.
+ *
+ * There is always at least one paragraph.
+ */
+class text_buffer
+{
+public:
+	class view;
+private:
+	/** A structure to represent a block of whole paragraphs.
+	 * The characters are held in a gap buffer, with each paragraph
+	 * followed by a separator.
+	 */
+	struct block
+	{
+		/** The characters of the block, including the gap. */
+		std::vector<char> data;
+
+		/** The logical offset at which the gap begins, with respect
+		 * to the start of the block. */
+		unsigned int gap;
+
+		/** The size of the gap. */
+		unsigned int gap_size;
+
+		/** Construct empty block. */
+		block():
+			gap(0),
+			gap_size(0)
+		{}
+
+		/** Get number of characters.
+		 * @return the number of characters, excluding the gap
+		 */
+		unsigned int size() const
+			{ return data.size()-gap_size; }
+
+		/** Convert logical offset to physical offset.
+		 * @param offset the logical offset, with respect to the start
+		 *  of the block
+		 * @return the corresponding index into data
+		 */
+		unsigned int physical(unsigned int offset) const
+			{ return (offset<gap)?offset:offset+gap_size; }
+
+		/** Move gap.
+		 * @param offset the required logical offset of the gap
+		 */
+		void move_gap(unsigned int offset);
+
+		/** Ensure that gap is at least a given size.
+		 * @param size the required minimum size
+		 */
+		void reserve_gap(unsigned int size);
+	};
+
+	/** The blocks, in order.
+	 * The gap within a block may be moved when a paragraph is viewed,
+	 * so the blocks are modified by some const member functions.
+	 */
+	std::vector<block*> _blocks;
+
+	/** The number of paragraphs in each block. */
+	cumulative_sum<unsigned int> _block_paras;
+
+	/** The length of each paragraph, including its separator. */
+	cumulative_sum<unsigned int> _lengths;
+public:
+	/** Construct text buffer containing one empty paragraph. */
+	text_buffer();
+
+	/** Destroy text buffer. */
+	~text_buffer();
+
+	/** Get number of paragraphs.
+	 * @return the number of paragraphs (always at least one)
+	 */
+	unsigned int size() const
+		{ return _lengths.size(); }
+
+	/** Get length of paragraph.
+	 * @param para the paragraph number
+	 * @return the length of the paragraph, excluding its separator
+	 */
+	unsigned int length(unsigned int para) const
+		{ return _lengths.sum(para+1)-_lengths.sum(para)-1; }
+
+	/** Get offset of character.
+	 * Each paragraph separator counts as one character.
+	 * @param para the paragraph number
+	 * @param index the byte index into the paragraph
+	 * @return the offset from the start of the text
+	 */
+	unsigned int offset(unsigned int para,unsigned int index=0) const
+		{ return _lengths.sum(para)+index; }
+
+	/** Find paragraph containing offset.
+	 * An offset which refers to a paragraph separator is considered
+	 * to be part of the paragraph which it follows.
+	 * @param offset the offset from the start of the text
+	 * @return the paragraph number
+	 */
+	unsigned int para(unsigned int offset) const;
+
+	/** Get character.
+	 * This does not move the gap.
+	 * @param para the paragraph number
+	 * @param index the byte index into the paragraph
+	 * @return the character
+	 */
+	char at(unsigned int para,unsigned int index) const;
+
+	/** Get view of paragraph.
+	 * @param para the paragraph number
+	 * @return a view of the paragraph
+	 */
+	view operator[](unsigned int para) const;
+
+	/** Replace text.
+	 * The text between the first and last locations is replaced by
+	 * a sequence of one or more paragraphs.  Any text in the first
+	 * paragraph before the first location is prepended to the first
+	 * replacement paragraph, and any text in the last paragraph after
+	 * the last location is appended to the last replacement paragraph.
+	 * An empty sequence is treated as a single empty paragraph.
+	 * @param first_para the first paragraph number
+	 * @param first_index the byte index into the first paragraph
+	 * @param last_para the last paragraph number
+	 * @param last_index the byte index into the last paragraph
+	 * @param first an iterator for the first replacement paragraph
+	 * @param last an iterator for the last replacement paragraph plus one
+	 */
+	template<class input_iterator>
+	void replace(unsigned int first_para,unsigned int first_index,
+		unsigned int last_para,unsigned int last_index,
+		input_iterator first,input_iterator last);
+private:
+	/** Copy constructor (not implemented). */
+	text_buffer(const text_buffer&);
+
+	/** Assignment operator (not implemented). */
+	text_buffer& operator=(const text_buffer&);
+
+	/** Replace text.
+	 * @param first_para the first paragraph number
+	 * @param first_index the byte index into the first paragraph
+	 * @param last_para the last paragraph number
+	 * @param last_index the byte index into the last paragraph
+	 * @param text the replacement paragraphs, each followed by
+	 *  a separator
+	 * @param lengths the length of each replacement paragraph,
+	 *  including its separator
+	 */
+	void splice(unsigned int first_para,unsigned int first_index,
+		unsigned int last_para,unsigned int last_index,
+		const string& text,std::vector<unsigned int>& lengths);
+
+	/** Find block containing paragraph.
+	 * @param para the paragraph number
+	 * @return the block number
+	 */
+	unsigned int block_of(unsigned int para) const
+		{ return _block_paras.find(para); }
+
+	/** Get offset of block.
+	 * @param b the block number
+	 * @return the offset of the first character of the block from
+	 *  the start of the text
+	 */
+	unsigned int block_offset(unsigned int b) const
+		{ return _lengths.sum(_block_paras.sum(b)); }
+
+	/** Split block if it is too large.
+	 * The block is divided at paragraph boundaries into blocks of
+	 * approximately the nominal size.
+	 * @param b the block number
+	 */
+	void split_block(unsigned int b);
+
+	/** Merge block with its successor if both are small.
+	 * @param b the block number
+	 */
+	void merge_block(unsigned int b);
+};
+
+/** A class to represent a read-only view of a paragraph.
+ * A view may also be constructed from a string, in which case
+ * it remains valid until the string is modified.
+ */
+class text_buffer::view
+{
+private:
+	/** A pointer to the first character. */
+	const char* _data;
+
+	/** The number of characters. */
+	unsigned int _size;
+public:
+	/** Construct empty view. */
+	view():
+		_data(""),
+		_size(0)
+	{}
+
+	/** Construct view.
+	 * The character following the last character of the view must
+	 * be addressable.
+	 * @param data a pointer to the first character
+	 * @param size the number of characters
+	 */
+	view(const char* data,unsigned int size):
+		_data(data),
+		_size(size)
+	{}
+
+	/** Construct view of string.
+	 * @param s the string
+	 */
+	view(const string& s):
+		_data(s.c_str()),
+		_size(s.size())
+	{}
+
+	/** Get pointer to first character.
+	 * @return a pointer to the first character
+	 */
+	const char* data() const
+		{ return _data; }
+
+	/** Get number of characters.
+	 * @return the number of characters
+	 */
+	unsigned int size() const
+		{ return _size; }
+
+	/** Get character.
+	 * @param index the index of the character
+	 * @return the character
+	 */
+	char operator[](unsigned int index) const
+		{ return _data[index]; }
+
+	/** Get copy of characters as string.
+	 * @param index the index of the first character to copy
+	 * @param count the maximum number of characters to copy
+	 * @return the characters
+	 */
+	string str(unsigned int index=0,unsigned int count=~0U) const;
+};
+
+template<class input_iterator>
+void text_buffer::replace(unsigned int first_para,unsigned int first_index,
+	unsigned int last_para,unsigned int last_index,
+	input_iterator first,input_iterator last)
+{
+	// Concatenate the replacement paragraphs, with separators,
+	// and record their lengths.
+	string text;
+	std::vector<unsigned int> lengths;
+	for (input_iterator i=first;i!=last;++i)
+	{
+		const string& ptext=*i;
+		text.append(ptext);
+		text+='\n';
+		lengths.push_back(ptext.size()+1);
+	}
+	if (lengths.empty())
+	{
+		text+='\n';
+		lengths.push_back(1);
+	}
+	splice(first_para,first_index,last_para,last_index,text,lengths);
+}
+
+} /* namespace util */
+} /* namespace rtk */
+
+#endif